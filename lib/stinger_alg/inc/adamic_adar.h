@@ -4,6 +4,7 @@
 #include "stinger_core/stinger_atomics.h"
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
+#include "stinger_net/stinger_alg.h"
 
 #ifdef __cplusplus
 #define restrict
@@ -12,6 +13,58 @@ extern "C" {
 
 int64_t adamic_adar(const stinger_t * S, int64_t source, int64_t etype, int64_t ** candidates, double ** scores);
 
+/*
+ * Link prediction by Adamic-Adar score, "Friends and neighbors on the Web",
+ * L. Adamic and E. Adar, Social Networks 2003. The graph is treated as
+ * undirected; etype selects one edge type, or -1 for all of them.
+ *
+ * The engine caches the sorted neighbor list of every vertex it visits and
+ * keeps 1 / log(degree) for all vertices, so repeated queries only walk the
+ * STINGER blocks of vertices touched since. After a batch has been applied,
+ * invalidate its endpoints. Queries may run concurrently with each other, but
+ * not with invalidation.
+ */
+typedef struct {
+  int64_t    nv;
+  int64_t    etype;
+  double   * inv_log_degree;  /* 1 / log(degree), 0 for degree < 2 */
+  int64_t  * state;           /* per vertex: ADAMIC_ADAR_STALE, _FILLING or _CACHED */
+  int64_t ** adj;             /* sorted neighbors without duplicates or v itself */
+  int64_t  * adj_len;
+} stinger_adamic_adar_t;
+
+#define ADAMIC_ADAR_STALE 0
+#define ADAMIC_ADAR_FILLING 1
+#define ADAMIC_ADAR_CACHED 2
+
+void adamic_adar_initialize(const stinger_t * S, int64_t nv, int64_t etype, stinger_adamic_adar_t * aa);
+void adamic_adar_release(stinger_adamic_adar_t * aa);
+
+/* Drops the cached neighbors of v and refreshes its degree term */
+void adamic_adar_invalidate(const stinger_t * S, stinger_adamic_adar_t * aa, int64_t v);
+
+void adamic_adar_update(const stinger_t * S, stinger_adamic_adar_t * aa,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions);
+
+/*
+ * The k best candidates for a new edge at source: vertices two hops away that
+ * are not already neighbors, by decreasing score and then increasing vertex
+ * id. k <= 0 returns every candidate. The output arrays are allocated here and
+ * must be NULL on entry. Returns the number of candidates.
+ */
+int64_t adamic_adar_top_k(const stinger_t * S, stinger_adamic_adar_t * aa, int64_t source, int64_t k,
+  int64_t ** candidates, double ** scores);
+
+/*
+ * Scores num_sources sources in parallel. Row i of candidates and scores
+ * (k entries each, k > 0) receives the result for sources[i] and counts[i]
+ * its length.
+ */
+void adamic_adar_top_k_batch(const stinger_t * S, stinger_adamic_adar_t * aa,
+  const int64_t * sources, int64_t num_sources, int64_t k,
+  int64_t * candidates, double * scores, int64_t * counts);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,10 @@ extern "C" {
 
 int64_t community_on_demand(const stinger_t * S, int64_t ** vertices, int64_t ** partitions);
 
+/* Same, with the Louvain level and per-level iteration limits chosen by the caller */
+int64_t community_on_demand_louvain(const stinger_t * S, int64_t ** vertices, int64_t ** partitions,
+    int64_t max_levels, int64_t max_iterations);
+
 #ifdef __cplusplus
 }
 #endif
@@ -14,6 +14,24 @@
 
 int64_t pseudo_diameter(stinger_t * S,int64_t NV , int64_t source, int64_t dist, bool ignore_weights);
 
+// Called after every search; lower and upper bound the diameter found so far (upper is -1 while
+// unknown) and searches counts the searches run. Returning false stops the computation, which
+// then reports the bounds it had reached.
+typedef bool (*diameter_progress_fn)(void * arg, int64_t lower, int64_t upper, int64_t searches);
+
+typedef struct {
+    int64_t lower;
+    int64_t upper;      // -1 if unknown
+    int64_t searches;
+    bool complete;      // lower == upper is the diameter
+} diameter_bounds_t;
+
+int64_t ifub_diameter(stinger_t * S, int64_t NV, diameter_bounds_t * bounds = NULL,
+                      diameter_progress_fn progress = NULL, void * arg = NULL);
+
 int64_t exact_diameter(stinger_t * S, int64_t NV);
 
+int64_t exact_diameter(stinger_t * S, int64_t NV, diameter_bounds_t * bounds,
+                       diameter_progress_fn progress, void * arg);
+
 #endif //DYNOGRAPH_DIAMETER_H
@@ -0,0 +1,122 @@
+#ifndef STINGER_EDGE_MAP_H_
+#define STINGER_EDGE_MAP_H_
+
+#include <stdint.h>
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+
+// Frontier-based graph processing over STINGER after "Ligra: A Lightweight
+// Graph Processing Framework for Shared Memory", J. Shun, G. Blelloch,
+// PPoPP 2013.
+//
+// A vertex_subset_t is a set of vertices held either as a list (sparse) or as
+// a byte per vertex (dense). edge_map applies an update to the edges leaving a
+// subset and returns the subset of destinations for which it returned
+// nonzero. Small frontiers are pushed along the out-edge chains of their
+// members; once the frontier and its out-degrees exceed a twentieth of the
+// edges, every vertex instead pulls from its in-edges, or, with
+// EDGE_MAP_DENSE_FORWARD, the edge type arrays are swept once.
+//
+// A few dozen lines on top of this give a parallel kernel; see the BFS,
+// connected components and PageRank below.
+
+typedef struct {
+  int64_t   nv;
+  int64_t   size;
+  int       is_dense;
+  int64_t * sparse;         /* members, when !is_dense */
+  uint8_t * dense;          /* nonzero for members, when is_dense */
+} vertex_subset_t;
+
+void vertex_subset_init(vertex_subset_t * vs, int64_t nv);
+void vertex_subset_release(vertex_subset_t * vs);
+
+// Replaces the contents with nothing, one vertex, or every vertex below nv.
+void vertex_subset_clear(vertex_subset_t * vs);
+void vertex_subset_from_vertex(vertex_subset_t * vs, int64_t v);
+void vertex_subset_all(vertex_subset_t * vs);
+
+void vertex_subset_to_dense(vertex_subset_t * vs);
+void vertex_subset_to_sparse(vertex_subset_t * vs);
+int  vertex_subset_contains(const vertex_subset_t * vs, int64_t v);
+
+// The graph an edge_map runs over: the edges of type etype (-1 for all)
+// between vertices below nv, optionally only those in a time window.
+typedef struct {
+  stinger_t * S;
+  int64_t     nv;
+  int64_t     etype;
+  int64_t     ne;           /* out-edges among the first nv vertices */
+  int         windowed;
+  int64_t     t0, t1;
+  int64_t     stamp;
+  int64_t   * mark;         /* == stamp once in the output of a push */
+} edge_map_graph_t;
+
+void edge_map_graph_init(edge_map_graph_t * G, stinger_t * S, int64_t nv, int64_t etype);
+void edge_map_graph_release(edge_map_graph_t * G);
+
+// Restricts G to the out-edges seen during [t0, t1] (see
+// STINGER_EDGE_IN_WINDOW), skipping edge blocks outside it. In-edge records
+// carry no timestamps, so dense rounds over a windowed graph always sweep the
+// edge type arrays, as do undirected rounds.
+void edge_map_graph_set_window(edge_map_graph_t * G, int64_t t0, int64_t t1);
+
+// update(src, dst, weight, arg) returns nonzero to put dst in the output.
+// cond(dst, arg) returns zero once dst needs no more updates; NULL means
+// always. update_atomic may run concurrently for the same dst and is used
+// when pushing or sweeping; update is only ever called by the thread pulling
+// into dst and may be NULL, in which case update_atomic is used throughout.
+// When pulling, weight is that of dst's in-edge record.
+typedef int (*edge_map_update_fn)(int64_t src, int64_t dst, int64_t weight, void * arg);
+typedef int (*edge_map_cond_fn)(int64_t v, void * arg);
+typedef int (*vertex_map_fn)(int64_t v, void * arg);
+
+typedef struct {
+  edge_map_update_fn update;
+  edge_map_update_fn update_atomic;
+  edge_map_cond_fn   cond;
+} edge_map_ops_t;
+
+#define EDGE_MAP_UNDIRECTED     0x1   /* follow edges in both directions */
+#define EDGE_MAP_SPARSE         0x2   /* always push */
+#define EDGE_MAP_DENSE          0x4   /* never push */
+#define EDGE_MAP_DENSE_FORWARD  0x8   /* dense rounds sweep the edge types instead of pulling */
+#define EDGE_MAP_NO_OUTPUT      0x10  /* out is not filled and may be NULL */
+
+// Fills out, which must have been initialized for G->nv vertices, and
+// returns its size.
+int64_t edge_map(edge_map_graph_t * G, vertex_subset_t * frontier, const edge_map_ops_t * ops, void * arg,
+  vertex_subset_t * out, int flags);
+
+// Calls fn on every member of vs in parallel. If out is not NULL it receives
+// the members for which fn returned nonzero; it must not be vs. Returns the
+// size of out, or of vs.
+int64_t vertex_map(vertex_subset_t * vs, vertex_map_fn fn, void * arg, vertex_subset_t * out);
+
+// Reference kernels
+
+// Hop distances from source along out-edges, -1 where unreachable. Returns
+// the number of vertices reached.
+int64_t bfs_edge_map(stinger_t * S, int64_t nv, int64_t source, int64_t * level);
+
+// Labels every vertex with the smallest id in its weakly connected component.
+// Returns the number of components.
+int64_t connected_components_edge_map(stinger_t * S, int64_t nv, int64_t * component_map);
+
+// PageRank over the out-edges, with the rank of vertices without out-edges
+// spread over every vertex, as page_rank does. pr holds the starting ranks.
+// Returns the iterations run.
+int64_t page_rank_edge_map(stinger_t * S, int64_t nv, double * pr, double epsilon, double dampingfactor, int64_t maxiter);
+
+// The same over the edges seen during [t0, t1] only. Vertices without such
+// edges are unreached, their own component, or dangling.
+int64_t bfs_edge_map_window(stinger_t * S, int64_t nv, int64_t source, int64_t t0, int64_t t1, int64_t * level);
+int64_t connected_components_edge_map_window(stinger_t * S, int64_t nv, int64_t t0, int64_t t1,
+  int64_t * component_map);
+int64_t page_rank_edge_map_window(stinger_t * S, int64_t nv, int64_t t0, int64_t t1, double * pr,
+  double epsilon, double dampingfactor, int64_t maxiter);
+
+#endif
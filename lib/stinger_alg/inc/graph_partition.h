@@ -4,6 +4,82 @@
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
 #include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
 
 void graph_partition(struct stinger * S, uint64_t NV, uint64_t num_partitions, double_t partition_capacity, int64_t * partitions, int64_t * partitions_sizes);
+
+/*
+ * Streaming partitioning. Partitions are labeled 1..num_partitions and 0 means
+ * a vertex has not been assigned yet. A vertex goes to the partition holding
+ * most of its neighbors (in and out edges of all types), discounted for size:
+ *
+ *   LDG:    n_p * (1 - |P| / C)
+ *     "Streaming graph partitioning for large distributed graphs",
+ *     I. Stanton and G. Kliot, KDD 2012.
+ *   Fennel: n_p - alpha * gamma * |P|^(gamma - 1)
+ *     "FENNEL: Streaming graph partitioning for massive scale graphs",
+ *     C. Tsourakakis, C. Gkantsidis, B. Radunovic, M. Vojnovic, WSDM 2014.
+ *
+ * Ties go to the smaller partition, then to the lower label. Vertices are
+ * assigned when they first show up in a batch; restreaming passes then move
+ * assigned vertices in parallel, as in "Restreaming graph partitioning: simple
+ * versatile algorithms for advanced balancing", J. Nishimura and J. Ugander,
+ * KDD 2013.
+ *
+ * sizes[p] and cut[p] (the number of out-edges from p to another partition)
+ * are kept for p in 1..num_partitions; sizes[0] is unused and cut[0] holds
+ * the total cut. All three arrays can live in alg_data.
+ */
+
+#define GRAPH_PARTITION_LDG 0
+#define GRAPH_PARTITION_FENNEL 1
+
+#define GRAPH_PARTITION_GAMMA_DEFAULT 1.5
+#define GRAPH_PARTITION_SLACK_DEFAULT 1.1
+
+typedef struct {
+  int64_t   nv;
+  int64_t   num_partitions;
+  int64_t   method;
+  double    capacity;     /* LDG: fixed capacity, or <= 0 for slack * assigned / k */
+  double    slack;
+  double    gamma;        /* Fennel */
+  double    alpha;        /* Fennel, recomputed by every full pass */
+  int64_t   assigned;
+  int64_t   stamp;
+  int64_t * mark;
+  int64_t * cut_out;      /* per vertex: out-edges to other partitions */
+} stinger_partition_internal;
+
+typedef struct {
+  int64_t vertices_assigned;
+  int64_t vertices_moved;
+  int64_t restream_passes;
+} stinger_partition_stats;
+
+/* Assigns every vertex below nv that has an edge in one parallel streaming pass */
+void stinger_partition_initialize_internals(stinger_t * S, int64_t nv, stinger_partition_internal * part_internal,
+  int64_t num_partitions, int64_t method, double capacity,
+  int64_t * partitions, int64_t * sizes, int64_t * cut, stinger_partition_stats * stats);
+void stinger_partition_release_internals(stinger_partition_internal * part_internal);
+
+void stinger_partition_reset_stats(stinger_partition_stats * stats);
+
+/*
+ * After a batch has been applied: assigns its unassigned endpoints one at a
+ * time in batch order and updates the cut of every vertex whose edges or
+ * neighbors changed. Returns the number of vertices assigned.
+ */
+int64_t stinger_partition_update(stinger_t * S, stinger_partition_internal * part_internal,
+  stinger_partition_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * partitions, int64_t * sizes, int64_t * cut);
+
+/* Runs up to passes parallel refinement passes, stopping early when nothing
+ * moves, and recounts the cut. Returns the number of moves. */
+int64_t stinger_partition_restream(stinger_t * S, stinger_partition_internal * part_internal,
+  stinger_partition_stats * stats, int64_t passes,
+  int64_t * partitions, int64_t * sizes, int64_t * cut);
+
 #endif
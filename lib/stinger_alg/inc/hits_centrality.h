@@ -10,6 +10,27 @@
 #include "stinger_core/stinger_error.h"
 #include "math.h"
 
+#define HITS_EPSILON_DEFAULT 1e-8
+#define HITS_MAXITER_DEFAULT 100
+
+/* Runs at most k iterations from uniform hub scores, stopping early once the
+ * scores no longer change */
 void hits_centrality(stinger_t * s, int64_t NV, double_t * hubs_scores, double_t * authority_scores, int64_t k);
 
+/*
+ * Parallel HITS. Each iteration computes authorities from the in-edges and
+ * hubs from the out-edges, folding the normalization of one into the sweep
+ * of the other, and stops once the L1 change of both unit vectors is at most
+ * epsilon or after maxiter iterations. With warm_start the current
+ * hubs_scores (e.g. the previous batch's, from alg_data) seed the iteration.
+ * tmp_in may hold 2 * NV doubles of scratch space or be NULL.
+ * Returns the number of iterations run.
+ */
+int64_t hits_centrality_epsilon(stinger_t * S, int64_t NV, double_t * hubs_scores, double_t * authority_scores,
+                                double * tmp_in, double epsilon, int64_t maxiter, int warm_start);
+
+/* Same, following only edges of the given type */
+int64_t hits_centrality_type(stinger_t * S, int64_t NV, double_t * hubs_scores, double_t * authority_scores,
+                             double * tmp_in, double epsilon, int64_t maxiter, int warm_start, int64_t type);
+
 #endif //DYNOGRAPH_HITS_CENTRALITY_H
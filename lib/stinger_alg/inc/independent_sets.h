@@ -6,7 +6,37 @@
 #define STINGER_INDEPENDENT_SETS_H
 
 #include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_net/stinger_alg.h"
+
+#define INDEPENDENT_SET_DEFAULT_SEED 0x5bd1e995
+
+/*
+ * Maximal independent sets over the undirected graph underlying STINGER (in
+ * and out edges of every type, self-loops ignored). independent_set[v] is 1
+ * for members and 0 otherwise.
+ */
 
 void independent_set(stinger_t * S, int64_t NV, int64_t * independent_set);
 
+/*
+ * Parallel priority MIS after Luby, "A simple parallel algorithm for the
+ * maximal independent set problem", SIAM J. Comput. 1986, in the
+ * deterministic form of Blelloch, Fineman and Shun, SPAA 2012: vertices are
+ * ranked by a hash of (seed, id) and the result is the greedy set for that
+ * order, independent of the thread count. Returns the size of the set.
+ */
+int64_t independent_set_luby(stinger_t * S, int64_t NV, int64_t * independent_set, uint64_t seed);
+
+/*
+ * Repairs a maximal independent set after a batch. Of two members joined by an
+ * inserted edge the later one in the seeded order leaves. Vertices left
+ * without a member neighbor by that or by a deletion, and the new vertices in
+ * [old_nv, NV), are settled again as above. The rest of the set is kept.
+ * Returns the number of vertices re-decided.
+ */
+int64_t independent_set_update(stinger_t * S, int64_t old_nv, int64_t NV, int64_t * independent_set, uint64_t seed,
+                               stinger_edge_update * insertions, int64_t num_insertions,
+                               stinger_edge_update * deletions, int64_t num_deletions);
+
 #endif
@@ -6,7 +6,60 @@
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
 #include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
 
 void kcore_find(stinger_t *S, int64_t * labels, int64_t * counts, int64_t nv, int64_t * k_out);
 
+// Exact core numbers by parallel bucket peeling (PKC):
+// "Parallel k-core Decomposition on Multicore Platforms", H. Kabir and
+// K. Madduri, IPDPSW 2017.
+// Every out-edge other than a self-loop counts towards the degree, so the
+// graph is expected to be undirected (inserted with edge pairs).
+void kcore_decomposition(stinger_t * S, int64_t nv, int64_t * core, int64_t * k_out);
+
+// Number of neighbors of each vertex whose core number is at least its own.
+void kcore_neighbor_counts(stinger_t * S, int64_t nv, const int64_t * core, int64_t * counts);
+
+// Streaming core maintenance. Insertions use the traversal algorithm from
+// "Incremental k-core decomposition: algorithms and evaluation", A.E. Sariyuce,
+// B. Gedik, G. Jacques-Silva, K.-L. Wu, U.V. Catalyurek, VLDB Journal 2016.
+// Deletions lower the stored core numbers, which remain upper bounds, with a
+// frontier-driven h-index iteration until they converge.
+typedef struct {
+  int64_t   nv;
+  int64_t   stamp;
+  int64_t * mark;
+  int64_t * cd;
+  int64_t * queue;
+  int64_t * stack;
+  int64_t * dirty_mark;
+  int64_t * dirty;
+
+  int64_t   skip_size;   /* batch edges hidden from the graph, see kcore.c */
+  int64_t   skip_count;
+  int64_t * skip_keys;
+} stinger_kcore_internal;
+
+typedef struct {
+  int64_t insertions_processed;
+  int64_t deletion_rounds;
+  int64_t vertices_visited;
+  int64_t vertices_changed;
+} stinger_kcore_stats;
+
+// Runs kcore_decomposition and kcore_neighbor_counts and allocates the
+// per-vertex state (about 48 bytes per vertex) used by stinger_kcore_update.
+void stinger_kcore_initialize_internals(stinger_t * S, int64_t nv, stinger_kcore_internal * kcore_internal,
+  int64_t * core, int64_t * counts, int64_t * k_out);
+void stinger_kcore_release_internals(stinger_kcore_internal * kcore_internal);
+
+void stinger_kcore_reset_stats(stinger_kcore_stats * stats);
+
+// Updates core and counts after a batch has been applied to S. Returns the
+// number of vertices that were touched by the batch or changed core number.
+int64_t stinger_kcore_update(stinger_t * S, stinger_kcore_internal * kcore_internal, stinger_kcore_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * core, int64_t * counts, int64_t * k_out);
+
 #endif
@@ -0,0 +1,61 @@
+#ifndef STINGER_LABEL_PROPAGATION_H_
+#define STINGER_LABEL_PROPAGATION_H_
+
+#include <stdint.h>
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
+
+// Label propagation communities, "Near linear time algorithm to detect
+// community structures in large-scale networks", U.N. Raghavan, R. Albert,
+// S. Kumara, Phys. Rev. E 2007, read straight from the STINGER adjacency.
+//
+// Every vertex adopts the label with the largest total edge weight among its
+// out-neighbors (all types; non-positive weights count as 1) plus a vote, as
+// heavy as its heaviest edge, for its own label, or for its own id if no
+// neighbor shares its label any more. Ties go to the smallest label. Rounds
+// are synchronous, so the result does not depend on the number of threads, and
+// only vertices next to a change are evaluated again.
+
+#define LABEL_PROPAGATION_DEFAULT_ITERATIONS 20
+
+typedef struct {
+  int64_t   nv;
+  int64_t   max_iterations;
+  int64_t   stamp;
+  int64_t * mark;           /* == stamp once queued for the next round */
+  int64_t * next_label;
+  int64_t * frontier;
+  int64_t * next_frontier;
+  int64_t * changed;
+} stinger_label_propagation_internal;
+
+typedef struct {
+  int64_t rounds;
+  int64_t vertices_evaluated;
+  int64_t labels_changed;
+} stinger_label_propagation_stats;
+
+// Starts every vertex below nv with its own id and propagates until no label
+// changes or max_iterations rounds have run.
+void stinger_label_propagation_initialize_internals(stinger_t * S, int64_t nv,
+  stinger_label_propagation_internal * lp_internal, int64_t max_iterations,
+  int64_t * labels, stinger_label_propagation_stats * stats);
+void stinger_label_propagation_release_internals(stinger_label_propagation_internal * lp_internal);
+
+void stinger_label_propagation_reset_stats(stinger_label_propagation_stats * stats);
+
+// After a batch has been applied, re-evaluates the endpoints of its edges and
+// then whatever their changes reach. Returns the number of labels changed.
+int64_t stinger_label_propagation_update(stinger_t * S, stinger_label_propagation_internal * lp_internal,
+  stinger_label_propagation_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * labels);
+
+// Number of distinct labels among the first nv entries.
+int64_t label_propagation_count(int64_t nv, const int64_t * labels);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef STINGER_LOUVAIN_H_
+#define STINGER_LOUVAIN_H_
+
+#include <stdint.h>
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
+
+// Parallel multi-level Louvain modularity maximization,
+// "Fast unfolding of communities in large networks", V.D. Blondel,
+// J.-L. Guillaume, R. Lambiotte, E. Lefebvre, J. Stat. Mech. 2008,
+// with the parallel local-moving heuristics of
+// "Parallel heuristics for scalable community detection", H. Lu,
+// M. Halappanavar, A. Kalyanaraman, Parallel Computing 2015.
+//
+// Every level moves vertices between neighboring communities in parallel and
+// then contracts each community into a single vertex of a CSR graph for the
+// next level. The graph is treated as undirected; edges of all types between
+// the same pair of vertices are merged and non-positive weights count as 1.
+//
+// Community labels are the smallest vertex id in each community.
+
+#define LOUVAIN_DEFAULT_LEVELS 8
+#define LOUVAIN_DEFAULT_ITERATIONS 20
+
+typedef struct {
+  int64_t levels;             /* levels run, including the first */
+  int64_t moves;              /* vertex moves summed over all levels */
+  int64_t vertices_examined;  /* vertex visits during local moving */
+  int64_t communities;
+  double  modularity;
+} stinger_louvain_stats;
+
+void stinger_louvain_reset_stats(stinger_louvain_stats * stats);
+
+// Cold start: every vertex below nv begins in its own community. Runs up to
+// max_levels levels with at most max_iterations local-moving rounds each.
+// Returns the number of communities.
+int64_t louvain_communities(stinger_t * S, int64_t nv, int64_t * partitions,
+  int64_t max_levels, int64_t max_iterations, stinger_louvain_stats * stats);
+
+// Warm start from the partition computed for the previous batch (labels for
+// vertices below old_nv, e.g. kept in alg_data). Vertices in [old_nv, nv) start
+// alone. On the first level only the endpoints of the batch and their neighbors
+// are re-optimized, followed by the neighbors of whatever moved; the coarser
+// levels are cheap and run in full. Returns the number of communities.
+int64_t louvain_communities_update(stinger_t * S, int64_t old_nv, int64_t nv, int64_t * partitions,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t max_levels, int64_t max_iterations, stinger_louvain_stats * stats);
+
+#endif
@@ -15,6 +15,8 @@ extern "C" {
 #include <stdlib.h>
 #include <functional>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 
 
@@ -24,6 +26,20 @@ std::vector<int64_t> dijkstra(stinger_t * S, int64_t NV, int64_t source_vertex,
 
 std::vector<std::vector <int64_t> > all_pairs_dijkstra(stinger_t * S, int64_t NV);
 
+int64_t delta_stepping_default_delta(stinger_t * S, int64_t NV, bool ignore_weights);
+
+std::vector<int64_t> delta_stepping(stinger_t * S, int64_t NV, int64_t source_vertex, bool ignore_weights, int64_t delta);
+
+std::vector<std::vector<int64_t> > multi_source_shortest_paths(stinger_t * S, int64_t NV, const std::vector<int64_t> & sources,
+                                                               bool ignore_weights, int64_t delta);
+
+int64_t bidirectional_shortest_path(stinger_t * S, int64_t NV, int64_t source_vertex, int64_t dest_vertex, bool ignore_weights);
+
+int64_t hop_distances(stinger_t * S, int64_t NV, int64_t source_vertex, bool undirected, int64_t * dist, int64_t * queue);
+
+double mean_shortest_path_sampled(stinger_t * S, int64_t NV, int64_t samples, uint64_t seed, bool ignore_weights,
+                                  double * half_width);
+
 int64_t mean_shortest_path(stinger * S, int64_t NV);
 
 #endif //STINGER_SHORTEST_PATHS_H
@@ -6,7 +6,26 @@
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
 #include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
 
+// Labels every vertex below nv with the smallest vertex id in its weakly
+// connected component, considering edges of all types.
 int64_t parallel_shiloach_vishkin_components (struct stinger * S, int64_t nv, int64_t * component_map);
 
+// Afforest: lock-free union-find over a few sampled neighbors per vertex,
+// after which the edges of the (likely) largest component are skipped.
+// "Afforest: A Fast Concurrent Connected Components Algorithm",
+// M. Sutton, T. Ben-Nun, A. Barak, ICPP 2018.
+// Labels are the same as above. Returns the number of components.
+int64_t afforest_components (struct stinger * S, int64_t nv, int64_t * component_map, int64_t neighbor_rounds);
+
+// Brings component_map up to date after a batch. Labels for vertices in
+// [old_nv, nv) are initialized and the new edges are unioned into the
+// existing forest; no other edges are visited. Deletions that removed an edge (result > 0)
+// can split components, so they trigger a full afforest_components instead.
+// Returns 1 if the batch was handled incrementally, 0 if it was recomputed.
+int64_t afforest_components_update (struct stinger * S, int64_t old_nv, int64_t nv, int64_t * component_map,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions);
+
 #endif
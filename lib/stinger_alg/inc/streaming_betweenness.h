@@ -0,0 +1,67 @@
+#ifndef STINGER_STREAMING_BETWEENNESS_H_
+#define STINGER_STREAMING_BETWEENNESS_H_
+
+#include <stdint.h>
+
+// Incremental approximate betweenness centrality. A fixed set of sample
+// sources is chosen once and the Brandes shortest-path DAG summary of each
+// source (distance, path count and dependency) is kept between batches. A
+// batch only triggers a new traversal from the sources whose DAG it can
+// change, in the spirit of QUBE and iCentral:
+//
+// "QUBE: a Quick algorithm for Updating BEtweenness centrality",
+// M.-J. Lee, J. Lee, J.Y. Park, R.H. Choi, C.-W. Chung, WWW 2012.
+// "Incremental Algorithm for Updating Betweenness Centrality in Dynamically
+// Growing Networks", M. Nasre, M. Pontecorvi, V. Ramachandran, ASONAM 2013.
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
+
+typedef struct {
+  int64_t sources_recomputed;
+  int64_t sources_skipped;
+  int64_t sources_added;
+} stinger_bc_stats;
+
+typedef struct {
+  int64_t   nsamples;     /* requested number of sample sources */
+  int64_t   num_sources;  /* sources currently tracked (<= nsamples) */
+  int64_t * sources;
+
+  int64_t   nv;           /* vertices covered by the per-source summaries */
+  int64_t   capacity;     /* allocated row length of the summaries */
+  int64_t * d;            /* num_sources x capacity distances, -1 if unreached */
+  int64_t * sigma;        /* num_sources x capacity shortest path counts */
+  double  * delta;        /* num_sources x capacity dependencies */
+
+  uint64_t  seed;
+} stinger_bc_internal;
+
+// Chooses the sample set, runs one traversal per source and fills bc and
+// found_count (both nv long) with the summed dependencies and the number of
+// sources that reach each vertex. If nv <= nsamples every vertex becomes a
+// source and the result is exact.  Memory use is 24 * nsamples * nv bytes.
+void stinger_bc_initialize_internals(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  int64_t nsamples, uint64_t seed, double * bc, int64_t * found_count);
+void stinger_bc_release_internals(stinger_bc_internal * bc_internal);
+
+void stinger_bc_reset_stats(stinger_bc_stats * stats);
+
+// Brings bc and found_count up to date after a batch has been applied to S.
+// Only sources whose shortest-path DAG is touched by one of the insertions or
+// deletions are traversed again. nv may grow between calls; while fewer than
+// nsamples sources are tracked, new vertices are added as sources.
+// Returns the number of sources that were recomputed.
+int64_t stinger_bc_update(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  stinger_bc_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  double * bc, int64_t * found_count);
+
+// Recomputes every tracked source from scratch, keeping the sample set.
+void stinger_bc_recompute(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  double * bc, int64_t * found_count);
+
+#endif
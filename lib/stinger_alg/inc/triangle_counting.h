@@ -0,0 +1,85 @@
+#ifndef STINGER_TRIANGLE_COUNTING_H_
+#define STINGER_TRIANGLE_COUNTING_H_
+
+#include <stdint.h>
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
+
+// Triangle counting and local clustering coefficients. The graph is taken to
+// be the simple undirected graph underlying STINGER: two vertices are adjacent
+// if there is an out-edge of any type between them, duplicates across types
+// are merged and self-loops are ignored. Edges are expected to be inserted in
+// both directions.
+//
+// Static counts orient every edge from lower to higher (degree, id) rank so
+// each triangle is found exactly once, as in
+// "Counting Triangles in Massive Graphs with MapReduce", S. Suri and
+// S. Vassilvitskii, WWW 2011, and intersect the sorted out-neighborhoods with
+// a merge (AVX2 4x4 block compares when compiled with -mavx2).
+
+// Number of values common to the sorted, duplicate-free arrays a and b. If out
+// is not NULL the common values are also written to it in increasing order.
+int64_t triangle_intersect(const int64_t * a, int64_t na, const int64_t * b, int64_t nb, int64_t * out);
+
+// Writes the sorted distinct neighbors of v into *buf, growing it (xrealloc)
+// when *buf_size is too small. Returns the number of neighbors.
+int64_t triangle_gather_neighbors(stinger_t * S, int64_t v, int64_t ** buf, int64_t * buf_size);
+
+// ntri[v] is the number of triangles containing v, for every v < nv. If deg is
+// not NULL it receives the number of distinct neighbors of each vertex.
+void triangle_count_all(stinger_t * S, int64_t nv, int64_t * ntri, int64_t * deg);
+
+// cc[v] = 2 * ntri[v] / (deg[v] * (deg[v] - 1)), or 0 for degree below 2.
+void triangle_clustering_coefficients(int64_t nv, const int64_t * ntri, const int64_t * deg, double * cc);
+
+// Streaming maintenance. Before a batch is applied, stinger_triangle_prepare
+// records whether each vertex pair touched by the batch is adjacent. After the
+// batch, stinger_triangle_update recounts the endpoints of the batch and adds
+// or removes one triangle at every common neighbor of a pair whose adjacency
+// changed. Nothing else in the graph is visited.
+typedef struct {
+  int64_t   nv;
+  int64_t * deg;          /* distinct neighbors per vertex */
+  int64_t   stamp;
+  int64_t * mark;         /* == stamp for endpoints of the current batch */
+  int64_t * touched;      /* vertices whose count changed during an update */
+
+  int64_t   prepared;     /* pairs below describe the pending batch */
+  int64_t   num_pairs;
+  int64_t   pair_capacity;
+  int64_t * pairs;        /* (u, v) with u < v */
+  uint8_t * was_adjacent;
+} stinger_triangle_internal;
+
+typedef struct {
+  int64_t pairs_changed;
+  int64_t vertices_recounted;
+  int64_t neighbor_updates;
+} stinger_triangle_stats;
+
+// Counts all triangles and fills ntri, and cc when it is not NULL.
+void stinger_triangle_initialize_internals(stinger_t * S, int64_t nv, stinger_triangle_internal * tri_internal,
+  int64_t * ntri, double * cc);
+void stinger_triangle_release_internals(stinger_triangle_internal * tri_internal);
+
+void stinger_triangle_reset_stats(stinger_triangle_stats * stats);
+
+// Must run while S still holds the graph from before the batch.
+void stinger_triangle_prepare(stinger_t * S, stinger_triangle_internal * tri_internal,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions);
+
+// Brings ntri (and cc, if not NULL) up to date after the batch has been
+// applied. Without a matching stinger_triangle_prepare the previous adjacency
+// of the touched pairs is unknown and every neighbor of an endpoint is
+// recounted instead. Returns the number of vertices recounted.
+int64_t stinger_triangle_update(stinger_t * S, stinger_triangle_internal * tri_internal,
+  stinger_triangle_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * ntri, double * cc);
+
+#endif
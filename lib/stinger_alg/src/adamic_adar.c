@@ -1,177 +1,486 @@
+#include <math.h>
+#include <string.h>
+
 #include "adamic_adar.h"
 #include "stinger_core/stinger_error.h"
 
 static int
 compare (const void * a, const void * b)
 {
-    return ( *(int*)a - *(int*)b );
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
 }
 
 /*
- *  Adamic Adar
- *
- *  This implementation treats the input graph as undirected.  Directed edges in the graph are treated as undirected
- *  when performing the analysis.  This is to account for the fact that Adamic Adar is only defined for an undirected
- *  graph.
+ * Score accumulator. The batch keeps one per thread indexed by vertex and
+ * resets it between sources by bumping stamp. A single query instead hashes
+ * the vertices it sees, so its cost follows the two-hop neighborhood rather
+ * than the number of vertices.
  */
-int64_t adamic_adar(const stinger_t * S, int64_t source, int64_t etype, int64_t ** candidates, double ** scores) {
-  if (*candidates != NULL || *scores != NULL) {
-    LOG_E("Adamic Adar output arrays should not be allocated before call.  Possible memory leak.");
+typedef struct {
+  int64_t   stamp;
+  int64_t   mask;      /* hash table size - 1, or -1 when indexed by vertex */
+  int64_t   used;      /* hash table entries in use */
+  int64_t * mark;      /* by vertex: == stamp once seen; hashed: the vertex, or -1 */
+  double  * acc;       /* score, or -1 for the source and its neighbors */
+  int64_t * touched;
+  int64_t   ntouched;
+  int64_t   touched_cap;
+  int64_t * buf;       /* neighbors of a vertex another thread is caching */
+  int64_t   buf_cap;
+} adamic_adar_scratch;
+
+static void
+scratch_init (adamic_adar_scratch * sc, int64_t nv)
+{
+  sc->stamp = 0;
+  sc->mask = -1;
+  sc->used = 0;
+  sc->mark = (int64_t *) xcalloc (nv, sizeof(int64_t));
+  sc->acc = (double *) xmalloc (nv * sizeof(double));
+  sc->touched = (int64_t *) xmalloc (nv * sizeof(int64_t));
+  sc->ntouched = 0;
+  sc->touched_cap = nv;
+  sc->buf = NULL;
+  sc->buf_cap = 0;
+}
+
+/* A hashed accumulator with room for about expected vertices; it grows */
+static void
+scratch_init_hashed (adamic_adar_scratch * sc, int64_t expected)
+{
+  int64_t size = 16;
+  while (size < 2 * expected)
+    size *= 2;
+  sc->stamp = 0;
+  sc->mask = size - 1;
+  sc->used = 0;
+  sc->mark = (int64_t *) xmalloc (size * sizeof(int64_t));
+  for (int64_t i = 0; i < size; i++)
+    sc->mark[i] = -1;
+  sc->acc = (double *) xmalloc (size * sizeof(double));
+  sc->touched_cap = expected > 0 ? expected : 1;
+  sc->touched = (int64_t *) xmalloc (sc->touched_cap * sizeof(int64_t));
+  sc->ntouched = 0;
+  sc->buf = NULL;
+  sc->buf_cap = 0;
+}
+
+static void
+scratch_release (adamic_adar_scratch * sc)
+{
+  xfree (sc->mark);
+  xfree (sc->acc);
+  xfree (sc->touched);
+  if (sc->buf)
+    xfree (sc->buf);
+}
+
+static inline int64_t
+scratch_hash (const adamic_adar_scratch * sc, int64_t x)
+{
+  uint64_t h = (uint64_t) x * 0x9E3779B97F4A7C15ULL;
+  return (int64_t) ((h ^ (h >> 32)) & (uint64_t) sc->mask);
+}
+
+/* Slot of x in a hashed accumulator: where it is, or the free slot it goes in */
+static inline int64_t
+scratch_probe (const adamic_adar_scratch * sc, int64_t x)
+{
+  int64_t i = scratch_hash (sc, x);
+  while (sc->mark[i] != x && sc->mark[i] != -1)
+    i = (i + 1) & sc->mask;
+  return i;
+}
+
+static void
+scratch_grow (adamic_adar_scratch * sc)
+{
+  int64_t old_size = sc->mask + 1;
+  int64_t * old_mark = sc->mark;
+  double * old_acc = sc->acc;
+
+  sc->mask = 2 * old_size - 1;
+  sc->mark = (int64_t *) xmalloc (2 * old_size * sizeof(int64_t));
+  for (int64_t i = 0; i <= sc->mask; i++)
+    sc->mark[i] = -1;
+  sc->acc = (double *) xmalloc (2 * old_size * sizeof(double));
+  for (int64_t i = 0; i < old_size; i++) {
+    if (old_mark[i] != -1) {
+      int64_t j = scratch_probe (sc, old_mark[i]);
+      sc->mark[j] = old_mark[i];
+      sc->acc[j] = old_acc[i];
+    }
+  }
+  xfree (old_mark);
+  xfree (old_acc);
+}
+
+/*
+ * Where x's score lives, marking x seen for the current source. *fresh is
+ * set if it had not been.
+ */
+static inline int64_t
+scratch_claim (adamic_adar_scratch * sc, int64_t x, int * fresh)
+{
+  if (sc->mask < 0) {
+    *fresh = (sc->mark[x] != sc->stamp);
+    sc->mark[x] = sc->stamp;
+    return x;
+  }
+
+  /* keep the table at most half full */
+  if (2 * (sc->used + 1) > sc->mask + 1)
+    scratch_grow (sc);
+  int64_t i = scratch_probe (sc, x);
+  *fresh = (sc->mark[i] == -1);
+  if (*fresh) {
+    sc->mark[i] = x;
+    sc->used++;
+  }
+  return i;
+}
+
+/* Where the score of a vertex already seen lives */
+static inline int64_t
+scratch_slot (const adamic_adar_scratch * sc, int64_t x)
+{
+  return sc->mask < 0 ? x : scratch_probe (sc, x);
+}
+
+static inline void
+scratch_touch (adamic_adar_scratch * sc, int64_t x)
+{
+  if (sc->ntouched == sc->touched_cap) {
+    sc->touched_cap *= 2;
+    sc->touched = (int64_t *) xrealloc (sc->touched, sc->touched_cap * sizeof(int64_t));
   }
+  sc->touched[sc->ntouched++] = x;
+}
+
+static int64_t
+vertex_degree (const stinger_t * S, int64_t etype, int64_t v)
+{
+  if (etype == -1)
+    return stinger_degree_get (S, v);
+  return stinger_typed_degree (S, v, etype);
+}
+
+static double
+inv_log (int64_t deg)
+{
+  return deg > 1 ? 1.0 / log ((double) deg) : 0.0;
+}
 
-  int64_t * output_vertices = NULL;
-  double * output_scores = NULL;
-  int64_t source_deg = 0;
+/*
+ * Gathers the neighbors of v into *out (grown as needed), sorted and without
+ * duplicates or v itself. Returns the count.
+ */
+static int64_t
+gather_sorted (const stinger_t * S, int64_t nv, int64_t etype, int64_t v, int64_t ** out, int64_t * cap)
+{
+  int64_t n = 0;
+  int64_t deg = vertex_degree (S, etype, v);
+  if (*cap < deg + 1) {
+    *cap = deg + 1;
+    *out = (int64_t *) xrealloc (*out, *cap * sizeof(int64_t));
+  }
+  int64_t * arr = *out;
 
+  /* the degree bounds the buffer if edges arrive while we read */
   if (etype == -1) {
-    source_deg = stinger_degree_get (S, source);
+    STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+      int64_t u = STINGER_EDGE_DEST;
+      if (u != v && u >= 0 && u < nv && n <= deg)
+        arr[n++] = u;
+    } STINGER_FORALL_EDGES_OF_VTX_END();
   } else {
-    source_deg = stinger_typed_degree (S, source, etype);
+    STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_BEGIN(S, etype, v) {
+      int64_t u = STINGER_EDGE_DEST;
+      if (u != v && u >= 0 && u < nv && n <= deg)
+        arr[n++] = u;
+    } STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_END();
   }
 
-  /* Initialize to NULL in case of error */
-  *candidates = output_vertices;
-  *scores = output_scores;
+  qsort (arr, n, sizeof(int64_t), compare);
 
-  /* vertex has no edges -- this is easy */
-  if (source_deg == 0) {
-    return 0;
+  int64_t m = 0;
+  for (int64_t i = 0; i < n; i++) {
+    if (m == 0 || arr[m-1] != arr[i])
+      arr[m++] = arr[i];
   }
+  return m;
+}
 
-  int64_t * source_adj = (int64_t *) xmalloc (source_deg * sizeof(int64_t));
+/*
+ * Sorted neighbors of v, from the cache if possible. The first thread to ask
+ * for a stale vertex fills its entry; others gather into their own buffer
+ * rather than wait.
+ */
+static const int64_t *
+neighbors (const stinger_t * S, stinger_adamic_adar_t * aa, int64_t v, adamic_adar_scratch * sc, int64_t * len)
+{
+  if (aa->state[v] == ADAMIC_ADAR_CACHED) {
+    *len = aa->adj_len[v];
+    return aa->adj[v];
+  }
 
-  /* extract and sort the neighborhood of SOURCE */
-  size_t res;
-  if (etype == -1) {
-    stinger_gather_neighbors (S, source, &res, source_adj, NULL, NULL, NULL, NULL, source_deg);
-    source_deg = res;
-  } else {
-    stinger_gather_typed_neighbors (S, etype, source, &res, source_adj, source_deg);
-    source_deg = res;
+  if (stinger_int64_cas (&aa->state[v], ADAMIC_ADAR_STALE, ADAMIC_ADAR_FILLING) == ADAMIC_ADAR_STALE) {
+    int64_t * arr = NULL;
+    int64_t cap = 0;
+    int64_t n = gather_sorted (S, aa->nv, aa->etype, v, &arr, &cap);
+    aa->adj[v] = arr;
+    aa->adj_len[v] = n;
+    stinger_int64_cas (&aa->state[v], ADAMIC_ADAR_FILLING, ADAMIC_ADAR_CACHED);
+    *len = n;
+    return arr;
   }
 
-  qsort (source_adj, source_deg, sizeof(int64_t), compare);
+  *len = gather_sorted (S, aa->nv, aa->etype, v, &sc->buf, &sc->buf_cap);
+  return sc->buf;
+}
 
-  /* create a marks array to unique-ify the vertex list */
-  uint64_t max_nv = S->max_nv;
-  int64_t * marks = (int64_t *) xmalloc (max_nv * sizeof(int64_t));
+void
+adamic_adar_initialize (const stinger_t * S, int64_t nv, int64_t etype, stinger_adamic_adar_t * aa)
+{
+  aa->nv = nv;
+  aa->etype = etype;
+  aa->inv_log_degree = (double *) xmalloc (nv * sizeof(double));
+  aa->state = (int64_t *) xcalloc (nv, sizeof(int64_t));
+  aa->adj = (int64_t **) xcalloc (nv, sizeof(int64_t *));
+  aa->adj_len = (int64_t *) xcalloc (nv, sizeof(int64_t));
 
-  for (int64_t i = 0; i < max_nv; i++) {
-    marks[i] = 0;
+  OMP("omp parallel for schedule(dynamic, 1024)")
+  for (int64_t v = 0; v < nv; v++) {
+    aa->inv_log_degree[v] = inv_log (vertex_degree (S, etype, v));
   }
-  marks[source] = 1;
+}
 
-  /* calculate the maximum number of vertices in the two-hop neighborhood */
-  int64_t two_hop_size = 0;
-  for (int64_t i = 0; i < source_deg; i++) {
-    int64_t v = source_adj[i];
-    int64_t v_deg;
-    if (etype == -1) {
-      v_deg = stinger_degree_get (S, v);
-    } else {
-      v_deg = stinger_typed_degree (S, v, etype);
-    }
-    marks[v] = 1;
-    two_hop_size += v_deg;
-  }
-
-  /* put everyone in the two hop neighborhood in a list (only once) */
-  int64_t head = 0;
-  int64_t * two_hop_neighborhood = (int64_t *) xmalloc (two_hop_size * sizeof(int64_t));
-
-  for (int64_t i = 0; i < source_deg; i++) {
-    int64_t v = source_adj[i];
-    if (etype == -1) {
-      STINGER_FORALL_EDGES_OF_VTX_BEGIN(S,v) {
-        if (stinger_int64_fetch_add(&marks[STINGER_EDGE_DEST], 1) == 0) {
-          int64_t loc = stinger_int64_fetch_add(&head, 1);
-          two_hop_neighborhood[loc] = STINGER_EDGE_DEST;
-        }
-      } STINGER_FORALL_EDGES_OF_VTX_END();
-    } else {
-      STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_BEGIN(S,etype,v) {
-        if (stinger_int64_fetch_add(&marks[STINGER_EDGE_DEST], 1) == 0) {
-          int64_t loc = stinger_int64_fetch_add(&head, 1);
-          two_hop_neighborhood[loc] = STINGER_EDGE_DEST;
-        }
-      } STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_END();        
+void
+adamic_adar_release (stinger_adamic_adar_t * aa)
+{
+  if (aa->adj) {
+    for (int64_t v = 0; v < aa->nv; v++) {
+      if (aa->adj[v])
+        xfree (aa->adj[v]);
     }
+    xfree (aa->inv_log_degree);
+    xfree (aa->state);
+    xfree (aa->adj);
+    xfree (aa->adj_len);
   }
+  memset (aa, 0, sizeof(stinger_adamic_adar_t));
+}
 
-  /* sanity check */
-  if (head > two_hop_size) {
-    LOG_W ("over ran the buffer");
+void
+adamic_adar_invalidate (const stinger_t * S, stinger_adamic_adar_t * aa, int64_t v)
+{
+  if (v < 0 || v >= aa->nv)
+    return;
+  if (aa->adj[v]) {
+    xfree (aa->adj[v]);
+    aa->adj[v] = NULL;
   }
-  two_hop_size = head;  // limit the computation later
+  aa->adj_len[v] = 0;
+  aa->state[v] = ADAMIC_ADAR_STALE;
+  aa->inv_log_degree[v] = inv_log (vertex_degree (S, aa->etype, v));
+}
 
-  /* Allocate output array */
-  output_vertices = (int64_t *) xmalloc (two_hop_size * sizeof(int64_t));
-  output_scores = (int64_t *) xmalloc (two_hop_size * sizeof(double));
+void
+adamic_adar_update (const stinger_t * S, stinger_adamic_adar_t * aa,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions)
+{
+  for (int64_t k = 0; k < num_insertions; k++) {
+    adamic_adar_invalidate (S, aa, insertions[k].source);
+    adamic_adar_invalidate (S, aa, insertions[k].destination);
+  }
+  for (int64_t k = 0; k < num_deletions; k++) {
+    adamic_adar_invalidate (S, aa, deletions[k].source);
+    adamic_adar_invalidate (S, aa, deletions[k].destination);
+  }
+}
 
-  /* calculate the Adamic-Adar score for each vertex in level 2 */
-  for (int64_t k = 0; k < two_hop_size; k++) {
-    double adamic_adar_score = 0.0;
-    int64_t vtx = two_hop_neighborhood[k];    
-    int64_t v_deg;
-    if (etype == -1) {
-      v_deg = stinger_degree_get (S, vtx);
-    } else {
-      v_deg = stinger_typed_degree (S, vtx, etype);
-    }
+/*
+ * Sums 1 / log(deg(w)) into every vertex two hops from source through w. The
+ * source and its neighbors are marked first so they never become candidates.
+ * Leaves the candidates in sc->touched.
+ */
+static void
+accumulate (const stinger_t * S, stinger_adamic_adar_t * aa, int64_t source, adamic_adar_scratch * sc)
+{
+  sc->stamp++;
+  sc->ntouched = 0;
+  if (source < 0 || source >= aa->nv)
+    return;
 
-    int64_t * target_adj = (int64_t *) xmalloc (v_deg * sizeof(int64_t));
-    size_t res;
-    if (etype == -1) {
-      stinger_gather_neighbors (S, vtx, &res, target_adj, NULL, NULL, NULL, NULL, v_deg);
-      v_deg = res;
-    } else {
-      stinger_gather_typed_neighbors (S, etype, vtx, &res, target_adj, v_deg);
-      v_deg = res;
-    }
-    qsort (target_adj, v_deg, sizeof(int64_t), compare);
+  int64_t slen;
+  const int64_t * sadj = neighbors (S, aa, source, sc, &slen);
 
-    int64_t i = 0, j = 0;
-    while (i < source_deg && j < v_deg)
-    {
-      if (source_adj[i] < target_adj[j]) {
-        i++;
-      }
-      else if (target_adj[j] < source_adj[i]) {
-        j++;
-      }
-      else /* if source_adj[i] == target_adj[j] */
-      {
-      	int64_t neighbor = source_adj[i];    
-        int64_t my_deg;
-        if (etype == -1) {
-          my_deg = stinger_degree_get (S, neighbor);
-        } else {
-          my_deg = stinger_typed_degree (S, neighbor, etype);
-        }
-
-        double score = 0.0;
-        if (my_deg > 1) {
-          score = 1.0 / log ((double) my_deg);
-        }
-      	adamic_adar_score += score;
-      	i++;
-      	j++;
+  /* the buffer may be reused for a neighbor, so keep a private copy */
+  int64_t * own = NULL;
+  if (sadj == sc->buf) {
+    own = (int64_t *) xmalloc ((slen + 1) * sizeof(int64_t));
+    memcpy (own, sadj, slen * sizeof(int64_t));
+    sadj = own;
+  }
+
+  int fresh;
+  sc->acc[scratch_claim (sc, source, &fresh)] = -1;
+  for (int64_t i = 0; i < slen; i++) {
+    sc->acc[scratch_claim (sc, sadj[i], &fresh)] = -1;
+  }
+
+  for (int64_t i = 0; i < slen; i++) {
+    int64_t w = sadj[i];
+    double score = aa->inv_log_degree[w];
+    int64_t wlen;
+    const int64_t * wadj = neighbors (S, aa, w, sc, &wlen);
+    for (int64_t j = 0; j < wlen; j++) {
+      int64_t x = wadj[j];
+      int64_t slot = scratch_claim (sc, x, &fresh);
+      if (fresh) {
+        sc->acc[slot] = score;
+        scratch_touch (sc, x);
+      } else if (sc->acc[slot] >= 0) {
+        sc->acc[slot] += score;
       }
     }
+  }
 
-    free (target_adj);
+  if (own)
+    xfree (own);
+}
+
+/* true if (s1, v1) ranks below (s2, v2) */
+static inline int
+ranks_below (double s1, int64_t v1, double s2, int64_t v2)
+{
+  return s1 < s2 || (s1 == s2 && v1 > v2);
+}
 
-    output_vertices[k] = vtx;
-    output_scores[k] = adamic_adar_score;
+/* min-heap on rank: the weakest of the k kept so far is at the root */
+static void
+heap_sift_down (int64_t * hv, double * hs, int64_t n, int64_t i)
+{
+  while (1) {
+    int64_t l = 2 * i + 1, r = l + 1, m = i;
+    if (l < n && ranks_below (hs[l], hv[l], hs[m], hv[m])) m = l;
+    if (r < n && ranks_below (hs[r], hv[r], hs[m], hv[m])) m = r;
+    if (m == i)
+      return;
+    int64_t tv = hv[i]; hv[i] = hv[m]; hv[m] = tv;
+    double ts = hs[i]; hs[i] = hs[m]; hs[m] = ts;
+    i = m;
   }
+}
 
-  /* Set output arrays */
-  *candidates = output_vertices;
-  *scores = output_scores;
+static void
+heap_sift_up (int64_t * hv, double * hs, int64_t i)
+{
+  while (i > 0) {
+    int64_t p = (i - 1) / 2;
+    if (!ranks_below (hs[i], hv[i], hs[p], hv[p]))
+      return;
+    int64_t tv = hv[i]; hv[i] = hv[p]; hv[p] = tv;
+    double ts = hs[i]; hs[i] = hs[p]; hs[p] = ts;
+    i = p;
+  }
+}
 
-  /* done with computation, free memory */
-  free (source_adj);
-  free (marks);
-  free (two_hop_neighborhood);
-  return two_hop_size;
-}
\ No newline at end of file
+/*
+ * Selects the best k of the accumulated candidates into out_v / out_s, best
+ * first. Returns the number written.
+ */
+static int64_t
+select_top_k (const adamic_adar_scratch * sc, int64_t k, int64_t * out_v, double * out_s)
+{
+  int64_t n = 0;
+  for (int64_t i = 0; i < sc->ntouched; i++) {
+    int64_t x = sc->touched[i];
+    double s = sc->acc[scratch_slot (sc, x)];
+    if (n < k) {
+      out_v[n] = x;
+      out_s[n] = s;
+      heap_sift_up (out_v, out_s, n);
+      n++;
+    } else if (ranks_below (out_s[0], out_v[0], s, x)) {
+      out_v[0] = x;
+      out_s[0] = s;
+      heap_sift_down (out_v, out_s, n, 0);
+    }
+  }
+
+  /* heap sort: popping the weakest to the back leaves the best first */
+  for (int64_t end = n - 1; end > 0; end--) {
+    int64_t tv = out_v[0]; out_v[0] = out_v[end]; out_v[end] = tv;
+    double ts = out_s[0]; out_s[0] = out_s[end]; out_s[end] = ts;
+    heap_sift_down (out_v, out_s, end, 0);
+  }
+  return n;
+}
+
+int64_t
+adamic_adar_top_k (const stinger_t * S, stinger_adamic_adar_t * aa, int64_t source, int64_t k,
+  int64_t ** candidates, double ** scores)
+{
+  if (*candidates != NULL || *scores != NULL) {
+    LOG_E("Adamic Adar output arrays should not be allocated before call.  Possible memory leak.");
+  }
+  *candidates = NULL;
+  *scores = NULL;
+
+  /* sized from the source's degree and grown as candidates turn up */
+  adamic_adar_scratch sc;
+  int64_t deg = (source >= 0 && source < aa->nv) ? vertex_degree (S, aa->etype, source) : 0;
+  scratch_init_hashed (&sc, 4 * (deg + 1));
+  accumulate (S, aa, source, &sc);
+
+  int64_t n = sc.ntouched;
+  if (k > 0 && k < n)
+    n = k;
+  if (n > 0) {
+    *candidates = (int64_t *) xmalloc (n * sizeof(int64_t));
+    *scores = (double *) xmalloc (n * sizeof(double));
+    n = select_top_k (&sc, n, *candidates, *scores);
+  }
+
+  scratch_release (&sc);
+  return n;
+}
+
+void
+adamic_adar_top_k_batch (const stinger_t * S, stinger_adamic_adar_t * aa,
+  const int64_t * sources, int64_t num_sources, int64_t k,
+  int64_t * candidates, double * scores, int64_t * counts)
+{
+  OMP("omp parallel")
+  {
+    adamic_adar_scratch sc;
+    scratch_init (&sc, aa->nv);
+
+    OMP("omp for schedule(dynamic, 1)")
+    for (int64_t i = 0; i < num_sources; i++) {
+      accumulate (S, aa, sources[i], &sc);
+      counts[i] = select_top_k (&sc, k, candidates + i * k, scores + i * k);
+    }
+
+    scratch_release (&sc);
+  }
+}
+
+/*
+ *  Adamic Adar
+ *
+ *  This implementation treats the input graph as undirected.  Directed edges in the graph are treated as undirected
+ *  when performing the analysis.  This is to account for the fact that Adamic Adar is only defined for an undirected
+ *  graph.  Returns every candidate; callers with repeated queries should keep a stinger_adamic_adar_t instead.
+ */
+int64_t adamic_adar(const stinger_t * S, int64_t source, int64_t etype, int64_t ** candidates, double ** scores) {
+  stinger_adamic_adar_t aa;
+  adamic_adar_initialize (S, S->max_nv, etype, &aa);
+  int64_t n = adamic_adar_top_k (S, &aa, source, 0, candidates, scores);
+  adamic_adar_release (&aa);
+  return n;
+}
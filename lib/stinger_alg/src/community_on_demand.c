@@ -1,5 +1,5 @@
 #include "community_on_demand.h"
-#include "modularity.h"
+#include "louvain.h"
 #include "stinger_core/stinger_error.h"
 
 /*
@@ -7,6 +7,11 @@
  *
  */
 int64_t community_on_demand(const stinger_t * S, int64_t ** vertices, int64_t ** partitions) {
+  return community_on_demand_louvain(S, vertices, partitions, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS);
+}
+
+int64_t community_on_demand_louvain(const stinger_t * S, int64_t ** vertices, int64_t ** partitions,
+    int64_t max_levels, int64_t max_iterations) {
   if (*vertices != NULL || *partitions != NULL) {
     LOG_E("Community on demand output arrays should not be allocated before call.  Possible memory leak.");
   }
@@ -29,8 +34,7 @@ int64_t community_on_demand(const stinger_t * S, int64_t ** vertices, int64_t **
       output_vertices[v] = v;
   }
 
-  /* Note wiring of max iterations to 5 */
-  community_detection(S, nv, output_partitions, (int64_t) 5);
+  louvain_communities((stinger_t *) S, nv, output_partitions, max_levels, max_iterations, NULL);
 
   /* Set output arrays */
   *vertices = output_vertices;
@@ -3,6 +3,10 @@
 //
 #include "diameter.h"
 #include "shortest_paths.h"
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 /**
  * this algorithm gives an approximation of the graph diameter.
  * It works by starting from a source vertex, and finds an end vertex that is farthest away
@@ -21,7 +25,7 @@ pseudo_diameter(stinger_t * S,int64_t NV , int64_t source, int64_t dist, bool ig
     std::vector<int64_t> paths(NV);
     while(1){
         int64_t new_source = target;
-        paths = dijkstra(S, NV, new_source, ignore_weights);
+        paths = delta_stepping(S, NV, new_source, ignore_weights, 0);
         int64_t max = std::numeric_limits<int64_t>::min();
         int64_t max_index = 0;
         for( int64_t i = 0; i< NV; i++){
@@ -43,21 +47,254 @@ pseudo_diameter(stinger_t * S,int64_t NV , int64_t source, int64_t dist, bool ig
 }
 /**
  * this algorithm gives an exact diameter for the graph.
- * It runs Dijkstras for every vertex in the graph, and returns the maximum shortest path
+ * It runs a shortest path search from every vertex in the graph, and returns the maximum shortest path
+ * The searches are batched so only a block of distance rows is held in memory at a time
  * Inputs: S- the graph itself, nv - the total number of active verticies in the graph
+ * bounds - if not NULL receives the result and whether it is complete, progress - if not NULL is
+ * called after every block of searches and may stop the computation
 */
+int64_t
+exact_diameter(stinger_t * S, int64_t NV, diameter_bounds_t * bounds, diameter_progress_fn progress, void * arg){
+    const int64_t inf = std::numeric_limits<int64_t>::max();
+    int64_t max = 0;
+    int64_t delta = delta_stepping_default_delta(S, NV, false);
+    int64_t block = 256;
+    int64_t searched = 0;
+    bool complete = true;
+
+    std::vector<int64_t> sources;
+    for (int64_t first = 0; first < NV; first += block){
+        int64_t last = std::min(first + block, NV);
+        sources.clear();
+        for (int64_t v = first; v < last; v++){
+            sources.push_back(v);
+        }
+
+        std::vector<std::vector <int64_t> > rows = multi_source_shortest_paths(S, NV, sources, false, delta);
+        for (size_t i = 0; i < rows.size(); i++){
+            for (int64_t j = 0; j < NV; j++){
+                if (rows[i][j] > max and rows[i][j] != inf){
+                    max = rows[i][j];
+                }
+            }
+        }
+
+        searched = last;
+        if (progress && last < NV && !progress(arg, max, -1, searched)){
+            complete = false;
+            break;
+        }
+    }
+
+    if (bounds){
+        bounds->lower = max;
+        bounds->upper = complete ? max : -1;
+        bounds->searches = searched;
+        bounds->complete = complete;
+    }
+    return max;
+}
 
 int64_t
 exact_diameter(stinger_t * S, int64_t NV){
-    std::vector<std::vector <int64_t> > all_pairs (NV, std::vector<int64_t>(NV));
-    all_pairs = all_pairs_dijkstra(S, NV);
-    int64_t max = std::numeric_limits<int64_t>::min();
-    for( int64_t i = 0; i< NV; i++){
-        for (int64_t j = 0; j < NV; j++){
-            if (all_pairs[i][j] > max and all_pairs[i][j] != std::numeric_limits<int64_t>::max()){
-                max = all_pairs[i][j];
+    return exact_diameter(S, NV, NULL, NULL, NULL);
+}
+
+//state shared by the searches of one ifub_diameter call
+typedef struct {
+    stinger_t * S;
+    int64_t NV;
+    diameter_progress_fn progress;
+    void * arg;
+    int64_t lower;
+    int64_t searches;
+    int64_t cancelled;
+    std::vector<std::vector<int64_t> > dist;   //per thread scratch, -1 between searches
+    std::vector<std::vector<int64_t> > queue;
+} ifub_state_t;
+
+//Eccentricity of v in the undirected view, from the scratch of the calling thread
+static int64_t
+ifub_eccentricity(ifub_state_t & st, int64_t v, int64_t * farthest){
+    int t = 0;
+#if defined(_OPENMP)
+    t = omp_get_thread_num();
+#endif
+    if (st.dist[t].empty()){
+        st.dist[t].assign(st.NV, -1);
+        st.queue[t].resize(st.NV);
+    }
+    int64_t * dist = &st.dist[t][0];
+    int64_t * queue = &st.queue[t][0];
+
+    int64_t reached = hop_distances(st.S, st.NV, v, true, dist, queue);
+    int64_t last = queue[reached - 1];
+    int64_t ecc = dist[last];
+    for (int64_t k = 0; k < reached; k++){
+        dist[queue[k]] = -1;
+    }
+    if (farthest){
+        *farthest = last;
+    }
+    return ecc;
+}
+
+//Records a finished search and asks the caller whether to go on
+static void
+ifub_report(ifub_state_t & st, int64_t ecc, int64_t upper){
+    OMP("omp critical")
+    {
+        st.searches++;
+        if (ecc > st.lower){
+            st.lower = ecc;
+        }
+        if (st.progress && !st.cancelled &&
+            !st.progress(st.arg, st.lower, std::max(st.lower, upper), st.searches)){
+            st.cancelled = 1;
+        }
+    }
+}
+
+/**
+ * Exact diameter of the undirected, unweighted view of the graph (the largest eccentricity inside
+ * any connected component) by iFUB, "On computing the diameter of real-world undirected graphs",
+ * P. Crescenzi, R. Grossi, M. Habib, L. Lanzi, A. Marino, Theoretical Computer Science 2013.
+ *
+ * In each component, a double sweep from its highest-degree vertex gives a lower bound and picks
+ * the middle of a long path as the root r. Vertices are then taken by decreasing distance i from
+ * r: the eccentricities in level i raise the lower bound, and every vertex farther than 2(i-1)
+ * from any other must lie at level i or beyond, so 2(i-1) becomes the upper bound. The searches
+ * of a level run in parallel, one per thread. Components are taken largest first and skipped once
+ * their size cannot beat the lower bound, so on most real graphs only a handful of searches run.
+ *
+ * Inputs: S- the graph itself, NV - vertices below NV are considered, bounds - if not NULL
+ * receives the bounds reached, progress - if not NULL is called after every search and may stop
+ * the computation. Returns the diameter, or the lower bound if stopped early.
+ */
+int64_t
+ifub_diameter(stinger_t * S, int64_t NV, diameter_bounds_t * bounds, diameter_progress_fn progress, void * arg){
+    int64_t num_threads = 1;
+#if defined(_OPENMP)
+    num_threads = omp_get_max_threads();
+#endif
+
+    ifub_state_t st;
+    st.S = S;
+    st.NV = NV;
+    st.progress = progress;
+    st.arg = arg;
+    st.lower = 0;
+    st.searches = 0;
+    st.cancelled = 0;
+    st.dist.resize(num_threads);
+    st.queue.resize(num_threads);
+
+    std::vector<int64_t> dist(NV, -1), queue(NV);
+    std::vector<int64_t> dist2(NV, -1), queue2(NV);
+
+    //connected components of the undirected view, as (size, offset into members)
+    std::vector<int64_t> members;
+    std::vector<std::pair<int64_t, int64_t> > comps;
+    std::vector<uint8_t> seen(NV, 0);
+    for (int64_t v = 0; v < NV; v++){
+        if (seen[v] || stinger_outdegree_get(S, v) + stinger_indegree_get(S, v) == 0){
+            continue;
+        }
+        int64_t reached = hop_distances(S, NV, v, true, &dist[0], &queue[0]);
+        comps.push_back(std::make_pair(reached, (int64_t)members.size()));
+        for (int64_t k = 0; k < reached; k++){
+            seen[queue[k]] = 1;
+            dist[queue[k]] = -1;
+            members.push_back(queue[k]);
+        }
+    }
+    std::sort(comps.begin(), comps.end(), std::greater<std::pair<int64_t, int64_t> >());
+
+    int64_t upper = 0;    //bound on everything not searched yet
+    for (size_t c = 0; c < comps.size() && !st.cancelled; c++){
+        int64_t size = comps[c].first;
+        const int64_t * comp = &members[comps[c].second];
+        //sorted by size, so nothing from here on is longer than this component allows
+        upper = size - 1;
+        if (upper <= st.lower){
+            break;
+        }
+        int64_t rest = c + 1 < comps.size() ? comps[c + 1].first - 1 : 0;
+
+        //double sweep from the highest-degree vertex
+        int64_t u = comp[0];
+        for (int64_t k = 1; k < size; k++){
+            if (stinger_outdegree_get(S, comp[k]) + stinger_indegree_get(S, comp[k]) >
+                stinger_outdegree_get(S, u) + stinger_indegree_get(S, u)){
+                u = comp[k];
+            }
+        }
+        int64_t a;
+        ifub_report(st, ifub_eccentricity(st, u, &a), upper);
+        int64_t reached = hop_distances(S, NV, a, true, &dist[0], &queue[0]);
+        int64_t b = queue[reached - 1];
+        int64_t d = dist[b];
+        ifub_report(st, d, upper);
+
+        //the root is the middle of the path between a and b
+        int64_t reached2 = hop_distances(S, NV, b, true, &dist2[0], &queue2[0]);
+        int64_t r = b;
+        for (int64_t k = 0; k < reached2; k++){
+            int64_t x = queue2[k];
+            if (dist[x] == d / 2 && dist[x] + dist2[x] == d){
+                r = x;
+                break;
             }
         }
+        ifub_report(st, dist2[queue2[reached2 - 1]], upper);
+        for (int64_t k = 0; k < reached; k++) dist[queue[k]] = -1;
+        for (int64_t k = 0; k < reached2; k++) dist2[queue2[k]] = -1;
+        if (st.cancelled){
+            break;
+        }
+
+        //levels of the search from the root, farthest last
+        reached = hop_distances(S, NV, r, true, &dist[0], &queue[0]);
+        int64_t i = dist[queue[reached - 1]];
+        int64_t comp_upper = std::min(size - 1, 2 * i);
+        upper = std::max(comp_upper, rest);
+        ifub_report(st, i, upper);
+
+        int64_t end = reached;
+        while (comp_upper > st.lower && !st.cancelled){
+            int64_t begin = end;
+            while (begin > 0 && dist[queue[begin - 1]] == i){
+                begin--;
+            }
+
+            OMP("omp parallel for schedule(dynamic, 1)")
+            for (int64_t k = begin; k < end; k++){
+                if (!st.cancelled){
+                    ifub_report(st, ifub_eccentricity(st, queue[k], NULL), upper);
+                }
+            }
+            if (st.cancelled){
+                break;
+            }
+
+            //any pair left lies within i - 1 of the root
+            i--;
+            end = begin;
+            comp_upper = 2 * i;
+            upper = std::max(comp_upper, rest);
+        }
+        for (int64_t k = 0; k < reached; k++) dist[queue[k]] = -1;
+        if (!st.cancelled){
+            upper = rest;
+        }
     }
-    return max;
-}
\ No newline at end of file
+
+    bool complete = !st.cancelled;
+    if (bounds){
+        bounds->lower = st.lower;
+        bounds->upper = complete ? st.lower : std::max(st.lower, upper);
+        bounds->searches = st.searches;
+        bounds->complete = complete;
+    }
+    return st.lower;
+}
@@ -0,0 +1,427 @@
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
+#include "edge_map.h"
+
+/* Ligra's switch: pull once the frontier touches a twentieth of the edges */
+#define EDGE_MAP_DENSE_DIVISOR 20
+
+/* Visits the edges of VTX_ in the given STINGER_EDGE_DIRECTION bits, of type
+ * ETYPE_ or of any type when ETYPE_ is negative */
+#define EDGE_MAP_FORALL_EDGES_OF_VTX_BEGIN(S_,VTX_,DIR_,ETYPE_) \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_BEGIN(S_,VTX_,if (STINGER_EDGE_DIRECTION & (DIR_)),if ((ETYPE_) < 0 || STINGER_EDGE_TYPE == (ETYPE_)),)
+#define EDGE_MAP_FORALL_EDGES_OF_VTX_END() \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_END()
+
+/* The same over the out-edges in the window [T0_, T1_] */
+#define EDGE_MAP_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S_,VTX_,ETYPE_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_BEGIN(S_,VTX_,if (STINGER_EDGE_IN_WINDOW(T0_,T1_)), \
+    if (((ETYPE_) < 0 || STINGER_EDGE_TYPE == (ETYPE_)) && STINGER_EB_IN_WINDOW(T0_,T1_)),)
+
+void
+vertex_subset_init(vertex_subset_t * vs, int64_t nv)
+{
+  memset(vs, 0, sizeof(vertex_subset_t));
+  vs->nv = nv;
+}
+
+void
+vertex_subset_release(vertex_subset_t * vs)
+{
+  if (vs->sparse)
+    xfree(vs->sparse);
+  if (vs->dense)
+    xfree(vs->dense);
+  memset(vs, 0, sizeof(vertex_subset_t));
+}
+
+static void
+vertex_subset_reserve_sparse(vertex_subset_t * vs)
+{
+  if (!vs->sparse)
+    vs->sparse = (int64_t *)xmalloc((vs->nv + 1) * sizeof(int64_t));
+}
+
+static void
+vertex_subset_reserve_dense(vertex_subset_t * vs)
+{
+  if (!vs->dense)
+    vs->dense = (uint8_t *)xmalloc((vs->nv + 1) * sizeof(uint8_t));
+}
+
+void
+vertex_subset_clear(vertex_subset_t * vs)
+{
+  vertex_subset_reserve_sparse(vs);
+  vs->is_dense = 0;
+  vs->size = 0;
+}
+
+void
+vertex_subset_from_vertex(vertex_subset_t * vs, int64_t v)
+{
+  vertex_subset_clear(vs);
+  if (v >= 0 && v < vs->nv)
+    vs->sparse[vs->size++] = v;
+}
+
+void
+vertex_subset_all(vertex_subset_t * vs)
+{
+  vertex_subset_reserve_dense(vs);
+  memset(vs->dense, 1, vs->nv * sizeof(uint8_t));
+  vs->is_dense = 1;
+  vs->size = vs->nv;
+}
+
+void
+vertex_subset_to_dense(vertex_subset_t * vs)
+{
+  if (vs->is_dense)
+    return;
+  vertex_subset_reserve_dense(vs);
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < vs->nv; v++) {
+    vs->dense[v] = 0;
+  }
+  OMP("omp parallel for")
+  for (int64_t i = 0; i < vs->size; i++) {
+    vs->dense[vs->sparse[i]] = 1;
+  }
+  vs->is_dense = 1;
+}
+
+void
+vertex_subset_to_sparse(vertex_subset_t * vs)
+{
+  if (!vs->is_dense)
+    return;
+  vertex_subset_reserve_sparse(vs);
+
+  /* the list comes out in no particular order */
+  int64_t size = 0;
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < vs->nv; v++) {
+    if (vs->dense[v])
+      vs->sparse[stinger_int64_fetch_add(&size, 1)] = v;
+  }
+  vs->size = size;
+  vs->is_dense = 0;
+}
+
+int
+vertex_subset_contains(const vertex_subset_t * vs, int64_t v)
+{
+  if (v < 0 || v >= vs->nv)
+    return 0;
+  if (vs->is_dense)
+    return vs->dense[v] != 0;
+  for (int64_t i = 0; i < vs->size; i++) {
+    if (vs->sparse[i] == v)
+      return 1;
+  }
+  return 0;
+}
+
+void
+edge_map_graph_init(edge_map_graph_t * G, stinger_t * S, int64_t nv, int64_t etype)
+{
+  G->S = S;
+  G->nv = nv;
+  G->etype = etype;
+  G->stamp = 0;
+  G->windowed = 0;
+  G->t0 = INT64_MIN;
+  G->t1 = INT64_MAX;
+  G->mark = (int64_t *)xcalloc(nv + 1, sizeof(int64_t));
+
+  int64_t ne = 0;
+  if (etype < 0) {
+    ne = stinger_edges_up_to(S, nv);
+  } else {
+    OMP("omp parallel for reduction(+:ne)")
+    for (int64_t v = 0; v < nv; v++) {
+      ne += stinger_typed_outdegree(S, v, etype);
+    }
+  }
+  G->ne = ne;
+}
+
+void
+edge_map_graph_release(edge_map_graph_t * G)
+{
+  if (G->mark)
+    xfree(G->mark);
+  memset(G, 0, sizeof(edge_map_graph_t));
+}
+
+void
+edge_map_graph_set_window(edge_map_graph_t * G, int64_t t0, int64_t t1)
+{
+  G->windowed = 1;
+  G->t0 = t0;
+  G->t1 = t1;
+}
+
+/* Frontier size plus the (untyped) degrees of its members */
+static int64_t
+edge_map_frontier_work(edge_map_graph_t * G, vertex_subset_t * frontier, int undirected)
+{
+  stinger_t * S = G->S;
+  int64_t work = frontier->size;
+
+  if (frontier->is_dense) {
+    OMP("omp parallel for reduction(+:work)")
+    for (int64_t v = 0; v < G->nv; v++) {
+      if (frontier->dense[v])
+        work += undirected ? stinger_degree_get(S, v) : stinger_outdegree_get(S, v);
+    }
+  } else {
+    OMP("omp parallel for reduction(+:work)")
+    for (int64_t i = 0; i < frontier->size; i++) {
+      int64_t v = frontier->sparse[i];
+      work += undirected ? stinger_degree_get(S, v) : stinger_outdegree_get(S, v);
+    }
+  }
+
+  return work;
+}
+
+static inline void
+edge_map_push_edge(edge_map_graph_t * G, int64_t src, int64_t dst, int64_t weight,
+  const edge_map_ops_t * ops, void * arg, vertex_subset_t * out, int64_t stamp, int64_t * size)
+{
+  if (dst >= 0 && dst < G->nv && (!ops->cond || ops->cond(dst, arg)) &&
+      ops->update_atomic(src, dst, weight, arg) && out) {
+    /* an update can succeed for dst more than once; list it only once */
+    int64_t old = G->mark[dst];
+    if (old != stamp && stinger_int64_cas(&G->mark[dst], old, stamp) == old)
+      out->sparse[stinger_int64_fetch_add(size, 1)] = dst;
+  }
+}
+
+static int64_t
+edge_map_sparse(edge_map_graph_t * G, vertex_subset_t * frontier, const edge_map_ops_t * ops, void * arg,
+  vertex_subset_t * out, int flags)
+{
+  stinger_t * S = G->S;
+  int64_t etype = G->etype;
+  int64_t dir = (flags & EDGE_MAP_UNDIRECTED) ? STINGER_EDGE_DIRECTION_MASK : STINGER_EDGE_DIRECTION_OUT;
+  int output = !(flags & EDGE_MAP_NO_OUTPUT);
+  int64_t stamp = ++G->stamp;
+  int64_t size = 0;
+
+  if (output)
+    vertex_subset_clear(out);
+  else
+    out = NULL;
+
+  OMP("omp parallel for schedule(dynamic, 64)")
+  for (int64_t i = 0; i < frontier->size; i++) {
+    int64_t src = frontier->sparse[i];
+    if (G->windowed) {
+      EDGE_MAP_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S, src, etype, G->t0, G->t1) {
+        edge_map_push_edge(G, src, STINGER_EDGE_DEST, STINGER_EDGE_WEIGHT, ops, arg, out, stamp, &size);
+      } EDGE_MAP_FORALL_EDGES_OF_VTX_END();
+    } else {
+      EDGE_MAP_FORALL_EDGES_OF_VTX_BEGIN(S, src, dir, etype) {
+        edge_map_push_edge(G, src, STINGER_EDGE_DEST, STINGER_EDGE_WEIGHT, ops, arg, out, stamp, &size);
+      } EDGE_MAP_FORALL_EDGES_OF_VTX_END();
+    }
+  }
+
+  if (output)
+    out->size = size;
+  return size;
+}
+
+static int64_t
+edge_map_dense(edge_map_graph_t * G, vertex_subset_t * frontier, const edge_map_ops_t * ops, void * arg,
+  vertex_subset_t * out, int flags)
+{
+  stinger_t * S = G->S;
+  int64_t nv = G->nv;
+  int64_t etype = G->etype;
+  int64_t dir = (flags & EDGE_MAP_UNDIRECTED) ? STINGER_EDGE_DIRECTION_MASK : STINGER_EDGE_DIRECTION_IN;
+  edge_map_update_fn update = ops->update ? ops->update : ops->update_atomic;
+  uint8_t * in = frontier->dense;
+  uint8_t * next = NULL;
+  int64_t size = 0;
+
+  if (!(flags & EDGE_MAP_NO_OUTPUT)) {
+    vertex_subset_reserve_dense(out);
+    out->is_dense = 1;
+    next = out->dense;
+  }
+
+  OMP("omp parallel for schedule(dynamic, 256) reduction(+:size)")
+  for (int64_t dst = 0; dst < nv; dst++) {
+    int active = !ops->cond || ops->cond(dst, arg);
+    int added = 0;
+    if (active) {
+      EDGE_MAP_FORALL_EDGES_OF_VTX_BEGIN(S, dst, dir, etype) {
+        int64_t src = STINGER_EDGE_DEST;
+        if (active && src >= 0 && src < nv && in[src]) {
+          added |= update(src, dst, STINGER_EDGE_WEIGHT, arg);
+          active = !ops->cond || ops->cond(dst, arg);
+        }
+      } EDGE_MAP_FORALL_EDGES_OF_VTX_END();
+    }
+    if (next)
+      next[dst] = added != 0;
+    size += added != 0;
+  }
+
+  if (next)
+    out->size = size;
+  return size;
+}
+
+static inline void
+edge_map_forward_arc(int64_t src, int64_t dst, int64_t weight, const uint8_t * in, uint8_t * next,
+  const edge_map_ops_t * ops, void * arg)
+{
+  if (in[src] && (!ops->cond || ops->cond(dst, arg)) &&
+      ops->update_atomic(src, dst, weight, arg) && next && !next[dst])
+    next[dst] = 1;
+}
+
+static inline void
+edge_map_forward_edge(int64_t nv, int64_t src, int64_t dst, int64_t weight, int undirected,
+  const uint8_t * in, uint8_t * next, const edge_map_ops_t * ops, void * arg)
+{
+  if (src >= 0 && src < nv && dst >= 0 && dst < nv) {
+    edge_map_forward_arc(src, dst, weight, in, next, ops, arg);
+    if (undirected)
+      edge_map_forward_arc(dst, src, weight, in, next, ops, arg);
+  }
+}
+
+static int64_t
+edge_map_dense_forward(edge_map_graph_t * G, vertex_subset_t * frontier, const edge_map_ops_t * ops, void * arg,
+  vertex_subset_t * out, int flags)
+{
+  stinger_t * S = G->S;
+  int64_t nv = G->nv;
+  int undirected = (flags & EDGE_MAP_UNDIRECTED) != 0;
+  uint8_t * in = frontier->dense;
+  uint8_t * next = NULL;
+  int64_t size = 0;
+
+  if (!(flags & EDGE_MAP_NO_OUTPUT)) {
+    vertex_subset_reserve_dense(out);
+    memset(out->dense, 0, nv * sizeof(uint8_t));
+    out->is_dense = 1;
+    next = out->dense;
+  }
+
+  /* one pass over the edge blocks of each type, which spreads the work
+   * evenly however skewed the degrees are */
+  int64_t first_type = G->etype < 0 ? 0 : G->etype;
+  int64_t last_type = G->etype < 0 ? stinger_max_num_etypes(S) - 1 : G->etype;
+  for (int64_t type = first_type; type <= last_type; type++) {
+    if (G->windowed) {
+      STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_BEGIN(S, type, G->t0, G->t1) {
+        edge_map_forward_edge(nv, STINGER_EDGE_SOURCE, STINGER_EDGE_DEST, STINGER_EDGE_WEIGHT, undirected, in, next, ops, arg);
+      } STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_END();
+    } else {
+      STINGER_PARALLEL_FORALL_EDGES_BEGIN(S, type) {
+        edge_map_forward_edge(nv, STINGER_EDGE_SOURCE, STINGER_EDGE_DEST, STINGER_EDGE_WEIGHT, undirected, in, next, ops, arg);
+      } STINGER_PARALLEL_FORALL_EDGES_END();
+    }
+  }
+
+  if (next) {
+    OMP("omp parallel for reduction(+:size)")
+    for (int64_t v = 0; v < nv; v++) {
+      size += next[v];
+    }
+    out->size = size;
+  }
+  return size;
+}
+
+int64_t
+edge_map(edge_map_graph_t * G, vertex_subset_t * frontier, const edge_map_ops_t * ops, void * arg,
+  vertex_subset_t * out, int flags)
+{
+  if (!out)
+    flags |= EDGE_MAP_NO_OUTPUT;
+
+  if (frontier->size == 0) {
+    if (!(flags & EDGE_MAP_NO_OUTPUT))
+      vertex_subset_clear(out);
+    return 0;
+  }
+
+  int dense;
+  if (flags & EDGE_MAP_SPARSE) {
+    dense = 0;
+  } else if (flags & EDGE_MAP_DENSE) {
+    dense = 1;
+  } else {
+    int undirected = (flags & EDGE_MAP_UNDIRECTED) != 0;
+    int64_t threshold = (undirected ? 2 * G->ne : G->ne) / EDGE_MAP_DENSE_DIVISOR;
+    dense = edge_map_frontier_work(G, frontier, undirected) > threshold;
+  }
+
+  /* windowed in-edges cannot be followed, so those rounds sweep instead */
+  if (G->windowed && (flags & EDGE_MAP_UNDIRECTED)) {
+    dense = 1;
+    flags |= EDGE_MAP_DENSE_FORWARD;
+  }
+
+  if (dense) {
+    vertex_subset_to_dense(frontier);
+    if ((flags & EDGE_MAP_DENSE_FORWARD) || G->windowed)
+      return edge_map_dense_forward(G, frontier, ops, arg, out, flags);
+    return edge_map_dense(G, frontier, ops, arg, out, flags);
+  } else {
+    vertex_subset_to_sparse(frontier);
+    return edge_map_sparse(G, frontier, ops, arg, out, flags);
+  }
+}
+
+int64_t
+vertex_map(vertex_subset_t * vs, vertex_map_fn fn, void * arg, vertex_subset_t * out)
+{
+  int64_t size = 0;
+
+  if (!out) {
+    if (vs->is_dense) {
+      OMP("omp parallel for")
+      for (int64_t v = 0; v < vs->nv; v++) {
+        if (vs->dense[v])
+          fn(v, arg);
+      }
+    } else {
+      OMP("omp parallel for")
+      for (int64_t i = 0; i < vs->size; i++) {
+        fn(vs->sparse[i], arg);
+      }
+    }
+    return vs->size;
+  }
+
+  if (vs->is_dense) {
+    vertex_subset_reserve_dense(out);
+    OMP("omp parallel for reduction(+:size)")
+    for (int64_t v = 0; v < vs->nv; v++) {
+      out->dense[v] = vs->dense[v] && fn(v, arg);
+      size += out->dense[v];
+    }
+    out->is_dense = 1;
+  } else {
+    vertex_subset_reserve_sparse(out);
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < vs->size; i++) {
+      int64_t v = vs->sparse[i];
+      if (fn(v, arg))
+        out->sparse[stinger_int64_fetch_add(&size, 1)] = v;
+    }
+    out->is_dense = 0;
+  }
+  out->size = size;
+  return size;
+}
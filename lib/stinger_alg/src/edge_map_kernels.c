@@ -0,0 +1,285 @@
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
+#include "edge_map.h"
+
+/* Breadth-first search */
+
+typedef struct {
+  int64_t * level;
+  int64_t   round;
+} bfs_edge_map_arg;
+
+static int
+bfs_cond(int64_t v, void * arg)
+{
+  return ((bfs_edge_map_arg *)arg)->level[v] < 0;
+}
+
+static int
+bfs_update(int64_t src, int64_t dst, int64_t weight, void * arg)
+{
+  bfs_edge_map_arg * a = (bfs_edge_map_arg *)arg;
+  a->level[dst] = a->round;
+  return 1;
+}
+
+static int
+bfs_update_atomic(int64_t src, int64_t dst, int64_t weight, void * arg)
+{
+  bfs_edge_map_arg * a = (bfs_edge_map_arg *)arg;
+  return stinger_int64_cas(&a->level[dst], -1, a->round) == -1;
+}
+
+static int64_t
+bfs_run(edge_map_graph_t * G, int64_t source, int64_t * level)
+{
+  const edge_map_ops_t ops = { bfs_update, bfs_update_atomic, bfs_cond };
+  bfs_edge_map_arg arg = { level, 0 };
+  int64_t nv = G->nv;
+  vertex_subset_t frontier, next;
+  int64_t reached = 0;
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    level[v] = -1;
+  }
+  if (source < 0 || source >= nv)
+    return 0;
+
+  vertex_subset_init(&frontier, nv);
+  vertex_subset_init(&next, nv);
+
+  level[source] = 0;
+  vertex_subset_from_vertex(&frontier, source);
+  while (frontier.size > 0) {
+    reached += frontier.size;
+    arg.round++;
+    edge_map(G, &frontier, &ops, &arg, &next, 0);
+    vertex_subset_t tmp = frontier; frontier = next; next = tmp;
+  }
+
+  vertex_subset_release(&frontier);
+  vertex_subset_release(&next);
+  return reached;
+}
+
+int64_t
+bfs_edge_map(stinger_t * S, int64_t nv, int64_t source, int64_t * level)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  int64_t reached = bfs_run(&G, source, level);
+  edge_map_graph_release(&G);
+  return reached;
+}
+
+int64_t
+bfs_edge_map_window(stinger_t * S, int64_t nv, int64_t source, int64_t t0, int64_t t1, int64_t * level)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  edge_map_graph_set_window(&G, t0, t1);
+  int64_t reached = bfs_run(&G, source, level);
+  edge_map_graph_release(&G);
+  return reached;
+}
+
+/* Connected components by minimum label propagation */
+
+static int
+cc_update_atomic(int64_t src, int64_t dst, int64_t weight, void * arg)
+{
+  int64_t * label = (int64_t *)arg;
+  int64_t mine = label[src];
+  int64_t old = label[dst];
+  while (mine < old) {
+    int64_t seen = stinger_int64_cas(&label[dst], old, mine);
+    if (seen == old)
+      return 1;
+    old = seen;
+  }
+  return 0;
+}
+
+static int64_t
+cc_run(edge_map_graph_t * G, int64_t * component_map)
+{
+  const edge_map_ops_t ops = { NULL, cc_update_atomic, NULL };
+  int64_t nv = G->nv;
+  vertex_subset_t frontier, next;
+  int64_t count = 0;
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    component_map[v] = v;
+  }
+
+  vertex_subset_init(&frontier, nv);
+  vertex_subset_init(&next, nv);
+
+  vertex_subset_all(&frontier);
+  while (frontier.size > 0) {
+    edge_map(G, &frontier, &ops, component_map, &next, EDGE_MAP_UNDIRECTED);
+    vertex_subset_t tmp = frontier; frontier = next; next = tmp;
+  }
+
+  OMP("omp parallel for reduction(+:count)")
+  for (int64_t v = 0; v < nv; v++) {
+    count += component_map[v] == v;
+  }
+
+  vertex_subset_release(&frontier);
+  vertex_subset_release(&next);
+  return count;
+}
+
+int64_t
+connected_components_edge_map(stinger_t * S, int64_t nv, int64_t * component_map)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  int64_t count = cc_run(&G, component_map);
+  edge_map_graph_release(&G);
+  return count;
+}
+
+int64_t
+connected_components_edge_map_window(stinger_t * S, int64_t nv, int64_t t0, int64_t t1,
+  int64_t * component_map)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  edge_map_graph_set_window(&G, t0, t1);
+  int64_t count = cc_run(&G, component_map);
+  edge_map_graph_release(&G);
+  return count;
+}
+
+/* PageRank */
+
+typedef struct {
+  const double  * pr;
+  const int64_t * outdegree;
+  double        * contrib;
+  double        * next;
+} pr_edge_map_arg;
+
+static int
+pr_prepare(int64_t v, void * arg)
+{
+  pr_edge_map_arg * a = (pr_edge_map_arg *)arg;
+  a->contrib[v] = a->outdegree[v] ? a->pr[v] / (double)a->outdegree[v] : 0.0;
+  a->next[v] = 0.0;
+  return 1;
+}
+
+static int
+pr_update(int64_t src, int64_t dst, int64_t weight, void * arg)
+{
+  pr_edge_map_arg * a = (pr_edge_map_arg *)arg;
+  a->next[dst] += a->contrib[src];
+  return 1;
+}
+
+static int
+pr_update_atomic(int64_t src, int64_t dst, int64_t weight, void * arg)
+{
+  pr_edge_map_arg * a = (pr_edge_map_arg *)arg;
+  int64_t * p = (int64_t *)&a->next[dst];
+  int64_t old_bits = *p;
+  while (1) {
+    double old_val, new_val;
+    int64_t new_bits;
+    memcpy(&old_val, &old_bits, sizeof(double));
+    new_val = old_val + a->contrib[src];
+    memcpy(&new_bits, &new_val, sizeof(double));
+    int64_t seen = stinger_int64_cas(p, old_bits, new_bits);
+    if (seen == old_bits)
+      return 1;
+    old_bits = seen;
+  }
+}
+
+static int64_t
+pr_run(edge_map_graph_t * G, double * pr, double epsilon, double dampingfactor, int64_t maxiter)
+{
+  const edge_map_ops_t ops = { pr_update, pr_update_atomic, NULL };
+  stinger_t * S = G->S;
+  int64_t nv = G->nv;
+  int64_t * outdegree = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  double * contrib = (double *)xmalloc(nv * sizeof(double));
+  double * next = (double *)xmalloc(nv * sizeof(double));
+  pr_edge_map_arg arg = { pr, outdegree, contrib, next };
+  vertex_subset_t all;
+  int64_t iter = 0;
+  double delta = 1;
+
+  /* out-degrees among the first nv vertices, counted the way the pull sees them */
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t d = 0;
+    if (G->windowed) {
+      STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S, v, G->t0, G->t1) {
+        d += STINGER_EDGE_DEST < nv;
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END();
+    } else {
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        d += STINGER_EDGE_DEST < nv;
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+    outdegree[v] = d;
+  }
+
+  vertex_subset_init(&all, nv);
+  vertex_subset_all(&all);
+
+  while (delta > epsilon && iter < maxiter) {
+    double dangling = 0.0;
+    OMP("omp parallel for reduction(+:dangling)")
+    for (int64_t v = 0; v < nv; v++) {
+      if (!outdegree[v])
+        dangling += pr[v];
+    }
+
+    vertex_map(&all, pr_prepare, &arg, NULL);
+    edge_map(G, &all, &ops, &arg, NULL, EDGE_MAP_DENSE | EDGE_MAP_NO_OUTPUT);
+
+    delta = 0;
+    OMP("omp parallel for reduction(+:delta)")
+    for (int64_t v = 0; v < nv; v++) {
+      double rank = (next[v] + dangling / (double)nv) * dampingfactor + (1 - dampingfactor) / (double)nv;
+      delta += rank > pr[v] ? rank - pr[v] : pr[v] - rank;
+      pr[v] = rank;
+    }
+    iter++;
+  }
+
+  vertex_subset_release(&all);
+  xfree(next);
+  xfree(contrib);
+  xfree(outdegree);
+  return iter;
+}
+
+int64_t
+page_rank_edge_map(stinger_t * S, int64_t nv, double * pr, double epsilon, double dampingfactor, int64_t maxiter)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  int64_t iter = pr_run(&G, pr, epsilon, dampingfactor, maxiter);
+  edge_map_graph_release(&G);
+  return iter;
+}
+
+int64_t
+page_rank_edge_map_window(stinger_t * S, int64_t nv, int64_t t0, int64_t t1, double * pr,
+  double epsilon, double dampingfactor, int64_t maxiter)
+{
+  edge_map_graph_t G;
+  edge_map_graph_init(&G, S, nv, -1);
+  edge_map_graph_set_window(&G, t0, t1);
+  int64_t iter = pr_run(&G, pr, epsilon, dampingfactor, maxiter);
+  edge_map_graph_release(&G);
+  return iter;
+}
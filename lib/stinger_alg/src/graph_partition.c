@@ -1,42 +1,398 @@
+#include <math.h>
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
 #include "graph_partition.h"
-#include <float.h>
 
+/* Per-thread count of neighbors in each partition */
+typedef struct {
+    int64_t * count;    /* num_partitions + 1 */
+    int64_t * touched;
+    int64_t   ntouched;
+} partition_counts;
+
+static void
+partition_counts_init(partition_counts * pc, int64_t num_partitions)
+{
+    pc->count = (int64_t *)xcalloc(num_partitions + 1, sizeof(int64_t));
+    pc->touched = (int64_t *)xmalloc((num_partitions + 1) * sizeof(int64_t));
+    pc->ntouched = 0;
+}
+
+static void
+partition_counts_release(partition_counts * pc)
+{
+    xfree(pc->touched);
+    xfree(pc->count);
+}
+
+static inline int64_t
+partition_degree(stinger_t * S, int64_t v)
+{
+    return stinger_outdegree_get(S, v) + stinger_indegree_get(S, v);
+}
+
+/* Lowest-labeled partition among the smallest */
+static int64_t
+partition_smallest(const stinger_partition_internal * part_internal, const int64_t * sizes)
+{
+    int64_t best = 1;
+    for (int64_t p = 2; p <= part_internal->num_partitions; p++) {
+        if (sizes[p] < sizes[best])
+            best = p;
+    }
+    return best;
+}
+
+/* LDG capacity for the current number of assigned vertices */
+static double
+partition_capacity(const stinger_partition_internal * part_internal)
+{
+    if (part_internal->capacity > 0)
+        return part_internal->capacity;
+    int64_t n = part_internal->assigned;
+    if (n < part_internal->num_partitions)
+        n = part_internal->num_partitions;
+    return part_internal->slack * (double)n / (double)part_internal->num_partitions;
+}
+
+/* Fennel alpha = sqrt(k) * m / n^1.5 for the graph as it is now */
+static void
+partition_update_alpha(stinger_t * S, stinger_partition_internal * part_internal)
+{
+    double m = (double)stinger_total_edges(S) / 2.0;
+    double n = part_internal->assigned > 0 ? (double)part_internal->assigned : 1.0;
+    part_internal->alpha = sqrt((double)part_internal->num_partitions) * m / pow(n, 1.5);
+}
 
 /*
- * heuristic that assigns a vertex to the partition where it has the most edges in
- * weighted by a linear function that pentalized large partitions so as to avoid trivial solutions
- * Inputs: stinger graph, number of vertices, boolean vertex partition, total size of the partition
+ * Best partition for v. Only the partitions of its neighbors, its own and the
+ * smallest one need scoring: any other partition holds none of its neighbors
+ * and is at least as large as the smallest, so it cannot score higher.
  */
-double_t
-linear_deterministic_greedy(stinger_t * S, int64_t NV, int64_t partition_label, int64_t * vertex_partition, int64_t vertex_partition_size, int64_t source_vertex, double_t capacity_constraint)
-{
-	//Need to get a list of the source vetex's neighbors
-	//uint8_t vertex_neighbors[NV]; // TODO: chage this to use malloc
-	//for (uint64_t v = 0; v < NV; v++){
-		//vertex_neighbors[v] = 0;
-	//}
-    int count = 0;
-    //OMP ("omp parallel for reduction(+:count)")
-	STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_BEGIN(S,source_vertex)
+static int64_t
+partition_choose(stinger_t * S, const stinger_partition_internal * part_internal, int64_t v,
+                 const int64_t * partitions, const int64_t * sizes, partition_counts * pc,
+                 int64_t smallest, double capacity)
+{
+    int64_t k = part_internal->num_partitions;
+    int64_t cur = partitions[v];
+
+    STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t u = STINGER_EDGE_DEST;
+        if (u != v && u >= 0 && u < part_internal->nv) {
+            int64_t p = partitions[u];
+            if (p > 0 && p <= k && pc->count[p]++ == 0)
+                pc->touched[pc->ntouched++] = p;
+        }
+    } STINGER_FORALL_EDGES_OF_VTX_END();
+
+    if (cur > 0 && pc->count[cur] == 0)
+        pc->touched[pc->ntouched++] = cur;
+    if (smallest != cur && pc->count[smallest] == 0)
+        pc->touched[pc->ntouched++] = smallest;
+
+    int64_t best = 0;
+    double best_score = 0;
+    int64_t best_size = 0;
+
+    for (int64_t i = 0; i < pc->ntouched; i++) {
+        int64_t p = pc->touched[i];
+        int64_t n = pc->count[p];
+        int64_t size = sizes[p] - (p == cur);
+        double score;
+        if (part_internal->method == GRAPH_PARTITION_FENNEL)
+            score = (double)n - part_internal->alpha * part_internal->gamma * pow((double)size, part_internal->gamma - 1.0);
+        else
+            score = (double)n * (1.0 - (double)size / capacity);
+
+        /* on a tie staying put wins, then the smaller and lower-labeled partition */
+        int take = !best || score > best_score;
+        if (!take && score == best_score && best != cur) {
+            take = (p == cur) || size < best_size || (size == best_size && p < best);
+        }
+        if (take) {
+            best = p;
+            best_score = score;
+            best_size = size;
+        }
+    }
+
+    for (int64_t i = 0; i < pc->ntouched; i++) {
+        pc->count[pc->touched[i]] = 0;
+    }
+    pc->ntouched = 0;
+
+    return best;
+}
+
+/*
+ * One parallel streaming pass. Each thread streams a contiguous block of
+ * vertices; sizes are shared and updated atomically. With only_unassigned the
+ * unassigned vertices that have an edge are placed, otherwise the assigned
+ * ones may move. Returns the number of vertices placed or moved.
+ */
+static int64_t
+partition_pass(stinger_t * S, stinger_partition_internal * part_internal, int only_unassigned,
+               int64_t * partitions, int64_t * sizes)
+{
+    int64_t nv = part_internal->nv;
+    int64_t first_smallest = partition_smallest(part_internal, sizes);
+    double capacity = partition_capacity(part_internal);
+    int64_t moved = 0;
+
+    OMP("omp parallel reduction(+:moved)")
     {
-        if (vertex_partition[STINGER_EDGE_DEST] == partition_label){
-            count += STINGER_EDGE_WEIGHT; //How to support negative edge weights?
+        partition_counts pc;
+        partition_counts_init(&pc, part_internal->num_partitions);
+        /* each thread tracks the smallest partition on its own */
+        int64_t smallest = first_smallest;
+
+        OMP("omp for schedule(static)")
+        for (int64_t v = 0; v < nv; v++) {
+            int64_t cur = partitions[v];
+            if (only_unassigned ? (cur != 0 || partition_degree(S, v) == 0) : (cur == 0))
+                continue;
+
+            int64_t best = partition_choose(S, part_internal, v, partitions, sizes, &pc, smallest, capacity);
+            if (best != cur) {
+                if (cur)
+                    stinger_int64_fetch_add(&sizes[cur], -1);
+                stinger_int64_fetch_add(&sizes[best], 1);
+                partitions[v] = best;
+                moved++;
+
+                /* the smallest partition just grew; sizes may lag other threads */
+                if (best == smallest)
+                    smallest = partition_smallest(part_internal, sizes);
+            }
+        }
+
+        partition_counts_release(&pc);
+    }
+
+    return moved;
+}
+
+/* Out-edges of v into other partitions; unassigned neighbors do not count */
+static int64_t
+partition_vertex_cut(stinger_t * S, const stinger_partition_internal * part_internal, int64_t v,
+                     const int64_t * partitions)
+{
+    int64_t p = partitions[v];
+    int64_t c = 0;
+    if (p == 0)
+        return 0;
+
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t u = STINGER_EDGE_DEST;
+        if (u != v && u >= 0 && u < part_internal->nv && partitions[u] > 0 && partitions[u] != p)
+            c++;
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+
+    return c;
+}
+
+static void
+partition_recount_all(stinger_t * S, stinger_partition_internal * part_internal,
+                      const int64_t * partitions, int64_t * cut)
+{
+    int64_t k = part_internal->num_partitions;
+    for (int64_t p = 0; p <= k; p++) {
+        cut[p] = 0;
+    }
+
+    OMP("omp parallel for schedule(dynamic, 256)")
+    for (int64_t v = 0; v < part_internal->nv; v++) {
+        int64_t c = partition_vertex_cut(S, part_internal, v, partitions);
+        part_internal->cut_out[v] = c;
+        if (c)
+            stinger_int64_fetch_add(&cut[partitions[v]], c);
+    }
+
+    for (int64_t p = 1; p <= k; p++) {
+        cut[0] += cut[p];
+    }
+}
+
+void
+stinger_partition_reset_stats(stinger_partition_stats * stats)
+{
+    stats->vertices_assigned = 0;
+    stats->vertices_moved = 0;
+    stats->restream_passes = 0;
+}
+
+void
+stinger_partition_initialize_internals(stinger_t * S, int64_t nv, stinger_partition_internal * part_internal,
+  int64_t num_partitions, int64_t method, double capacity,
+  int64_t * partitions, int64_t * sizes, int64_t * cut, stinger_partition_stats * stats)
+{
+    memset(part_internal, 0, sizeof(stinger_partition_internal));
+    part_internal->nv = nv;
+    part_internal->num_partitions = num_partitions > 0 ? num_partitions : 1;
+    part_internal->method = method;
+    part_internal->capacity = capacity;
+    part_internal->slack = GRAPH_PARTITION_SLACK_DEFAULT;
+    part_internal->gamma = GRAPH_PARTITION_GAMMA_DEFAULT;
+    part_internal->stamp = 1;
+    part_internal->mark = (int64_t *)xcalloc(nv, sizeof(int64_t));
+    part_internal->cut_out = (int64_t *)xcalloc(nv, sizeof(int64_t));
+
+    for (int64_t p = 0; p <= part_internal->num_partitions; p++) {
+        sizes[p] = 0;
+    }
+
+    int64_t present = 0;
+    OMP("omp parallel for reduction(+:present)")
+    for (int64_t v = 0; v < nv; v++) {
+        partitions[v] = 0;
+        present += (partition_degree(S, v) > 0);
+    }
+
+    /* balance against the number of vertices this pass will place */
+    part_internal->assigned = present;
+    partition_update_alpha(S, part_internal);
+
+    int64_t placed = partition_pass(S, part_internal, 1, partitions, sizes);
+    part_internal->assigned = placed;
+
+    partition_recount_all(S, part_internal, partitions, cut);
+
+    if (stats)
+        stats->vertices_assigned += placed;
+}
+
+void
+stinger_partition_release_internals(stinger_partition_internal * part_internal)
+{
+    if (part_internal->mark) {
+        xfree(part_internal->mark);
+        xfree(part_internal->cut_out);
+    }
+    memset(part_internal, 0, sizeof(stinger_partition_internal));
+}
+
+/* Appends v to list once per stamp */
+static inline void
+partition_queue(stinger_partition_internal * part_internal, int64_t v,
+                int64_t ** list, int64_t * n, int64_t * capacity)
+{
+    if (part_internal->mark[v] == part_internal->stamp)
+        return;
+    part_internal->mark[v] = part_internal->stamp;
+    if (*n == *capacity) {
+        *capacity = 2 * *capacity + 16;
+        *list = (int64_t *)xrealloc(*list, *capacity * sizeof(int64_t));
+    }
+    (*list)[(*n)++] = v;
+}
+
+int64_t
+stinger_partition_update(stinger_t * S, stinger_partition_internal * part_internal,
+  stinger_partition_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * partitions, int64_t * sizes, int64_t * cut)
+{
+    int64_t nv = part_internal->nv;
+    int64_t capacity = 2 * (num_insertions + num_deletions) + 16;
+    int64_t * recount = (int64_t *)xmalloc(capacity * sizeof(int64_t));
+    int64_t num_recount = 0;
+    int64_t placed = 0;
+
+    if (part_internal->method == GRAPH_PARTITION_FENNEL && part_internal->alpha == 0)
+        partition_update_alpha(S, part_internal);
+
+    partition_counts pc;
+    partition_counts_init(&pc, part_internal->num_partitions);
+    int64_t smallest = partition_smallest(part_internal, sizes);
+
+    part_internal->stamp++;
+
+    /* stream the endpoints in batch order, insertions first */
+    for (int64_t k = 0; k < num_insertions + num_deletions; k++) {
+        stinger_edge_update * e = k < num_insertions ? &insertions[k] : &deletions[k - num_insertions];
+        int64_t ends[2] = { e->source, e->destination };
+
+        for (int i = 0; i < 2; i++) {
+            int64_t v = ends[i];
+            if (v < 0 || v >= nv)
+                continue;
+
+            if (partitions[v] == 0 && partition_degree(S, v) > 0) {
+                part_internal->assigned++;
+                int64_t best = partition_choose(S, part_internal, v, partitions, sizes, &pc,
+                                                smallest, partition_capacity(part_internal));
+                partitions[v] = best;
+                sizes[best]++;
+                placed++;
+                if (best == smallest)
+                    smallest = partition_smallest(part_internal, sizes);
+
+                /* edges into v now cross or stay inside partitions */
+                STINGER_FORALL_IN_EDGES_OF_VTX_BEGIN(S, v) {
+                    int64_t u = STINGER_EDGE_DEST;
+                    if (u >= 0 && u < nv)
+                        partition_queue(part_internal, u, &recount, &num_recount, &capacity);
+                } STINGER_FORALL_IN_EDGES_OF_VTX_END();
+            }
+
+            partition_queue(part_internal, v, &recount, &num_recount, &capacity);
         }
-        //vertex_neighbors[STINGER_EDGE_DEST] = STINGER_EDGE_WEIGHT; //How to support negative edge weights?
+    }
+
+    partition_counts_release(&pc);
 
+    int64_t total = 0;
+    OMP("omp parallel for reduction(+:total)")
+    for (int64_t i = 0; i < num_recount; i++) {
+        int64_t v = recount[i];
+        int64_t c = partition_vertex_cut(S, part_internal, v, partitions);
+        int64_t delta = c - part_internal->cut_out[v];
+        if (delta) {
+            stinger_int64_fetch_add(&cut[partitions[v]], delta);
+            total += delta;
+        }
+        part_internal->cut_out[v] = c;
+    }
+    cut[0] += total;
 
-    }STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_END();
+    xfree(recount);
 
-	//int count = 0;
-	//for (uint64_t v = 0; v < NV; v++) {
-		//if (vertex_partition[v] && vertex_neighbors[v]){
-			//we are trying the count the number of verticies in the partition that are also in the neighborhood of the source vertex
-			//count += vertex_neighbors[v];
-		//}
-	//}
-	double_t weight = 1 - (double_t) vertex_partition_size/capacity_constraint;
-    return (double_t)count*weight;
+    if (stats)
+        stats->vertices_assigned += placed;
 
+    return placed;
+}
+
+int64_t
+stinger_partition_restream(stinger_t * S, stinger_partition_internal * part_internal,
+  stinger_partition_stats * stats, int64_t passes,
+  int64_t * partitions, int64_t * sizes, int64_t * cut)
+{
+    int64_t moved = 0;
+    int64_t run = 0;
+
+    if (part_internal->method == GRAPH_PARTITION_FENNEL)
+        partition_update_alpha(S, part_internal);
+
+    while (run < passes) {
+        int64_t m = partition_pass(S, part_internal, 0, partitions, sizes);
+        run++;
+        moved += m;
+        if (m == 0)
+            break;
+    }
+
+    partition_recount_all(S, part_internal, partitions, cut);
+
+    if (stats) {
+        stats->vertices_moved += moved;
+        stats->restream_passes += run;
+    }
+
+    return moved;
 }
 
 /*This function partitons a graph into an aribitrary number of parts 
@@ -47,53 +403,12 @@ Inputs: the graph to be partitioned, total number of verticies, non-zero number
 void
 graph_partition(struct stinger * S, uint64_t NV, uint64_t num_partitions, double_t partition_capacity, int64_t * partitions, int64_t * partitions_sizes)
 {
-    srand(time(NULL));
-    //int64_t partitions[NV];
-    //int64_t partitions_sizes[num_partitions];
-
-    //instatiate these to zeros
-    //for(uint64_t i = 0; i < num_partitions; i++){
-        //partitions_sizes[i] = 0;
-    //}
-    //for(uint64_t j = 0; j < NV; j++){
-        //partitions[j] = 0;
-    //}
-
-	//for each vertex in the graph,
-	//assign it to a partition given a heuristic
-    //OMP ("omp parallel for")
-    for (uint64_t v = 0; v < NV; v++) {
-        uint64_t max_partition = 0;
-        double_t max_score = -DBL_MAX;
-        for (uint64_t i = 0; i < num_partitions; i++){
-            //evaluate heuristic score per each partition
-            double_t partition_score = linear_deterministic_greedy(S, NV, i+1, partitions, partitions_sizes[i], v, partition_capacity);
-            if (partition_score == max_score){
-                //break ties based on size of partitions
-                if (partitions_sizes[max_partition] > partitions_sizes[i+1]){
-                    max_partition = i+1;
-                }
-                else if (partitions_sizes[max_partition] == partitions_sizes[i+1]){
-                    //break ties randomly
-                    int r = rand()%1;
-                    if (r < 0.5){
-                        max_partition = i+1;
-                    }
-                }
-            }
-            else if (partition_score > max_score) {
-                max_partition = i+1;
-                max_score = partition_score;
-            }
-        }
-        //add the vertex to the winning partition
-        partitions[v] = max_partition;
-        partitions_sizes[max_partition] += 1;
-    }
-    //TODO fix returns, what would be a good output?
-    for (int64_t i = 0; i<NV; i++){
-        printf("Verticies Added %ld => %ld\n", i, partitions[i]);
-    }
-}
+    stinger_partition_internal part_internal;
+    int64_t * cut = (int64_t *)xcalloc(num_partitions + 1, sizeof(int64_t));
 
+    stinger_partition_initialize_internals(S, NV, &part_internal, num_partitions, GRAPH_PARTITION_LDG,
+                                           partition_capacity, partitions, partitions_sizes, cut, NULL);
 
+    stinger_partition_release_internals(&part_internal);
+    xfree(cut);
+}
@@ -1,46 +1,126 @@
+#include <math.h>
+
 #include "stinger_core/stinger.h"
 #include "hits_centrality.h"
 
-//helper function to update the authority values for the verticies in the graph
-void
-authority_update(stinger_t * s, int64_t NV, double_t * authority_scores, double_t * hubs_scores){
-    int64_t norm = 0; //we wil have to normalize each iteration
-    for(int64_t v = 0; v< NV; v++){
-        authority_scores[v] = 0;
-        STINGER_FORALL_IN_EDGES_OF_VTX_BEGIN(s, v)
-                                {
-                                    authority_scores[v] += hubs_scores[STINGER_EDGE_DEST];
-
-                                }
-        STINGER_FORALL_IN_EDGES_OF_VTX_END();
-        norm += pow(authority_scores[v], 2);
-    }
-    norm = sqrt(norm); //normalize using the sum of squared errors
-    for(int64_t v = 0; v< NV; v++){
-        authority_scores[v] = authority_scores[v]/norm;
+/*
+ * One half step of HITS: out[v] = scale * sum of in_scores over the in-edges
+ * (authority) or out-edges (hub) of v, restricted to one edge type when type
+ * is not negative. Returns the sum of squares of out so the caller can fold
+ * the normalization into the next half step instead of a separate sweep.
+ */
+static double
+hits_half_step(stinger_t * S, int64_t NV, int64_t type, int authority,
+               const double * in_scores, double scale, double * out)
+{
+    double norm = 0;
+
+    OMP("omp parallel for reduction(+:norm) schedule(dynamic, 256)")
+    for (int64_t v = 0; v < NV; v++) {
+        double sum = 0;
+        if (type < 0 && authority) {
+            STINGER_FORALL_IN_EDGES_OF_VTX_BEGIN(S, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u < NV)
+                    sum += in_scores[u];
+            } STINGER_FORALL_IN_EDGES_OF_VTX_END();
+        } else if (type < 0) {
+            STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u < NV)
+                    sum += in_scores[u];
+            } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+        } else if (authority) {
+            STINGER_FORALL_IN_EDGES_OF_TYPE_OF_VTX_BEGIN(S, type, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u < NV)
+                    sum += in_scores[u];
+            } STINGER_FORALL_IN_EDGES_OF_TYPE_OF_VTX_END();
+        } else {
+            STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_BEGIN(S, type, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u < NV)
+                    sum += in_scores[u];
+            } STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_END();
+        }
+        sum *= scale;
+        out[v] = sum;
+        norm += sum * sum;
     }
+
+    return norm;
 }
-//helper function to update the hub values for the verticies in the graph
-void
-hub_update(stinger_t * s, int64_t NV, double_t * authority_scores, double_t * hubs_scores){
-    int64_t norm = 0; //we wil have to normalize each iteration
-    for(int64_t v = 0; v< NV; v++){
-        hubs_scores[v] = 0;
-        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(s, v)
-                                {
-                                    hubs_scores[v] += authority_scores[STINGER_EDGE_DEST];
-
-                                }
-        STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-        norm += pow(hubs_scores[v], 2);
+
+/* Scales v to unit length unless it is all zeros; returns the old length */
+static double
+hits_normalize(int64_t NV, double * scores)
+{
+    double norm = 0;
+    OMP("omp parallel for reduction(+:norm)")
+    for (int64_t v = 0; v < NV; v++) {
+        norm += scores[v] * scores[v];
     }
-    norm = sqrt(norm); //normalize using the sum of squared values
-    for(int64_t v = 0; v< NV; v++){
-        hubs_scores[v] = hubs_scores[v]/norm;
+    norm = sqrt(norm);
+    if (norm > 0) {
+        OMP("omp parallel for")
+        for (int64_t v = 0; v < NV; v++) {
+            scores[v] /= norm;
+        }
     }
+    return norm;
 }
 
+int64_t
+hits_centrality_type(stinger_t * S, int64_t NV, double_t * hubs_scores, double_t * authority_scores,
+                     double * tmp_in, double epsilon, int64_t maxiter, int warm_start, int64_t type)
+{
+    double * tmp = tmp_in ? tmp_in : (double *)xmalloc(2 * NV * sizeof(double));
+    double * new_auth = tmp;
+    double * new_hubs = tmp + NV;
+
+    if (!warm_start || hits_normalize(NV, hubs_scores) == 0) {
+        double start = NV > 0 ? 1.0 / sqrt((double)NV) : 0;
+        OMP("omp parallel for")
+        for (int64_t v = 0; v < NV; v++) {
+            hubs_scores[v] = start;
+            authority_scores[v] = 0;
+        }
+    }
+
+    int64_t iter = 0;
+    double delta = epsilon + 1;
 
+    while (iter < maxiter && delta > epsilon) {
+        iter++;
+
+        double auth_norm = sqrt(hits_half_step(S, NV, type, 1, hubs_scores, 1.0, new_auth));
+        double auth_scale = auth_norm > 0 ? 1.0 / auth_norm : 0;
+        double hubs_norm = sqrt(hits_half_step(S, NV, type, 0, new_auth, auth_scale, new_hubs));
+        double hubs_scale = hubs_norm > 0 ? 1.0 / hubs_norm : 0;
+
+        delta = 0;
+        OMP("omp parallel for reduction(+:delta)")
+        for (int64_t v = 0; v < NV; v++) {
+            double a = new_auth[v] * auth_scale;
+            double h = new_hubs[v] * hubs_scale;
+            delta += fabs(a - authority_scores[v]) + fabs(h - hubs_scores[v]);
+            authority_scores[v] = a;
+            hubs_scores[v] = h;
+        }
+    }
+
+    if (!tmp_in)
+        xfree(tmp);
+
+    return iter;
+}
+
+int64_t
+hits_centrality_epsilon(stinger_t * S, int64_t NV, double_t * hubs_scores, double_t * authority_scores,
+                        double * tmp_in, double epsilon, int64_t maxiter, int warm_start)
+{
+    return hits_centrality_type(S, NV, hubs_scores, authority_scores, tmp_in, epsilon, maxiter, warm_start, -1);
+}
 
 /**
  * This is an implementation of the HITS algorithm
@@ -48,15 +128,5 @@ hub_update(stinger_t * s, int64_t NV, double_t * authority_scores, double_t * hu
  */
 void
 hits_centrality(stinger_t * s, int64_t NV, double_t * hubs_scores, double_t * authority_scores, int64_t k) {
-    for (int64_t i = 0; i < NV; i++) {
-        //initialize all the hub and authority scores to one
-        hubs_scores[i] = 1;
-        authority_scores[i] = 1;
-    }
-    //run for k steps
-    for (int64_t i = 0; i < k; i++) {
-        authority_update(s, NV, authority_scores, hubs_scores);
-        hub_update(s, NV, authority_scores, hubs_scores);
-
-    }
+    hits_centrality_epsilon(s, NV, hubs_scores, authority_scores, NULL, 0.0, k, 0);
 }
@@ -1,44 +1,220 @@
 //
 // Created by jdeeb3 on 5/31/16.
 //
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
 #include "independent_sets.h"
 
+#define MIS_UNDECIDED (-1)
 
-//we are going to use the independent_set array as a mask for the verticies in the independent set
-//if independent_set[vertex] = 1, then  vertex is in the set - else that vertex is not in the set
-void
-independent_set(stinger_t * S, int64_t NV, int64_t * independent_set){
-    int64_t vertex_pool[NV]; //TODO this should be using malloc
-    int64_t vertexCount = NV;
-    srand(time(NULL));
-    for (int64_t i = 0; i < NV; i ++){
-        independent_set[i] = 0; // set all values to zero
-        vertex_pool[i] = 1; //add all the verticies to the pool
-    }
-
-    while (vertexCount != 0){
-        int r = rand()%NV;
-        if (independent_set[r] != 1 && vertex_pool[r] == 1){
-            //this means we have never seen the vertex before and the vertex is a valid choice
-            independent_set[r] = 1; //add the vertex from the set
-            //now we need to remove the vertex from the pool
-            vertex_pool[r] = 0;
-            vertexCount -= 1;
-            STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, r){
-                                        if (vertex_pool[STINGER_EDGE_DEST]) {
-                                            vertex_pool[STINGER_EDGE_DEST] = 0;
-                                            vertexCount -= 1;
-                                        }
-
-                                    }STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-            STINGER_FORALL_IN_EDGES_OF_VTX_BEGIN(S, r){
-                                        if (vertex_pool[STINGER_EDGE_DEST]) {
-                                            vertex_pool[STINGER_EDGE_DEST] = 0;
-                                            vertexCount -= 1;
-                                        }
-                                    }STINGER_FORALL_IN_EDGES_OF_VTX_END();
+/* splitmix64 finalizer of the seeded vertex id */
+static inline uint64_t
+mis_priority(uint64_t seed, int64_t v)
+{
+    uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (uint64_t)(v + 1);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Does u come before v in the greedy order? Ids break hash ties. */
+static inline int
+mis_before(uint64_t seed, int64_t u, int64_t v)
+{
+    uint64_t pu = mis_priority(seed, u);
+    uint64_t pv = mis_priority(seed, v);
+    return pu > pv || (pu == pv && u < v);
+}
+
+/*
+ * Settles the n undecided vertices in list. Each round an undecided vertex
+ * joins the set if it has no neighbor in the set and comes before all of its
+ * undecided neighbors; the undecided neighbors of the new members then drop
+ * out. Rounds only read the state left by the previous one, so the outcome is
+ * the greedy set for the seeded order whatever the number of threads.
+ * list and decision are clobbered. Returns the number of rounds.
+ */
+static int64_t
+mis_settle(stinger_t * S, int64_t NV, int64_t * independent_set, uint64_t seed,
+           int64_t * list, int64_t n, int8_t * decision)
+{
+    int64_t rounds = 0;
+
+    while (n > 0) {
+        rounds++;
+
+        OMP("omp parallel for schedule(dynamic, 64)")
+        for (int64_t i = 0; i < n; i++) {
+            int64_t v = list[i];
+            int8_t d = 1;
+            STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u != v && u >= 0 && u < NV) {
+                    if (independent_set[u] == 1)
+                        d = 0;
+                    else if (d == 1 && independent_set[u] == MIS_UNDECIDED && mis_before(seed, u, v))
+                        d = MIS_UNDECIDED;
+                }
+            } STINGER_FORALL_EDGES_OF_VTX_END();
+            decision[i] = d;
+        }
+
+        OMP("omp parallel for")
+        for (int64_t i = 0; i < n; i++) {
+            if (decision[i] != MIS_UNDECIDED)
+                independent_set[list[i]] = decision[i];
+        }
+
+        OMP("omp parallel for schedule(dynamic, 64)")
+        for (int64_t i = 0; i < n; i++) {
+            if (decision[i] == 1) {
+                int64_t v = list[i];
+                STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+                    int64_t u = STINGER_EDGE_DEST;
+                    if (u != v && u >= 0 && u < NV && independent_set[u] == MIS_UNDECIDED)
+                        independent_set[u] = 0;
+                } STINGER_FORALL_EDGES_OF_VTX_END();
+            }
+        }
+
+        int64_t remaining = 0;
+        for (int64_t i = 0; i < n; i++) {
+            if (independent_set[list[i]] == MIS_UNDECIDED)
+                list[remaining++] = list[i];
+        }
+        n = remaining;
+    }
+
+    return rounds;
+}
+
+int64_t
+independent_set_luby(stinger_t * S, int64_t NV, int64_t * independent_set, uint64_t seed)
+{
+    int64_t * list = (int64_t *)xmalloc((NV ? NV : 1) * sizeof(int64_t));
+    int8_t * decision = (int8_t *)xmalloc((NV ? NV : 1) * sizeof(int8_t));
+
+    OMP("omp parallel for")
+    for (int64_t v = 0; v < NV; v++) {
+        independent_set[v] = MIS_UNDECIDED;
+        list[v] = v;
+    }
+
+    mis_settle(S, NV, independent_set, seed, list, NV, decision);
+
+    int64_t size = 0;
+    OMP("omp parallel for reduction(+:size)")
+    for (int64_t v = 0; v < NV; v++) {
+        size += independent_set[v];
+    }
+
+    xfree(decision);
+    xfree(list);
+
+    return size;
+}
+
+/* Is any neighbor of v in the set? */
+static int
+mis_covered(stinger_t * S, int64_t NV, const int64_t * independent_set, int64_t v)
+{
+    int covered = 0;
+    STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t u = STINGER_EDGE_DEST;
+        if (u != v && u >= 0 && u < NV && independent_set[u] == 1)
+            covered = 1;
+    } STINGER_FORALL_EDGES_OF_VTX_END();
+    return covered;
+}
+
+int64_t
+independent_set_update(stinger_t * S, int64_t old_nv, int64_t NV, int64_t * independent_set, uint64_t seed,
+                       stinger_edge_update * insertions, int64_t num_insertions,
+                       stinger_edge_update * deletions, int64_t num_deletions)
+{
+    if (old_nv > NV)
+        old_nv = NV;
+
+    /* members joined by a new edge: the later one in the greedy order leaves */
+    int64_t * demoted = (int64_t *)xmalloc((num_insertions ? num_insertions : 1) * sizeof(int64_t));
+    int64_t num_demoted = 0;
+    for (int64_t k = 0; k < num_insertions; k++) {
+        int64_t u = insertions[k].source;
+        int64_t v = insertions[k].destination;
+        if (u == v || u < 0 || v < 0 || u >= old_nv || v >= old_nv)
+            continue;
+        if (independent_set[u] == 1 && independent_set[v] == 1) {
+            int64_t w = mis_before(seed, u, v) ? v : u;
+            independent_set[w] = 0;
+            demoted[num_demoted++] = w;
         }
+    }
+
+    /* vertices that may have lost their only neighbor in the set */
+    int64_t capacity = 2 * num_deletions + num_demoted;
+    for (int64_t k = 0; k < num_demoted; k++) {
+        capacity += stinger_outdegree_get(S, demoted[k]) + stinger_indegree_get(S, demoted[k]);
+    }
+    int64_t * check = (int64_t *)xmalloc((capacity ? capacity : 1) * sizeof(int64_t));
+    int64_t num_check = 0;
 
+    for (int64_t k = 0; k < num_deletions; k++) {
+        int64_t u = deletions[k].source;
+        int64_t v = deletions[k].destination;
+        if (u >= 0 && u < old_nv)
+            check[num_check++] = u;
+        if (v >= 0 && v < old_nv)
+            check[num_check++] = v;
     }
+    for (int64_t k = 0; k < num_demoted; k++) {
+        int64_t w = demoted[k];
+        check[num_check++] = w;
+        STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, w) {
+            int64_t u = STINGER_EDGE_DEST;
+            if (u >= 0 && u < old_nv && num_check < capacity)
+                check[num_check++] = u;
+        } STINGER_FORALL_EDGES_OF_VTX_END();
+    }
+
+    int64_t * list = (int64_t *)xmalloc((num_check + NV - old_nv + 1) * sizeof(int64_t));
+    int8_t * decision = (int8_t *)xmalloc((num_check + NV - old_nv + 1) * sizeof(int8_t));
+    int64_t n = 0;
 
-}
\ No newline at end of file
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < num_check; i++) {
+        int64_t v = check[i];
+        if (independent_set[v] == 0 && !mis_covered(S, NV, independent_set, v))
+            decision[i] = 1;
+        else
+            decision[i] = 0;
+    }
+    for (int64_t i = 0; i < num_check; i++) {
+        int64_t v = check[i];
+        if (decision[i] && independent_set[v] == 0) {
+            independent_set[v] = MIS_UNDECIDED;
+            list[n++] = v;
+        }
+    }
+    for (int64_t v = old_nv; v < NV; v++) {
+        independent_set[v] = MIS_UNDECIDED;
+        list[n++] = v;
+    }
+
+    int64_t repaired = n + num_demoted;
+    mis_settle(S, NV, independent_set, seed, list, n, decision);
+
+    xfree(decision);
+    xfree(list);
+    xfree(check);
+    xfree(demoted);
+
+    return repaired;
+}
+
+//we are going to use the independent_set array as a mask for the verticies in the independent set
+//if independent_set[vertex] = 1, then  vertex is in the set - else that vertex is not in the set
+void
+independent_set(stinger_t * S, int64_t NV, int64_t * independent_set){
+    independent_set_luby(S, NV, independent_set, INDEPENDENT_SET_DEFAULT_SEED);
+}
@@ -1,11 +1,14 @@
 #include <stdio.h>
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
 #include "kcore.h"
 
 void
 kcore_find(stinger_t *S, int64_t * labels, int64_t * counts, int64_t nv, int64_t * k_out) {
   int64_t k = 0;
 
-  for(int64_t v; v < nv; v++) {
+  for(int64_t v = 0; v < nv; v++) {
     if(stinger_outdegree_get(S,v)) {
       labels[v] = 1;
     } else {
@@ -49,3 +52,514 @@ kcore_find(stinger_t *S, int64_t * labels, int64_t * counts, int64_t nv, int64_t
 
   *k_out = k;
 }
+
+/*
+ * Bucket peeling. core[v] starts as the degree of v; level by level, every
+ * vertex whose remaining degree equals the level is peeled and decrements its
+ * neighbors, which join the current level when they drop to it. Vertices still
+ * above the level are kept in a compacted list so later levels only scan them.
+ */
+void
+kcore_decomposition(stinger_t * S, int64_t nv, int64_t * core, int64_t * k_out)
+{
+  int64_t * remaining = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * next_remaining = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * frontier = (int64_t *)xmalloc(nv * sizeof(int64_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t deg = 0;
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+      deg += (STINGER_EDGE_DEST != v);
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    core[v] = deg;
+    remaining[v] = v;
+  }
+
+  int64_t num_remaining = nv;
+  int64_t level = 0;
+
+  while (num_remaining > 0) {
+    int64_t tail = 0;
+
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < num_remaining; i++) {
+      int64_t v = remaining[i];
+      if (core[v] == level) {
+        frontier[stinger_int64_fetch_add(&tail, 1)] = v;
+      }
+    }
+
+    int64_t head = 0;
+    while (head < tail) {
+      int64_t end = tail;
+
+      OMP("omp parallel for schedule(dynamic,64)")
+      for (int64_t i = head; i < end; i++) {
+        int64_t v = frontier[i];
+        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+          int64_t u = STINGER_EDGE_DEST;
+          if (u != v && core[u] > level) {
+            int64_t old = stinger_int64_fetch_add(core + u, -1);
+            if (old == level + 1) {
+              frontier[stinger_int64_fetch_add(&tail, 1)] = u;
+            } else if (old <= level) {
+              stinger_int64_fetch_add(core + u, 1);
+            }
+          }
+        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+      }
+
+      head = end;
+    }
+
+    /* drop the peeled vertices from the scan list */
+    int64_t num_next = 0;
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < num_remaining; i++) {
+      int64_t v = remaining[i];
+      if (core[v] > level) {
+        next_remaining[stinger_int64_fetch_add(&num_next, 1)] = v;
+      }
+    }
+
+    int64_t * tmp = remaining;
+    remaining = next_remaining;
+    next_remaining = tmp;
+    num_remaining = num_next;
+
+    if (num_remaining)
+      level++;
+  }
+
+  *k_out = level;
+
+  xfree(frontier);
+  xfree(next_remaining);
+  xfree(remaining);
+}
+
+static inline int64_t
+kcore_count_vertex(stinger_t * S, const int64_t * core, int64_t v)
+{
+  int64_t count = 0;
+  STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+    int64_t u = STINGER_EDGE_DEST;
+    count += (u != v && core[u] >= core[v]);
+  } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+  return count;
+}
+
+void
+kcore_neighbor_counts(stinger_t * S, int64_t nv, const int64_t * core, int64_t * counts)
+{
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    counts[v] = kcore_count_vertex(S, core, v);
+  }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Streaming maintenance
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/*
+ * The batch has already been applied to STINGER when the update runs, but the
+ * insertions must be replayed one at a time. Inserted edges that have not been
+ * replayed yet are kept in a small open-addressing set of (type, from, to)
+ * keys and skipped by every traversal below.
+ */
+#define KCORE_SKIP_EMPTY   -1
+#define KCORE_SKIP_REMOVED -2
+
+static inline uint64_t
+kcore_skip_hash(int64_t type, int64_t from, int64_t to)
+{
+  uint64_t h = (uint64_t)from * 0x9E3779B97F4A7C15ULL;
+  h ^= (uint64_t)to + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+  h ^= (uint64_t)type * 0xC2B2AE3D27D4EB4FULL;
+  return h ^ (h >> 29);
+}
+
+static void
+kcore_skip_reset(stinger_kcore_internal * kcore_internal, int64_t max_edges)
+{
+  int64_t size = 64;
+  while (size < 2 * max_edges)
+    size <<= 1;
+
+  if (size > kcore_internal->skip_size) {
+    if (kcore_internal->skip_keys)
+      xfree(kcore_internal->skip_keys);
+    kcore_internal->skip_keys = (int64_t *)xmalloc(3 * size * sizeof(int64_t));
+    kcore_internal->skip_size = size;
+  }
+
+  for (int64_t i = 0; i < kcore_internal->skip_size; i++) {
+    kcore_internal->skip_keys[3 * i + 1] = KCORE_SKIP_EMPTY;
+  }
+  kcore_internal->skip_count = 0;
+}
+
+static int64_t
+kcore_skip_find(const stinger_kcore_internal * kcore_internal, int64_t type, int64_t from, int64_t to)
+{
+  uint64_t mask = kcore_internal->skip_size - 1;
+  uint64_t i = kcore_skip_hash(type, from, to) & mask;
+  while (1) {
+    const int64_t * key = kcore_internal->skip_keys + 3 * i;
+    if (key[1] == KCORE_SKIP_EMPTY)
+      return -1;
+    if (key[0] == type && key[1] == from && key[2] == to)
+      return i;
+    i = (i + 1) & mask;
+  }
+}
+
+static void
+kcore_skip_insert(stinger_kcore_internal * kcore_internal, int64_t type, int64_t from, int64_t to)
+{
+  if (kcore_skip_find(kcore_internal, type, from, to) >= 0)
+    return;
+
+  uint64_t mask = kcore_internal->skip_size - 1;
+  uint64_t i = kcore_skip_hash(type, from, to) & mask;
+  while (kcore_internal->skip_keys[3 * i + 1] >= 0) {
+    i = (i + 1) & mask;
+  }
+  kcore_internal->skip_keys[3 * i] = type;
+  kcore_internal->skip_keys[3 * i + 1] = from;
+  kcore_internal->skip_keys[3 * i + 2] = to;
+  kcore_internal->skip_count++;
+}
+
+static int
+kcore_skip_remove(stinger_kcore_internal * kcore_internal, int64_t type, int64_t from, int64_t to)
+{
+  int64_t i = kcore_skip_find(kcore_internal, type, from, to);
+  if (i < 0)
+    return 0;
+  kcore_internal->skip_keys[3 * i + 1] = KCORE_SKIP_REMOVED;
+  kcore_internal->skip_count--;
+  return 1;
+}
+
+#define KCORE_EDGE_VISIBLE(KI_, V_, U_) \
+  ((U_) != (V_) && (!(KI_)->skip_count || kcore_skip_find((KI_), STINGER_EDGE_TYPE, (V_), (U_)) < 0))
+
+static inline void
+kcore_mark_dirty(stinger_kcore_internal * kcore_internal, int64_t * num_dirty, int64_t v, int64_t stamp)
+{
+  int64_t m = kcore_internal->dirty_mark[v];
+  if (m != stamp && stinger_int64_cas(kcore_internal->dirty_mark + v, m, stamp) == m) {
+    kcore_internal->dirty[stinger_int64_fetch_add(num_dirty, 1)] = v;
+  }
+}
+
+void
+stinger_kcore_reset_stats(stinger_kcore_stats * stats)
+{
+  stats->insertions_processed = 0;
+  stats->deletion_rounds = 0;
+  stats->vertices_visited = 0;
+  stats->vertices_changed = 0;
+}
+
+void
+stinger_kcore_initialize_internals(stinger_t * S, int64_t nv, stinger_kcore_internal * kcore_internal,
+  int64_t * core, int64_t * counts, int64_t * k_out)
+{
+  memset(kcore_internal, 0, sizeof(stinger_kcore_internal));
+  kcore_internal->nv = nv;
+  kcore_internal->mark = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  kcore_internal->cd = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  kcore_internal->queue = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  kcore_internal->stack = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  kcore_internal->dirty_mark = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  kcore_internal->dirty = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  kcore_skip_reset(kcore_internal, 0);
+
+  kcore_decomposition(S, nv, core, k_out);
+  kcore_neighbor_counts(S, nv, core, counts);
+}
+
+void
+stinger_kcore_release_internals(stinger_kcore_internal * kcore_internal)
+{
+  if (kcore_internal->mark) {
+    xfree(kcore_internal->mark);
+    xfree(kcore_internal->cd);
+    xfree(kcore_internal->queue);
+    xfree(kcore_internal->stack);
+    xfree(kcore_internal->dirty_mark);
+    xfree(kcore_internal->dirty);
+  }
+  if (kcore_internal->skip_keys)
+    xfree(kcore_internal->skip_keys);
+  memset(kcore_internal, 0, sizeof(stinger_kcore_internal));
+}
+
+/*
+ * Lower core numbers until they are consistent with the visible graph. Each
+ * vertex in the frontier takes the h-index of its neighbors' core numbers; if
+ * that drops, neighbors above the new value are re-examined in the next round.
+ * Starting from upper bounds this converges to the exact core numbers.
+ */
+static int64_t
+kcore_lower(stinger_t * S, stinger_kcore_internal * kcore_internal, int64_t * core,
+  int64_t num_frontier, int64_t kmax, int64_t * num_dirty, int64_t dirty_stamp,
+  stinger_kcore_stats * stats)
+{
+  int64_t * frontier = kcore_internal->queue;
+  int64_t * next = kcore_internal->stack;
+  int64_t rounds = 0;
+  int64_t visited = 0;
+
+  while (num_frontier > 0) {
+    int64_t stamp = ++kcore_internal->stamp;
+    int64_t num_next = 0;
+    rounds++;
+    visited += num_frontier;
+
+    OMP("omp parallel")
+    {
+      int64_t * hist = (int64_t *)xmalloc((kmax + 1) * sizeof(int64_t));
+
+      OMP("omp for schedule(dynamic,64)")
+      for (int64_t i = 0; i < num_frontier; i++) {
+        int64_t v = frontier[i];
+        int64_t c = core[v];
+        if (c == 0)
+          continue;
+
+        for (int64_t j = 0; j <= c; j++) {
+          hist[j] = 0;
+        }
+        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+          int64_t u = STINGER_EDGE_DEST;
+          if (KCORE_EDGE_VISIBLE(kcore_internal, v, u)) {
+            int64_t cu = core[u];
+            hist[cu < c ? cu : c]++;
+          }
+        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+
+        int64_t h = c;
+        int64_t at_least = 0;
+        for (; h > 0; h--) {
+          at_least += hist[h];
+          if (at_least >= h)
+            break;
+        }
+
+        if (h < c) {
+          core[v] = h;
+          kcore_mark_dirty(kcore_internal, num_dirty, v, dirty_stamp);
+          STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+            int64_t u = STINGER_EDGE_DEST;
+            if (u != v && core[u] > h) {
+              int64_t m = kcore_internal->mark[u];
+              if (m != stamp && stinger_int64_cas(kcore_internal->mark + u, m, stamp) == m) {
+                next[stinger_int64_fetch_add(&num_next, 1)] = u;
+              }
+            }
+          } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+        }
+      }
+
+      xfree(hist);
+    }
+
+    int64_t * tmp = frontier;
+    frontier = next;
+    next = tmp;
+    num_frontier = num_next;
+  }
+
+  if (stats) {
+    stats->deletion_rounds += rounds;
+    stats->vertices_visited += visited;
+  }
+
+  return rounds;
+}
+
+/*
+ * Replay the insertion of the visible edge (u, v). Only vertices with core
+ * number K = min(core[u], core[v]) that are connected to the root(s) through
+ * other such vertices can move up, and only to K + 1. Candidates without more
+ * than K neighbors in the (K+1)-core plus the surviving candidates are evicted
+ * until the remaining ones are promoted.
+ */
+static void
+kcore_insert_edge(stinger_t * S, stinger_kcore_internal * kcore_internal, int64_t * core,
+  int64_t u, int64_t v, int64_t * num_dirty, int64_t dirty_stamp, stinger_kcore_stats * stats)
+{
+  int64_t K = core[u] < core[v] ? core[u] : core[v];
+  int64_t * queue = kcore_internal->queue;
+  int64_t * stack = kcore_internal->stack;
+  int64_t * mark = kcore_internal->mark;
+  int64_t * cd = kcore_internal->cd;
+
+  /* mark == candidate: in the subcore; mark == evicted: cannot be promoted */
+  int64_t candidate = kcore_internal->stamp + 1;
+  int64_t evicted = kcore_internal->stamp + 2;
+  kcore_internal->stamp += 2;
+
+  int64_t tail = 0;
+  if (core[u] == K) {
+    mark[u] = candidate;
+    queue[tail++] = u;
+  }
+  if (core[v] == K && mark[v] != candidate) {
+    mark[v] = candidate;
+    queue[tail++] = v;
+  }
+
+  for (int64_t head = 0; head < tail; head++) {
+    int64_t w = queue[head];
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, w) {
+      int64_t x = STINGER_EDGE_DEST;
+      if (core[x] == K && mark[x] != candidate && KCORE_EDGE_VISIBLE(kcore_internal, w, x)) {
+        mark[x] = candidate;
+        queue[tail++] = x;
+      }
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+  }
+
+  for (int64_t i = 0; i < tail; i++) {
+    int64_t w = queue[i];
+    int64_t count = 0;
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, w) {
+      int64_t x = STINGER_EDGE_DEST;
+      if (KCORE_EDGE_VISIBLE(kcore_internal, w, x)) {
+        count += (core[x] > K || (core[x] == K && mark[x] == candidate));
+      }
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    cd[w] = count;
+  }
+
+  for (int64_t i = 0; i < tail; i++) {
+    int64_t w = queue[i];
+    if (mark[w] != candidate || cd[w] > K)
+      continue;
+
+    int64_t top = 0;
+    mark[w] = evicted;
+    stack[top++] = w;
+    while (top > 0) {
+      int64_t y = stack[--top];
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, y) {
+        int64_t x = STINGER_EDGE_DEST;
+        if (mark[x] == candidate && KCORE_EDGE_VISIBLE(kcore_internal, y, x)) {
+          if (--cd[x] <= K) {
+            mark[x] = evicted;
+            stack[top++] = x;
+          }
+        }
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+  }
+
+  for (int64_t i = 0; i < tail; i++) {
+    int64_t w = queue[i];
+    if (mark[w] == candidate) {
+      core[w] = K + 1;
+      kcore_mark_dirty(kcore_internal, num_dirty, w, dirty_stamp);
+    }
+  }
+
+  if (stats) {
+    stats->vertices_visited += tail;
+  }
+}
+
+int64_t
+stinger_kcore_update(stinger_t * S, stinger_kcore_internal * kcore_internal, stinger_kcore_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * core, int64_t * counts, int64_t * k_out)
+{
+  int64_t nv = kcore_internal->nv;
+  int64_t dirty_stamp = ++kcore_internal->stamp;
+  int64_t num_dirty = 0;
+  int64_t kmax = *k_out;
+
+  /* Hide every inserted edge so the visible graph is a subgraph of the one
+   * the stored core numbers describe. Edges that existed before the batch are
+   * hidden too; replaying them below is harmless. */
+  kcore_skip_reset(kcore_internal, 2 * num_insertions);
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t t = insertions[k].type;
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    if (u < 0 || v < 0 || u >= nv || v >= nv || u == v || t < 0)
+      continue;
+    if (stinger_has_typed_successor(S, t, u, v))
+      kcore_skip_insert(kcore_internal, t, u, v);
+    if (stinger_has_typed_successor(S, t, v, u))
+      kcore_skip_insert(kcore_internal, t, v, u);
+  }
+
+  /* deletions, and hidden edges, can only lower core numbers */
+  int64_t num_frontier = 0;
+  int64_t stamp = ++kcore_internal->stamp;
+  for (int64_t pass = 0; pass < 2; pass++) {
+    stinger_edge_update * updates = pass ? insertions : deletions;
+    int64_t num_updates = pass ? num_insertions : num_deletions;
+    for (int64_t k = 0; k < num_updates; k++) {
+      int64_t ends[2] = { updates[k].source, updates[k].destination };
+      for (int64_t e = 0; e < 2; e++) {
+        int64_t w = ends[e];
+        if (w >= 0 && w < nv && kcore_internal->mark[w] != stamp) {
+          kcore_internal->mark[w] = stamp;
+          kcore_internal->queue[num_frontier++] = w;
+          kcore_mark_dirty(kcore_internal, &num_dirty, w, dirty_stamp);
+        }
+      }
+    }
+  }
+  kcore_lower(S, kcore_internal, core, num_frontier, kmax, &num_dirty, dirty_stamp, stats);
+
+  /* replay the insertions one edge at a time */
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t t = insertions[k].type;
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    if (u < 0 || v < 0 || u >= nv || v >= nv || u == v || t < 0)
+      continue;
+
+    int removed = kcore_skip_remove(kcore_internal, t, u, v);
+    removed += kcore_skip_remove(kcore_internal, t, v, u);
+    if (removed) {
+      kcore_insert_edge(S, kcore_internal, core, u, v, &num_dirty, dirty_stamp, stats);
+      if (stats)
+        stats->insertions_processed++;
+    }
+  }
+
+  /* counts change for every changed vertex and its neighbors */
+  int64_t * dirty = kcore_internal->dirty;
+  OMP("omp parallel for schedule(dynamic,64)")
+  for (int64_t i = 0; i < num_dirty; i++) {
+    int64_t w = dirty[i];
+    counts[w] = kcore_count_vertex(S, core, w);
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, w) {
+      int64_t x = STINGER_EDGE_DEST;
+      if (x != w)
+        counts[x] = kcore_count_vertex(S, core, x);
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+  }
+
+  kmax = 0;
+  OMP("omp parallel for reduction(max:kmax)")
+  for (int64_t v = 0; v < nv; v++) {
+    if (core[v] > kmax)
+      kmax = core[v];
+  }
+  *k_out = kmax;
+
+  if (stats)
+    stats->vertices_changed += num_dirty;
+
+  return num_dirty;
+}
@@ -0,0 +1,302 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
+#include "label_propagation.h"
+
+/*
+ * Per-thread label histogram: open addressing from label to summed weight,
+ * with the slots in use listed so clearing is proportional to the degree.
+ */
+typedef struct {
+  int64_t   cap;
+  int64_t * keys;
+  double  * vals;
+  int64_t   nused;
+  int64_t * used;
+} lp_histogram;
+
+static void
+lp_histogram_reserve(lp_histogram * hist, int64_t n)
+{
+  int64_t cap = 16;
+  while (cap < 2 * n)
+    cap <<= 1;
+  if (cap <= hist->cap)
+    return;
+
+  if (hist->cap) {
+    xfree(hist->keys);
+    xfree(hist->vals);
+    xfree(hist->used);
+  }
+  hist->keys = (int64_t *)xmalloc(cap * sizeof(int64_t));
+  hist->vals = (double *)xmalloc(cap * sizeof(double));
+  hist->used = (int64_t *)xmalloc(cap * sizeof(int64_t));
+  for (int64_t i = 0; i < cap; i++) {
+    hist->keys[i] = -1;
+  }
+  hist->cap = cap;
+  hist->nused = 0;
+}
+
+static void
+lp_histogram_release(lp_histogram * hist)
+{
+  if (hist->cap) {
+    xfree(hist->keys);
+    xfree(hist->vals);
+    xfree(hist->used);
+  }
+  memset(hist, 0, sizeof(lp_histogram));
+}
+
+static inline void
+lp_histogram_add(lp_histogram * hist, int64_t key, double w)
+{
+  uint64_t mask = (uint64_t)(hist->cap - 1);
+  uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+  h = (h ^ (h >> 29)) & mask;
+  while (hist->keys[h] != -1 && hist->keys[h] != key) {
+    h = (h + 1) & mask;
+  }
+  if (hist->keys[h] == -1) {
+    hist->keys[h] = key;
+    hist->vals[h] = 0;
+    hist->used[hist->nused++] = (int64_t)h;
+  }
+  hist->vals[h] += w;
+}
+
+/*
+ * The label v would take given the current labels. The neighbors can fill the
+ * histogram only up to the degree counted when it was reserved, which keeps a
+ * concurrently growing adjacency from overflowing it.
+ */
+static int64_t
+lp_choose_label(stinger_t * S, int64_t nv, int64_t v, const int64_t * labels, lp_histogram * hist)
+{
+  int64_t deg = stinger_outdegree_get(S, v);
+  int64_t own = labels[v];
+  int64_t supported = 0;
+  double heaviest = 1.0;
+
+  lp_histogram_reserve(hist, deg + 2);
+
+  STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+    int64_t u = STINGER_EDGE_DEST;
+    if (u != v && u >= 0 && u < nv && hist->nused <= deg) {
+      double w = STINGER_EDGE_WEIGHT > 0 ? (double)STINGER_EDGE_WEIGHT : 1.0;
+      lp_histogram_add(hist, labels[u], w);
+      supported |= (labels[u] == own);
+      if (w > heaviest)
+        heaviest = w;
+    }
+  } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+
+  /* weighing the own vote like the heaviest edge keeps two vertices from
+   * swapping labels across that edge round after round */
+  lp_histogram_add(hist, supported ? own : v, heaviest);
+
+  int64_t best = -1;
+  double best_w = 0;
+  for (int64_t i = 0; i < hist->nused; i++) {
+    int64_t h = hist->used[i];
+    int64_t label = hist->keys[h];
+    double w = hist->vals[h];
+    if (best < 0 || w > best_w || (w == best_w && label < best)) {
+      best = label;
+      best_w = w;
+    }
+    hist->keys[h] = -1;
+  }
+  hist->nused = 0;
+
+  return best;
+}
+
+/* Adds u to the next frontier unless it is already there */
+static inline void
+lp_enqueue(stinger_label_propagation_internal * lp_internal, int64_t u, int64_t * count)
+{
+  int64_t old = lp_internal->mark[u];
+  if (old != lp_internal->stamp &&
+      stinger_int64_cas(&lp_internal->mark[u], old, lp_internal->stamp) == old) {
+    lp_internal->next_frontier[stinger_int64_fetch_add(count, 1)] = u;
+  }
+}
+
+/*
+ * Synchronous rounds starting from the nfrontier vertices in
+ * lp_internal->frontier. Returns the number of labels changed.
+ */
+static int64_t
+lp_propagate(stinger_t * S, stinger_label_propagation_internal * lp_internal, int64_t nfrontier,
+  int64_t * labels, stinger_label_propagation_stats * stats)
+{
+  int64_t nv = lp_internal->nv;
+  int64_t total_changed = 0;
+  int64_t rounds = 0;
+  int64_t evaluated = 0;
+
+  while (nfrontier > 0 && rounds < lp_internal->max_iterations) {
+    int64_t nchanged = 0;
+    int64_t * frontier = lp_internal->frontier;
+
+    OMP("omp parallel")
+    {
+      lp_histogram hist;
+      memset(&hist, 0, sizeof(lp_histogram));
+
+      OMP("omp for schedule(dynamic, 64)")
+      for (int64_t i = 0; i < nfrontier; i++) {
+        int64_t v = frontier[i];
+        int64_t label = lp_choose_label(S, nv, v, labels, &hist);
+        if (label != labels[v]) {
+          lp_internal->next_label[v] = label;
+          lp_internal->changed[stinger_int64_fetch_add(&nchanged, 1)] = v;
+        }
+      }
+
+      lp_histogram_release(&hist);
+    }
+
+    rounds++;
+    evaluated += nfrontier;
+    total_changed += nchanged;
+
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < nchanged; i++) {
+      int64_t v = lp_internal->changed[i];
+      labels[v] = lp_internal->next_label[v];
+    }
+
+    /* a change can move the neighbors, and the vertex itself if its old label
+     * still has support around it */
+    lp_internal->stamp++;
+    int64_t nnext = 0;
+    OMP("omp parallel for schedule(dynamic, 64)")
+    for (int64_t i = 0; i < nchanged; i++) {
+      int64_t v = lp_internal->changed[i];
+      lp_enqueue(lp_internal, v, &nnext);
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t u = STINGER_EDGE_DEST;
+        if (u >= 0 && u < nv)
+          lp_enqueue(lp_internal, u, &nnext);
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+
+    lp_internal->frontier = lp_internal->next_frontier;
+    lp_internal->next_frontier = frontier;
+    nfrontier = nnext;
+  }
+
+  if (stats) {
+    stats->rounds += rounds;
+    stats->vertices_evaluated += evaluated;
+    stats->labels_changed += total_changed;
+  }
+
+  return total_changed;
+}
+
+void
+stinger_label_propagation_reset_stats(stinger_label_propagation_stats * stats)
+{
+  stats->rounds = 0;
+  stats->vertices_evaluated = 0;
+  stats->labels_changed = 0;
+}
+
+void
+stinger_label_propagation_initialize_internals(stinger_t * S, int64_t nv,
+  stinger_label_propagation_internal * lp_internal, int64_t max_iterations,
+  int64_t * labels, stinger_label_propagation_stats * stats)
+{
+  memset(lp_internal, 0, sizeof(stinger_label_propagation_internal));
+  lp_internal->nv = nv;
+  lp_internal->max_iterations = max_iterations > 0 ? max_iterations : LABEL_PROPAGATION_DEFAULT_ITERATIONS;
+  lp_internal->stamp = 1;
+  lp_internal->mark = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  lp_internal->next_label = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  lp_internal->frontier = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  lp_internal->next_frontier = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  lp_internal->changed = (int64_t *)xmalloc(nv * sizeof(int64_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    labels[v] = v;
+    lp_internal->frontier[v] = v;
+  }
+
+  lp_propagate(S, lp_internal, nv, labels, stats);
+}
+
+void
+stinger_label_propagation_release_internals(stinger_label_propagation_internal * lp_internal)
+{
+  if (lp_internal->mark) {
+    xfree(lp_internal->mark);
+    xfree(lp_internal->next_label);
+    xfree(lp_internal->frontier);
+    xfree(lp_internal->next_frontier);
+    xfree(lp_internal->changed);
+  }
+  memset(lp_internal, 0, sizeof(stinger_label_propagation_internal));
+}
+
+int64_t
+stinger_label_propagation_update(stinger_t * S, stinger_label_propagation_internal * lp_internal,
+  stinger_label_propagation_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * labels)
+{
+  int64_t nv = lp_internal->nv;
+  int64_t nfrontier = 0;
+
+  /* lp_enqueue fills next_frontier, which becomes the first frontier */
+  lp_internal->stamp++;
+  OMP("omp parallel for")
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    if (u >= 0 && u < nv)
+      lp_enqueue(lp_internal, u, &nfrontier);
+    if (v >= 0 && v < nv)
+      lp_enqueue(lp_internal, v, &nfrontier);
+  }
+  OMP("omp parallel for")
+  for (int64_t k = 0; k < num_deletions; k++) {
+    int64_t u = deletions[k].source;
+    int64_t v = deletions[k].destination;
+    if (u >= 0 && u < nv)
+      lp_enqueue(lp_internal, u, &nfrontier);
+    if (v >= 0 && v < nv)
+      lp_enqueue(lp_internal, v, &nfrontier);
+  }
+
+  int64_t * tmp = lp_internal->frontier;
+  lp_internal->frontier = lp_internal->next_frontier;
+  lp_internal->next_frontier = tmp;
+
+  return lp_propagate(S, lp_internal, nfrontier, labels, stats);
+}
+
+int64_t
+label_propagation_count(int64_t nv, const int64_t * labels)
+{
+  uint8_t * seen = (uint8_t *)xcalloc(nv, sizeof(uint8_t));
+  int64_t count = 0;
+
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t label = labels[v];
+    if (label >= 0 && label < nv && !seen[label]) {
+      seen[label] = 1;
+      count++;
+    }
+  }
+
+  xfree(seen);
+  return count;
+}
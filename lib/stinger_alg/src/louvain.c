@@ -0,0 +1,686 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
+#include "louvain.h"
+
+/*
+ * Weighted undirected graph for one level. Level 0 is built from STINGER;
+ * every later level has one vertex per community of the level below, with the
+ * weight inside the community kept as a self-loop.
+ */
+typedef struct {
+  int64_t   nv;
+  int64_t * off;
+  int64_t * adj;
+  double  * wgt;
+  double  * self;   /* self-loop weight */
+  double  * k;      /* weighted degree, self-loop included */
+  double    total;  /* sum of k, twice the edge weight of the graph */
+} louvain_graph;
+
+/*
+ * Open-addressing map from community to accumulated edge weight, one per
+ * thread. Slots in use are remembered so clearing costs only what was added.
+ */
+typedef struct {
+  int64_t   cap;
+  int64_t * keys;
+  double  * vals;
+  int64_t   nused;
+  int64_t * used;
+} louvain_accum;
+
+static void
+accum_reserve(louvain_accum * acc, int64_t n)
+{
+  int64_t cap = 16;
+  while (cap < 2 * n)
+    cap <<= 1;
+  if (cap <= acc->cap)
+    return;
+
+  if (acc->cap) {
+    xfree(acc->keys);
+    xfree(acc->vals);
+    xfree(acc->used);
+  }
+  acc->keys = (int64_t *)xmalloc(cap * sizeof(int64_t));
+  acc->vals = (double *)xmalloc(cap * sizeof(double));
+  acc->used = (int64_t *)xmalloc(cap * sizeof(int64_t));
+  for (int64_t i = 0; i < cap; i++) {
+    acc->keys[i] = -1;
+  }
+  acc->cap = cap;
+  acc->nused = 0;
+}
+
+static void
+accum_release(louvain_accum * acc)
+{
+  if (acc->cap) {
+    xfree(acc->keys);
+    xfree(acc->vals);
+    xfree(acc->used);
+  }
+  memset(acc, 0, sizeof(louvain_accum));
+}
+
+static inline int64_t
+accum_slot(const louvain_accum * acc, int64_t key)
+{
+  uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+  h ^= h >> 29;
+  h &= (uint64_t)(acc->cap - 1);
+  while (acc->keys[h] != -1 && acc->keys[h] != key) {
+    h = (h + 1) & (uint64_t)(acc->cap - 1);
+  }
+  return (int64_t)h;
+}
+
+static inline void
+accum_add(louvain_accum * acc, int64_t key, double w)
+{
+  int64_t h = accum_slot(acc, key);
+  if (acc->keys[h] == -1) {
+    acc->keys[h] = key;
+    acc->vals[h] = 0;
+    acc->used[acc->nused++] = h;
+  }
+  acc->vals[h] += w;
+}
+
+static inline void
+accum_clear(louvain_accum * acc)
+{
+  for (int64_t i = 0; i < acc->nused; i++) {
+    acc->keys[acc->used[i]] = -1;
+  }
+  acc->nused = 0;
+}
+
+static void
+louvain_graph_release(louvain_graph * g)
+{
+  xfree(g->off);
+  xfree(g->adj);
+  xfree(g->wgt);
+  xfree(g->self);
+  xfree(g->k);
+  memset(g, 0, sizeof(louvain_graph));
+}
+
+/*
+ * Packs the rows in tmp_adj/tmp_wgt (row v starts at bound[v] and holds len[v]
+ * entries) into g's CSR arrays and computes degrees and the total weight.
+ */
+static void
+louvain_graph_pack(louvain_graph * g, const int64_t * bound, const int64_t * len,
+  const int64_t * tmp_adj, const double * tmp_wgt)
+{
+  int64_t nv = g->nv;
+
+  g->off = (int64_t *)xmalloc((nv + 1) * sizeof(int64_t));
+  g->off[0] = 0;
+  for (int64_t v = 0; v < nv; v++) {
+    g->off[v + 1] = g->off[v] + len[v];
+  }
+
+  int64_t ne = g->off[nv];
+  g->adj = (int64_t *)xmalloc((ne ? ne : 1) * sizeof(int64_t));
+  g->wgt = (double *)xmalloc((ne ? ne : 1) * sizeof(double));
+
+  double total = 0;
+  OMP("omp parallel for reduction(+:total)")
+  for (int64_t v = 0; v < nv; v++) {
+    double kv = g->self[v];
+    memcpy(g->adj + g->off[v], tmp_adj + bound[v], len[v] * sizeof(int64_t));
+    memcpy(g->wgt + g->off[v], tmp_wgt + bound[v], len[v] * sizeof(double));
+    for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+      kv += g->wgt[e];
+    }
+    g->k[v] = kv;
+    total += kv;
+  }
+  g->total = total;
+}
+
+/*
+ * Level 0: out-edges of every type from each vertex below nv, with parallel
+ * edges to the same neighbor merged.
+ */
+static void
+louvain_graph_from_stinger(stinger_t * S, int64_t nv, louvain_graph * g)
+{
+  int64_t * bound = (int64_t *)xmalloc((nv + 1) * sizeof(int64_t));
+  int64_t * len = (int64_t *)xcalloc(nv, sizeof(int64_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    bound[v + 1] = stinger_outdegree_get(S, v);
+  }
+  bound[0] = 0;
+  for (int64_t v = 0; v < nv; v++) {
+    bound[v + 1] += bound[v];
+  }
+
+  int64_t ne = bound[nv];
+  int64_t * tmp_adj = (int64_t *)xmalloc((ne ? ne : 1) * sizeof(int64_t));
+  double * tmp_wgt = (double *)xmalloc((ne ? ne : 1) * sizeof(double));
+
+  g->nv = nv;
+  g->self = (double *)xcalloc(nv, sizeof(double));
+  g->k = (double *)xcalloc(nv, sizeof(double));
+
+  OMP("omp parallel")
+  {
+    louvain_accum acc;
+    memset(&acc, 0, sizeof(louvain_accum));
+
+    OMP("omp for schedule(dynamic, 64)")
+    for (int64_t v = 0; v < nv; v++) {
+      int64_t begin = bound[v];
+      int64_t end = bound[v + 1];
+      double loop = 0;
+      accum_reserve(&acc, end - begin + 1);
+
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t u = STINGER_EDGE_DEST;
+        double w = STINGER_EDGE_WEIGHT > 0 ? (double)STINGER_EDGE_WEIGHT : 1.0;
+        if (u == v) {
+          loop += w;
+        } else if (u >= 0 && u < nv && acc.nused < end - begin) {
+          accum_add(&acc, u, w);
+        }
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+
+      for (int64_t i = 0; i < acc.nused; i++) {
+        int64_t h = acc.used[i];
+        tmp_adj[begin + i] = acc.keys[h];
+        tmp_wgt[begin + i] = acc.vals[h];
+      }
+      len[v] = acc.nused;
+      g->self[v] = loop;
+      accum_clear(&acc);
+    }
+
+    accum_release(&acc);
+  }
+
+  louvain_graph_pack(g, bound, len, tmp_adj, tmp_wgt);
+
+  xfree(tmp_wgt);
+  xfree(tmp_adj);
+  xfree(len);
+  xfree(bound);
+}
+
+/*
+ * Builds the next level: community c of g (dense id newid[comm[v]]) becomes
+ * vertex c of out, its internal weight becomes the self-loop.
+ */
+static void
+louvain_contract(const louvain_graph * g, const int64_t * comm, const int64_t * newid, int64_t nc,
+  louvain_graph * out)
+{
+  int64_t nv = g->nv;
+  int64_t * moff = (int64_t *)xcalloc(nc + 1, sizeof(int64_t));
+  int64_t * bound = (int64_t *)xcalloc(nc + 1, sizeof(int64_t));
+  int64_t * pos = (int64_t *)xmalloc(nc * sizeof(int64_t));
+  int64_t * members = (int64_t *)xmalloc((nv ? nv : 1) * sizeof(int64_t));
+  int64_t * len = (int64_t *)xcalloc(nc, sizeof(int64_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t c = newid[comm[v]];
+    stinger_int64_fetch_add(&moff[c + 1], 1);
+    stinger_int64_fetch_add(&bound[c + 1], g->off[v + 1] - g->off[v]);
+  }
+  for (int64_t c = 0; c < nc; c++) {
+    moff[c + 1] += moff[c];
+    bound[c + 1] += bound[c];
+    pos[c] = moff[c];
+  }
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    members[stinger_int64_fetch_add(&pos[newid[comm[v]]], 1)] = v;
+  }
+
+  int64_t ne = bound[nc];
+  int64_t * tmp_adj = (int64_t *)xmalloc((ne ? ne : 1) * sizeof(int64_t));
+  double * tmp_wgt = (double *)xmalloc((ne ? ne : 1) * sizeof(double));
+
+  out->nv = nc;
+  out->self = (double *)xcalloc(nc, sizeof(double));
+  out->k = (double *)xcalloc(nc, sizeof(double));
+
+  OMP("omp parallel")
+  {
+    louvain_accum acc;
+    memset(&acc, 0, sizeof(louvain_accum));
+
+    OMP("omp for schedule(dynamic, 16)")
+    for (int64_t c = 0; c < nc; c++) {
+      double self = 0;
+      accum_reserve(&acc, bound[c + 1] - bound[c] + 1);
+
+      for (int64_t m = moff[c]; m < moff[c + 1]; m++) {
+        int64_t v = members[m];
+        self += g->self[v];
+        for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+          int64_t d = newid[comm[g->adj[e]]];
+          if (d == c)
+            self += g->wgt[e];
+          else
+            accum_add(&acc, d, g->wgt[e]);
+        }
+      }
+
+      for (int64_t i = 0; i < acc.nused; i++) {
+        int64_t h = acc.used[i];
+        tmp_adj[bound[c] + i] = acc.keys[h];
+        tmp_wgt[bound[c] + i] = acc.vals[h];
+      }
+      len[c] = acc.nused;
+      out->self[c] = self;
+      accum_clear(&acc);
+    }
+
+    accum_release(&acc);
+  }
+
+  louvain_graph_pack(out, bound, len, tmp_adj, tmp_wgt);
+
+  xfree(tmp_wgt);
+  xfree(tmp_adj);
+  xfree(len);
+  xfree(members);
+  xfree(pos);
+  xfree(bound);
+  xfree(moff);
+}
+
+/* tot[c] and size[c] for every community label c in [0, g->nv) */
+static void
+louvain_community_totals(const louvain_graph * g, const int64_t * comm, double * tot, int64_t * size)
+{
+  OMP("omp parallel for")
+  for (int64_t c = 0; c < g->nv; c++) {
+    tot[c] = 0;
+    size[c] = 0;
+  }
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < g->nv; v++) {
+    int64_t c = comm[v];
+    OMP("omp atomic")
+    tot[c] += g->k[v];
+    stinger_int64_fetch_add(&size[c], 1);
+  }
+}
+
+/*
+ * Parallel local moving. Each round visits the vertices flagged in active and
+ * moves each one to the neighboring community with the largest modularity
+ * gain; the neighbors of every vertex that moved are flagged for the next
+ * round. Moves are applied immediately, so later vertices in a round see them.
+ * Ties keep the vertex where it is, and a singleton only joins another
+ * singleton with a smaller label so pairs of vertices cannot keep swapping.
+ * Returns the number of moves; active is left cleared.
+ */
+static int64_t
+louvain_local_moving(const louvain_graph * g, int64_t * comm, double * tot, int64_t * size,
+  uint8_t * active, int64_t max_iterations, int64_t * examined)
+{
+  int64_t nv = g->nv;
+  double m2 = g->total;
+  int64_t total_moves = 0;
+  int64_t total_examined = 0;
+
+  if (m2 <= 0) {
+    memset(active, 0, nv * sizeof(uint8_t));
+    return 0;
+  }
+
+  uint8_t * next = (uint8_t *)xcalloc(nv, sizeof(uint8_t));
+
+  for (int64_t iter = 0; iter < max_iterations; iter++) {
+    int64_t moves = 0;
+    int64_t visited = 0;
+
+    OMP("omp parallel reduction(+:moves, visited)")
+    {
+      louvain_accum acc;
+      memset(&acc, 0, sizeof(louvain_accum));
+
+      OMP("omp for schedule(dynamic, 64)")
+      for (int64_t v = 0; v < nv; v++) {
+        if (!active[v])
+          continue;
+        active[v] = 0;
+        visited++;
+
+        int64_t deg = g->off[v + 1] - g->off[v];
+        if (deg == 0)
+          continue;
+
+        int64_t a = comm[v];
+        double kv = g->k[v];
+
+        accum_reserve(&acc, deg + 1);
+        accum_add(&acc, a, 0.0);
+        for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+          accum_add(&acc, comm[g->adj[e]], g->wgt[e]);
+        }
+
+        /* gain of joining c, up to terms that are the same for every c */
+        int64_t best = a;
+        double best_gain = acc.vals[accum_slot(&acc, a)] - kv * (tot[a] - kv) / m2;
+        for (int64_t i = 0; i < acc.nused; i++) {
+          int64_t h = acc.used[i];
+          int64_t c = acc.keys[h];
+          if (c == a)
+            continue;
+          double gain = acc.vals[h] - kv * tot[c] / m2;
+          if (gain > best_gain + 1e-12 || (best != a && gain >= best_gain - 1e-12 && c < best)) {
+            best = c;
+            best_gain = gain;
+          }
+        }
+        accum_clear(&acc);
+
+        if (best == a)
+          continue;
+        if (size[a] == 1 && size[best] == 1 && best > a)
+          continue;
+
+        OMP("omp atomic")
+        tot[a] -= kv;
+        OMP("omp atomic")
+        tot[best] += kv;
+        stinger_int64_fetch_add(&size[a], -1);
+        stinger_int64_fetch_add(&size[best], 1);
+        comm[v] = best;
+        moves++;
+
+        for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+          next[g->adj[e]] = 1;
+        }
+      }
+
+      accum_release(&acc);
+    }
+
+    total_moves += moves;
+    total_examined += visited;
+
+    if (moves == 0 || iter + 1 == max_iterations)
+      break;
+
+    memcpy(active, next, nv * sizeof(uint8_t));
+    memset(next, 0, nv * sizeof(uint8_t));
+  }
+
+  xfree(next);
+  if (examined)
+    *examined += total_examined;
+
+  return total_moves;
+}
+
+/*
+ * Splits every community into its connected pieces and labels each piece by
+ * its smallest vertex, by min-label propagation with shortcutting restricted
+ * to edges inside a community. Splitting never lowers modularity.
+ */
+static int64_t
+louvain_split_and_label(const louvain_graph * g, const int64_t * label, int64_t * partitions)
+{
+  int64_t nv = g->nv;
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    partitions[v] = v;
+  }
+
+  int64_t changed;
+  do {
+    changed = 0;
+
+    OMP("omp parallel for reduction(+:changed) schedule(dynamic, 64)")
+    for (int64_t v = 0; v < nv; v++) {
+      int64_t best = partitions[v];
+      for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+        int64_t u = g->adj[e];
+        if (label[u] == label[v] && partitions[u] < best)
+          best = partitions[u];
+      }
+      if (best < partitions[v]) {
+        partitions[v] = best;
+        changed++;
+      }
+    }
+
+    OMP("omp parallel for")
+    for (int64_t v = 0; v < nv; v++) {
+      while (partitions[v] != partitions[partitions[v]]) {
+        partitions[v] = partitions[partitions[v]];
+      }
+    }
+  } while (changed);
+
+  int64_t count = 0;
+  OMP("omp parallel for reduction(+:count)")
+  for (int64_t v = 0; v < nv; v++) {
+    count += (partitions[v] == v);
+  }
+  return count;
+}
+
+static double
+louvain_modularity(const louvain_graph * g, const int64_t * comm, double * tot)
+{
+  if (g->total <= 0)
+    return 0;
+
+  double inside = 0;
+  OMP("omp parallel for reduction(+:inside)")
+  for (int64_t v = 0; v < g->nv; v++) {
+    inside += g->self[v];
+    for (int64_t e = g->off[v]; e < g->off[v + 1]; e++) {
+      if (comm[g->adj[e]] == comm[v])
+        inside += g->wgt[e];
+    }
+  }
+
+  OMP("omp parallel for")
+  for (int64_t c = 0; c < g->nv; c++) {
+    tot[c] = 0;
+  }
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < g->nv; v++) {
+    OMP("omp atomic")
+    tot[comm[v]] += g->k[v];
+  }
+
+  double squares = 0;
+  OMP("omp parallel for reduction(+:squares)")
+  for (int64_t c = 0; c < g->nv; c++) {
+    squares += tot[c] * tot[c];
+  }
+
+  return inside / g->total - squares / (g->total * g->total);
+}
+
+/*
+ * Shared driver. With warm set, partitions holds the starting labels (all in
+ * [0, nv)) and active the vertices to optimize on the first level; otherwise
+ * every vertex starts alone and active is ignored.
+ */
+static int64_t
+louvain_run(stinger_t * S, int64_t nv, int64_t * partitions, int warm, uint8_t * active,
+  int64_t max_levels, int64_t max_iterations, stinger_louvain_stats * stats)
+{
+  if (nv <= 0)
+    return 0;
+  if (max_levels < 1)
+    max_levels = 1;
+  if (max_iterations < 1)
+    max_iterations = 1;
+
+  louvain_graph g0;
+  louvain_graph_from_stinger(S, nv, &g0);
+
+  int64_t * label = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * comm = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * size = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * newid = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  double * tot = (double *)xmalloc(nv * sizeof(double));
+  uint8_t * flags = (uint8_t *)xmalloc(nv * sizeof(uint8_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    label[v] = v;
+    comm[v] = warm ? partitions[v] : v;
+    flags[v] = warm ? active[v] : 1;
+  }
+
+  if (warm) {
+    /* the neighbors of the seeds can gain from following them */
+    OMP("omp parallel for schedule(dynamic, 64)")
+    for (int64_t v = 0; v < nv; v++) {
+      if (active[v]) {
+        for (int64_t e = g0.off[v]; e < g0.off[v + 1]; e++) {
+          flags[g0.adj[e]] = 1;
+        }
+      }
+    }
+  }
+
+  int64_t levels = 0;
+  int64_t moves = 0;
+  int64_t examined = 0;
+
+  louvain_graph level = g0;
+  for (int64_t l = 0; l < max_levels; l++) {
+    louvain_community_totals(&level, comm, tot, size);
+    moves += louvain_local_moving(&level, comm, tot, size, flags, max_iterations, &examined);
+    levels++;
+
+    OMP("omp parallel for")
+    for (int64_t c = 0; c < level.nv; c++) {
+      newid[c] = 0;
+    }
+    OMP("omp parallel for")
+    for (int64_t v = 0; v < level.nv; v++) {
+      newid[comm[v]] = 1;
+    }
+    int64_t nc = 0;
+    for (int64_t c = 0; c < level.nv; c++) {
+      newid[c] = newid[c] ? nc++ : -1;
+    }
+
+    OMP("omp parallel for")
+    for (int64_t v = 0; v < nv; v++) {
+      label[v] = newid[comm[label[v]]];
+    }
+
+    if (nc == level.nv || l + 1 >= max_levels)
+      break;
+
+    louvain_graph next;
+    louvain_contract(&level, comm, newid, nc, &next);
+    if (level.off != g0.off)
+      louvain_graph_release(&level);
+    level = next;
+
+    OMP("omp parallel for")
+    for (int64_t v = 0; v < nc; v++) {
+      comm[v] = v;
+      flags[v] = 1;
+    }
+  }
+  if (level.off != g0.off)
+    louvain_graph_release(&level);
+
+  int64_t communities = louvain_split_and_label(&g0, label, partitions);
+
+  if (stats) {
+    stats->levels += levels;
+    stats->moves += moves;
+    stats->vertices_examined += examined;
+    stats->communities = communities;
+    stats->modularity = louvain_modularity(&g0, partitions, tot);
+  }
+
+  xfree(flags);
+  xfree(tot);
+  xfree(newid);
+  xfree(size);
+  xfree(comm);
+  xfree(label);
+  louvain_graph_release(&g0);
+
+  return communities;
+}
+
+void
+stinger_louvain_reset_stats(stinger_louvain_stats * stats)
+{
+  stats->levels = 0;
+  stats->moves = 0;
+  stats->vertices_examined = 0;
+  stats->communities = 0;
+  stats->modularity = 0;
+}
+
+int64_t
+louvain_communities(stinger_t * S, int64_t nv, int64_t * partitions,
+  int64_t max_levels, int64_t max_iterations, stinger_louvain_stats * stats)
+{
+  return louvain_run(S, nv, partitions, 0, NULL, max_levels, max_iterations, stats);
+}
+
+int64_t
+louvain_communities_update(stinger_t * S, int64_t old_nv, int64_t nv, int64_t * partitions,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t max_levels, int64_t max_iterations, stinger_louvain_stats * stats)
+{
+  if (nv <= 0)
+    return 0;
+
+  uint8_t * active = (uint8_t *)xcalloc(nv, sizeof(uint8_t));
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    if (v >= old_nv || partitions[v] < 0 || partitions[v] >= nv) {
+      partitions[v] = v;
+      active[v] = 1;
+    }
+  }
+
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    if (u >= 0 && u < nv)
+      active[u] = 1;
+    if (v >= 0 && v < nv)
+      active[v] = 1;
+  }
+  for (int64_t k = 0; k < num_deletions; k++) {
+    int64_t u = deletions[k].source;
+    int64_t v = deletions[k].destination;
+    if (u >= 0 && u < nv)
+      active[u] = 1;
+    if (v >= 0 && v < nv)
+      active[v] = 1;
+  }
+
+  int64_t communities = louvain_run(S, nv, partitions, 1, active, max_levels, max_iterations, stats);
+
+  xfree(active);
+  return communities;
+}
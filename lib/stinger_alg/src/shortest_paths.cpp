@@ -4,6 +4,16 @@
 //
 #include "shortest_paths.h"
 
+#include <math.h>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+extern "C" {
+#include "stinger_core/stinger_atomics.h"
+}
+
 //these algorithms need to be sorted based on cost to reach them,
 //thus we need a new structure to handle vertex cost pairs
 typedef struct{
@@ -12,10 +22,11 @@ typedef struct{
 }weighted_vertex_t;
 
 //this is a simple comparison function for the queue that sorts based on the cost to reach a vertex
+//std::priority_queue puts the largest element on top, so the cheaper vertex must compare greater
 bool
 comp(weighted_vertex_t a, weighted_vertex_t b)
 {
-    return a.cost < b.cost;
+    return a.cost > b.cost;
 }
 typedef bool(*CompareType)(weighted_vertex_t a, weighted_vertex_t b);
 
@@ -44,6 +55,10 @@ a_star(stinger_t * S, int64_t NV, int64_t source_vertex, int64_t dest_vertex, bo
         weighted_vertex_t current = frontier.top();
         frontier.pop();
 
+        if (current.cost > cost_so_far[current.vertex]) {
+            continue; // a cheaper copy of this vertex was already settled
+        }
+
         if (current.vertex == dest_vertex) {
             //we found our goal!
             return cost_so_far[current.vertex];
@@ -96,6 +111,10 @@ dijkstra(stinger_t * S, int64_t NV, int64_t source_vertex, bool ignore_weights){
         weighted_vertex_t current = frontier.top();
         frontier.pop();
 
+        if (current.cost > cost_so_far[current.vertex]) {
+            continue; // a cheaper copy of this vertex was already settled
+        }
+
         STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, current.vertex){
                                     int64_t new_cost;
                                     if (ignore_weights){
@@ -116,28 +135,454 @@ dijkstra(stinger_t * S, int64_t NV, int64_t source_vertex, bool ignore_weights){
     return cost_so_far;
 }
 
+//Picks a bucket width for delta_stepping: 1 when weights are ignored, otherwise the mean
+//positive edge weight, which keeps the number of buckets close to the number of hops.
+int64_t
+delta_stepping_default_delta(stinger_t * S, int64_t NV, bool ignore_weights){
+    if (ignore_weights){
+        return 1;
+    }
+    int64_t total = 0;
+    int64_t count = 0;
+    OMP("omp parallel for reduction(+:total, count)")
+    for (int64_t v = 0; v < NV; v++){
+        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v){
+            if (STINGER_EDGE_WEIGHT > 0){
+                total += STINGER_EDGE_WEIGHT;
+                count++;
+            }
+        }STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+    int64_t delta = count ? total / count : 1;
+    return delta > 0 ? delta : 1;
+}
+
+//buckets smaller than this are drained by the thread that owns them without another global round
+#define DELTA_STEPPING_BIN_SIZE_THRESHOLD 1000
+
+//Relax the out-edges of u. Improved vertices are appended to the calling thread's bucket for their new distance.
+static inline void
+delta_stepping_relax(stinger_t * S, int64_t NV, int64_t u, bool ignore_weights, int64_t delta,
+                     int64_t * dist, std::vector<std::vector<int64_t> > & local_bins){
+    int64_t du = dist[u];
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u){
+        int64_t v = STINGER_EDGE_DEST;
+        int64_t w = ignore_weights ? 1 : STINGER_EDGE_WEIGHT;
+        if (v < NV && w >= 0){
+            int64_t new_dist = du + w;
+            int64_t old_dist = dist[v];
+            while (new_dist < old_dist){
+                if (stinger_int64_cas(dist + v, old_dist, new_dist) == old_dist){
+                    size_t bin = (size_t)(new_dist / delta);
+                    if (bin >= local_bins.size()){
+                        local_bins.resize(bin + 1);
+                    }
+                    local_bins[bin].push_back(v);
+                    break;
+                }
+                old_dist = dist[v];
+            }
+        }
+    }STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+}
+
+//Parallel delta-stepping from a single source into dist (NV entries, already set to infinity).
+//Each thread keeps its own buckets; every round the smallest non-empty bucket across threads
+//is gathered into a shared frontier and relaxed in parallel. The structure follows the GAP
+//benchmark suite implementation (S. Beamer, K. Asanovic, D. Patterson, arXiv:1508.03619).
+static void
+delta_stepping_run(stinger_t * S, int64_t NV, int64_t source_vertex, bool ignore_weights, int64_t delta, int64_t * dist){
+    const size_t max_bin = std::numeric_limits<size_t>::max() / 2;
+
+    //a vertex enters the frontier once per improvement, which is bounded by its in-degree
+    int64_t num_edges = 0;
+    OMP("omp parallel for reduction(+:num_edges)")
+    for (int64_t v = 0; v < NV; v++){
+        num_edges += stinger_outdegree_get(S, v);
+    }
+    std::vector<int64_t> frontier(num_edges + NV + 1);
+
+    dist[source_vertex] = 0;
+    frontier[0] = source_vertex;
+    size_t shared_indexes[2] = {0, max_bin};
+    int64_t frontier_tails[2] = {1, 0};
+
+    OMP("omp parallel")
+    {
+        std::vector<std::vector<int64_t> > local_bins;
+        size_t iter = 0;
+
+        while (shared_indexes[iter & 1] != max_bin){
+            size_t & curr_bin_index = shared_indexes[iter & 1];
+            size_t & next_bin_index = shared_indexes[(iter + 1) & 1];
+            int64_t & curr_frontier_tail = frontier_tails[iter & 1];
+            int64_t & next_frontier_tail = frontier_tails[(iter + 1) & 1];
+
+            OMP("omp for nowait schedule(dynamic, 64)")
+            for (int64_t i = 0; i < curr_frontier_tail; i++){
+                int64_t u = frontier[i];
+                //stale entries were superseded by a shorter distance in an earlier bucket
+                if (dist[u] >= delta * (int64_t)curr_bin_index){
+                    delta_stepping_relax(S, NV, u, ignore_weights, delta, dist, local_bins);
+                }
+            }
+
+            while (curr_bin_index < local_bins.size() &&
+                   !local_bins[curr_bin_index].empty() &&
+                   local_bins[curr_bin_index].size() < DELTA_STEPPING_BIN_SIZE_THRESHOLD){
+                std::vector<int64_t> curr_bin_copy;
+                curr_bin_copy.swap(local_bins[curr_bin_index]);
+                for (size_t i = 0; i < curr_bin_copy.size(); i++){
+                    delta_stepping_relax(S, NV, curr_bin_copy[i], ignore_weights, delta, dist, local_bins);
+                }
+            }
+
+            for (size_t i = curr_bin_index; i < local_bins.size(); i++){
+                if (!local_bins[i].empty()){
+                    OMP("omp critical")
+                    next_bin_index = std::min(next_bin_index, i);
+                    break;
+                }
+            }
+
+            OMP("omp barrier")
+            OMP("omp single nowait")
+            {
+                curr_bin_index = max_bin;
+                curr_frontier_tail = 0;
+            }
+
+            if (next_bin_index < local_bins.size()){
+                std::vector<int64_t> & bin = local_bins[next_bin_index];
+                int64_t copy_start = stinger_int64_fetch_add(&next_frontier_tail, (int64_t)bin.size());
+                std::copy(bin.begin(), bin.end(), frontier.begin() + copy_start);
+                bin.clear();
+            }
+
+            iter++;
+            OMP("omp barrier")
+        }
+    }
+}
+
+//Parallel single source shortest paths by delta-stepping
+//("Delta-stepping: a parallelizable shortest path algorithm", U. Meyer and P. Sanders, J. Algorithms 2003).
+//Returns the same distances as dijkstra. Edges with negative weights are skipped.
+//A delta <= 0 selects delta_stepping_default_delta.
+std::vector<int64_t>
+delta_stepping(stinger_t * S, int64_t NV, int64_t source_vertex, bool ignore_weights, int64_t delta){
+    std::vector<int64_t> dist(NV, std::numeric_limits<int64_t>::max());
+    if (source_vertex < 0 || source_vertex >= NV){
+        return dist;
+    }
+    if (delta <= 0){
+        delta = delta_stepping_default_delta(S, NV, ignore_weights);
+    }
+    delta_stepping_run(S, NV, source_vertex, ignore_weights, delta, dist.data());
+    return dist;
+}
+
+//Shortest paths from several sources. With at least as many sources as threads every thread
+//runs its own serial search; otherwise the sources are handled one after another with the
+//parallel delta-stepping search. Row i holds the distances from sources[i].
+std::vector<std::vector<int64_t> >
+multi_source_shortest_paths(stinger_t * S, int64_t NV, const std::vector<int64_t> & sources, bool ignore_weights, int64_t delta){
+    int64_t num_sources = (int64_t)sources.size();
+    std::vector<std::vector<int64_t> > dist(num_sources);
+
+    int64_t num_threads = 1;
+#if defined(_OPENMP)
+    num_threads = omp_get_max_threads();
+#endif
+
+    if (num_sources >= num_threads){
+        OMP("omp parallel for schedule(dynamic, 1)")
+        for (int64_t i = 0; i < num_sources; i++){
+            if (sources[i] >= 0 && sources[i] < NV){
+                dist[i] = dijkstra(S, NV, sources[i], ignore_weights);
+            } else {
+                dist[i].assign(NV, std::numeric_limits<int64_t>::max());
+            }
+        }
+    } else {
+        if (delta <= 0){
+            delta = delta_stepping_default_delta(S, NV, ignore_weights);
+        }
+        for (int64_t i = 0; i < num_sources; i++){
+            dist[i] = delta_stepping(S, NV, sources[i], ignore_weights, delta);
+        }
+    }
+    return dist;
+}
+
+//Point to point shortest path by bidirectional search: one search runs forward along out-edges
+//from the source and one backward along in-edges from the destination, always advancing the side
+//with the smaller queue. The search stops once the two queue heads together cannot improve on the
+//best meeting point. Returns the path length, or the max integer value if there is no path.
+//STINGER only keeps edge weights on the out-edge records, so weighted queries use the
+//forward search in a_star instead.
+int64_t
+bidirectional_shortest_path(stinger_t * S, int64_t NV, int64_t source_vertex, int64_t dest_vertex, bool ignore_weights){
+    const int64_t inf = std::numeric_limits<int64_t>::max();
+    if (source_vertex < 0 || source_vertex >= NV || dest_vertex < 0 || dest_vertex >= NV){
+        return inf;
+    }
+    if (source_vertex == dest_vertex){
+        return 0;
+    }
+    if (!ignore_weights){
+        return a_star(S, NV, source_vertex, dest_vertex, false);
+    }
+
+    std::vector<int64_t> dist_fwd(NV, inf);
+    std::vector<int64_t> dist_bwd(NV, inf);
+    std::priority_queue<weighted_vertex_t, std::vector<weighted_vertex_t>, CompareType> frontier_fwd (comp);
+    std::priority_queue<weighted_vertex_t, std::vector<weighted_vertex_t>, CompareType> frontier_bwd (comp);
+
+    weighted_vertex_t start;
+    start.vertex = source_vertex;
+    start.cost = 0;
+    dist_fwd[source_vertex] = 0;
+    frontier_fwd.push(start);
+    start.vertex = dest_vertex;
+    dist_bwd[dest_vertex] = 0;
+    frontier_bwd.push(start);
+
+    int64_t best = inf;
+
+    while (!frontier_fwd.empty() && !frontier_bwd.empty()){
+        if (frontier_fwd.top().cost + frontier_bwd.top().cost >= best){
+            break;
+        }
+
+        bool forward = frontier_fwd.size() <= frontier_bwd.size();
+        std::priority_queue<weighted_vertex_t, std::vector<weighted_vertex_t>, CompareType> & frontier =
+            forward ? frontier_fwd : frontier_bwd;
+        std::vector<int64_t> & dist = forward ? dist_fwd : dist_bwd;
+        std::vector<int64_t> & other = forward ? dist_bwd : dist_fwd;
+
+        weighted_vertex_t current = frontier.top();
+        frontier.pop();
+        if (current.cost > dist[current.vertex]){
+            continue;
+        }
+
+        if (forward){
+            STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, current.vertex){
+                int64_t v = STINGER_EDGE_DEST;
+                if (v < NV){
+                    int64_t new_cost = current.cost + 1;
+                    if (new_cost < dist[v]){
+                        dist[v] = new_cost;
+                        weighted_vertex_t next;
+                        next.vertex = v;
+                        next.cost = new_cost;
+                        frontier.push(next);
+                    }
+                    if (other[v] != inf && new_cost + other[v] < best){
+                        best = new_cost + other[v];
+                    }
+                }
+            }STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+        } else {
+            STINGER_FORALL_IN_EDGES_OF_VTX_BEGIN(S, current.vertex){
+                int64_t v = STINGER_EDGE_DEST;
+                if (v < NV){
+                    int64_t new_cost = current.cost + 1;
+                    if (new_cost < dist[v]){
+                        dist[v] = new_cost;
+                        weighted_vertex_t next;
+                        next.vertex = v;
+                        next.cost = new_cost;
+                        frontier.push(next);
+                    }
+                    if (other[v] != inf && new_cost + other[v] < best){
+                        best = new_cost + other[v];
+                    }
+                }
+            }STINGER_FORALL_IN_EDGES_OF_VTX_END();
+        }
+    }
+
+    return best;
+}
+
 //this is a slower way to find all pairs shortest paths, but  since there is no adjaceny matrix
 //this approach might end up being faster.
 std::vector<std::vector <int64_t> >
 all_pairs_dijkstra(stinger_t * S, int64_t NV){
-    std::vector<std::vector <int64_t> > dist(NV, std::vector<int64_t>(NV));
+    std::vector<int64_t> sources(NV);
     for (int64_t v = 0; v < NV; v++){
-        std::vector<int64_t> row = dijkstra(S, NV, v, false);
-        for (int64_t i = 0; i < NV; i++){
-            dist[v][i] = row[i];
+        sources[v] = v;
+    }
+    return multi_source_shortest_paths(S, NV, sources, false, 0);
+}
+//Unweighted breadth-first search from source over the caller's scratch arrays. dist must hold NV
+//entries equal to -1. The vertices reached are left in queue in order of distance with their
+//distance in dist, so the caller can walk the levels; it must reset dist through queue afterwards.
+//Follows out-edges, or in- and out-edges when undirected is set.
+//Returns the number of vertices reached, including the source.
+int64_t
+hop_distances(stinger_t * S, int64_t NV, int64_t source_vertex, bool undirected, int64_t * dist, int64_t * queue){
+    if (source_vertex < 0 || source_vertex >= NV){
+        return 0;
+    }
+    int64_t head = 0;
+    int64_t tail = 0;
+    dist[source_vertex] = 0;
+    queue[tail++] = source_vertex;
+
+    while (head < tail){
+        int64_t u = queue[head++];
+        int64_t next = dist[u] + 1;
+        if (undirected){
+            STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, u){
+                int64_t v = STINGER_EDGE_DEST;
+                if (v >= 0 && v < NV && dist[v] < 0){
+                    dist[v] = next;
+                    queue[tail++] = v;
+                }
+            }STINGER_FORALL_EDGES_OF_VTX_END();
+        } else {
+            STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u){
+                int64_t v = STINGER_EDGE_DEST;
+                if (v >= 0 && v < NV && dist[v] < 0){
+                    dist[v] = next;
+                    queue[tail++] = v;
+                }
+            }STINGER_FORALL_OUT_EDGES_OF_VTX_END();
         }
-        //dist[v] = row;
     }
-    return dist;
+    return tail;
+}
+
+static inline uint64_t
+splitmix64(uint64_t * state){
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//Sum of the shortest path lengths from source to every other vertex it reaches; the number of
+//those vertices goes to count. dist and queue are the breadth-first scratch of hop_distances()
+//(dist all -1, and left that way), used only when ignore_weights is set.
+static int64_t
+source_distance_sum(stinger_t * S, int64_t NV, int64_t source, bool ignore_weights,
+                    std::vector<int64_t> & dist, std::vector<int64_t> & queue, int64_t * count){
+    int64_t total = 0;
+    if (ignore_weights){
+        int64_t reached = hop_distances(S, NV, source, false, &dist[0], &queue[0]);
+        for (int64_t k = 0; k < reached; k++){
+            total += dist[queue[k]];
+            dist[queue[k]] = -1;
+        }
+        *count = reached - 1;
+    } else {
+        const int64_t inf = std::numeric_limits<int64_t>::max();
+        std::vector<int64_t> row = dijkstra(S, NV, source, false);
+        *count = 0;
+        for (int64_t v = 0; v < NV; v++){
+            if (row[v] != inf && v != source){
+                total += row[v];
+                (*count)++;
+            }
+        }
+    }
+    return total;
 }
+
+//Mean length of the shortest paths from a sample of source vertices to every vertex they reach.
+//Sources are drawn without replacement from the vertices with an out-edge; each runs its own
+//serial search (breadth-first when ignore_weights is set, Dijkstra otherwise) on a separate
+//thread, so only one distance row per thread is held at a time. The estimate is the average over
+//the sources of their mean distance. If half_width is given it receives the half width of a 95%
+//confidence interval (normal approximation with the finite population correction, so it is 0
+//once every source has been used). Returns 0 when no vertex has an out-edge.
+double
+mean_shortest_path_sampled(stinger_t * S, int64_t NV, int64_t samples, uint64_t seed, bool ignore_weights,
+                           double * half_width){
+    std::vector<int64_t> sources;
+    for (int64_t v = 0; v < NV; v++){
+        if (stinger_outdegree_get(S, v) > 0){
+            sources.push_back(v);
+        }
+    }
+    int64_t population = (int64_t)sources.size();
+    if (samples <= 0 || samples > population){
+        samples = population;
+    }
+    if (half_width){
+        *half_width = 0;
+    }
+    if (samples == 0){
+        return 0;
+    }
+
+    //partial Fisher-Yates: the first samples entries become the sample
+    uint64_t state = seed;
+    for (int64_t i = 0; i < samples && samples < population; i++){
+        int64_t j = i + (int64_t)(splitmix64(&state) % (uint64_t)(population - i));
+        std::swap(sources[i], sources[j]);
+    }
+
+    std::vector<double> means(samples, 0.0);
+    OMP("omp parallel")
+    {
+        std::vector<int64_t> dist;
+        std::vector<int64_t> queue;
+        if (ignore_weights){
+            dist.assign(NV, -1);
+            queue.resize(NV);
+        }
+
+        OMP("omp for schedule(dynamic, 1)")
+        for (int64_t i = 0; i < samples; i++){
+            int64_t count = 0;
+            int64_t total = source_distance_sum(S, NV, sources[i], ignore_weights, dist, queue, &count);
+            means[i] = count ? (double)total / (double)count : 0.0;
+        }
+    }
+
+    double sum = 0;
+    for (int64_t i = 0; i < samples; i++){
+        sum += means[i];
+    }
+    double mean = sum / (double)samples;
+
+    if (half_width && samples > 1 && samples < population){
+        double var = 0;
+        for (int64_t i = 0; i < samples; i++){
+            var += (means[i] - mean) * (means[i] - mean);
+        }
+        var /= (double)(samples - 1);
+        double fpc = (double)(population - samples) / (double)(population - 1);
+        *half_width = 1.96 * sqrt(var / (double)samples * fpc);
+    }
+    return mean;
+}
+
+//Mean weighted shortest path length over all pairs of vertices connected by a path,
+//rounded down. Every source is searched, but only one distance row per thread is kept.
+//Lengths and pairs are summed over all sources before dividing, so every pair counts once
+//(unlike the sampled estimate, which averages the sources' means).
 int64_t
 mean_shortest_path(stinger * S, int64_t NV){
-    std::vector<std::vector <int64_t> > all_paths = all_pairs_dijkstra(S, NV);
     int64_t total = 0;
-    for (int64_t i = 0; i < NV; i++){
-        for (int64_t j = 0; j< NV; j++){
-            total += all_paths[i][j];
+    int64_t pairs = 0;
+    OMP("omp parallel reduction(+:total, pairs)")
+    {
+        std::vector<int64_t> dist;
+        std::vector<int64_t> queue;
+
+        OMP("omp for schedule(dynamic, 1)")
+        for (int64_t v = 0; v < NV; v++){
+            if (stinger_outdegree_get(S, v) > 0){
+                int64_t count = 0;
+                total += source_distance_sum(S, NV, v, false, dist, queue, &count);
+                pairs += count;
+            }
         }
     }
-    return total/(NV*NV);
-}
\ No newline at end of file
+    return pairs ? total / pairs : 0;
+}
@@ -1,49 +1,195 @@
 #include <stdio.h>
+#include "stinger_core/stinger_atomics.h"
 #include "static_components.h"
+#include "random.h"
+
+#define AFFOREST_NEIGHBOR_ROUNDS 2
+#define AFFOREST_NUM_SAMPLES 1024
 
 /*
  * Perform a shiloach vishkin connected components calculation in parallel on a stinger graph
+ *
+ * The label propagation this used to run raced on component_map and needed a
+ * full pass over every edge type per round, so it is now computed with
+ * afforest_components, which produces the same labels.
  */
 int64_t
 parallel_shiloach_vishkin_components (struct stinger * S, int64_t nv,
                                       int64_t * component_map)
 {
-  /* Initialize each vertex with its own component label in parallel */
-  OMP ("omp parallel for")
-    for (uint64_t i = 0; i < nv; i++) {
-      component_map[i] = i;
+  afforest_components(S, nv, component_map, AFFOREST_NEIGHBOR_ROUNDS);
+  return 0;
+}
+
+/*
+ * Hook the higher of the two roots under the lower one. A root only ever
+ * moves to a smaller id, so concurrent links cannot form cycles and every
+ * tree ends up rooted at the smallest id in it.
+ */
+static inline void
+afforest_link (int64_t u, int64_t v, int64_t * comp)
+{
+  int64_t p1 = comp[u];
+  int64_t p2 = comp[v];
+
+  while (p1 != p2) {
+    int64_t high = p1 > p2 ? p1 : p2;
+    int64_t low = p1 + (p2 - high);
+    int64_t p_high = comp[high];
+
+    if (p_high == low ||
+        (p_high == high && stinger_int64_cas(comp + high, high, low) == high))
+      break;
+
+    p1 = comp[comp[high]];
+    p2 = comp[low];
+  }
+}
+
+static void
+afforest_compress (int64_t nv, int64_t * comp)
+{
+  OMP ("omp parallel for schedule(dynamic,16384)")
+  for (int64_t i = 0; i < nv; i++) {
+    while (comp[i] != comp[comp[i]]) {
+      comp[i] = comp[comp[i]];
     }
+  }
+}
 
-  /* Iterate until no changes occur */
-  while (1) {
-    int changed = 0;
-
-    /* For all edges in the STINGER graph of type 0 in parallel, attempt to assign
-       lesser component IDs to neighbors with greater component IDs */
-    for(int64_t t = 0; t < S->max_netypes; t++) {
-      STINGER_PARALLEL_FORALL_EDGES_BEGIN (S, t) {
-        if (component_map[STINGER_EDGE_DEST] < component_map[STINGER_EDGE_SOURCE]) {
-          component_map[STINGER_EDGE_SOURCE] = component_map[STINGER_EDGE_DEST];
-          changed++;
-        }
-      }
-      STINGER_PARALLEL_FORALL_EDGES_END ();
+/*
+ * Most frequent label among a random sample of vertices, which after the
+ * sampling rounds is almost always the giant component.
+ */
+static int64_t
+afforest_sample_frequent (int64_t nv, const int64_t * comp)
+{
+  int64_t samples[AFFOREST_NUM_SAMPLES];
+  dxor128_env_t env;
+  dxor128_seed(&env, 27491095);
+
+  for (int64_t i = 0; i < AFFOREST_NUM_SAMPLES; i++) {
+    int64_t v = (int64_t)(dxor128(&env) * nv);
+    samples[i] = comp[v < nv ? v : nv - 1];
+  }
+
+  /* insertion sort and pick the longest run */
+  for (int64_t i = 1; i < AFFOREST_NUM_SAMPLES; i++) {
+    int64_t x = samples[i];
+    int64_t j = i - 1;
+    while (j >= 0 && samples[j] > x) {
+      samples[j + 1] = samples[j];
+      j--;
     }
+    samples[j + 1] = x;
+  }
 
-    /* if nothing changed */
-    if (!changed) {
-      break;
+  int64_t best = samples[0], best_run = 0, run = 0;
+  for (int64_t i = 0; i < AFFOREST_NUM_SAMPLES; i++) {
+    run = (i && samples[i] == samples[i - 1]) ? run + 1 : 1;
+    if (run > best_run) {
+      best_run = run;
+      best = samples[i];
     }
+  }
+
+  return best;
+}
 
-    /* Tree climbing with OpenMP parallel for */
-    OMP ("omp parallel for")
-      
-      for (uint64_t i = 0; i < nv; i++) {
-        while (component_map[i] != component_map[component_map[i]]) {
-          component_map[i] = component_map[component_map[i]];
+int64_t
+afforest_components (struct stinger * S, int64_t nv, int64_t * component_map, int64_t neighbor_rounds)
+{
+  int64_t * comp = component_map;
+
+  if (nv <= 0)
+    return 0;
+
+  OMP ("omp parallel for")
+  for (int64_t i = 0; i < nv; i++) {
+    comp[i] = i;
+  }
+
+  /* link each vertex to its first few neighbors, in or out */
+  for (int64_t r = 0; r < neighbor_rounds; r++) {
+    OMP ("omp parallel for schedule(dynamic,16384)")
+    for (int64_t u = 0; u < nv; u++) {
+      int64_t k = 0;
+      STINGER_FORALL_EDGES_OF_VTX_BEGIN (S, u) {
+        if (k++ == r) {
+          int64_t v = STINGER_EDGE_DEST;
+          if (v < nv)
+            afforest_link(u, v, comp);
         }
+      } STINGER_FORALL_EDGES_OF_VTX_END ();
+    }
+    afforest_compress(nv, comp);
+  }
+
+  /* finish the remaining edges, except those of the sampled giant component:
+   * every edge leaving it is still seen from its other endpoint */
+  int64_t c = afforest_sample_frequent(nv, comp);
+
+  OMP ("omp parallel for schedule(dynamic,16384)")
+  for (int64_t u = 0; u < nv; u++) {
+    if (comp[u] == c)
+      continue;
+    int64_t k = 0;
+    STINGER_FORALL_EDGES_OF_VTX_BEGIN (S, u) {
+      if (k++ >= neighbor_rounds) {
+        int64_t v = STINGER_EDGE_DEST;
+        if (v < nv)
+          afforest_link(u, v, comp);
       }
+    } STINGER_FORALL_EDGES_OF_VTX_END ();
   }
 
-  return 0;
+  afforest_compress(nv, comp);
+
+  int64_t num_components = 0;
+  OMP ("omp parallel for reduction(+:num_components)")
+  for (int64_t i = 0; i < nv; i++) {
+    num_components += (comp[i] == i);
+  }
+
+  return num_components;
+}
+
+int64_t
+afforest_components_update (struct stinger * S, int64_t old_nv, int64_t nv, int64_t * component_map,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions)
+{
+  /* result is -1 for an edge that was not there, which changes nothing */
+  int64_t removed = 0;
+  for (int64_t k = 0; k < num_deletions; k++) {
+    if (deletions[k].result > 0) {
+      removed = 1;
+      break;
+    }
+  }
+
+  if (removed) {
+    afforest_components(S, nv, component_map, AFFOREST_NEIGHBOR_ROUNDS);
+    return 0;
+  }
+
+  OMP ("omp parallel for")
+  for (int64_t i = old_nv; i < nv; i++) {
+    component_map[i] = i;
+  }
+
+  OMP ("omp parallel for")
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    /* a failed insertion did not create the edge */
+    if (insertions[k].result < 0 || u < 0 || v < 0 || u >= nv || v >= nv)
+      continue;
+    afforest_link(u, v, component_map);
+  }
+
+  if (num_insertions)
+    afforest_compress(nv, component_map);
+
+  return 1;
 }
@@ -0,0 +1,350 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "stinger_core/stinger_atomics.h"
+#include "streaming_betweenness.h"
+#include "betweenness.h"
+#include "random.h"
+
+void
+stinger_bc_reset_stats(stinger_bc_stats * stats)
+{
+  stats->sources_recomputed = 0;
+  stats->sources_skipped = 0;
+  stats->sources_added = 0;
+}
+
+/* Row i of a per-source summary array */
+#define BC_ROW(ARRAY_, I_) ((ARRAY_) + (I_) * bc_internal->capacity)
+
+/*
+ * Brandes forward and backward sweep from a single source. The distance, path
+ * count and dependency of every vertex below nv are left in d, sigma and delta.
+ * queue must hold nv entries. Returns the number of vertices reached.
+ */
+static int64_t
+bc_source_search(stinger_t * S, int64_t nv, int64_t source, int64_t * d, int64_t * sigma,
+  double * delta, int64_t * queue)
+{
+  for (int64_t v = 0; v < nv; v++) {
+    d[v] = -1;
+    sigma[v] = 0;
+    delta[v] = 0.0;
+  }
+
+  d[source] = 0;
+  sigma[source] = 1;
+  queue[0] = source;
+
+  int64_t head = 0;
+  int64_t tail = 1;
+
+  while (head < tail) {
+    int64_t v = queue[head++];
+    int64_t d_next = d[v] + 1;
+
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+      int64_t w = STINGER_EDGE_DEST;
+      if (d[w] < 0) {
+        d[w] = d_next;
+        queue[tail++] = w;
+      }
+      if (d[w] == d_next) {
+        sigma[w] += sigma[v];
+      }
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+  }
+
+  /* the source itself never accumulates a dependency */
+  for (int64_t i = tail - 1; i > 0; i--) {
+    int64_t w = queue[i];
+    double dsw = 0;
+    int64_t sw = sigma[w];
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, w) {
+      int64_t x = STINGER_EDGE_DEST;
+      if (d[x] == d[w] + 1) {
+        dsw += frac(sw, sigma[x]) * (1.0 + delta[x]);
+      }
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    delta[w] = dsw;
+  }
+
+  return tail;
+}
+
+/*
+ * Add (sign = 1) or remove (sign = -1) the contribution of one source.
+ */
+static void
+bc_apply_source(int64_t nv, int64_t sign, const int64_t * d, const double * delta,
+  double * bc, int64_t * found_count)
+{
+  for (int64_t v = 0; v < nv; v++) {
+    bc[v] += sign * delta[v];
+    found_count[v] += sign * (d[v] > 0);
+  }
+}
+
+/*
+ * An update can only change the shortest-path DAG of a source if it joins
+ * vertices at different distances (insertion) or removes an edge between
+ * consecutive levels (deletion). Both directions are checked so the test is
+ * also safe for undirected batches.
+ */
+static int
+bc_source_affected(const int64_t * d, int64_t nv,
+  const stinger_edge_update * insertions, int64_t num_insertions,
+  const stinger_edge_update * deletions, int64_t num_deletions)
+{
+  for (int64_t k = 0; k < num_insertions; k++) {
+    int64_t u = insertions[k].source;
+    int64_t v = insertions[k].destination;
+    int64_t du = (u >= 0 && u < nv) ? d[u] : -1;
+    int64_t dv = (v >= 0 && v < nv) ? d[v] : -1;
+    if (du < 0 && dv < 0)
+      continue;
+    if (du != dv)
+      return 1;
+  }
+
+  for (int64_t k = 0; k < num_deletions; k++) {
+    int64_t u = deletions[k].source;
+    int64_t v = deletions[k].destination;
+    int64_t du = (u >= 0 && u < nv) ? d[u] : -1;
+    int64_t dv = (v >= 0 && v < nv) ? d[v] : -1;
+    if (du < 0 || dv < 0)
+      continue;
+    if (du - dv == 1 || dv - du == 1)
+      return 1;
+  }
+
+  return 0;
+}
+
+/*
+ * Make room for nv vertices in every summary row. New entries are unreached.
+ */
+static void
+bc_grow(stinger_t * S, stinger_bc_internal * bc_internal, int64_t nv)
+{
+  if (nv > bc_internal->capacity) {
+    int64_t old_capacity = bc_internal->capacity;
+    int64_t capacity = 2 * old_capacity;
+    if (capacity < nv)
+      capacity = nv;
+    if (capacity > S->max_nv)
+      capacity = S->max_nv;
+
+    int64_t rows = bc_internal->nsamples;
+    int64_t * d = (int64_t *)xmalloc(rows * capacity * sizeof(int64_t));
+    int64_t * sigma = (int64_t *)xcalloc(rows * capacity, sizeof(int64_t));
+    double * delta = (double *)xcalloc(rows * capacity, sizeof(double));
+
+    OMP("omp parallel for")
+    for (int64_t i = 0; i < rows; i++) {
+      int64_t * d_row = d + i * capacity;
+      for (int64_t v = 0; v < capacity; v++) {
+        d_row[v] = -1;
+      }
+      if (i < bc_internal->num_sources && old_capacity) {
+        memcpy(d_row, bc_internal->d + i * old_capacity, old_capacity * sizeof(int64_t));
+        memcpy(sigma + i * capacity, bc_internal->sigma + i * old_capacity, old_capacity * sizeof(int64_t));
+        memcpy(delta + i * capacity, bc_internal->delta + i * old_capacity, old_capacity * sizeof(double));
+      }
+    }
+
+    if (bc_internal->d) {
+      xfree(bc_internal->d);
+      xfree(bc_internal->sigma);
+      xfree(bc_internal->delta);
+    }
+
+    bc_internal->d = d;
+    bc_internal->sigma = sigma;
+    bc_internal->delta = delta;
+    bc_internal->capacity = capacity;
+  }
+
+  if (nv > bc_internal->nv)
+    bc_internal->nv = nv;
+}
+
+/*
+ * Pick the sample set. When there are no more vertices than samples every
+ * vertex is a source, otherwise the sources are drawn without replacement
+ * from a generator seeded with bc_internal->seed.
+ */
+static void
+bc_choose_sources(stinger_bc_internal * bc_internal, int64_t nv)
+{
+  if (nv <= bc_internal->nsamples) {
+    for (int64_t v = 0; v < nv; v++) {
+      bc_internal->sources[v] = v;
+    }
+    bc_internal->num_sources = nv;
+    return;
+  }
+
+  uint8_t * chosen = (uint8_t *)xcalloc(nv, sizeof(uint8_t));
+  dxor128_env_t env;
+  dxor128_seed(&env, (unsigned)bc_internal->seed);
+
+  int64_t count = 0;
+  while (count < bc_internal->nsamples) {
+    int64_t v = (int64_t)(dxor128(&env) * nv);
+    if (v >= nv)
+      v = nv - 1;
+    if (!chosen[v]) {
+      chosen[v] = 1;
+      bc_internal->sources[count++] = v;
+    }
+  }
+  bc_internal->num_sources = count;
+
+  xfree(chosen);
+}
+
+/*
+ * Runs the sources in [first, last) in parallel. Sources for which
+ * recompute[i] is zero are skipped; those that already hold a summary have it
+ * subtracted from bc before the new one is added.
+ */
+static void
+bc_process_sources(stinger_t * S, stinger_bc_internal * bc_internal, int64_t nv,
+  int64_t first, int64_t last, const uint8_t * recompute, int64_t first_new,
+  double * bc, int64_t * found_count)
+{
+  OMP("omp parallel")
+  {
+    double * partial_bc = (double *)xcalloc(nv, sizeof(double));
+    int64_t * partial_found = (int64_t *)xcalloc(nv, sizeof(int64_t));
+    int64_t * queue = (int64_t *)xmalloc(nv * sizeof(int64_t));
+
+    OMP("omp for schedule(dynamic,1)")
+    for (int64_t i = first; i < last; i++) {
+      if (recompute && !recompute[i])
+        continue;
+
+      int64_t * d = BC_ROW(bc_internal->d, i);
+      int64_t * sigma = BC_ROW(bc_internal->sigma, i);
+      double * delta = BC_ROW(bc_internal->delta, i);
+
+      if (i < first_new)
+        bc_apply_source(nv, -1, d, delta, partial_bc, partial_found);
+
+      bc_source_search(S, nv, bc_internal->sources[i], d, sigma, delta, queue);
+      bc_apply_source(nv, 1, d, delta, partial_bc, partial_found);
+    }
+
+    OMP("omp critical")
+    {
+      for (int64_t v = 0; v < nv; v++) {
+        bc[v] += partial_bc[v];
+        found_count[v] += partial_found[v];
+      }
+    }
+
+    xfree(queue);
+    xfree(partial_found);
+    xfree(partial_bc);
+  }
+}
+
+void
+stinger_bc_initialize_internals(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  int64_t nsamples, uint64_t seed, double * bc, int64_t * found_count)
+{
+  memset(bc_internal, 0, sizeof(stinger_bc_internal));
+  bc_internal->nsamples = nsamples;
+  bc_internal->seed = seed;
+  bc_internal->sources = (int64_t *)xmalloc(nsamples * sizeof(int64_t));
+
+  LOG_V_A("  > Initializing incremental BC with %ld vertices and %ld samples", (long)nv, (long)nsamples);
+
+  bc_grow(S, bc_internal, nv);
+  bc_choose_sources(bc_internal, nv);
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    bc[v] = 0;
+    found_count[v] = 0;
+  }
+
+  bc_process_sources(S, bc_internal, nv, 0, bc_internal->num_sources, NULL, 0, bc, found_count);
+}
+
+void
+stinger_bc_release_internals(stinger_bc_internal * bc_internal)
+{
+  if (bc_internal->sources)
+    xfree(bc_internal->sources);
+  if (bc_internal->d) {
+    xfree(bc_internal->d);
+    xfree(bc_internal->sigma);
+    xfree(bc_internal->delta);
+  }
+  memset(bc_internal, 0, sizeof(stinger_bc_internal));
+}
+
+void
+stinger_bc_recompute(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  double * bc, int64_t * found_count)
+{
+  bc_grow(S, bc_internal, nv);
+  nv = bc_internal->nv;
+
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    bc[v] = 0;
+    found_count[v] = 0;
+  }
+
+  bc_process_sources(S, bc_internal, nv, 0, bc_internal->num_sources, NULL, 0, bc, found_count);
+}
+
+int64_t
+stinger_bc_update(stinger_t * S, int64_t nv, stinger_bc_internal * bc_internal,
+  stinger_bc_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  double * bc, int64_t * found_count)
+{
+  int64_t old_nv = bc_internal->nv;
+  bc_grow(S, bc_internal, nv);
+  nv = bc_internal->nv;
+
+  /* while the graph is smaller than the sample, every vertex is a source */
+  int64_t first_new = bc_internal->num_sources;
+  if (first_new == old_nv) {
+    for (int64_t v = old_nv; v < nv && bc_internal->num_sources < bc_internal->nsamples; v++) {
+      bc_internal->sources[bc_internal->num_sources++] = v;
+    }
+  }
+  int64_t num_sources = bc_internal->num_sources;
+
+  uint8_t * recompute = (uint8_t *)xcalloc(num_sources, sizeof(uint8_t));
+  int64_t recomputed = 0;
+
+  OMP("omp parallel for reduction(+:recomputed)")
+  for (int64_t i = 0; i < num_sources; i++) {
+    if (i >= first_new ||
+        bc_source_affected(BC_ROW(bc_internal->d, i), nv,
+          insertions, num_insertions, deletions, num_deletions)) {
+      recompute[i] = 1;
+      recomputed++;
+    }
+  }
+
+  if (recomputed)
+    bc_process_sources(S, bc_internal, nv, 0, num_sources, recompute, first_new, bc, found_count);
+
+  if (stats) {
+    stats->sources_added += num_sources - first_new;
+    stats->sources_recomputed += recomputed;
+    stats->sources_skipped += num_sources - recomputed;
+  }
+
+  xfree(recompute);
+
+  return recomputed;
+}
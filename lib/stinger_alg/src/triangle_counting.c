@@ -0,0 +1,552 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "stinger_core/stinger_atomics.h"
+#include "triangle_counting.h"
+
+static int
+triangle_compare_int64 (const void * a, const void * b)
+{
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static int
+triangle_compare_pair (const void * a, const void * b)
+{
+  const int64_t * x = (const int64_t *)a;
+  const int64_t * y = (const int64_t *)b;
+  if (x[0] != y[0])
+    return (x[0] > y[0]) - (x[0] < y[0]);
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Sorted intersections
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static int64_t
+triangle_intersect_scalar(const int64_t * a, int64_t na, const int64_t * b, int64_t nb, int64_t * out)
+{
+  int64_t i = 0, j = 0, count = 0;
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (a[i] > b[j]) {
+      j++;
+    } else {
+      if (out)
+        out[count] = a[i];
+      count++;
+      i++;
+      j++;
+    }
+  }
+  return count;
+}
+
+#if defined(__AVX2__)
+/*
+ * Compare a block of four values from each list against every rotation of the
+ * other block, then retire whichever block ends with the smaller value. Both
+ * lists are duplicate free, so a value can only match once.
+ */
+static int64_t
+triangle_intersect_avx2(const int64_t * a, int64_t na, const int64_t * b, int64_t nb, int64_t * out)
+{
+  int64_t i = 0, j = 0, count = 0;
+
+  while (i + 4 <= na && j + 4 <= nb) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + j));
+
+    __m256i m = _mm256_cmpeq_epi64(va, vb);
+    vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0,3,2,1));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+    vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0,3,2,1));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+    vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0,3,2,1));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(m));
+    if (mask) {
+      if (out) {
+        for (int k = 0; k < 4; k++) {
+          if (mask & (1 << k))
+            out[count++] = a[i + k];
+        }
+      } else {
+        count += __builtin_popcount(mask);
+      }
+    }
+
+    int64_t a_last = a[i + 3];
+    int64_t b_last = b[j + 3];
+    if (a_last <= b_last)
+      i += 4;
+    if (b_last <= a_last)
+      j += 4;
+  }
+
+  return count + triangle_intersect_scalar(a + i, na - i, b + j, nb - j, out ? out + count : NULL);
+}
+#endif
+
+int64_t
+triangle_intersect(const int64_t * a, int64_t na, const int64_t * b, int64_t nb, int64_t * out)
+{
+#if defined(__AVX2__)
+  if (na >= 8 && nb >= 8)
+    return triangle_intersect_avx2(a, na, b, nb, out);
+#endif
+  return triangle_intersect_scalar(a, na, b, nb, out);
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Neighborhoods
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* Sort and drop duplicates in place, returns the new length */
+static int64_t
+triangle_sort_unique(int64_t * list, int64_t n)
+{
+  if (n < 2)
+    return n;
+
+  qsort(list, n, sizeof(int64_t), triangle_compare_int64);
+
+  int64_t d = 1;
+  for (int64_t i = 1; i < n; i++) {
+    if (list[i] != list[d - 1])
+      list[d++] = list[i];
+  }
+  return d;
+}
+
+int64_t
+triangle_gather_neighbors(stinger_t * S, int64_t v, int64_t ** buf, int64_t * buf_size)
+{
+  int64_t outdeg = stinger_outdegree_get(S, v);
+  if (outdeg > *buf_size) {
+    *buf_size = 2 * outdeg;
+    *buf = (int64_t *)xrealloc(*buf, *buf_size * sizeof(int64_t));
+  }
+
+  int64_t * list = *buf;
+  int64_t n = 0;
+  STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+    int64_t u = STINGER_EDGE_DEST;
+    if (u != v && n < *buf_size)
+      list[n++] = u;
+  } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+
+  return triangle_sort_unique(list, n);
+}
+
+/* Per-thread scratch space, grown on demand */
+typedef struct {
+  int64_t * nbr_u;
+  int64_t   nbr_u_size;
+  int64_t * nbr_v;
+  int64_t   nbr_v_size;
+  int64_t * common;
+  int64_t   common_size;
+} triangle_scratch;
+
+static void
+triangle_scratch_reserve_common(triangle_scratch * scratch, int64_t n)
+{
+  if (n > scratch->common_size) {
+    scratch->common_size = 2 * n;
+    scratch->common = (int64_t *)xrealloc(scratch->common, scratch->common_size * sizeof(int64_t));
+  }
+}
+
+static void
+triangle_scratch_free(triangle_scratch * scratch)
+{
+  if (scratch->nbr_u)
+    xfree(scratch->nbr_u);
+  if (scratch->nbr_v)
+    xfree(scratch->nbr_v);
+  if (scratch->common)
+    xfree(scratch->common);
+}
+
+/*
+ * Triangles at a single vertex: every triangle {v, u, w} is seen once from u
+ * and once from w while scanning the neighbors of v.
+ */
+static int64_t
+triangle_count_vertex(stinger_t * S, int64_t v, triangle_scratch * scratch, int64_t * deg_out)
+{
+  int64_t dv = triangle_gather_neighbors(S, v, &scratch->nbr_u, &scratch->nbr_u_size);
+  int64_t twice = 0;
+
+  for (int64_t k = 0; k < dv; k++) {
+    int64_t u = scratch->nbr_u[k];
+    int64_t du = triangle_gather_neighbors(S, u, &scratch->nbr_v, &scratch->nbr_v_size);
+    twice += triangle_intersect(scratch->nbr_u, dv, scratch->nbr_v, du, NULL);
+  }
+
+  if (deg_out)
+    *deg_out = dv;
+  return twice / 2;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Static counts
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+/* (degree, id) order used to orient edges */
+#define TRIANGLE_RANK_LESS(DEG_, A_, B_) \
+  ((DEG_)[A_] < (DEG_)[B_] || ((DEG_)[A_] == (DEG_)[B_] && (A_) < (B_)))
+
+void
+triangle_count_all(stinger_t * S, int64_t nv, int64_t * ntri, int64_t * deg)
+{
+  int64_t * off = (int64_t *)xmalloc((nv + 1) * sizeof(int64_t));
+  int64_t * len = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t * d = deg ? deg : (int64_t *)xmalloc(nv * sizeof(int64_t));
+
+  /* out-degree bounds the distinct neighbor count, so use it for the slots */
+  off[0] = 0;
+  for (int64_t v = 0; v < nv; v++) {
+    off[v + 1] = off[v] + stinger_outdegree_get(S, v);
+  }
+
+  int64_t * adj = (int64_t *)xmalloc((off[nv] ? off[nv] : 1) * sizeof(int64_t));
+
+  OMP("omp parallel for schedule(dynamic,128)")
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t * list = adj + off[v];
+    int64_t cap = off[v + 1] - off[v];
+    int64_t n = 0;
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+      int64_t u = STINGER_EDGE_DEST;
+      if (u != v && u < nv && n < cap)
+        list[n++] = u;
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    d[v] = triangle_sort_unique(list, n);
+    ntri[v] = 0;
+  }
+
+  /* keep only the neighbors that rank higher; the lists stay sorted by id */
+  OMP("omp parallel for schedule(dynamic,128)")
+  for (int64_t v = 0; v < nv; v++) {
+    int64_t * list = adj + off[v];
+    int64_t n = 0;
+    for (int64_t k = 0; k < d[v]; k++) {
+      int64_t u = list[k];
+      if (TRIANGLE_RANK_LESS(d, v, u))
+        list[n++] = u;
+    }
+    len[v] = n;
+  }
+
+  OMP("omp parallel")
+  {
+    triangle_scratch scratch;
+    memset(&scratch, 0, sizeof(triangle_scratch));
+
+    OMP("omp for schedule(dynamic,64)")
+    for (int64_t v = 0; v < nv; v++) {
+      const int64_t * nv_list = adj + off[v];
+      int64_t found = 0;
+      triangle_scratch_reserve_common(&scratch, len[v]);
+
+      for (int64_t k = 0; k < len[v]; k++) {
+        int64_t u = nv_list[k];
+        int64_t c = triangle_intersect(nv_list, len[v], adj + off[u], len[u], scratch.common);
+        if (c) {
+          found += c;
+          stinger_int64_fetch_add(ntri + u, c);
+          for (int64_t i = 0; i < c; i++) {
+            stinger_int64_fetch_add(ntri + scratch.common[i], 1);
+          }
+        }
+      }
+
+      if (found)
+        stinger_int64_fetch_add(ntri + v, found);
+    }
+
+    triangle_scratch_free(&scratch);
+  }
+
+  xfree(adj);
+  if (!deg)
+    xfree(d);
+  xfree(len);
+  xfree(off);
+}
+
+static inline double
+triangle_local_cc(int64_t ntri, int64_t deg)
+{
+  return deg > 1 ? (2.0 * ntri) / ((double)deg * (deg - 1)) : 0.0;
+}
+
+void
+triangle_clustering_coefficients(int64_t nv, const int64_t * ntri, const int64_t * deg, double * cc)
+{
+  OMP("omp parallel for")
+  for (int64_t v = 0; v < nv; v++) {
+    cc[v] = triangle_local_cc(ntri[v], deg[v]);
+  }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Streaming maintenance
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+void
+stinger_triangle_reset_stats(stinger_triangle_stats * stats)
+{
+  stats->pairs_changed = 0;
+  stats->vertices_recounted = 0;
+  stats->neighbor_updates = 0;
+}
+
+void
+stinger_triangle_initialize_internals(stinger_t * S, int64_t nv, stinger_triangle_internal * tri_internal,
+  int64_t * ntri, double * cc)
+{
+  memset(tri_internal, 0, sizeof(stinger_triangle_internal));
+  tri_internal->nv = nv;
+  tri_internal->deg = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  tri_internal->mark = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  tri_internal->touched = (int64_t *)xmalloc(nv * sizeof(int64_t));
+
+  triangle_count_all(S, nv, ntri, tri_internal->deg);
+  if (cc)
+    triangle_clustering_coefficients(nv, ntri, tri_internal->deg, cc);
+}
+
+void
+stinger_triangle_release_internals(stinger_triangle_internal * tri_internal)
+{
+  if (tri_internal->deg) {
+    xfree(tri_internal->deg);
+    xfree(tri_internal->mark);
+    xfree(tri_internal->touched);
+  }
+  if (tri_internal->pairs) {
+    xfree(tri_internal->pairs);
+    xfree(tri_internal->was_adjacent);
+  }
+  memset(tri_internal, 0, sizeof(stinger_triangle_internal));
+}
+
+static int
+triangle_adjacent(stinger_t * S, int64_t u, int64_t v)
+{
+  if (stinger_outdegree_get(S, v) < stinger_outdegree_get(S, u)) {
+    int64_t t = u; u = v; v = t;
+  }
+  STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+    if (STINGER_EDGE_DEST == v)
+      return 1;
+  } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+  return 0;
+}
+
+/* Collect the distinct vertex pairs touched by a batch */
+static void
+triangle_collect_pairs(stinger_triangle_internal * tri_internal,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions)
+{
+  int64_t total = num_insertions + num_deletions;
+  if (total > tri_internal->pair_capacity) {
+    if (tri_internal->pairs) {
+      xfree(tri_internal->pairs);
+      xfree(tri_internal->was_adjacent);
+    }
+    tri_internal->pair_capacity = total;
+    tri_internal->pairs = (int64_t *)xmalloc(2 * total * sizeof(int64_t));
+    tri_internal->was_adjacent = (uint8_t *)xmalloc(total * sizeof(uint8_t));
+  }
+
+  int64_t n = 0;
+  for (int64_t k = 0; k < total; k++) {
+    stinger_edge_update * e = k < num_insertions ? insertions + k : deletions + (k - num_insertions);
+    int64_t u = e->source;
+    int64_t v = e->destination;
+    if (u == v || u < 0 || v < 0 || u >= tri_internal->nv || v >= tri_internal->nv)
+      continue;
+    tri_internal->pairs[2 * n] = u < v ? u : v;
+    tri_internal->pairs[2 * n + 1] = u < v ? v : u;
+    n++;
+  }
+
+  qsort(tri_internal->pairs, n, 2 * sizeof(int64_t), triangle_compare_pair);
+
+  int64_t unique = 0;
+  for (int64_t k = 0; k < n; k++) {
+    if (unique && tri_internal->pairs[2 * k] == tri_internal->pairs[2 * (unique - 1)] &&
+        tri_internal->pairs[2 * k + 1] == tri_internal->pairs[2 * (unique - 1) + 1])
+      continue;
+    tri_internal->pairs[2 * unique] = tri_internal->pairs[2 * k];
+    tri_internal->pairs[2 * unique + 1] = tri_internal->pairs[2 * k + 1];
+    unique++;
+  }
+  tri_internal->num_pairs = unique;
+}
+
+void
+stinger_triangle_prepare(stinger_t * S, stinger_triangle_internal * tri_internal,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions)
+{
+  triangle_collect_pairs(tri_internal, insertions, num_insertions, deletions, num_deletions);
+
+  int64_t * pairs = tri_internal->pairs;
+  uint8_t * was_adjacent = tri_internal->was_adjacent;
+  OMP("omp parallel for")
+  for (int64_t k = 0; k < tri_internal->num_pairs; k++) {
+    was_adjacent[k] = triangle_adjacent(S, pairs[2 * k], pairs[2 * k + 1]);
+  }
+
+  tri_internal->prepared = 1;
+}
+
+static inline void
+triangle_mark_touched(stinger_triangle_internal * tri_internal, int64_t * num_touched, int64_t w,
+  int64_t keep, int64_t stamp)
+{
+  int64_t m = tri_internal->mark[w];
+  while (m != keep && m != stamp) {
+    if (stinger_int64_cas(tri_internal->mark + w, m, stamp) == m) {
+      tri_internal->touched[stinger_int64_fetch_add(num_touched, 1)] = w;
+      return;
+    }
+    m = tri_internal->mark[w];
+  }
+}
+
+int64_t
+stinger_triangle_update(stinger_t * S, stinger_triangle_internal * tri_internal,
+  stinger_triangle_stats * stats,
+  stinger_edge_update * insertions, int64_t num_insertions,
+  stinger_edge_update * deletions, int64_t num_deletions,
+  int64_t * ntri, double * cc)
+{
+  int prepared = tri_internal->prepared;
+  tri_internal->prepared = 0;
+
+  if (!prepared)
+    triangle_collect_pairs(tri_internal, insertions, num_insertions, deletions, num_deletions);
+
+  int64_t * mark = tri_internal->mark;
+  int64_t * deg = tri_internal->deg;
+  int64_t * pairs = tri_internal->pairs;
+  int64_t num_pairs = tri_internal->num_pairs;
+
+  /* endpoints get stamp, other vertices to recount or refresh get stamp + 1 */
+  int64_t stamp = tri_internal->stamp + 1;
+  int64_t other = tri_internal->stamp + 2;
+  tri_internal->stamp += 2;
+
+  int64_t * endpoints = (int64_t *)xmalloc((2 * num_pairs + 1) * sizeof(int64_t));
+  int64_t num_endpoints = 0;
+  for (int64_t k = 0; k < 2 * num_pairs; k++) {
+    int64_t w = pairs[k];
+    if (mark[w] != stamp) {
+      mark[w] = stamp;
+      endpoints[num_endpoints++] = w;
+    }
+  }
+
+  int64_t num_touched = 0;
+  int64_t pairs_changed = 0;
+  int64_t neighbor_updates = 0;
+
+  OMP("omp parallel reduction(+:pairs_changed, neighbor_updates)")
+  {
+    triangle_scratch scratch;
+    memset(&scratch, 0, sizeof(triangle_scratch));
+
+    if (prepared) {
+      /* a common neighbor outside the batch gains or loses exactly the
+       * triangle closed by the changed pair */
+      OMP("omp for schedule(dynamic,16)")
+      for (int64_t k = 0; k < num_pairs; k++) {
+        int64_t u = pairs[2 * k];
+        int64_t v = pairs[2 * k + 1];
+        int adjacent = triangle_adjacent(S, u, v);
+        if (adjacent == tri_internal->was_adjacent[k])
+          continue;
+        pairs_changed++;
+
+        int64_t du = triangle_gather_neighbors(S, u, &scratch.nbr_u, &scratch.nbr_u_size);
+        int64_t dv = triangle_gather_neighbors(S, v, &scratch.nbr_v, &scratch.nbr_v_size);
+        triangle_scratch_reserve_common(&scratch, du < dv ? du : dv);
+        int64_t c = triangle_intersect(scratch.nbr_u, du, scratch.nbr_v, dv, scratch.common);
+
+        for (int64_t i = 0; i < c; i++) {
+          int64_t w = scratch.common[i];
+          if (mark[w] == stamp)
+            continue;
+          stinger_int64_fetch_add(ntri + w, adjacent ? 1 : -1);
+          triangle_mark_touched(tri_internal, &num_touched, w, stamp, other);
+          neighbor_updates++;
+        }
+      }
+    } else {
+      /* previous adjacency unknown, recount the neighborhood as well */
+      OMP("omp for schedule(dynamic,16)")
+      for (int64_t k = 0; k < num_endpoints; k++) {
+        int64_t u = endpoints[k];
+        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+          int64_t w = STINGER_EDGE_DEST;
+          if (w < tri_internal->nv)
+            triangle_mark_touched(tri_internal, &num_touched, w, stamp, other);
+        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+      }
+
+      OMP("omp for schedule(dynamic,16)")
+      for (int64_t k = 0; k < num_touched; k++) {
+        int64_t w = tri_internal->touched[k];
+        ntri[w] = triangle_count_vertex(S, w, &scratch, deg + w);
+        neighbor_updates++;
+      }
+    }
+
+    OMP("omp for schedule(dynamic,16)")
+    for (int64_t k = 0; k < num_endpoints; k++) {
+      int64_t u = endpoints[k];
+      ntri[u] = triangle_count_vertex(S, u, &scratch, deg + u);
+      if (cc)
+        cc[u] = triangle_local_cc(ntri[u], deg[u]);
+    }
+
+    if (cc) {
+      OMP("omp for")
+      for (int64_t k = 0; k < num_touched; k++) {
+        int64_t w = tri_internal->touched[k];
+        cc[w] = triangle_local_cc(ntri[w], deg[w]);
+      }
+    }
+
+    triangle_scratch_free(&scratch);
+  }
+
+  int64_t recounted = num_endpoints + (prepared ? 0 : num_touched);
+
+  if (stats) {
+    stats->pairs_changed += pairs_changed;
+    stats->vertices_recounted += recounted;
+    stats->neighbor_updates += neighbor_updates;
+  }
+
+  xfree(endpoints);
+
+  return recounted;
+}
@@ -56,6 +56,24 @@ extern "C" {
 #undef STINGER_PARALLEL_FORALL_EDGES_BEGIN
 #undef STINGER_PARALLEL_FORALL_EDGES_END
 
+#undef STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN
+#undef STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END
+
+#undef STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_BEGIN
+#undef STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_END
+
+#undef STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN
+#undef STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END
+
+#undef STINGER_FORALL_EDGES_IN_WINDOW_BEGIN
+#undef STINGER_FORALL_EDGES_IN_WINDOW_END
+
+#undef STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_BEGIN
+#undef STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_END
+
+#undef STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_BEGIN
+#undef STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_END
+
 #undef STINGER_READ_ONLY_FORALL_OUT_EDGES_OF_VTX_BEGIN
 #undef STINGER_READ_ONLY_FORALL_OUT_EDGES_OF_VTX_END
 
@@ -268,6 +286,69 @@ extern "C" {
 #define STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_END() \
   STINGER_GENERIC_FORALL_EDGES_END()
 
+// Time windows. An out-edge is in the window [T0_, T1_] when it was seen
+// during it: timeFirst <= T1_ and timeRecent >= T0_. Every block keeps the
+// smallest and largest timestamp of the out-edges written into it, so blocks
+// entirely before or after the window are skipped without reading their
+// edges. In-edge records carry no timestamps and are never in a window.
+#define STINGER_EB_IN_WINDOW(T0_,T1_) \
+  (current_eb__->largeStamp >= (T0_) && current_eb__->smallStamp <= (T1_))
+#define STINGER_EDGE_IN_WINDOW(T0_,T1_) \
+  (STINGER_IS_OUT_EDGE && STINGER_EDGE_TIME_RECENT >= (T0_) && STINGER_EDGE_TIME_FIRST <= (T1_))
+
+// For all out-edges of vertex in the window
+#define STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(STINGER_,VTX_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_BEGIN(STINGER_,VTX_,if (STINGER_EDGE_IN_WINDOW(T0_,T1_)),if (STINGER_EB_IN_WINDOW(T0_,T1_)),)
+#define STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_END()
+
+// For all out-edges of vertex of a certain edge type in the window
+#define STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_BEGIN(STINGER_,TYPE_,VTX_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_BEGIN(STINGER_,VTX_,if (STINGER_EDGE_IN_WINDOW(T0_,T1_)),if (current_eb__->etype == TYPE_ && STINGER_EB_IN_WINDOW(T0_,T1_)),)
+#define STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_END()
+
+// For all out-edges of vertex in the window, in parallel
+#define STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(STINGER_,VTX_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_BEGIN(STINGER_,VTX_,if (STINGER_EDGE_IN_WINDOW(T0_,T1_)),if (STINGER_EB_IN_WINDOW(T0_,T1_)),STINGER_FORALL_ENABLE_PARALLEL_)
+#define STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_OF_VTX_END()
+
+// Generic macro for iterating over all edges in a time window. Edges are writable.
+#define STINGER_GENERIC_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_,SELECT_TYPE_,PARALLEL_,T0_,T1_) \
+  do {                                                                                        \
+    MAP_STING(STINGER_);                                                                      \
+    SELECT_TYPE_ { /* This sets t__ */                                                        \
+      struct stinger_eb * ebpool_priv = ebpool->ebpool;                                       \
+      PARALLEL_                                                                               \
+      for(uint64_t p__ = 0; p__ < ETA((STINGER_),(t__))->high; p__++) {                       \
+        struct stinger_eb *  current_eb__ = ebpool_priv+ ETA((STINGER_),(t__))->blocks[p__];  \
+        if (!STINGER_EB_IN_WINDOW(T0_,T1_)) continue;                                         \
+        int64_t source__ = current_eb__->vertexID;                                            \
+        int64_t type__ = current_eb__->etype;                                                 \
+        for(uint64_t i__ = 0; i__ < stinger_eb_high(current_eb__); i__++) {                   \
+          if(!stinger_eb_is_blank(current_eb__, i__)) {                                       \
+            struct stinger_edge * current_edge__ = current_eb__->edges + i__;                 \
+            if (STINGER_EDGE_IN_WINDOW(T0_,T1_)) {
+
+// For all edges of a given type in the window
+#define STINGER_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_,TYPE_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_, uint64_t t__ = TYPE_;,,T0_,T1_)
+#define STINGER_FORALL_EDGES_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_END()
+
+// For all edges of a given type in the window, in parallel
+#define STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_,TYPE_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_, uint64_t t__ = TYPE_;,STINGER_FORALL_ENABLE_PARALLEL_,T0_,T1_)
+#define STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_END()
+
+// For all edges in the window, in parallel
+#define STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_BEGIN(STINGER_,T0_,T1_) \
+  STINGER_GENERIC_FORALL_EDGES_IN_WINDOW_BEGIN(STINGER_,for (uint64_t t__ = 0; t__ < stinger_max_num_etypes(STINGER_); t__++),STINGER_FORALL_ENABLE_PARALLEL_,T0_,T1_)
+#define STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_END() \
+  STINGER_GENERIC_FORALL_EDGES_END()
+
 // Generic macro for iterating over all edges of a vertex. Edges are read-only.
 #define STINGER_GENERIC_READ_ONLY_FORALL_EDGES_OF_VTX_BEGIN(STINGER_,VTX_,EDGE_FILTER_,EB_FILTER_) \
   do {                                                                                  \
@@ -3,9 +3,12 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <stdint.h>
+#include <pthread.h>
 #include <semaphore.h>
 #include "stinger_alg_state.h"
+#include "stinger_snapshot.h"
 #include "stinger_core/stinger.h"
 #include "stinger_core/stinger_error.h"
 #include "rapidjson/document.h"
@@ -14,6 +17,80 @@
 
 namespace gt {
   namespace stinger {
+
+    struct SortedIndexKey {
+      const uint8_t * data;
+      int64_t stride;
+      int64_t nv;
+      char type;
+      bool asc;
+
+      bool operator<(const SortedIndexKey & b) const;
+    };
+
+    /* Log-scale histogram bins over |value|: bin 0 counts zeros and bin
+     * 1 + STINGER_SUMMARY_HIST_BIAS + e counts values in [2^e, 2^(e+1)),
+     * with e clamped to the bins there are. */
+#define STINGER_SUMMARY_HIST_BINS 64
+#define STINGER_SUMMARY_HIST_BIAS 31
+
+    /* isum and positive_isum are exact sums, kept only for the integer
+     * types ('i', 'l' and 'b'); sum holds them as doubles for the others. */
+    struct StingerValueSummary {
+      int64_t count;
+      double sum;
+      int64_t isum;
+      double min;
+      double max;
+    };
+
+    /* One field of an algorithm's data summarized over the vertices */
+    struct StingerFieldSummary {
+      std::string name;
+      char type;
+      StingerValueSummary all;
+      int64_t positive;
+      double positive_sum;
+      int64_t positive_isum;
+      int64_t negative;
+      int64_t hist[STINGER_SUMMARY_HIST_BINS];
+      std::vector<StingerValueSummary> by_vtype;
+    };
+
+    /* Everything the monitor received with one batch: the STINGER and the
+     * algorithm data mapped for it, with what was computed from them. Readers
+     * pin the current epoch for the length of a query, so update_algs never
+     * waits for them; an epoch that has been replaced is unmapped when its
+     * last reader lets go. Pinning keeps the mappings, the algorithm list and
+     * the per-batch indices and summaries, not the contents: the mappings are
+     * shared views that the server and algorithms go on writing. */
+    struct StingerMonEpoch {
+      int64_t id;                 /* batches received before this one */
+      int64_t max_time;
+      int64_t refs;               /* pinning readers, plus one while current */
+
+      stinger_t * stinger;
+      StingerSnapshotMaps * maps; /* holds the mappings of stinger and algs */
+      std::string stinger_loc;
+      int64_t stinger_sz;
+      int64_t max_nv;
+
+      std::vector<StingerAlgState *> * algs;
+      std::map<std::string, StingerAlgState *> * alg_map;
+
+      /* sorted vertex indices over this epoch's algorithm data */
+      pthread_mutex_t sorted_lock;
+      std::map<SortedIndexKey, std::vector<int64_t> *> sorted_index;
+      std::vector<std::vector<int64_t> *> sorted_retired;
+
+      /* per-field aggregates of each algorithm's data, by name */
+      pthread_mutex_t summary_lock;
+      std::map<std::string, std::vector<StingerFieldSummary> *> summaries;
+
+      StingerMonEpoch();
+      ~StingerMonEpoch();
+    };
+
     class StingerMon {
 
       protected:
@@ -22,23 +99,38 @@ namespace gt {
 	~StingerMon();
 
       private:
-	std::vector<StingerAlgState *> * algs;                     
-	std::map<std::string, StingerAlgState *> * alg_map;        
-
-	pthread_rwlock_t alg_lock;
+	pthread_mutex_t epoch_lock;
+	StingerMonEpoch * current;
+	int64_t live_epochs;
 
-	stinger_t * stinger;
-	std::string stinger_loc;
-	int64_t stinger_sz;
+	StingerSnapshotMaps snapshots;
 
 	int64_t waiting;
 	int64_t wait_lock;
-	int64_t max_time;
         sem_t sync_lock;
 
+	StingerMonEpoch *
+	acquire_epoch();
+
+	void
+	release_epoch(StingerMonEpoch * epoch);
+
+	/* The epoch pinned by this thread, or else the current one, which only
+	 * the monitor thread (the one that retires epochs) may keep using */
+	StingerMonEpoch *
+	view();
+
+	const std::vector<StingerFieldSummary> *
+	summarize(StingerMonEpoch * epoch, StingerAlgState * alg);
+
       public:
 	static StingerMon& get_mon();
 
+	/* Mappings for update_algs are taken from here; each epoch releases
+	 * its own once its last reader is gone. */
+	StingerSnapshotMaps &
+	get_snapshots();
+
 	size_t
 	get_num_algs();
 
@@ -51,6 +143,8 @@ namespace gt {
 	bool
 	has_alg(const std::string & name);
 
+	/* Pins the current epoch for the calling thread until the matching
+	 * release; calls nest. The accessors below then answer from it. */
 	void
 	get_alg_read_lock();
 
@@ -65,6 +159,31 @@ namespace gt {
 	int64_t
 	get_max_time();
 
+	/* id of the epoch being read, -1 before the first batch */
+	int64_t
+	get_epoch();
+
+	/* epochs still mapped, including the current one */
+	int64_t
+	get_live_epochs();
+
+	/* Returns at least the first k vertices of data (nv values of the given
+	 * description-string type, byte_stride apart) ordered by value, ties by
+	 * vertex id, and sets *len to how many there are. The index is built on
+	 * the first request after a batch and only extended by later ones, so
+	 * repeated top-k and offset queries do not re-sort. Callers must hold the
+	 * alg read lock for as long as they use the result. */
+	const int64_t *
+	get_sorted_index(const uint8_t * data, char type, int64_t byte_stride, int64_t nv,
+	  bool asc, int64_t k, int64_t * len);
+
+	/* Sum, min, max, log-scale histogram and per vertex type aggregates
+	 * of every field in the named algorithm's data, or NULL if it has
+	 * none. update_algs computes them once per batch; the result is
+	 * valid while the alg read lock is held. */
+	const std::vector<StingerFieldSummary> *
+	get_alg_summary(const std::string & name);
+
 	stinger_t *
 	get_stinger();
 
@@ -0,0 +1,114 @@
+#ifndef  STINGER_RESULT_WRITER_H
+#define  STINGER_RESULT_WRITER_H
+
+extern "C" {
+  #include "stinger_core/stinger.h"
+}
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "stinger_alg_state.h"
+
+namespace gt {
+  namespace stinger {
+
+    /* Persists vertex names and algorithm results on a thread of its own so
+     * the batch loop never waits on the disk. submit() copies what is to be
+     * written into one of two buffers and returns; the writer thread writes
+     * the other. A snapshot still waiting when the next arrives is replaced
+     * by it, so under sustained load some batches are not written.
+     *
+     * Each field named in an algorithm's data_description goes to its own
+     * file, <out_dir>/<alg>.<field>.<batch>.col (.col.gz when compressed):
+     *
+     *   char[8] "STGRCOL1"
+     *   int64   batch, max_nv, nv, type (the data_description character)
+     *   int64   length, then the algorithm name
+     *   int64   length, then the field name
+     *   nv values of the field's type
+     *
+     * Names go to <out_dir>/vertex_names.<batch>.vtx in the format of
+     * stinger_names_save(). Files are written under a temporary name and
+     * renamed, so a reader never sees one half written. Only the results
+     * of the last history_cap batches written are kept (all if 0), and
+     * only the latest names. */
+    class StingerResultWriter {
+      public:
+	StingerResultWriter();
+	~StingerResultWriter();
+
+	/* zlib level 1-9; 0 writes uncompressed */
+	int
+	set_compression(int level);
+
+	void
+	submit(int64_t batch, stinger_t * S, bool names, const std::vector<StingerAlgState *> & algs,
+	  const std::string & out_dir, int64_t history_cap);
+
+	/* Writes what is pending and stops the writer thread */
+	void
+	finish();
+
+      private:
+	struct Column {
+	  std::string alg;
+	  std::string field;
+	  char type;
+	  std::vector<uint8_t> data;
+	};
+
+	struct Snapshot {
+	  int64_t batch;
+	  int64_t max_nv;
+	  int64_t nv;
+	  std::string out_dir;
+	  int64_t history_cap;
+	  int compression;
+	  char * names;      /* from open_memstream, NULL when not written */
+	  size_t names_len;
+	  std::vector<Column> columns;  /* only the first ncolumns are live */
+	  size_t ncolumns;
+	};
+
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	pthread_t thread;
+	bool running;
+	bool stopping;
+	bool ready;          /* front holds a snapshot for the writer */
+	Snapshot buffers[2];
+	Snapshot * front;    /* filled by submit() */
+	Snapshot * back;     /* written by the writer thread */
+	int compression;
+
+	std::deque<std::vector<std::string> > history;
+	std::string last_names;
+
+	int64_t submitted;
+	int64_t written;
+	int64_t superseded;
+	int64_t bytes_written;
+	double write_seconds;
+
+	static void *
+	start(void * self);
+
+	void
+	run();
+
+	void
+	write(Snapshot & snap);
+
+	bool
+	write_column(const Snapshot & snap, const Column & col, std::string & path);
+    };
+
+  }
+}
+
+#endif  /*STINGER_RESULT_WRITER_H*/
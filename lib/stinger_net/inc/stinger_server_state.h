@@ -11,6 +11,7 @@ extern "C" {
 #include "stinger_stream_state.h"
 #include "stinger_alg_state.h"
 #include "stinger_mon_state.h"
+#include "stinger_result_writer.h"
 #include "proto/stinger-batch.pb.h"
 #include "proto/stinger-monitor.pb.h"
 
@@ -43,6 +44,7 @@ namespace gt {
 	int64_t history_cap;
 	bool write_names;
 	std::string out_dir;
+	StingerResultWriter result_writer;
 
 	int64_t mon_lock;
 	std::vector<StingerMonState *> monitors;                     
@@ -224,8 +226,14 @@ namespace gt {
 	bool
 	set_write_names(bool write);
 
+	int
+	set_compress_data(int level);
+
 	void
 	write_data();
+
+	void
+	finish_writes();
     };
 
   } /* gt */
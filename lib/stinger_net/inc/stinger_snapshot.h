@@ -0,0 +1,80 @@
+#ifndef  STINGER_SNAPSHOT_H
+#define  STINGER_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+namespace gt {
+  namespace stinger {
+
+    typedef struct {
+      int64_t mappings;          /* held now, in use or idle */
+      int64_t mapped_bytes;
+      int64_t maps;              /* fresh mappings made */
+      int64_t reuses;            /* requests answered by an existing one */
+      int64_t unmaps;
+      double map_seconds;        /* spent in mmap */
+      double last_map_seconds;
+      int64_t populated_bytes;   /* prefaulted before first use */
+      double populate_seconds;   /* spent prefaulting: the first touch */
+    } snapshot_stats_t;
+
+    /* The shared memory the monitor maps for each batch: the STINGER and
+     * every algorithm's data. shm segments are mapped MAP_SHARED, so a
+     * mapping made for an earlier batch already shows the current contents;
+     * asking again for a segment of the same name and size returns it
+     * instead of mapping many GB afresh. Each map_* call takes a reference
+     * that release() drops, normally when the epoch using it is retired
+     * after its last reader. Up to ring_size unreferenced mappings are kept
+     * for reuse; older ones are unmapped. */
+    class StingerSnapshotMaps {
+      public:
+	StingerSnapshotMaps();
+	~StingerSnapshotMaps();
+
+	/* The STINGER is read sparsely, so it is left to fault in */
+	void *
+	map_stinger(const std::string & loc, int64_t size);
+
+	/* Algorithm data is read whole by reductions and sorts, so fresh
+	 * mappings are prefaulted when populate is set */
+	void *
+	map_data(const std::string & loc, int64_t size, bool populate = true);
+
+	void
+	release(void * addr);
+
+	void
+	set_ring_size(int64_t idle);
+
+	snapshot_stats_t
+	get_stats();
+
+      private:
+	struct Mapping {
+	  std::string loc;
+	  int64_t size;
+	  void * addr;
+	  int64_t refs;
+	  int64_t last_used;
+	};
+
+	pthread_mutex_t lock;
+	std::vector<Mapping> mappings;
+	int64_t ring_size;
+	int64_t clock;
+	snapshot_stats_t stats;
+
+	void *
+	map(const std::string & loc, int64_t size, bool populate);
+
+	void
+	trim();
+    };
+
+  }
+}
+
+#endif  /*STINGER_SNAPSHOT_H*/
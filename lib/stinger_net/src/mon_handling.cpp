@@ -35,21 +35,25 @@ typedef struct {
 } mon_handler_params_t;
 
 bool
-map_update(ServerToMon & server_to_mon, stinger_t ** stinger_copy,
+map_update(StingerSnapshotMaps & maps, ServerToMon & server_to_mon, stinger_t ** stinger_copy,
   std::vector<StingerAlgState *> & algs, 
   std::map<std::string, StingerAlgState *> & alg_map)
 {
-
+  /* the same segments come back batch after batch and keep their mappings */
   LOG_D_A("Mapping stinger %s %ld", server_to_mon.stinger_loc().c_str(), server_to_mon.stinger_size());
-  *stinger_copy = stinger_shared_private(server_to_mon.stinger_loc().c_str(), server_to_mon.stinger_size());
+  *stinger_copy = (stinger_t *) maps.map_stinger(server_to_mon.stinger_loc(), server_to_mon.stinger_size());
+
+  if (!(*stinger_copy)) {
+    LOG_E("Failed to map STINGER");
+    return false;
+  }
 
   LOG_D("Mapping all algs");
   for(int64_t d = 0; d < server_to_mon.dep_name_size(); d++) {
     StingerAlgState * alg_state = new StingerAlgState();
     
-    alg_state->data = shmmap(
-      server_to_mon.dep_data_loc(d).c_str(), O_RDWR, S_IRUSR | S_IWUSR, PROT_READ | PROT_WRITE, 
-      server_to_mon.dep_data_per_vertex(d) * ((*stinger_copy)->max_nv), MAP_PRIVATE);
+    alg_state->data = maps.map_data(server_to_mon.dep_data_loc(d),
+      server_to_mon.dep_data_per_vertex(d) * ((*stinger_copy)->max_nv));
 
     if(!alg_state->data) {
       LOG_E_A("Failed to map data for %s, but continuing", server_to_mon.dep_name(d).c_str());
@@ -105,7 +109,7 @@ mon_handler(void * args)
       stinger_t * new_stinger;
       std::vector<StingerAlgState *> * algs = new std::vector<StingerAlgState *>();
       std::map<std::string, StingerAlgState *> * alg_map = new std::map<std::string, StingerAlgState *>();
-      map_update(server_to_mon, &new_stinger, *algs, *alg_map);
+      map_update(server_state.get_snapshots(), server_to_mon, &new_stinger, *algs, *alg_map);
       server_state.update_algs(new_stinger, server_to_mon.stinger_loc(), server_to_mon.stinger_size(), algs, alg_map, server_to_mon.batch());
       while(1) {
 	LOG_V_A("%s : beginning update cycle", params->name);
@@ -119,7 +123,7 @@ mon_handler(void * args)
 	  stinger_t * new_stinger;
 	  std::vector<StingerAlgState *> * algs = new std::vector<StingerAlgState *>();
 	  std::map<std::string, StingerAlgState *> * alg_map = new std::map<std::string, StingerAlgState *>();
-	  map_update(server_to_mon, &new_stinger, *algs, *alg_map);
+	  map_update(server_state.get_snapshots(), server_to_mon, &new_stinger, *algs, *alg_map);
 	  server_state.sync();
 	  mon_to_server.set_action(END_UPDATE);
 	  if(!send_message(params->sock, mon_to_server)) {
@@ -1,5 +1,8 @@
 #include <pthread.h>
 #include <sys/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 #include "stinger_core/xmalloc.h"
 #include "stinger_core/x86_full_empty.h"
@@ -12,9 +15,208 @@
 
 using namespace gt::stinger;
 
+/* Built indices cover at least this many vertices, so that a dashboard
+ * stepping through pages does not rebuild on every page */
+#define SORTED_INDEX_MIN 1024
+
+namespace {
+  template <typename T>
+  struct sorted_index_less {
+    const uint8_t * data;
+    int64_t stride;
+    bool asc;
+
+    bool operator()(int64_t a, int64_t b) const {
+      T a_t = *(const T *)(data + stride * a);
+      T b_t = *(const T *)(data + stride * b);
+      if (a_t != b_t)
+	return asc ? a_t < b_t : a_t > b_t;
+      return a < b;
+    }
+  };
+
+  /* Orders the first k entries of idx, which holds every vertex. Everything
+   * past them is only partitioned, and dropped unless k is close to nv. */
+  template <typename T>
+  void
+  sort_prefix(std::vector<int64_t> & idx, const uint8_t * data, int64_t stride, bool asc, int64_t k)
+  {
+    sorted_index_less<T> cmp = { data, stride, asc };
+    int64_t nv = idx.size();
+    if (k * 4 >= nv * 3) {
+      std::sort(idx.begin(), idx.end(), cmp);
+    } else {
+      std::nth_element(idx.begin(), idx.begin() + k, idx.end(), cmp);
+      std::sort(idx.begin(), idx.begin() + k, cmp);
+      idx.resize(k);
+    }
+  }
+}
+
+bool
+SortedIndexKey::operator<(const SortedIndexKey & b) const
+{
+  if (data != b.data) return data < b.data;
+  if (stride != b.stride) return stride < b.stride;
+  if (nv != b.nv) return nv < b.nv;
+  if (type != b.type) return type < b.type;
+  return asc < b.asc;
+}
+
+namespace {
+  void
+  value_summary_init(StingerValueSummary & s)
+  {
+    s.count = 0;
+    s.sum = 0.0;
+    s.isum = 0;
+    s.min = HUGE_VAL;
+    s.max = -HUGE_VAL;
+  }
+
+  void
+  value_summary_add(StingerValueSummary & s, double x, int64_t ix)
+  {
+    s.count++;
+    s.sum += x;
+    s.isum += ix;
+    if (x < s.min) s.min = x;
+    if (x > s.max) s.max = x;
+  }
+
+  void
+  value_summary_merge(StingerValueSummary & into, const StingerValueSummary & from)
+  {
+    into.count += from.count;
+    into.sum += from.sum;
+    into.isum += from.isum;
+    if (from.min < into.min) into.min = from.min;
+    if (from.max > into.max) into.max = from.max;
+  }
+
+  void
+  field_summary_init(StingerFieldSummary & f, int64_t nvtypes)
+  {
+    value_summary_init(f.all);
+    f.positive = 0;
+    f.positive_sum = 0.0;
+    f.positive_isum = 0;
+    f.negative = 0;
+    memset(f.hist, 0, sizeof(f.hist));
+    f.by_vtype.resize(nvtypes);
+    for (int64_t t = 0; t < nvtypes; t++)
+      value_summary_init(f.by_vtype[t]);
+  }
+
+  int64_t
+  hist_bin(double x)
+  {
+    if (x == 0.0)
+      return 0;
+    int e;
+    frexp(fabs(x), &e);   /* |x| in [2^(e-1), 2^e) */
+    int64_t bin = 1 + STINGER_SUMMARY_HIST_BIAS + (e - 1);
+    if (bin < 1) bin = 1;
+    if (bin > STINGER_SUMMARY_HIST_BINS - 1) bin = STINGER_SUMMARY_HIST_BINS - 1;
+    return bin;
+  }
+
+  /* width in bytes of a description string type, 0 if unknown */
+  int64_t
+  field_width(char type)
+  {
+    switch (type) {
+      case 'f': return sizeof(float);
+      case 'd': return sizeof(double);
+      case 'i': return sizeof(int32_t);
+      case 'l': return sizeof(int64_t);
+      case 'b': return sizeof(uint8_t);
+      default: return 0;
+    }
+  }
+
+  double
+  field_value(char type, const uint8_t * field, int64_t v)
+  {
+    switch (type) {
+      case 'f': return ((const float *) field)[v];
+      case 'd': return ((const double *) field)[v];
+      case 'i': return ((const int32_t *) field)[v];
+      case 'l': return (double) ((const int64_t *) field)[v];
+      default:  return field[v];
+    }
+  }
+
+  /* the value as an integer for the integer types, 0 for the others */
+  int64_t
+  field_int_value(char type, const uint8_t * field, int64_t v)
+  {
+    switch (type) {
+      case 'i': return ((const int32_t *) field)[v];
+      case 'l': return ((const int64_t *) field)[v];
+      case 'b': return field[v];
+      default:  return 0;
+    }
+  }
+}
+
 static uint64_t singleton_lock = 0;
 static StingerMon * state = NULL;
 
+/* the epoch each thread has pinned, and in which monitor */
+static __thread StingerMon * pinned_mon = NULL;
+static __thread StingerMonEpoch * pinned_epoch = NULL;
+static __thread int64_t pinned_depth = 0;
+
+StingerMonEpoch::StingerMonEpoch() : id(-1), max_time(-922337203685477580), refs(1),
+  stinger(NULL), maps(NULL), stinger_loc(""), stinger_sz(0), max_nv(0),
+  algs(NULL), alg_map(NULL)
+{
+  pthread_mutex_init(&sorted_lock, NULL);
+  pthread_mutex_init(&summary_lock, NULL);
+}
+
+StingerMonEpoch::~StingerMonEpoch()
+{
+  if(algs) {
+    for(int64_t i = 0; i < algs->size(); i++) {
+      StingerAlgState * cur_alg = (*algs)[i];
+      if(cur_alg) {
+	if(maps)
+	  maps->release(cur_alg->data);
+	delete cur_alg;
+      }
+    }
+    delete algs;
+  }
+  if(alg_map)
+    delete alg_map;
+
+  if(maps)
+    maps->release(stinger);
+
+  for (std::map<SortedIndexKey, std::vector<int64_t> *>::iterator it = sorted_index.begin();
+       it != sorted_index.end(); it++) {
+    delete it->second;
+  }
+  for (size_t i = 0; i < sorted_retired.size(); i++) {
+    delete sorted_retired[i];
+  }
+  pthread_mutex_destroy(&sorted_lock);
+
+  for (std::map<std::string, std::vector<StingerFieldSummary> *>::iterator it = summaries.begin();
+       it != summaries.end(); it++) {
+    delete it->second;
+  }
+  pthread_mutex_destroy(&summary_lock);
+}
+
+StingerSnapshotMaps &
+StingerMon::get_snapshots()
+{
+  return snapshots;
+}
+
 StingerMon &
 StingerMon::get_mon() {
   if(!state) {
@@ -27,24 +229,68 @@ StingerMon::get_mon() {
   return *state;
 }
 
-StingerMon::StingerMon() : stinger(NULL), 
-  stinger_loc(""), stinger_sz(0), algs(NULL), alg_map(NULL),
-  waiting(0), wait_lock(0), max_time(-922337203685477580)
+StingerMon::StingerMon() : current(NULL), live_epochs(0),
+  waiting(0), wait_lock(0)
 {
-  pthread_rwlock_init(&alg_lock, NULL);
+  pthread_mutex_init(&epoch_lock, NULL);
   sem_init(&sync_lock, 0, 0);
 }
 
 StingerMon::~StingerMon()
 {
+  if(current)
+    release_epoch(current);
+  pthread_mutex_destroy(&epoch_lock);
   sem_destroy(&sync_lock);
 }
 
+StingerMonEpoch *
+StingerMon::acquire_epoch()
+{
+  pthread_mutex_lock(&epoch_lock);
+  StingerMonEpoch * epoch = current;
+  if(epoch)
+    epoch->refs++;
+  pthread_mutex_unlock(&epoch_lock);
+  return epoch;
+}
+
+void
+StingerMon::release_epoch(StingerMonEpoch * epoch)
+{
+  if(!epoch)
+    return;
+
+  pthread_mutex_lock(&epoch_lock);
+  int64_t refs = --epoch->refs;
+  if(refs == 0)
+    live_epochs--;
+  pthread_mutex_unlock(&epoch_lock);
+
+  if(refs == 0) {
+    LOG_D_A("Unmapping epoch %ld", (long)epoch->id);
+    delete epoch;
+  }
+}
+
+StingerMonEpoch *
+StingerMon::view()
+{
+  if(pinned_depth > 0 && pinned_mon == this)
+    return pinned_epoch;
+
+  pthread_mutex_lock(&epoch_lock);
+  StingerMonEpoch * epoch = current;
+  pthread_mutex_unlock(&epoch_lock);
+  return epoch;
+}
+
 size_t
 StingerMon::get_num_algs()
 {
-  if(algs)
-    return algs->size();
+  StingerMonEpoch * epoch = view();
+  if(epoch && epoch->algs)
+    return epoch->algs->size();
   else
     return 0;
 }
@@ -52,8 +298,9 @@ StingerMon::get_num_algs()
 StingerAlgState *
 StingerMon::get_alg(size_t num)
 {
-  if(algs)
-    return (*algs)[num];
+  StingerMonEpoch * epoch = view();
+  if(epoch && epoch->algs)
+    return (*epoch->algs)[num];
   else
     return NULL;
 }
@@ -61,17 +308,21 @@ StingerMon::get_alg(size_t num)
 StingerAlgState *
 StingerMon::get_alg(const std::string & name)
 {
-  if(alg_map && has_alg(name))
-    return (*alg_map)[name];
-  else
-    return NULL;
+  StingerMonEpoch * epoch = view();
+  if(epoch && epoch->alg_map) {
+    std::map<std::string, StingerAlgState *>::iterator it = epoch->alg_map->find(name);
+    if(it != epoch->alg_map->end())
+      return it->second;
+  }
+  return NULL;
 }
 
 bool
 StingerMon::has_alg(const std::string & name)
 {
-  if(alg_map)
-    return alg_map->count(name) > 0;
+  StingerMonEpoch * epoch = view();
+  if(epoch && epoch->alg_map)
+    return epoch->alg_map->count(name) > 0;
   else
     return false;
 }
@@ -79,17 +330,30 @@ StingerMon::has_alg(const std::string & name)
 void
 StingerMon::get_alg_read_lock()
 {
-  LOG_D("read lock get");
-  pthread_rwlock_rdlock(&alg_lock);
-  LOG_D("read lock received");
+  if(pinned_depth > 0 && pinned_mon != this) {
+    LOG_E("Thread already reads from another monitor");
+    return;
+  }
+  if(pinned_depth++ == 0) {
+    pinned_mon = this;
+    pinned_epoch = acquire_epoch();
+    LOG_D_A("pinned epoch %ld", pinned_epoch ? (long)pinned_epoch->id : -1L);
+  }
 }
 
 void
 StingerMon::release_alg_read_lock()
 {
-  LOG_D("read lock release");
-  pthread_rwlock_unlock(&alg_lock);
-  LOG_D("read lock released");
+  if(pinned_depth <= 0 || pinned_mon != this) {
+    LOG_E("Releasing an epoch that was never pinned");
+    return;
+  }
+  if(--pinned_depth == 0) {
+    StingerMonEpoch * epoch = pinned_epoch;
+    pinned_epoch = NULL;
+    pinned_mon = NULL;
+    release_epoch(epoch);
+  }
 }
 
 void
@@ -98,52 +362,135 @@ StingerMon::update_algs(stinger_t * stinger_copy, std::string new_loc, int64_t n
   const StingerBatch & batch)
 {
   LOG_D_A("Called with %s, %ld", new_loc.c_str(), (long)new_sz);
-  LOG_D("write lock get");
-  pthread_rwlock_wrlock(&alg_lock);
-  LOG_D("write lock received");
-  /* remap stinger */
-  if(stinger) {
-    stinger_shared_unmap (stinger, stinger_loc.c_str(), stinger_sz);
-  }
-  stinger = stinger_copy;
-  stinger_loc = new_loc;
-  stinger_sz = new_sz;
-
-  /* unmap / delete existing algs */
-  if(stinger && algs) {
-    for(int64_t i = 0; i < algs->size(); i++) {
-      StingerAlgState * cur_alg = (*algs)[i];
-      if(cur_alg) {
-	shmunmap(cur_alg->data_loc.c_str(), cur_alg->data, cur_alg->data_per_vertex * stinger->max_nv);
-	delete cur_alg;
-      }
-    }
 
-    delete algs;
-  }
-  if(alg_map)
-    delete alg_map;
+  StingerMonEpoch * epoch = new StingerMonEpoch();
+  epoch->stinger = stinger_copy;
+  epoch->stinger_loc = new_loc;
+  epoch->stinger_sz = new_sz;
+  epoch->max_nv = stinger_copy ? stinger_copy->max_nv : 0;
+  epoch->algs = new_algs;
+  epoch->alg_map = new_alg_map;
+  epoch->maps = &snapshots;
 
-  algs = new_algs;
-  alg_map = new_alg_map;
+  /* only the monitor thread replaces the current epoch */
+  StingerMonEpoch * prev = current;
+  if(prev) {
+    epoch->id = prev->id + 1;
+    epoch->max_time = prev->max_time;
+  } else {
+    epoch->id = 0;
+  }
 
   /* update max time with latest insertion time */
-  int64_t new_max_time = max_time;
   for(int64_t i = 0; i < batch.insertions_size(); i++) {
     int64_t edge_time = batch.insertions(i).time();
-    if(edge_time > new_max_time)
-      new_max_time = edge_time;
+    if(edge_time > epoch->max_time)
+      epoch->max_time = edge_time;
+  }
+
+  pthread_mutex_lock(&epoch_lock);
+  current = epoch;
+  live_epochs++;
+  pthread_mutex_unlock(&epoch_lock);
+
+  /* readers still pinning the previous epoch keep it mapped */
+  release_epoch(prev);
+
+  /* aggregate the new data once, here, rather than per request */
+  if(new_algs) {
+    for(size_t i = 0; i < new_algs->size(); i++) {
+      if((*new_algs)[i])
+	summarize(epoch, (*new_algs)[i]);
+    }
+  }
+}
+
+const int64_t *
+StingerMon::get_sorted_index(const uint8_t * data, char type, int64_t byte_stride, int64_t nv,
+  bool asc, int64_t k, int64_t * len)
+{
+  StingerMonEpoch * epoch = view();
+  SortedIndexKey key = { data, byte_stride, nv, type, asc };
+  int64_t have = 0;
+
+  if (!epoch) {
+    *len = 0;
+    return NULL;
+  }
+  if (k > nv) k = nv;
+
+  pthread_mutex_lock(&epoch->sorted_lock);
+  std::map<SortedIndexKey, std::vector<int64_t> *>::iterator it = epoch->sorted_index.find(key);
+  if (it != epoch->sorted_index.end()) {
+    have = it->second->size();
+    if (have >= k) {
+      const int64_t * idx = it->second->data();
+      *len = have;
+      pthread_mutex_unlock(&epoch->sorted_lock);
+      return idx;
+    }
   }
-  max_time = new_max_time;
+  pthread_mutex_unlock(&epoch->sorted_lock);
+
+  /* sort outside the lock; two readers may race to build the same index */
+  int64_t want = std::max(k, std::max(2 * have, (int64_t)SORTED_INDEX_MIN));
+  if (want > nv) want = nv;
 
-  LOG_D("write lock release");
-  pthread_rwlock_unlock(&alg_lock);
-  LOG_D("write lock released");
+  std::vector<int64_t> * idx = new std::vector<int64_t>(nv);
+  for (int64_t i = 0; i < nv; i++)
+    (*idx)[i] = i;
+
+  switch (type) {
+    case 'f': sort_prefix<float>(*idx, data, byte_stride, asc, want); break;
+    case 'd': sort_prefix<double>(*idx, data, byte_stride, asc, want); break;
+    case 'i': sort_prefix<int32_t>(*idx, data, byte_stride, asc, want); break;
+    case 'l':
+    case 's': sort_prefix<int64_t>(*idx, data, byte_stride, asc, want); break;
+    case 'b': sort_prefix<uint8_t>(*idx, data, byte_stride, asc, want); break;
+    default:
+      LOG_W_A("Unknown data type %c", type);
+      delete idx;
+      *len = 0;
+      return NULL;
+  }
+  LOG_D_A("Sorted %ld of %ld vertices", (long)idx->size(), (long)nv);
+
+  /* an index handed out earlier may still be in use until the epoch ends */
+  pthread_mutex_lock(&epoch->sorted_lock);
+  std::vector<int64_t> *& slot = epoch->sorted_index[key];
+  if (slot && slot->size() >= idx->size()) {
+    delete idx;
+    idx = slot;
+  } else {
+    if (slot)
+      epoch->sorted_retired.push_back(slot);
+    slot = idx;
+  }
+  const int64_t * rtn = idx->data();
+  *len = idx->size();
+  pthread_mutex_unlock(&epoch->sorted_lock);
+
+  return rtn;
 }
 
 int64_t
 StingerMon::get_max_time() {
-  return max_time;
+  StingerMonEpoch * epoch = view();
+  return epoch ? epoch->max_time : -922337203685477580;
+}
+
+int64_t
+StingerMon::get_epoch() {
+  StingerMonEpoch * epoch = view();
+  return epoch ? epoch->id : -1;
+}
+
+int64_t
+StingerMon::get_live_epochs() {
+  pthread_mutex_lock(&epoch_lock);
+  int64_t rtn = live_epochs;
+  pthread_mutex_unlock(&epoch_lock);
+  return rtn;
 }
 
 void
@@ -166,8 +513,109 @@ StingerMon::sync()
   writeef((uint64_t *)&wait_lock, 0);
 }
 
+/* One parallel pass per field over all max_nv vertex slots, the range the
+ * reductions have always covered; threads keep private partials and merge
+ * them at the end. */
+const std::vector<StingerFieldSummary> *
+StingerMon::summarize(StingerMonEpoch * epoch, StingerAlgState * alg)
+{
+  pthread_mutex_lock(&epoch->summary_lock);
+  std::map<std::string, std::vector<StingerFieldSummary> *>::iterator it = epoch->summaries.find(alg->name);
+  if (it != epoch->summaries.end()) {
+    pthread_mutex_unlock(&epoch->summary_lock);
+    return it->second;
+  }
+
+  std::vector<StingerFieldSummary> * fields = NULL;
+  const std::string & desc = alg->data_description;
+  size_t space = desc.find(' ');
+  if (alg->data && space != std::string::npos) {
+    stinger_t * S = epoch->stinger;
+    int64_t max_nv = epoch->max_nv;
+    int64_t nvtypes = S ? S->max_nvtypes : 0;
+
+    fields = new std::vector<StingerFieldSummary>();
+    const uint8_t * field = (const uint8_t *) alg->data;
+    size_t pos = space + 1;
+    for (size_t f = 0; f < space && pos <= desc.size(); f++) {
+      char type = desc[f];
+      int64_t width = field_width(type);
+      if (!width)
+	break;
+      size_t end = desc.find(' ', pos);
+      if (end == std::string::npos)
+	end = desc.size();
+
+      StingerFieldSummary summary;
+      summary.name = desc.substr(pos, end - pos);
+      summary.type = type;
+      field_summary_init(summary, nvtypes);
+
+      OMP("omp parallel")
+      {
+	StingerFieldSummary local;
+	field_summary_init(local, nvtypes);
+
+	OMP("omp for")
+	for (int64_t v = 0; v < max_nv; v++) {
+	  double x = field_value(type, field, v);
+	  int64_t ix = field_int_value(type, field, v);
+	  value_summary_add(local.all, x, ix);
+	  if (x > 0.0) {
+	    local.positive++;
+	    local.positive_sum += x;
+	    local.positive_isum += ix;
+	  } else if (x < 0.0) {
+	    local.negative++;
+	  }
+	  local.hist[hist_bin(x)]++;
+	  if (nvtypes) {
+	    int64_t t = stinger_vtype_get(S, v);
+	    if (t >= 0 && t < nvtypes)
+	      value_summary_add(local.by_vtype[t], x, ix);
+	  }
+	}
+
+	OMP("omp critical")
+	{
+	  value_summary_merge(summary.all, local.all);
+	  summary.positive += local.positive;
+	  summary.positive_sum += local.positive_sum;
+	  summary.positive_isum += local.positive_isum;
+	  summary.negative += local.negative;
+	  for (int64_t b = 0; b < STINGER_SUMMARY_HIST_BINS; b++)
+	    summary.hist[b] += local.hist[b];
+	  for (int64_t t = 0; t < nvtypes; t++)
+	    value_summary_merge(summary.by_vtype[t], local.by_vtype[t]);
+	}
+      }
+
+      fields->push_back(summary);
+      field += width * max_nv;
+      pos = end + 1;
+    }
+  }
+
+  epoch->summaries[alg->name] = fields;
+  pthread_mutex_unlock(&epoch->summary_lock);
+  return fields;
+}
+
+const std::vector<StingerFieldSummary> *
+StingerMon::get_alg_summary(const std::string & name)
+{
+  StingerMonEpoch * epoch = view();
+  if (!epoch || !epoch->alg_map)
+    return NULL;
+  std::map<std::string, StingerAlgState *>::iterator alg = epoch->alg_map->find(name);
+  if (alg == epoch->alg_map->end() || !alg->second)
+    return NULL;
+  return summarize(epoch, alg->second);
+}
+
 stinger_t *
 StingerMon::get_stinger()
 {
-  return stinger;
+  StingerMonEpoch * epoch = view();
+  return epoch ? epoch->stinger : NULL;
 }
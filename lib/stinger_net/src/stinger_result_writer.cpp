@@ -0,0 +1,406 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(STINGER_NET_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "stinger_result_writer.h"
+
+extern "C" {
+  #include "stinger_core/stinger_error.h"
+}
+
+using namespace gt::stinger;
+
+#define COLUMN_MAGIC "STGRCOL1"
+
+/* bytes each thread copies at a time */
+#define COPY_CHUNK (1 << 20)
+
+static double
+now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static int64_t
+field_width(char type)
+{
+  switch (type) {
+    case 'f': return sizeof(float);
+    case 'd': return sizeof(double);
+    case 'i': return sizeof(int32_t);
+    case 'l': return sizeof(int64_t);
+    case 'b': return sizeof(uint8_t);
+    default: return 0;
+  }
+}
+
+static void
+parallel_copy(uint8_t * dst, const uint8_t * src, int64_t bytes)
+{
+  int64_t chunks = (bytes + COPY_CHUNK - 1) / COPY_CHUNK;
+  OMP("omp parallel for if(chunks > 1)")
+  for (int64_t c = 0; c < chunks; c++) {
+    int64_t off = c * COPY_CHUNK;
+    int64_t len = bytes - off < COPY_CHUNK ? bytes - off : COPY_CHUNK;
+    memcpy(dst + off, src + off, len);
+  }
+}
+
+/* A file being written, plain or through zlib */
+class ColumnFile {
+  public:
+    ColumnFile() : fp(NULL), failed(false), bytes(0)
+#if defined(STINGER_NET_USE_ZLIB)
+      , gz(NULL)
+#endif
+    { }
+
+    bool
+    open(const char * path, int level)
+    {
+#if defined(STINGER_NET_USE_ZLIB)
+      if (level > 0) {
+	char mode[8];
+	snprintf(mode, sizeof(mode), "wb%d", level);
+	gz = gzopen(path, mode);
+	return gz != NULL;
+      }
+#endif
+      fp = fopen(path, "wb");
+      return fp != NULL;
+    }
+
+    void
+    put(const void * buf, int64_t len)
+    {
+      if (failed || len <= 0)
+	return;
+#if defined(STINGER_NET_USE_ZLIB)
+      if (gz) {
+	/* gzwrite takes an unsigned length */
+	const char * p = (const char *) buf;
+	while (len > 0 && !failed) {
+	  unsigned n = len > (1 << 30) ? (1 << 30) : (unsigned) len;
+	  failed = (gzwrite(gz, p, n) != (int) n);
+	  p += n;
+	  len -= n;
+	  bytes += n;
+	}
+	return;
+      }
+#endif
+      failed = (fwrite(buf, 1, len, fp) != (size_t) len);
+      bytes += len;
+    }
+
+    void
+    put_int64(int64_t x)
+    {
+      put(&x, sizeof(x));
+    }
+
+    void
+    put_string(const std::string & s)
+    {
+      put_int64(s.size());
+      put(s.data(), s.size());
+    }
+
+    bool
+    close()
+    {
+#if defined(STINGER_NET_USE_ZLIB)
+      if (gz) {
+	failed |= (gzclose(gz) != Z_OK);
+	gz = NULL;
+	return !failed;
+      }
+#endif
+      if (fp) {
+	failed |= (fclose(fp) != 0);
+	fp = NULL;
+      }
+      return !failed;
+    }
+
+    int64_t
+    written() { return bytes; }
+
+  private:
+    FILE * fp;
+    bool failed;
+    int64_t bytes;
+#if defined(STINGER_NET_USE_ZLIB)
+    gzFile gz;
+#endif
+};
+
+StingerResultWriter::StingerResultWriter() : running(false), stopping(false), ready(false),
+  front(&buffers[0]), back(&buffers[1]), compression(0),
+  submitted(0), written(0), superseded(0), bytes_written(0), write_seconds(0)
+{
+  pthread_mutex_init(&lock, NULL);
+  pthread_cond_init(&cond, NULL);
+  for (int i = 0; i < 2; i++) {
+    buffers[i].names = NULL;
+    buffers[i].names_len = 0;
+    buffers[i].ncolumns = 0;
+  }
+}
+
+StingerResultWriter::~StingerResultWriter()
+{
+  finish();
+  for (int i = 0; i < 2; i++)
+    free(buffers[i].names);
+  pthread_cond_destroy(&cond);
+  pthread_mutex_destroy(&lock);
+}
+
+int
+StingerResultWriter::set_compression(int level)
+{
+#if !defined(STINGER_NET_USE_ZLIB)
+  if (level > 0) {
+    LOG_W("Built without zlib; results will be written uncompressed");
+    level = 0;
+  }
+#endif
+  if (level < 0) level = 0;
+  if (level > 9) level = 9;
+  return compression = level;
+}
+
+void
+StingerResultWriter::submit(int64_t batch, stinger_t * S, bool names,
+  const std::vector<StingerAlgState *> & algs, const std::string & out_dir, int64_t history_cap)
+{
+  pthread_mutex_lock(&lock);
+  if (!running) {
+    if (pthread_create(&thread, NULL, start, this)) {
+      LOG_E("Could not start the result writer");
+      pthread_mutex_unlock(&lock);
+      return;
+    }
+    running = true;
+  }
+  /* take back a snapshot the writer has not started on; this one replaces it */
+  if (ready) {
+    ready = false;
+    superseded++;
+    LOG_D_A("Results of batch %ld superseded before being written", (long) front->batch);
+  }
+  submitted++;
+  pthread_mutex_unlock(&lock);
+
+  Snapshot & snap = *front;
+  snap.batch = batch;
+  snap.max_nv = S->max_nv;
+  snap.nv = stinger_mapping_nv(S);
+  if (snap.nv <= 0 || snap.nv > snap.max_nv)
+    snap.nv = snap.max_nv;
+  snap.out_dir = out_dir;
+  snap.history_cap = history_cap;
+  snap.compression = compression;
+
+  free(snap.names);
+  snap.names = NULL;
+  snap.names_len = 0;
+  if (names) {
+    FILE * fp = open_memstream(&snap.names, &snap.names_len);
+    if (fp) {
+      stinger_names_save(stinger_physmap_get(S), fp);
+      fclose(fp);
+    } else {
+      LOG_E_A("Could not buffer vertex names: %s", strerror(errno));
+    }
+  }
+
+  snap.ncolumns = 0;
+  for (size_t a = 0; a < algs.size(); a++) {
+    StingerAlgState * alg = algs[a];
+    if (alg->state >= ALG_STATE_DONE || !alg->data) /* skip invalid, completed, etc. */
+      continue;
+
+    const std::string & desc = alg->data_description;
+    size_t space = desc.find(' ');
+    if (space == std::string::npos)
+      continue;
+
+    const uint8_t * field = (const uint8_t *) alg->data;
+    size_t pos = space + 1;
+    for (size_t f = 0; f < space && pos <= desc.size(); f++) {
+      int64_t width = field_width(desc[f]);
+      if (!width)
+	break;
+      size_t end = desc.find(' ', pos);
+      if (end == std::string::npos)
+	end = desc.size();
+
+      if (snap.ncolumns == snap.columns.size())
+	snap.columns.resize(snap.ncolumns + 1);
+      Column & col = snap.columns[snap.ncolumns++];
+      col.alg = alg->name;
+      col.field = desc.substr(pos, end - pos);
+      col.type = desc[f];
+      /* the vector keeps its capacity from batch to batch */
+      col.data.resize(width * snap.nv);
+      parallel_copy(col.data.data(), field, width * snap.nv);
+
+      field += width * snap.max_nv;
+      pos = end + 1;
+    }
+  }
+
+  pthread_mutex_lock(&lock);
+  ready = true;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+}
+
+void
+StingerResultWriter::finish()
+{
+  pthread_mutex_lock(&lock);
+  if (!running) {
+    pthread_mutex_unlock(&lock);
+    return;
+  }
+  stopping = true;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&lock);
+
+  pthread_join(thread, NULL);
+  running = false;
+  stopping = false;
+  LOG_I_A("Result writer wrote %ld of %ld batches (%ld superseded), %ld bytes in %g s",
+    (long) written, (long) submitted, (long) superseded, (long) bytes_written, write_seconds);
+}
+
+void *
+StingerResultWriter::start(void * self)
+{
+  ((StingerResultWriter *) self)->run();
+  return NULL;
+}
+
+void
+StingerResultWriter::run()
+{
+  pthread_mutex_lock(&lock);
+  while (1) {
+    while (!ready && !stopping)
+      pthread_cond_wait(&cond, &lock);
+    if (!ready)
+      break;
+
+    std::swap(front, back);
+    ready = false;
+    pthread_mutex_unlock(&lock);
+
+    double t = now_seconds();
+    write(*back);
+    t = now_seconds() - t;
+
+    pthread_mutex_lock(&lock);
+    written++;
+    write_seconds += t;
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void
+StingerResultWriter::write(Snapshot & snap)
+{
+  char name_buf[1024];
+  char tmp_buf[1040];
+
+  if (snap.names) {
+    snprintf(name_buf, sizeof(name_buf), "%s/vertex_names.%ld.vtx", snap.out_dir.c_str(), (long) snap.batch);
+    snprintf(tmp_buf, sizeof(tmp_buf), "%s.tmp", name_buf);
+    FILE * fp = fopen(tmp_buf, "wb");
+    if (!fp) {
+      LOG_E_A("Could not open %s: %s", tmp_buf, strerror(errno));
+    } else {
+      bool ok = (fwrite(snap.names, 1, snap.names_len, fp) == snap.names_len);
+      ok &= (fclose(fp) == 0);
+      if (ok && 0 == rename(tmp_buf, name_buf)) {
+	pthread_mutex_lock(&lock);
+	bytes_written += snap.names_len;
+	pthread_mutex_unlock(&lock);
+	/* remove previous vertex names */
+	if (!last_names.empty() && last_names != name_buf)
+	  unlink(last_names.c_str());
+	last_names = name_buf;
+      } else {
+	LOG_E_A("Writing %s failed", name_buf);
+	unlink(tmp_buf);
+      }
+    }
+  }
+
+  if (!snap.ncolumns)
+    return;
+
+  std::vector<std::string> files;
+  for (size_t c = 0; c < snap.ncolumns; c++) {
+    std::string path;
+    if (write_column(snap, snap.columns[c], path))
+      files.push_back(path);
+  }
+  history.push_back(files);
+
+  /* if there is a cap on history, erase the oldest batches written */
+  while (snap.history_cap > 0 && (int64_t) history.size() > snap.history_cap) {
+    const std::vector<std::string> & old = history.front();
+    for (size_t i = 0; i < old.size(); i++)
+      unlink(old[i].c_str());
+    history.pop_front();
+  }
+}
+
+bool
+StingerResultWriter::write_column(const Snapshot & snap, const Column & col, std::string & path)
+{
+  char name_buf[1024];
+  char tmp_buf[1040];
+  snprintf(name_buf, sizeof(name_buf), "%s/%s.%s.%ld.col%s", snap.out_dir.c_str(), col.alg.c_str(),
+    col.field.c_str(), (long) snap.batch, snap.compression ? ".gz" : "");
+  snprintf(tmp_buf, sizeof(tmp_buf), "%s.tmp", name_buf);
+
+  ColumnFile out;
+  if (!out.open(tmp_buf, snap.compression)) {
+    LOG_E_A("Could not open %s: %s", tmp_buf, strerror(errno));
+    return false;
+  }
+
+  out.put(COLUMN_MAGIC, 8);
+  out.put_int64(snap.batch);
+  out.put_int64(snap.max_nv);
+  out.put_int64(snap.nv);
+  out.put_int64(col.type);
+  out.put_string(col.alg);
+  out.put_string(col.field);
+  out.put(col.data.data(), col.data.size());
+
+  if (!out.close() || rename(tmp_buf, name_buf)) {
+    LOG_E_A("Writing %s failed", name_buf);
+    unlink(tmp_buf);
+    return false;
+  }
+
+  pthread_mutex_lock(&lock);
+  bytes_written += out.written();
+  pthread_mutex_unlock(&lock);
+  path = name_buf;
+  return true;
+}
@@ -526,106 +526,34 @@ StingerServerState::set_write_names(bool write)
   return write_names = write;
 }
 
-/* write out the current algorithm states and names as needed 
- * alg state data format (binary):
- *  64-bit integer: name_length
- *  string: name
- *  64-bit integer: description_length
- *  string: description (see stinger_alg.h for explanation)
- *  64-bit integer: maximum number of vertices
- *  64-bit integer: number of vertices in file
- *  for each field in the description
- *    [ array of number of vertices elements of the given field type ]
+int
+StingerServerState::set_compress_data(int level)
+{
+  return result_writer.set_compression(level);
+}
+
+/* hand the current algorithm states and names to the result writer, which
+ * writes them in the background (see stinger_result_writer.h for the format)
  */
 void
 StingerServerState::write_data()
 {
-  char name_buf[1024];
-  if(write_names) {
-    /* write current vertex names to file */
-    snprintf(name_buf, 1024, "%s/vertex_names.%ld.vtx", out_dir.c_str(), batch_count);
-
-    FILE * fp = fopen(name_buf, "w");
-    stinger_names_save(stinger_physmap_get(stinger), fp);
-    fflush(fp);
-    fclose(fp);
+  if(!write_names && !write_alg_data)
+    return;
 
-    /* remove previous vertex names */
-    snprintf(name_buf, 1024, "%s/vertex_names.%ld.vtx", out_dir.c_str(), batch_count-1);
-    if(access(name_buf, F_OK) != -1) {
-      unlink(name_buf);
-    }
-  }
-
-  /* write out each algorithm's data */
+  std::vector<StingerAlgState *> to_write;
   if(write_alg_data) {
     for(int64_t i = 0; i < get_num_algs(); i++) {
-      StingerAlgState * alg = get_alg(i);
-
-      if(alg->state >= ALG_STATE_DONE) /* skip invalid, completed, etc. */
-	continue;
-
-      snprintf(name_buf, 1024, "%s/%s.%ld.rslt", out_dir.c_str(), alg->name.c_str(), batch_count);
-
-      int64_t nv_max = stinger->max_nv;
-      int64_t nv = stinger_mapping_nv(stinger);
-      int64_t size = 0;
-
-      FILE * fp = fopen(name_buf, "w");
-      
-      size = alg->name.length();
-      fwrite(&size, sizeof(int64_t), 1, fp);
-      fwrite(alg->name.c_str(), size, sizeof(char), fp);
-      size = alg->data_description.length();
-      fwrite(&size, sizeof(int64_t), 1, fp);
-      fwrite(alg->data_description.c_str(), size, sizeof(char), fp);
-      fwrite(&nv_max, sizeof(int64_t), 1, fp);
-      fwrite(&nv, sizeof(int64_t), 1, fp);
-
-      const char * field = alg->data_description.c_str();
-      uint8_t * data = (uint8_t *)alg->data;
-      bool done = false;
-      while(!done) {
-	switch(*field) {
-
-	  case 'f': {
-	    fwrite(data, sizeof(float), nv_max, fp);
-	    data += (sizeof(float) * nv_max);
-	  } break;
-	  case 'd': {
-	    fwrite(data, sizeof(double), nv_max, fp);
-	    data += (sizeof(double) * nv_max);
-	  } break;
-	  case 'i': {
-	    fwrite(data, sizeof(int32_t), nv_max, fp);
-	    data += (sizeof(int32_t) * nv_max);
-	  } break;
-	  case 'l': {
-	    fwrite(data, sizeof(int64_t), nv_max, fp);
-	    data += (sizeof(int64_t) * nv_max);
-	  } break;
-	  case 'b': {
-	    fwrite(data, sizeof(uint8_t), nv_max, fp);
-	    data += (sizeof(uint8_t) * nv_max);
-	  } break;
-
-	  default: {
-	    done = true;
-	  } break;
-	}
-	field++;
-      }
-
-      fflush(fp);
-      fclose(fp);
-
-      /* if there is a cap on history, erase (current - history) if it exists */
-      if(history_cap) {
-	snprintf(name_buf, 1024, "%s/%s.%ld.rslt", out_dir.c_str(), alg->name.c_str(), batch_count - history_cap);
-	if(access(name_buf, F_OK) != -1) {
-	  unlink(name_buf);
-	}
-      }
+      to_write.push_back(get_alg(i));
     }
   }
+
+  result_writer.submit(batch_count, stinger, write_names, to_write, out_dir, history_cap);
+}
+
+/* write what is pending; called on shutdown */
+void
+StingerServerState::finish_writes()
+{
+  result_writer.finish();
 }
@@ -0,0 +1,181 @@
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stinger_snapshot.h"
+
+#define LOG_AT_W  /* warning only */
+#include "stinger_core/stinger_error.h"
+
+using namespace gt::stinger;
+
+static double
+now_seconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+/* Faults in every page of a fresh mapping so readers do not pay for it */
+static void
+prefault(void * addr, int64_t size)
+{
+#if defined(MADV_POPULATE_READ)
+  if (0 == madvise(addr, size, MADV_POPULATE_READ))
+    return;
+#endif
+  int64_t page = sysconf(_SC_PAGESIZE);
+  volatile const char * p = (volatile const char *) addr;
+  char sum = 0;
+  for (int64_t i = 0; i < size; i += page)
+    sum += p[i];
+  (void) sum;
+}
+
+StingerSnapshotMaps::StingerSnapshotMaps() : ring_size(4), clock(0)
+{
+  pthread_mutex_init(&lock, NULL);
+  memset(&stats, 0, sizeof(stats));
+}
+
+StingerSnapshotMaps::~StingerSnapshotMaps()
+{
+  pthread_mutex_destroy(&lock);
+}
+
+void *
+StingerSnapshotMaps::map_stinger(const std::string & loc, int64_t size)
+{
+  return map(loc, size, false);
+}
+
+void *
+StingerSnapshotMaps::map_data(const std::string & loc, int64_t size, bool populate)
+{
+  return map(loc, size, populate);
+}
+
+void *
+StingerSnapshotMaps::map(const std::string & loc, int64_t size, bool populate)
+{
+  pthread_mutex_lock(&lock);
+  for (size_t i = 0; i < mappings.size(); i++) {
+    Mapping & m = mappings[i];
+    if (m.size == size && m.loc == loc) {
+      m.refs++;
+      m.last_used = ++clock;
+      stats.reuses++;
+      pthread_mutex_unlock(&lock);
+      return m.addr;
+    }
+  }
+  pthread_mutex_unlock(&lock);
+
+  double t0 = now_seconds();
+  int fd = shm_open(loc.c_str(), O_RDONLY, S_IRUSR);
+  if (fd < 0) {
+    LOG_E_A("Opening %s failed: %s", loc.c_str(), strerror(errno));
+    return NULL;
+  }
+  void * addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    LOG_E_A("Mapping %s of size %ld failed: %s", loc.c_str(), (long) size, strerror(errno));
+    return NULL;
+  }
+  double t1 = now_seconds();
+  if (populate)
+    prefault(addr, size);
+  double t2 = now_seconds();
+
+  pthread_mutex_lock(&lock);
+  Mapping m;
+  m.loc = loc;
+  m.size = size;
+  m.addr = addr;
+  m.refs = 1;
+  m.last_used = ++clock;
+  mappings.push_back(m);
+
+  stats.maps++;
+  stats.mapped_bytes += size;
+  stats.map_seconds += t1 - t0;
+  stats.last_map_seconds = t1 - t0;
+  if (populate) {
+    stats.populated_bytes += size;
+    stats.populate_seconds += t2 - t1;
+  }
+  trim();
+  pthread_mutex_unlock(&lock);
+
+  LOG_D_A("Mapped %s (%ld bytes) in %g s, prefaulted in %g s", loc.c_str(), (long) size, t1 - t0, t2 - t1);
+  return addr;
+}
+
+void
+StingerSnapshotMaps::release(void * addr)
+{
+  if (!addr)
+    return;
+
+  pthread_mutex_lock(&lock);
+  for (size_t i = 0; i < mappings.size(); i++) {
+    if (mappings[i].addr == addr) {
+      mappings[i].refs--;
+      break;
+    }
+  }
+  trim();
+  pthread_mutex_unlock(&lock);
+}
+
+/* Unmaps the least recently used idle mappings beyond ring_size */
+void
+StingerSnapshotMaps::trim()
+{
+  while (1) {
+    int64_t idle = 0;
+    int64_t oldest = -1;
+    for (size_t i = 0; i < mappings.size(); i++) {
+      if (mappings[i].refs > 0)
+	continue;
+      idle++;
+      if (oldest < 0 || mappings[i].last_used < mappings[oldest].last_used)
+	oldest = i;
+    }
+    if (idle <= ring_size)
+      return;
+
+    Mapping & m = mappings[oldest];
+    if (munmap(m.addr, m.size))
+      LOG_E_A("Unmapping %s failed: %s", m.loc.c_str(), strerror(errno));
+    stats.mapped_bytes -= m.size;
+    stats.unmaps++;
+    mappings[oldest] = mappings.back();
+    mappings.pop_back();
+  }
+}
+
+void
+StingerSnapshotMaps::set_ring_size(int64_t idle)
+{
+  pthread_mutex_lock(&lock);
+  ring_size = idle;
+  trim();
+  pthread_mutex_unlock(&lock);
+}
+
+snapshot_stats_t
+StingerSnapshotMaps::get_stats()
+{
+  pthread_mutex_lock(&lock);
+  snapshot_stats_t rtn = stats;
+  rtn.mappings = mappings.size();
+  pthread_mutex_unlock(&lock);
+  return rtn;
+}
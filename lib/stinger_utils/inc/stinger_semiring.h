@@ -0,0 +1,93 @@
+#ifndef  STINGER_SEMIRING_H
+#define  STINGER_SEMIRING_H
+
+/*
+ * C++ semiring kernels behind stinger_spmv.h. The semiring is a template
+ * parameter, so add and multiply inline into the edge loops; C code should use
+ * the wrappers in stinger_spmv.h instead.
+ *
+ * A semiring provides zero(), add() and mul(). mul() must return zero() when
+ * either argument is zero().
+ */
+
+#include <limits>
+#include <stdint.h>
+
+#include "stinger_spmv.h"
+
+namespace gt {
+  namespace stinger {
+
+    template <typename T>
+    struct PlusTimes {
+      static T zero() { return T(0); }
+      static T add(T a, T b) { return a + b; }
+      static T mul(T a, T b) { return a * b; }
+    };
+
+    template <typename T>
+    struct MinPlus {
+      static T zero() {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                    : std::numeric_limits<T>::max();
+      }
+      static T add(T a, T b) { return a < b ? a : b; }
+      static T mul(T a, T b) { return (a == zero() || b == zero()) ? zero() : a + b; }
+    };
+
+    template <typename T>
+    struct OrAnd {
+      static T zero() { return T(0); }
+      static T add(T a, T b) { return (a != T(0) || b != T(0)) ? T(1) : T(0); }
+      static T mul(T a, T b) { return (a != T(0) && b != T(0)) ? T(1) : T(0); }
+    };
+
+    template <typename T>
+    struct MaxTimes {
+      static T zero() { return T(0); }
+      static T add(T a, T b) { return a > b ? a : b; }
+      static T mul(T a, T b) { return a * b; }
+    };
+
+    static inline bool
+    row_selected(const uint8_t * mask, int complement, int64_t i) {
+      return !mask || ((mask[i] != 0) != (complement != 0));
+    }
+
+    /* y[i] = (+)_j A(i,j) (*) x[j] over the rows of A */
+    template <class SR, typename T>
+    void
+    csr_spmv(const stinger_csr_t * A, const T * x, T * y, const uint8_t * mask, int complement) {
+      OMP("omp parallel for schedule(dynamic, 256)")
+      for (int64_t i = 0; i < A->nv; i++) {
+        if (!row_selected(mask, complement, i))
+          continue;
+        T acc = SR::zero();
+        for (int64_t k = A->off[i]; k < A->off[i+1]; k++) {
+          acc = SR::add(acc, SR::mul((T)A->val[k], x[A->ind[k]]));
+        }
+        y[i] = acc;
+      }
+    }
+
+    /* The same product read straight from the STINGER out-edges, without a
+     * snapshot; every row starts from init */
+    template <class SR, typename T>
+    void
+    stinger_spmv_direct(stinger_t * S, int64_t nv, const T * x, T * y, T init) {
+      OMP("omp parallel for schedule(dynamic, 256)")
+      for (int64_t i = 0; i < nv; i++) {
+        T acc = init;
+        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, i) {
+          if (STINGER_EDGE_DEST < nv) {
+            acc = SR::add(acc, SR::mul((T)STINGER_EDGE_WEIGHT, x[STINGER_EDGE_DEST]));
+          }
+        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+        y[i] = acc;
+      }
+    }
+
+  }
+}
+
+#endif  /*STINGER_SEMIRING_H*/
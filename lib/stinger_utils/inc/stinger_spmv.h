@@ -0,0 +1,102 @@
+#ifndef  STINGER_SPMV_H
+#define  STINGER_SPMV_H
+
+#ifdef __cplusplus
+#define restrict
+extern "C" {
+#endif
+
+#include "stinger_core/stinger.h"
+
+/*
+ * Sparse matrix-vector products over a semiring on a CSR snapshot of STINGER.
+ *
+ * A(i,j) is the weight of the edge i -> j. A snapshot built from out-edges
+ * has one row per source vertex; a transposed snapshot has one row per
+ * destination, listing its in-edges with the weight of the out-edge record.
+ *
+ *   stinger_csr_spmv    y[i] = (+)_j  A_row(i,j) (*) x[j]   (pull, dense x)
+ *   stinger_csr_spmspv  y[j] = (+)_i  A_row(i,j) (*) x[i]   (push, sparse x)
+ *
+ * so spmv on a transposed snapshot and spmspv on a plain one both compute
+ * A^T x. Semirings, with their zero:
+ *
+ *   PLUS_TIMES  (+, *)      0
+ *   MIN_PLUS    (min, +)    +inf       shortest paths
+ *   OR_AND      (or, and)   0          reachability; values are 0 or 1
+ *   MAX_TIMES   (max, *)    0          most reliable path; values >= 0
+ *
+ * Rows of y that are masked out (mask[i] == 0, or != 0 with mask_complement)
+ * are left untouched; pass a NULL mask to compute every row. The dense
+ * products use AVX2 gathers when the CPU has them, so sums may round
+ * differently from a serial loop.
+ */
+
+typedef enum {
+  STINGER_SEMIRING_PLUS_TIMES,
+  STINGER_SEMIRING_MIN_PLUS,
+  STINGER_SEMIRING_OR_AND,
+  STINGER_SEMIRING_MAX_TIMES
+} stinger_semiring_t;
+
+typedef struct {
+  int64_t   nv;
+  int64_t   ne;
+  int64_t * off;         /* nv + 1 */
+  int64_t * ind;         /* sorted within each row */
+  double  * val;
+  int       transposed;
+} stinger_csr_t;
+
+/* Workspace for stinger_csr_spmspv, reusable across calls */
+typedef struct {
+  int64_t   nv;
+  int       semiring;    /* the zero val holds, or -1 */
+  double  * val;
+  int64_t * flag;
+} stinger_spmspv_ws_t;
+
+double
+stinger_semiring_zero(stinger_semiring_t sr);
+
+/* Snapshot of the edges of type etype (-1 for all) between vertices below nv */
+void
+stinger_csr_from_stinger(stinger_t * S, int64_t nv, int64_t etype, int transposed, stinger_csr_t * A);
+
+void
+stinger_csr_release(stinger_csr_t * A);
+
+void
+stinger_csr_spmv(const stinger_csr_t * A, stinger_semiring_t sr, const double * x, double * y,
+  const uint8_t * mask, int mask_complement);
+
+void
+stinger_spmspv_ws_init(stinger_spmspv_ws_t * ws, int64_t nv);
+
+void
+stinger_spmspv_ws_release(stinger_spmspv_ws_t * ws);
+
+/*
+ * y_idx and y_val need room for every distinct destination (nv at most).
+ * Returns the number of entries of y, in no particular order.
+ */
+int64_t
+stinger_csr_spmspv(const stinger_csr_t * A, stinger_semiring_t sr,
+  int64_t x_nnz, const int64_t * x_idx, const double * x_val,
+  int64_t * y_idx, double * y_val,
+  const uint8_t * mask, int mask_complement, stinger_spmspv_ws_t * ws);
+
+/*
+ * The same pull product on integers, read straight from the out-edges of S
+ * without a snapshot. Every row starts from init rather than the semiring
+ * zero, which is what stinger_matvec expects.
+ */
+void
+stinger_spmv_i64(stinger_t * S, int64_t nv, stinger_semiring_t sr, const int64_t * x, int64_t * y, int64_t init);
+
+#ifdef __cplusplus
+}
+#undef restrict
+#endif
+
+#endif  /*STINGER_SPMV_H*/
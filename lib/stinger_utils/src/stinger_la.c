@@ -1,4 +1,5 @@
 #include "stinger_la.h"
+#include "stinger_spmv.h"
 
 eweight_t
 stinger_add(eweight_t a, eweight_t b)
@@ -41,10 +42,25 @@ stinger_matvec(stinger_t * S, eweight_t * vec_in, int64_t nv, eweight_t * vec_ou
   eweight_t (*multiply)(eweight_t, eweight_t), eweight_t (*reduce)(eweight_t, eweight_t), 
   eweight_t empty)
 {
+  /* the usual semirings go to the inlined kernels */
+  int sr = -1;
+  if (multiply == stinger_mult && reduce == stinger_add)
+    sr = STINGER_SEMIRING_PLUS_TIMES;
+  else if (multiply == stinger_add && reduce == stinger_min)
+    sr = STINGER_SEMIRING_MIN_PLUS;
+  else if (multiply == stinger_and && reduce == stinger_or)
+    sr = STINGER_SEMIRING_OR_AND;
+  else if (multiply == stinger_mult && reduce == stinger_max)
+    sr = STINGER_SEMIRING_MAX_TIMES;
+
+  if (sr >= 0) {
+    stinger_spmv_i64(S, nv, (stinger_semiring_t)sr, vec_in, vec_out, empty);
+    return 0;
+  }
+
   OMP("omp parallel for")
   for(int64_t v = 0; v < nv; v++) {
     eweight_t out = empty;
-    eweight_t cur = empty;
     STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
       if(STINGER_EDGE_DEST < nv) {
         out = reduce(multiply(STINGER_EDGE_WEIGHT, vec_in[STINGER_EDGE_DEST]), out);
@@ -52,5 +68,6 @@ stinger_matvec(stinger_t * S, eweight_t * vec_in, int64_t nv, eweight_t * vec_ou
     } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
     vec_out[v] = out;
   }
+  return 0;
 }
 
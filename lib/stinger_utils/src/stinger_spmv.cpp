@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "stinger_core/stinger_atomics.h"
+#include "stinger_core/xmalloc.h"
+}
+#include "stinger_semiring.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STINGER_SPMV_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace gt::stinger;
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * CSR snapshot
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+static void
+csr_sort_rows(stinger_csr_t * A) {
+  OMP("omp parallel")
+  {
+    std::vector<std::pair<int64_t, double> > row;
+    OMP("omp for schedule(dynamic, 256)")
+    for (int64_t i = 0; i < A->nv; i++) {
+      int64_t begin = A->off[i], end = A->off[i+1];
+      row.clear();
+      for (int64_t k = begin; k < end; k++) {
+        row.push_back(std::make_pair(A->ind[k], A->val[k]));
+      }
+      std::sort(row.begin(), row.end());
+      for (int64_t k = begin; k < end; k++) {
+        A->ind[k] = row[k - begin].first;
+        A->val[k] = row[k - begin].second;
+      }
+    }
+  }
+}
+
+#define CSR_FORALL_EDGES_BEGIN(S, etype, i)                        \
+  if ((etype) < 0) {                                               \
+    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, i) {                  \
+      if (STINGER_EDGE_DEST >= 0 && STINGER_EDGE_DEST < nv) {
+
+#define CSR_FORALL_EDGES_MIDDLE(S, etype, i)                       \
+      }                                                            \
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();                       \
+  } else {                                                         \
+    STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_BEGIN(S, etype, i) {   \
+      if (STINGER_EDGE_DEST >= 0 && STINGER_EDGE_DEST < nv) {
+
+#define CSR_FORALL_EDGES_END()                                     \
+      }                                                            \
+    } STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_END();               \
+  }
+
+void
+stinger_csr_from_stinger(stinger_t * S, int64_t nv, int64_t etype, int transposed, stinger_csr_t * A) {
+  A->nv = nv;
+  A->transposed = transposed;
+  A->off = (int64_t *)xcalloc(nv + 1, sizeof(int64_t));
+
+  /* count, then fill through a per-row cursor; a transposed row is filled by
+   * the sources of its in-edges, so the cursors are shared */
+  int64_t * count = A->off + 1;
+  OMP("omp parallel for schedule(dynamic, 256)")
+  for (int64_t i = 0; i < nv; i++) {
+    CSR_FORALL_EDGES_BEGIN(S, etype, i)
+      if (transposed) stinger_int64_fetch_add(&count[STINGER_EDGE_DEST], 1); else count[i]++;
+    CSR_FORALL_EDGES_MIDDLE(S, etype, i)
+      if (transposed) stinger_int64_fetch_add(&count[STINGER_EDGE_DEST], 1); else count[i]++;
+    CSR_FORALL_EDGES_END()
+  }
+
+  for (int64_t i = 0; i < nv; i++) {
+    A->off[i+1] += A->off[i];
+  }
+  A->ne = A->off[nv];
+  A->ind = (int64_t *)xmalloc((A->ne + 1) * sizeof(int64_t));
+  A->val = (double *)xmalloc((A->ne + 1) * sizeof(double));
+
+  int64_t * cursor = (int64_t *)xmalloc((nv + 1) * sizeof(int64_t));
+  memcpy(cursor, A->off, (nv + 1) * sizeof(int64_t));
+
+  /* edges that arrived after counting are dropped rather than overrun a row */
+  OMP("omp parallel for schedule(dynamic, 256)")
+  for (int64_t i = 0; i < nv; i++) {
+    CSR_FORALL_EDGES_BEGIN(S, etype, i)
+      int64_t r = transposed ? STINGER_EDGE_DEST : i;
+      int64_t c = transposed ? i : STINGER_EDGE_DEST;
+      int64_t k = stinger_int64_fetch_add(&cursor[r], 1);
+      if (k < A->off[r+1]) { A->ind[k] = c; A->val[k] = (double)STINGER_EDGE_WEIGHT; }
+    CSR_FORALL_EDGES_MIDDLE(S, etype, i)
+      int64_t r = transposed ? STINGER_EDGE_DEST : i;
+      int64_t c = transposed ? i : STINGER_EDGE_DEST;
+      int64_t k = stinger_int64_fetch_add(&cursor[r], 1);
+      if (k < A->off[r+1]) { A->ind[k] = c; A->val[k] = (double)STINGER_EDGE_WEIGHT; }
+    CSR_FORALL_EDGES_END()
+  }
+
+  /* and rows that lost edges meanwhile are closed up */
+  int64_t ne = 0;
+  for (int64_t r = 0; r < nv; r++) {
+    int64_t begin = A->off[r];
+    int64_t end = cursor[r] < A->off[r+1] ? cursor[r] : A->off[r+1];
+    A->off[r] = ne;
+    if (begin != ne) {
+      memmove(A->ind + ne, A->ind + begin, (end - begin) * sizeof(int64_t));
+      memmove(A->val + ne, A->val + begin, (end - begin) * sizeof(double));
+    }
+    ne += end - begin;
+  }
+  A->off[nv] = ne;
+  A->ne = ne;
+  xfree(cursor);
+
+  csr_sort_rows(A);
+}
+
+void
+stinger_csr_release(stinger_csr_t * A) {
+  if (A->off) {
+    xfree(A->off);
+    xfree(A->ind);
+    xfree(A->val);
+  }
+  memset(A, 0, sizeof(stinger_csr_t));
+}
+
+double
+stinger_semiring_zero(stinger_semiring_t sr) {
+  switch (sr) {
+    case STINGER_SEMIRING_MIN_PLUS:
+      return MinPlus<double>::zero();
+    default:
+      return 0.0;
+  }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Dense products
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#if defined(STINGER_SPMV_AVX2)
+
+/* four lanes of a semiring; OR_AND has no vector form and stays scalar */
+struct PlusTimesAVX2 {
+  typedef PlusTimes<double> scalar;
+  static __attribute__((target("avx2"))) __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+  static __attribute__((target("avx2"))) __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+};
+
+struct MinPlusAVX2 {
+  typedef MinPlus<double> scalar;
+  static __attribute__((target("avx2"))) __m256d add(__m256d a, __m256d b) { return _mm256_min_pd(a, b); }
+  static __attribute__((target("avx2"))) __m256d mul(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+};
+
+struct MaxTimesAVX2 {
+  typedef MaxTimes<double> scalar;
+  static __attribute__((target("avx2"))) __m256d add(__m256d a, __m256d b) { return _mm256_max_pd(a, b); }
+  static __attribute__((target("avx2"))) __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+};
+
+/* Rows four edges at a time: gather x by column index, then a scalar tail */
+template <class V>
+__attribute__((target("avx2"))) static void
+csr_spmv_avx2(const stinger_csr_t * A, const double * x, double * y, const uint8_t * mask, int complement) {
+  typedef typename V::scalar SR;
+  OMP("omp parallel for schedule(dynamic, 256)")
+  for (int64_t i = 0; i < A->nv; i++) {
+    if (!row_selected(mask, complement, i))
+      continue;
+    int64_t k = A->off[i];
+    int64_t end = A->off[i+1];
+    double acc = SR::zero();
+    if (end - k >= 4) {
+      __m256d vacc = _mm256_set1_pd(SR::zero());
+      for (; k + 4 <= end; k += 4) {
+        __m256i idx = _mm256_loadu_si256((const __m256i *)(A->ind + k));
+        __m256d xv = _mm256_i64gather_pd(x, idx, 8);
+        __m256d av = _mm256_loadu_pd(A->val + k);
+        vacc = V::add(vacc, V::mul(av, xv));
+      }
+      double lanes[4];
+      _mm256_storeu_pd(lanes, vacc);
+      acc = SR::add(SR::add(lanes[0], lanes[1]), SR::add(lanes[2], lanes[3]));
+    }
+    for (; k < end; k++) {
+      acc = SR::add(acc, SR::mul(A->val[k], x[A->ind[k]]));
+    }
+    y[i] = acc;
+  }
+}
+
+static bool
+have_avx2() {
+  static int cached = -1;
+  if (cached < 0)
+    cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+  return cached == 1;
+}
+
+#endif
+
+void
+stinger_csr_spmv(const stinger_csr_t * A, stinger_semiring_t sr, const double * x, double * y,
+  const uint8_t * mask, int mask_complement) {
+#if defined(STINGER_SPMV_AVX2)
+  if (have_avx2()) {
+    switch (sr) {
+      case STINGER_SEMIRING_PLUS_TIMES: csr_spmv_avx2<PlusTimesAVX2>(A, x, y, mask, mask_complement); return;
+      case STINGER_SEMIRING_MIN_PLUS:   csr_spmv_avx2<MinPlusAVX2>(A, x, y, mask, mask_complement); return;
+      case STINGER_SEMIRING_MAX_TIMES:  csr_spmv_avx2<MaxTimesAVX2>(A, x, y, mask, mask_complement); return;
+      default: break;
+    }
+  }
+#endif
+  switch (sr) {
+    case STINGER_SEMIRING_PLUS_TIMES: csr_spmv<PlusTimes<double> >(A, x, y, mask, mask_complement); break;
+    case STINGER_SEMIRING_MIN_PLUS:   csr_spmv<MinPlus<double> >(A, x, y, mask, mask_complement); break;
+    case STINGER_SEMIRING_OR_AND:     csr_spmv<OrAnd<double> >(A, x, y, mask, mask_complement); break;
+    case STINGER_SEMIRING_MAX_TIMES:  csr_spmv<MaxTimes<double> >(A, x, y, mask, mask_complement); break;
+  }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Sparse products
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+void
+stinger_spmspv_ws_init(stinger_spmspv_ws_t * ws, int64_t nv) {
+  ws->nv = nv;
+  ws->semiring = -1;
+  ws->val = (double *)xmalloc(nv * sizeof(double));
+  ws->flag = (int64_t *)xcalloc(nv, sizeof(int64_t));
+}
+
+void
+stinger_spmspv_ws_release(stinger_spmspv_ws_t * ws) {
+  if (ws->val) {
+    xfree(ws->val);
+    xfree(ws->flag);
+  }
+  memset(ws, 0, sizeof(stinger_spmspv_ws_t));
+}
+
+/* *p = add(*p, v) for doubles, by compare-and-swap on the bit pattern */
+template <class SR>
+static inline void
+atomic_reduce(double * p, double v) {
+  int64_t * ip = (int64_t *)p;
+  int64_t old_bits = *ip;
+  while (1) {
+    double old_val, new_val;
+    memcpy(&old_val, &old_bits, sizeof(double));
+    new_val = SR::add(old_val, v);
+    if (new_val == old_val)
+      return;
+    int64_t new_bits;
+    memcpy(&new_bits, &new_val, sizeof(double));
+    int64_t seen = stinger_int64_cas(ip, old_bits, new_bits);
+    if (seen == old_bits)
+      return;
+    old_bits = seen;
+  }
+}
+
+/*
+ * Pushes every x[i] along row i into the workspace, which holds the zero of
+ * the semiring between calls, and lists each destination the first time it
+ * is reached. The workspace is reset through that list on the way out.
+ */
+template <class SR>
+static int64_t
+csr_spmspv(const stinger_csr_t * A, int64_t x_nnz, const int64_t * x_idx, const double * x_val,
+  int64_t * y_idx, double * y_val, const uint8_t * mask, int complement, stinger_spmspv_ws_t * ws) {
+  int64_t y_nnz = 0;
+
+  OMP("omp parallel for schedule(dynamic, 64)")
+  for (int64_t t = 0; t < x_nnz; t++) {
+    int64_t i = x_idx[t];
+    double xi = x_val[t];
+    if (i < 0 || i >= A->nv || xi == SR::zero())
+      continue;
+    for (int64_t k = A->off[i]; k < A->off[i+1]; k++) {
+      int64_t j = A->ind[k];
+      if (!row_selected(mask, complement, j))
+        continue;
+      atomic_reduce<SR>(&ws->val[j], SR::mul(A->val[k], xi));
+      if (ws->flag[j] == 0 && stinger_int64_cas(&ws->flag[j], 0, 1) == 0) {
+        y_idx[stinger_int64_fetch_add(&y_nnz, 1)] = j;
+      }
+    }
+  }
+
+  OMP("omp parallel for")
+  for (int64_t t = 0; t < y_nnz; t++) {
+    int64_t j = y_idx[t];
+    y_val[t] = ws->val[j];
+    ws->val[j] = SR::zero();
+    ws->flag[j] = 0;
+  }
+
+  return y_nnz;
+}
+
+int64_t
+stinger_csr_spmspv(const stinger_csr_t * A, stinger_semiring_t sr,
+  int64_t x_nnz, const int64_t * x_idx, const double * x_val,
+  int64_t * y_idx, double * y_val,
+  const uint8_t * mask, int mask_complement, stinger_spmspv_ws_t * ws) {
+  if (ws->semiring != (int)sr) {
+    double zero = stinger_semiring_zero(sr);
+    OMP("omp parallel for")
+    for (int64_t j = 0; j < ws->nv; j++) {
+      ws->val[j] = zero;
+    }
+    ws->semiring = sr;
+  }
+
+  switch (sr) {
+    case STINGER_SEMIRING_PLUS_TIMES:
+      return csr_spmspv<PlusTimes<double> >(A, x_nnz, x_idx, x_val, y_idx, y_val, mask, mask_complement, ws);
+    case STINGER_SEMIRING_MIN_PLUS:
+      return csr_spmspv<MinPlus<double> >(A, x_nnz, x_idx, x_val, y_idx, y_val, mask, mask_complement, ws);
+    case STINGER_SEMIRING_OR_AND:
+      return csr_spmspv<OrAnd<double> >(A, x_nnz, x_idx, x_val, y_idx, y_val, mask, mask_complement, ws);
+    case STINGER_SEMIRING_MAX_TIMES:
+      return csr_spmspv<MaxTimes<double> >(A, x_nnz, x_idx, x_val, y_idx, y_val, mask, mask_complement, ws);
+  }
+  return 0;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+ * Integer products straight from STINGER
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+void
+stinger_spmv_i64(stinger_t * S, int64_t nv, stinger_semiring_t sr, const int64_t * x, int64_t * y, int64_t init) {
+  switch (sr) {
+    case STINGER_SEMIRING_PLUS_TIMES: stinger_spmv_direct<PlusTimes<int64_t> >(S, nv, x, y, init); break;
+    case STINGER_SEMIRING_MIN_PLUS:   stinger_spmv_direct<MinPlus<int64_t> >(S, nv, x, y, init); break;
+    case STINGER_SEMIRING_OR_AND:     stinger_spmv_direct<OrAnd<int64_t> >(S, nv, x, y, init); break;
+    case STINGER_SEMIRING_MAX_TIMES:  stinger_spmv_direct<MaxTimes<int64_t> >(S, nv, x, y, init); break;
+  }
+}
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <signal.h>
 
 #include "stinger_core/stinger.h"
 #include "stinger_core/stinger_atomics.h"
@@ -8,6 +9,16 @@
 #include "stinger_core/stinger_error.h"
 #include "stinger_net/stinger_alg.h"
 #include "stinger_alg/betweenness.h"
+#include "stinger_alg/streaming_betweenness.h"
+
+/* toggled by SIGUSR1 to switch between full and incremental mode */
+static volatile sig_atomic_t toggle_mode = 0;
+
+static void
+handle_toggle(int sig)
+{
+    toggle_mode = 1;
+}
 
 int
 main(int argc, char *argv[])
@@ -18,10 +29,12 @@ main(int argc, char *argv[])
     int64_t num_samples = 256;
     double weighting = 0.5;
     uint8_t do_weighted = 1;
+    uint8_t do_incremental = 0;
+    uint64_t seed = 1;
     char * alg_name = "betweenness_centrality";
 
     int opt = 0;
-    while(-1 != (opt = getopt(argc, argv, "w:s:n:x?h"))) {
+    while(-1 != (opt = getopt(argc, argv, "w:s:n:r:xi?h"))) {
         switch(opt) {
             case 'w': {
                 weighting = atof(optarg);
@@ -47,6 +60,14 @@ main(int argc, char *argv[])
                 do_weighted = 0;
             } break;
 
+            case 'i': {
+                do_incremental = 1;
+            } break;
+
+            case 'r': {
+                seed = strtoull(optarg, NULL, 10);
+            } break;
+
             default:
                 printf("Unknown option '%c'\n", opt);
             case '?':
@@ -60,11 +81,18 @@ main(int argc, char *argv[])
                     "aggregated and potentially weighted with the result from\n"
                     "the last pass\n"
                     "\n"
+                    "In incremental mode the sample set is fixed and the traversal from each sample\n"
+                    "is kept between batches. Only samples whose shortest-path DAG is touched by a\n"
+                    "batch are traversed again, and no weighting is applied. Sending SIGUSR1 to the\n"
+                    "running client switches between full and incremental mode.\n"
+                    "\n"
                     "  -s <num>  Set the number of samples (%ld by default)\n"
                     "  -w <num>  Set the weighintg (0.0 - 1.0) (%lf by default)\n"
                     "  -x        Disable weighting\n"
+                    "  -i        Start in incremental mode\n"
+                    "  -r <num>  Seed for the incremental sample set (%lu by default)\n"
                     "  -n <str>  Set the algorithm name (%s by default)\n"
-                    "\n", num_samples, weighting, alg_name
+                    "\n", num_samples, weighting, (unsigned long)seed, alg_name
                 );
                 return(opt);
             }
@@ -99,12 +127,22 @@ main(int argc, char *argv[])
         sample_bc = xcalloc(sizeof(double), alg->stinger->max_nv);
     }
 
+    stinger_bc_internal bc_internal;
+    stinger_bc_stats stats;
+    memset(&bc_internal, 0, sizeof(stinger_bc_internal));
+
+    signal(SIGUSR1, handle_toggle);
+
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
     * Initial static computation
     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     stinger_alg_begin_init(alg); {
-        if (stinger_max_active_vertex(alg->stinger) > 0)
-            sample_search(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, num_samples, bc, times_found);
+        int64_t nv = (stinger_max_active_vertex(alg->stinger) > 0) ? stinger_max_active_vertex(alg->stinger) + 1 : 0;
+        if(do_incremental) {
+            stinger_bc_initialize_internals(alg->stinger, nv, &bc_internal, num_samples, seed, bc, times_found);
+        } else if (nv > 0) {
+            sample_search(alg->stinger, nv, num_samples, bc, times_found);
+        }
     } stinger_alg_end_init(alg);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -120,7 +158,29 @@ main(int argc, char *argv[])
         /* Post processing */
         if(stinger_alg_begin_post(alg)) {
             int64_t nv = (stinger_mapping_nv(alg->stinger))?stinger_mapping_nv(alg->stinger)+1:0;
-            if (nv > 0) {
+
+            if(toggle_mode) {
+                toggle_mode = 0;
+                do_incremental = !do_incremental;
+                if(do_incremental) {
+                    LOG_I("Switching to incremental mode");
+                    stinger_bc_initialize_internals(alg->stinger, nv, &bc_internal, num_samples, seed, bc, times_found);
+                    stinger_alg_end_post(alg);
+                    continue;
+                } else {
+                    LOG_I("Switching to full mode");
+                    stinger_bc_release_internals(&bc_internal);
+                }
+            }
+
+            if (do_incremental) {
+                stinger_bc_reset_stats(&stats);
+                stinger_bc_update(alg->stinger, nv, &bc_internal, &stats,
+                    alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions,
+                    bc, times_found);
+                LOG_V_A("Incremental BC: %ld sources recomputed, %ld skipped, %ld added",
+                    (long)stats.sources_recomputed, (long)stats.sources_skipped, (long)stats.sources_added);
+            } else if (nv > 0) {
                 if(do_weighted) {
                     sample_search(alg->stinger, nv, num_samples, sample_bc, times_found);
 
@@ -142,5 +202,6 @@ main(int argc, char *argv[])
     if(do_weighted) {
         free(sample_bc);
     }
+    stinger_bc_release_internals(&bc_internal);
     xfree(alg);
 }
@@ -6,7 +6,7 @@
 #include "stinger_core/stinger_error.h"
 #include "stinger_net/stinger_alg.h"
 #include "stinger_utils/timer.h"
-#include "stinger_alg/clustering.h"
+#include "stinger_alg/triangle_counting.h"
 
 
 int
@@ -36,7 +36,9 @@ main(int argc, char *argv[])
   double * local_cc = (double *)alg->alg_data;
   int64_t * ntri = (int64_t *)(((double *)alg->alg_data) + alg->stinger->max_nv);
 
-  int64_t * affected = xcalloc (alg->stinger->max_nv, sizeof (int64_t));
+  stinger_triangle_internal tri_internal;
+  stinger_triangle_stats stats;
+  stinger_triangle_reset_stats(&stats);
 
   init_timer();
   double time;
@@ -47,14 +49,7 @@ main(int argc, char *argv[])
   stinger_alg_begin_init(alg); {
     LOG_I("Clustering coefficients init starting");
     tic();
-    count_all_triangles (alg->stinger, ntri);
-
-    OMP("omp parallel for")
-    for(uint64_t v = 0; v < alg->stinger->max_nv; v++) {
-      int64_t deg = stinger_outdegree_get(alg->stinger, v);
-      int64_t d = deg * (deg-1);
-      local_cc[v] = (d ? ntri[v] / (double) d : 0.0);
-    }
+    stinger_triangle_initialize_internals(alg->stinger, alg->stinger->max_nv, &tri_internal, ntri, local_cc);
     time = toc();
     LOG_I("Clustering coefficients init end");
     LOG_I_A("Time: %f sec", time);
@@ -68,51 +63,13 @@ main(int argc, char *argv[])
     if(stinger_alg_begin_pre(alg)) {
       tic();
 
-      OMP("omp parallel for")
-      for (uint64_t v = 0; v < alg->stinger->max_nv; v++) {
-        affected[v] = 0;
-      }
-
-      /* each vertex incident on an insertion is affected */
-      OMP("omp parallel for")
-      for (uint64_t i = 0; i < alg->num_insertions; i++) {
-        int64_t src = alg->insertions[i].source;
-        int64_t dst = alg->insertions[i].destination;
-        stinger_int64_fetch_add (&affected[src], 1);
-        stinger_int64_fetch_add (&affected[dst], 1);
-
-        /* and all neighbors */
-        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(alg->stinger, src) {
-          stinger_int64_fetch_add (&affected[STINGER_EDGE_DEST], 1);
-        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-
-        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(alg->stinger, dst) {
-          stinger_int64_fetch_add (&affected[STINGER_EDGE_DEST], 1);
-        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-      }
-
-      /* each vertex incident on a deletion is affected */
-      OMP("omp parallel for")
-      for (uint64_t i = 0; i < alg->num_deletions; i++) {
-        int64_t src = alg->deletions[i].source;
-        int64_t dst = alg->deletions[i].destination;
-        stinger_int64_fetch_add (&affected[src], 1);
-        stinger_int64_fetch_add (&affected[dst], 1);
-
-        /* and all neighbors */
-        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(alg->stinger, src) {
-          stinger_int64_fetch_add (&affected[STINGER_EDGE_DEST], 1);
-        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-
-        STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(alg->stinger, dst) {
-          stinger_int64_fetch_add (&affected[STINGER_EDGE_DEST], 1);
-        } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-      }
+      /* remember which touched pairs are adjacent before the batch lands */
+      stinger_triangle_prepare(alg->stinger, &tri_internal,
+        alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions);
 
       time = toc();
       LOG_I_A("Time: %f", time);
 
-      /* nothing to do */
       stinger_alg_end_pre(alg);
     }
 
@@ -120,19 +77,14 @@ main(int argc, char *argv[])
     if(stinger_alg_begin_post(alg)) {
       tic();
 
-      OMP("omp parallel for")
-      for (uint64_t v = 0; v < alg->stinger->max_nv; v++) {
-        if (affected[v]) {
-          ntri[v] = count_triangles (alg->stinger, v);
-
-          int64_t deg = stinger_outdegree_get(alg->stinger, v);
-          int64_t d = deg * (deg-1);
-          local_cc[v] = (d ? ntri[v] / (double) d : 0.0);
-        }
-      }
+      int64_t recounted = stinger_triangle_update(alg->stinger, &tri_internal, &stats,
+        alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions,
+        ntri, local_cc);
 
       time = toc();
-      LOG_I_A("Time: %f", time);
+      LOG_I_A("Time: %f, %ld vertices recounted", time, (long)recounted);
+      LOG_V_A("Triangle stats: %ld pairs changed, %ld recounted, %ld neighbor updates",
+        (long)stats.pairs_changed, (long)stats.vertices_recounted, (long)stats.neighbor_updates);
 
       /* done */
       stinger_alg_end_post(alg);
@@ -140,6 +92,6 @@ main(int argc, char *argv[])
   }
 
   LOG_I("Algorithm complete... shutting down");
-  xfree(affected);
+  stinger_triangle_release_internals(&tri_internal);
   xfree(alg);
 }
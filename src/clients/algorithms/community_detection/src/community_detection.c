@@ -10,7 +10,7 @@
 #include "stinger_core/stinger_error.h"
 #include "stinger_net/stinger_alg.h"
 #include "stinger_utils/timer.h"
-#include "stinger_alg/modularity.h"
+#include "stinger_alg/louvain.h"
 
 int
 main(int argc, char *argv[])
@@ -19,10 +19,11 @@ main(int argc, char *argv[])
     * Options and arg parsing
     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     int64_t max_iter = 5;
+    int64_t max_levels = LOUVAIN_DEFAULT_LEVELS;
     char * alg_name = "community_detection";
 
     int opt = 0;
-    while(-1 != (opt = getopt(argc, argv, "i:n:x?h"))) {
+    while(-1 != (opt = getopt(argc, argv, "i:l:n:x?h"))) {
         switch(opt) {
             case 'i': {
                 max_iter = atol(optarg);
@@ -31,6 +32,13 @@ main(int argc, char *argv[])
                 }
             } break;
 
+            case 'l': {
+                max_levels = atol(optarg);
+                if(max_levels < 1) {
+                    max_levels = LOUVAIN_DEFAULT_LEVELS;
+                }
+            } break;
+
             case 'n': {
                 alg_name = optarg;
             } break;
@@ -43,11 +51,13 @@ main(int argc, char *argv[])
                         "Louvain Community detection\n"
                                 "==================================\n"
                                 "\n"
-                                "This approach returns the first level of Louvain's Community detection\n"
+                                "Multi-level Louvain community detection. Each batch warm starts from the\n"
+                                "previous partition and re-optimizes the vertices it touched.\n"
                                 "\n"
-                                "  -i <num>  Set the max number of iterations (%ld by default)\n"
+                                "  -i <num>  Set the max number of iterations per level (%ld by default)\n"
+                                "  -l <num>  Set the max number of levels (%ld by default)\n"
                                 "  -n <str>  Set the algorithm name (%s by default)\n"
-                                "\n", max_iter,alg_name
+                                "\n", max_iter, max_levels, alg_name
                 );
                 return(opt);
             }
@@ -72,14 +82,19 @@ main(int argc, char *argv[])
     }
 
     int64_t * partitions = (int64_t *)alg->alg_data;
+    int64_t nv = 0;
+    stinger_louvain_stats stats;
+    stinger_louvain_reset_stats(&stats);
 
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
     * Initial static computation
     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     stinger_alg_begin_init(alg); {
-        if (stinger_max_active_vertex(alg->stinger) > 0)
-            community_detection(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, partitions, max_iter);
+        if (stinger_max_active_vertex(alg->stinger) > 0) {
+            nv = stinger_max_active_vertex(alg->stinger) + 1;
+            louvain_communities(alg->stinger, nv, partitions, max_levels, max_iter, &stats);
+        }
     } stinger_alg_end_init(alg);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -94,9 +109,17 @@ main(int argc, char *argv[])
 
         /* Post processing */
         if(stinger_alg_begin_post(alg)) {
-            int64_t nv = (stinger_mapping_nv(alg->stinger))?stinger_mapping_nv(alg->stinger)+1:0;
+            int64_t old_nv = nv;
+            int64_t new_nv = (stinger_mapping_nv(alg->stinger))?stinger_mapping_nv(alg->stinger)+1:0;
+            if (new_nv > nv) nv = new_nv;
+            if (stinger_max_active_vertex(alg->stinger) + 1 > nv)
+                nv = stinger_max_active_vertex(alg->stinger) + 1;
             if (nv > 0) {
-                community_detection(alg->stinger, nv, partitions, max_iter);
+                louvain_communities_update(alg->stinger, old_nv, nv, partitions,
+                    alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions,
+                    max_levels, max_iter, &stats);
+                LOG_V_A("Louvain: %ld communities, modularity %f, %ld vertices examined",
+                    (long)stats.communities, stats.modularity, (long)stats.vertices_examined);
             }
 
             stinger_alg_end_post(alg);
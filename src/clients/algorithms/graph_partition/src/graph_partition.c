@@ -3,6 +3,9 @@
 //
 
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
@@ -15,30 +18,31 @@
 int
 main(int argc, char *argv[]) {
 
-    char name[1024];
-    char type_str[1024];
-
-    stinger_registered_alg * alg =
-    stinger_register_alg(
-            .name="graphpartition",
-    .data_per_vertex=sizeof(int64_t) + sizeof(int64_t),
-    .data_description="ll partitions partition_sizes",
-    .host="localhost",
-    );
-
-    double num_vertices = stinger_max_active_vertex(alg->stinger) + 1;
-    int num_partitons = 2;
-    double partition_capacity = (double)num_vertices/(double)num_partitons;
+    int64_t num_partitons = 2;
+    double partition_capacity = 0;
+    int64_t method = GRAPH_PARTITION_LDG;
+    int64_t restream_passes = 0;
 
     int opt = 0;
-    while(-1 != (opt = getopt(argc, argv, "p:c:h"))) {
+    while(-1 != (opt = getopt(argc, argv, "p:c:m:r:h"))) {
         switch(opt) {
             case 'p': {
-                num_partitons = atof(optarg);
+                num_partitons = atol(optarg);
+                if (num_partitons < 1)
+                    num_partitons = 2;
             } break;
             case 'c': {
                 partition_capacity = atof(optarg);
             } break;
+            case 'm': {
+                if (!strcmp(optarg, "fennel"))
+                    method = GRAPH_PARTITION_FENNEL;
+                else
+                    method = GRAPH_PARTITION_LDG;
+            } break;
+            case 'r': {
+                restream_passes = atol(optarg);
+            } break;
             default:
                 printf("Unknown option '%c'\n", opt);
             case '?':
@@ -47,31 +51,56 @@ main(int argc, char *argv[]) {
                         "GraphPartition\n"
                                 "==================================\n"
                                 "This algorithm partitions the verticies in the STINGER graph into a specified number of\n"
-                                "partitions using a linear greedy heuristic and limits the partition sizes based on the \n"
-                                "capacity constraint\n"
+                                "partitions with a streaming heuristic (LDG or Fennel). Vertices are placed as they\n"
+                                "first appear in a batch and can be moved by parallel restreaming passes.\n"
                                 "\n"
-                                "  -p        Set number of partitions (default: %ld)\n"
-                                "  -c        Set partition capacity (default: %0.1e)\n"
-                                "\n",num_partitons,partition_capacity);
+                                "  -p <num>  Set number of partitions (default: %ld)\n"
+                                "  -c <num>  Set LDG partition capacity (default: %0.1f of the assigned vertices per partition)\n"
+                                "  -m <str>  Heuristic, ldg or fennel (default: ldg)\n"
+                                "  -r <num>  Restreaming passes after each batch (default: %ld)\n"
+                                "\n", (long)num_partitons, GRAPH_PARTITION_SLACK_DEFAULT, (long)restream_passes);
                 return(opt);
             }
         }
     }
 
+    stinger_registered_alg * alg =
+    stinger_register_alg(
+            .name="graphpartition",
+    .data_per_vertex=3 * sizeof(int64_t),
+    .data_description="lll partitions partition_sizes partition_cut",
+    .host="localhost",
+    );
+
     if(!alg) {
         LOG_E("Registering algorithm failed.  Exiting");
         return -1;
     }
 
+    if (num_partitons >= alg->stinger->max_nv) {
+        LOG_E_A("Too many partitions (%ld) for %ld vertices", (long)num_partitons, (long)alg->stinger->max_nv);
+        return -1;
+    }
+
     int64_t * partitions = (int64_t*)alg->alg_data;
     int64_t * partition_sizes = (int64_t *)(partitions + alg->stinger->max_nv);
+    int64_t * partition_cut = (int64_t *)(partition_sizes + alg->stinger->max_nv);
+
+    stinger_partition_internal part_internal;
+    stinger_partition_stats stats;
+    stinger_partition_reset_stats(&stats);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
      * Initial static computation
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     stinger_alg_begin_init(alg); {
-        if (stinger_max_active_vertex(alg->stinger) > 0)
-            graph_partition(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, num_partitons, partition_capacity, partitions, partition_sizes);
+        stinger_partition_initialize_internals(alg->stinger, alg->stinger->max_nv, &part_internal,
+            num_partitons, method, partition_capacity, partitions, partition_sizes, partition_cut, &stats);
+        if (restream_passes > 0)
+            stinger_partition_restream(alg->stinger, &part_internal, &stats, restream_passes,
+                partitions, partition_sizes, partition_cut);
+        LOG_I_A("Graph partition init: %ld vertices assigned, cut %ld",
+            (long)stats.vertices_assigned, (long)partition_cut[0]);
     } stinger_alg_end_init(alg);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -86,13 +115,21 @@ main(int argc, char *argv[]) {
 
         /* Post processing */
         if(stinger_alg_begin_post(alg)) {
-            int64_t nv = (stinger_mapping_nv(alg->stinger))?stinger_mapping_nv(alg->stinger)+1:0;
-            if (nv > 0) {
-                graph_partition(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, num_partitons, partition_capacity, partitions, partition_sizes);
-            }
+            int64_t assigned = stinger_partition_update(alg->stinger, &part_internal, &stats,
+                alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions,
+                partitions, partition_sizes, partition_cut);
+            int64_t moved = 0;
+            if (restream_passes > 0)
+                moved = stinger_partition_restream(alg->stinger, &part_internal, &stats, restream_passes,
+                    partitions, partition_sizes, partition_cut);
+            LOG_V_A("Graph partition: %ld assigned, %ld moved, cut %ld",
+                (long)assigned, (long)moved, (long)partition_cut[0]);
 
             stinger_alg_end_post(alg);
         }
     }
 
-}
\ No newline at end of file
+    LOG_I("Algorithm complete... shutting down");
+    stinger_partition_release_internals(&part_internal);
+    xfree(alg);
+}
@@ -19,20 +19,33 @@ main(int argc, char *argv[])
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
     * Options and arg parsing
     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
-    int64_t num_iter = 10;
+    int64_t num_iter = HITS_MAXITER_DEFAULT;
+    double epsilon = HITS_EPSILON_DEFAULT;
+    int64_t type = -1;
     char * alg_name = "hits_centrality";
 
     int opt = 0;
-    while(-1 != (opt = getopt(argc, argv, "k:n:?h"))) {
+    while(-1 != (opt = getopt(argc, argv, "k:e:t:n:?h"))) {
         switch(opt) {
 
             case 'k': {
                 num_iter = atol(optarg);
                 if(num_iter < 1) {
-                    num_iter = 10;
+                    num_iter = HITS_MAXITER_DEFAULT;
                 }
             } break;
 
+            case 'e': {
+                epsilon = atof(optarg);
+                if(epsilon < 0) {
+                    epsilon = HITS_EPSILON_DEFAULT;
+                }
+            } break;
+
+            case 't': {
+                type = atol(optarg);
+            } break;
+
             case 'n': {
                 alg_name = optarg;
             } break;
@@ -50,9 +63,13 @@ main(int argc, char *argv[])
                                 "An authority value is computed as the sum of the scaled hub values, and conversely a \n"
                                 "hub value is the sum of the scaled authority values of the pages it points to.\n"
                                 "\n"
+                                "After each batch the iteration restarts from the previous scores.\n"
+                                "\n"
                                 "  -k <num>  Set the maximum number of iterations (%ld by default)\n"
+                                "  -e <num>  Set the convergence threshold on the L1 change (%g by default)\n"
+                                "  -t <num>  Only follow edges of this type (all types by default)\n"
                                 "  -n <str>  Set the algorithm name (%s by default)\n"
-                                "\n", num_iter,  alg_name
+                                "\n", num_iter, epsilon, alg_name
                 );
                 return(opt);
             }
@@ -66,7 +83,7 @@ main(int argc, char *argv[])
     stinger_register_alg(
             .name=alg_name,
     .data_per_vertex=sizeof(double) + sizeof(double),
-    .data_description="ll hubs_scores authority_scores",
+    .data_description="dd hubs_scores authority_scores",
     .host="localhost",
     );
 
@@ -76,14 +93,19 @@ main(int argc, char *argv[])
     }
 
     double * hubs_scores = (double *)alg->alg_data;
-    double * authority_scores = (int64_t *)(hubs_scores + alg->stinger->max_nv);
+    double * authority_scores = hubs_scores + alg->stinger->max_nv;
+    double * tmp = (double *)xmalloc(2 * alg->stinger->max_nv * sizeof(double));
+    int64_t nv = 0;
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
     * Initial static computation
     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     stinger_alg_begin_init(alg); {
-        if (stinger_max_active_vertex(alg->stinger) > 0)
-            hits_centrality(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, hubs_scores, authority_scores, num_iter);
+        if (stinger_max_active_vertex(alg->stinger) > 0) {
+            nv = stinger_max_active_vertex(alg->stinger) + 1;
+            hits_centrality_type(alg->stinger, nv, hubs_scores, authority_scores, tmp,
+                                 epsilon, num_iter, 0, type);
+        }
     } stinger_alg_end_init(alg);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -98,14 +120,24 @@ main(int argc, char *argv[])
 
         /* Post processing */
         if(stinger_alg_begin_post(alg)) {
-            int64_t nv = stinger_max_active_vertex(alg->stinger) + 1;
-            if (nv > 0) {
-                hits_centrality(alg->stinger, nv, hubs_scores, authority_scores, num_iter);
+            int64_t new_nv = stinger_max_active_vertex(alg->stinger) + 1;
+            if (new_nv > 0) {
+                /* vertices new to this batch start from zero */
+                for (int64_t v = nv; v < new_nv; v++) {
+                    hubs_scores[v] = 0;
+                    authority_scores[v] = 0;
+                }
+                nv = new_nv > nv ? new_nv : nv;
+                int64_t iters = hits_centrality_type(alg->stinger, nv, hubs_scores, authority_scores, tmp,
+                                                     epsilon, num_iter, 1, type);
+                LOG_V_A("HITS converged after %ld iterations", (long)iters);
             }
 
             stinger_alg_end_post(alg);
         }
     }
 
+    LOG_I("Algorithm complete... shutting down");
+    xfree(tmp);
 
 }
\ No newline at end of file
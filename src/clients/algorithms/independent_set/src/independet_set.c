@@ -3,6 +3,7 @@
 //
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #include "stinger_core/stinger.h"
 #include "stinger_core/xmalloc.h"
@@ -24,10 +25,14 @@ main(int argc, char *argv[]) {
     );
 
     char * alg_name = "independent_set";
+    uint64_t seed = INDEPENDENT_SET_DEFAULT_SEED;
 
     int opt = 0;
-    while(-1 != (opt = getopt(argc, argv, "n:h"))) {
+    while(-1 != (opt = getopt(argc, argv, "s:n:h"))) {
         switch(opt) {
+            case 's': {
+                seed = strtoull(optarg, NULL, 0);
+            } break;
             case 'n': {
                 alg_name = optarg;
             } break;
@@ -39,12 +44,13 @@ main(int argc, char *argv[]) {
                         "IndependetSet\n"
                                 "==================================\n"
                                 "This algorithm finds a set of vertices that form an independent set. \n"
-                                "The algorithms works by randomly adding verticies to the graph such that no edges exist\n"
-                                "between any verticies in the selected set. The algoirhtm stops where there are no more\n"
-                                "vertices that can be added.\n"
+                                "Vertices are ranked by a seeded hash and join the set in parallel rounds when they\n"
+                                "outrank all of their undecided neighbors, until no more vertices can be added.\n"
+                                "After each batch the set is only repaired around the changed edges.\n"
                                 "\n"
+                                "  -s <num>  Set the seed of the vertex ranking (%lu by default)\n"
                                 "  -n <str>  Set the algorithm name (%s by default)\n"
-                                "\n",alg_name);
+                                "\n", (unsigned long)seed, alg_name);
                 return(opt);
             }
         }
@@ -56,13 +62,16 @@ main(int argc, char *argv[]) {
     }
 
     int64_t * ind_sets = (int64_t*)alg->alg_data;
+    int64_t nv = 0;
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
      * Initial static computation
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     stinger_alg_begin_init(alg); {
-        if (stinger_max_active_vertex(alg->stinger) > 0)
-            independent_set(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, ind_sets);
+        if (stinger_max_active_vertex(alg->stinger) > 0) {
+            nv = stinger_max_active_vertex(alg->stinger) + 1;
+            independent_set_luby(alg->stinger, nv, ind_sets, seed);
+        }
     } stinger_alg_end_init(alg);
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -77,9 +86,13 @@ main(int argc, char *argv[]) {
 
         /* Post processing */
         if(stinger_alg_begin_post(alg)) {
-            int64_t nv = (stinger_mapping_nv(alg->stinger))?stinger_mapping_nv(alg->stinger)+1:0;
-            if (nv > 0) {
-                independent_set(alg->stinger, stinger_max_active_vertex(alg->stinger) + 1, ind_sets);
+            int64_t new_nv = stinger_max_active_vertex(alg->stinger) + 1;
+            if (new_nv < nv) new_nv = nv;
+            if (new_nv > 0) {
+                int64_t repaired = independent_set_update(alg->stinger, nv, new_nv, ind_sets, seed,
+                    alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions);
+                nv = new_nv;
+                LOG_V_A("Independent set: %ld vertices re-decided", (long)repaired);
             }
 
             stinger_alg_end_post(alg);
@@ -18,12 +18,10 @@ main(int argc, char *argv[])
       .name="kcore",
       .data_per_vertex=2*sizeof(int64_t),
       .data_description="ll kcore size\n"
-      "  kcore - a label per vertex, the k of the largest core in which that vertex belongs\n"
-      "  count - the number of neighbors also in this large core\n"
-      "This algorithm gives an indication of the largest k-core to which each\n"
-      "vertex belongs by counting the number of neighboring vertices in the k-1 core and its neighbors'\n"
-      "counts of how many neighbors they have in a k-1 core. If their are enough, the vertex upgrades\n"
-      "itself to k.",
+      "  kcore - the core number of each vertex, the k of the largest k-core it belongs to\n"
+      "  size  - the number of neighbors whose core number is at least that of the vertex\n"
+      "Core numbers are computed once by bucket peeling and then maintained as\n"
+      "batches arrive. The graph is treated as undirected.",
       .host="localhost",
     );
 
@@ -36,12 +34,16 @@ main(int argc, char *argv[])
   int64_t * count = ((int64_t *)alg->alg_data) + alg->stinger->max_nv;
   int64_t k;
 
+  stinger_kcore_internal kcore_internal;
+  stinger_kcore_stats stats;
+  stinger_kcore_reset_stats(&stats);
+
   /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
    * Initial static computation
    * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
   stinger_alg_begin_init(alg); {
     LOG_I("Kcore init starting");
-    kcore_find(alg->stinger, kcore, count, alg->stinger->max_nv, &k);
+    stinger_kcore_initialize_internals(alg->stinger, alg->stinger->max_nv, &kcore_internal, kcore, count, &k);
     LOG_I_A("Kcore init finished. Largest core is %ld", (long)k);
   } stinger_alg_end_init(alg);
 
@@ -58,12 +60,18 @@ main(int argc, char *argv[])
     /* Post processing */
     if(stinger_alg_begin_post(alg)) {
       LOG_I("Kcore post starting");
-      kcore_find(alg->stinger, kcore, count, alg->stinger->max_nv, &k);
-      LOG_I_A("Kcore post finished. Largest core is %ld", (long)k);
+      int64_t touched = stinger_kcore_update(alg->stinger, &kcore_internal, &stats,
+        alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions,
+        kcore, count, &k);
+      LOG_I_A("Kcore post finished. Largest core is %ld, %ld vertices touched", (long)k, (long)touched);
+      LOG_V_A("Kcore stats: %ld insertions replayed, %ld deletion rounds, %ld visited, %ld changed",
+        (long)stats.insertions_processed, (long)stats.deletion_rounds,
+        (long)stats.vertices_visited, (long)stats.vertices_changed);
       stinger_alg_end_post(alg);
     }
   }
 
   LOG_I("Algorithm complete... shutting down");
+  stinger_kcore_release_internals(&kcore_internal);
   xfree(alg);
 }
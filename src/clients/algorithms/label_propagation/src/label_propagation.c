@@ -0,0 +1,111 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_error.h"
+#include "stinger_net/stinger_alg.h"
+#include "stinger_alg/label_propagation.h"
+
+
+int
+main(int argc, char *argv[])
+{
+  /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+   * Options and arg parsing
+   * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+  int64_t max_iter = LABEL_PROPAGATION_DEFAULT_ITERATIONS;
+  char * alg_name = "label_propagation";
+
+  int opt = 0;
+  while(-1 != (opt = getopt(argc, argv, "i:n:?h"))) {
+    switch(opt) {
+      case 'i': {
+        max_iter = atol(optarg);
+        if(max_iter < 1) {
+          max_iter = LABEL_PROPAGATION_DEFAULT_ITERATIONS;
+        }
+      } break;
+
+      case 'n': {
+        alg_name = optarg;
+      } break;
+
+      default:
+        printf("Unknown option '%c'\n", opt);
+      case '?':
+      case 'h': {
+        printf(
+          "Label propagation communities\n"
+          "==================================\n"
+          "\n"
+          "Each vertex takes the label carrying the most edge weight among its\n"
+          "neighbors. After each batch only the endpoints of changed edges and the\n"
+          "vertices their changes reach are evaluated again.\n"
+          "\n"
+          "  -i <num>  Set the max number of rounds per batch (%ld by default)\n"
+          "  -n <str>  Set the algorithm name (%s by default)\n"
+          "\n", (long)max_iter, alg_name
+        );
+        return(opt);
+      }
+    }
+  }
+
+  /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+   * Setup and register algorithm with the server
+   * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+  stinger_registered_alg * alg =
+    stinger_register_alg(
+      .name=alg_name,
+      .data_per_vertex=sizeof(int64_t),
+      .data_description="l community_label",
+      .host="localhost",
+    );
+
+  if(!alg) {
+    LOG_E("Registering algorithm failed.  Exiting");
+    return -1;
+  }
+
+  int64_t * labels = (int64_t *)alg->alg_data;
+
+  stinger_label_propagation_internal lp_internal;
+  stinger_label_propagation_stats stats;
+  stinger_label_propagation_reset_stats(&stats);
+
+  /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+   * Initial static computation
+   * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+  stinger_alg_begin_init(alg); {
+    LOG_I("Label propagation init starting");
+    stinger_label_propagation_initialize_internals(alg->stinger, alg->stinger->max_nv, &lp_internal,
+      max_iter, labels, &stats);
+    LOG_I_A("Label propagation init finished after %ld rounds", (long)stats.rounds);
+  } stinger_alg_end_init(alg);
+
+  /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
+   * Streaming Phase
+   * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+  while(alg->enabled) {
+    /* Pre processing */
+    if(stinger_alg_begin_pre(alg)) {
+      /* nothing to do */
+      stinger_alg_end_pre(alg);
+    }
+
+    /* Post processing */
+    if(stinger_alg_begin_post(alg)) {
+      int64_t changed = stinger_label_propagation_update(alg->stinger, &lp_internal, &stats,
+        alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions, labels);
+      LOG_V_A("Label propagation: %ld labels changed (%ld rounds, %ld evaluated in total)",
+        (long)changed, (long)stats.rounds, (long)stats.vertices_evaluated);
+      stinger_alg_end_post(alg);
+    }
+  }
+
+  LOG_I("Algorithm complete... shutting down");
+  stinger_label_propagation_release_internals(&lp_internal);
+  xfree(alg);
+}
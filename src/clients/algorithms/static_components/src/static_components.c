@@ -26,13 +26,16 @@ main(int argc, char *argv[])
     return -1;
   }
 
-  int64_t * components = (double *)alg->alg_data;
+  int64_t * components = (int64_t *)alg->alg_data;
+  int64_t nv = 0;
 
   /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
    * Initial static computation
    * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
   stinger_alg_begin_init(alg); {
-    parallel_shiloach_vishkin_components(alg->stinger, stinger_mapping_nv(alg->stinger), components);
+    nv = stinger_mapping_nv(alg->stinger);
+    int64_t num_components = afforest_components(alg->stinger, nv, components, 2);
+    LOG_I_A("Static components init finished. %ld components", (long)num_components);
   } stinger_alg_end_init(alg);
 
   /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ *
@@ -47,7 +50,12 @@ main(int argc, char *argv[])
 
     /* Post processing */
     if(stinger_alg_begin_post(alg)) {
-      parallel_shiloach_vishkin_components(alg->stinger, stinger_mapping_nv(alg->stinger), components);
+      /* insertions are unioned in place, deletions force a recompute */
+      int64_t new_nv = stinger_mapping_nv(alg->stinger);
+      int64_t incremental = afforest_components_update(alg->stinger, nv, new_nv, components,
+        alg->insertions, alg->num_insertions, alg->deletions, alg->num_deletions);
+      nv = new_nv;
+      LOG_V_A("Static components post: %s", incremental ? "incremental" : "recomputed");
       stinger_alg_end_post(alg);
     }
   }
@@ -2,6 +2,7 @@
 #define _JSON_RPC_SERVER_H
 
 #include "rpc_state.h"
+#include "stinger_alg/adamic_adar.h"
 
 using namespace gt::stinger;
 
@@ -95,6 +96,7 @@ struct JSON_RPC_get_server_info: JSON_RPCFunction {
 struct JSON_RPC_get_graph_stats: JSON_RPCFunction {
   JSON_RPC_get_graph_stats(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_label_breadth_first_search: JSON_RPCFunction {
@@ -118,8 +120,16 @@ struct JSON_RPC_breadth_first_search: JSON_RPCFunction {
 };
 
 struct JSON_RPC_adamic_adar: JSON_RPCFunction {
-  JSON_RPC_adamic_adar(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
+  JSON_RPC_adamic_adar(JSON_RPCServerState * state) : JSON_RPCFunction(state) {
+    pthread_rwlock_init(&cache_lock, NULL);
+  }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual int64_t update(const StingerBatch & batch);
+
+private:
+  /* neighbor caches by edge type, -1 for all types */
+  pthread_rwlock_t cache_lock;
+  std::map<int64_t, stinger_adamic_adar_t *> cache;
 };
 
 struct JSON_RPC_community_on_demand: JSON_RPCFunction {
@@ -135,36 +145,43 @@ struct JSON_RPC_get_algorithms : JSON_RPCFunction {
 struct JSON_RPC_get_data_description : JSON_RPCFunction {
   JSON_RPC_get_data_description(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array : JSON_RPCFunction {
   JSON_RPC_get_data_array(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array_range : JSON_RPCFunction {
   JSON_RPC_get_data_array_range(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array_sorted_range : JSON_RPCFunction {
   JSON_RPC_get_data_array_sorted_range(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array_set : JSON_RPCFunction {
   JSON_RPC_get_data_array_set(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array_stride : JSON_RPCFunction {
   JSON_RPC_get_data_array_stride(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_data_array_reduction : JSON_RPCFunction {
   JSON_RPC_get_data_array_reduction(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_server_health : JSON_RPCFunction {
@@ -175,11 +192,13 @@ struct JSON_RPC_get_server_health : JSON_RPCFunction {
 struct JSON_RPC_egonet : JSON_RPCFunction {
   JSON_RPC_egonet(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_get_connected_component : JSON_RPCFunction {
   JSON_RPC_get_connected_component(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_bfs_edges: JSON_RPCFunction {
@@ -190,6 +209,7 @@ struct JSON_RPC_bfs_edges: JSON_RPCFunction {
 struct JSON_RPC_pagerank_subgraph: JSON_RPCFunction {
   JSON_RPC_pagerank_subgraph(JSON_RPCServerState * state) : JSON_RPCFunction(state) { }
   virtual int64_t operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+  virtual bool cacheable() { return true; }
 };
 
 struct JSON_RPC_exact_diameter: JSON_RPCFunction {
@@ -223,8 +243,12 @@ int
 array_to_json_reduction    (stinger_t * S,
                 rapidjson::Value& rtn,
                 rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator,
-                const char * description_string, uint8_t * data,
-                const char * search_string
+                const std::vector<StingerFieldSummary> & summary,
+                uint8_t * data,
+                const char * algorithm_name,
+                const char * field,
+                const char * op,
+                double threshold
                 );
 
 #endif /* _JSON_RPC_SERVER_H */
@@ -0,0 +1,102 @@
+#ifndef _NEIGHBORHOOD_CACHE_H
+#define _NEIGHBORHOOD_CACHE_H
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "stinger_core/stinger.h"
+#include "stinger_net/proto/stinger-batch.pb.h"
+
+namespace gt {
+  namespace stinger {
+
+    /* The vertices within k hops of a seed, following edges in either
+     * direction, and the out-edges among them. Vertices are in order of
+     * discovery with the seed first; edges are (src, dst, etype) triples. */
+    struct Neighborhood {
+      std::vector<int64_t> vertices;
+      std::vector<int64_t> edges;
+    };
+
+    typedef struct {
+      int64_t entries;
+      int64_t bytes;
+      int64_t max_bytes;
+      int64_t hits;
+      int64_t misses;
+      int64_t invalidations;
+      int64_t evictions;
+    } neighborhood_cache_stats_t;
+
+    /* Neighborhoods of recently requested seeds, kept across batches. Each
+     * batch drops only those a changed edge could alter: edges between two
+     * members, or from a member closer than k hops to the seed. The least
+     * recently used go once max_bytes is reached. */
+    class NeighborhoodCache {
+      public:
+	NeighborhoodCache();
+
+	/* Fills out with the neighborhood of seed over edges of etype (-1
+	 * for all) in S, the graph of the given epoch. */
+	void
+	get(stinger_t * S, int64_t epoch, int64_t seed, int64_t k, int64_t etype, Neighborhood & out);
+
+	/* Applies the batch that produced epoch */
+	void
+	invalidate(const StingerBatch & batch, int64_t epoch);
+
+	void
+	set_size(int64_t max_bytes);
+
+	neighborhood_cache_stats_t
+	get_stats();
+
+      private:
+	struct Key {
+	  int64_t seed;
+	  int64_t k;
+	  int64_t etype;
+	  bool operator<(const Key & o) const {
+	    if (seed != o.seed) return seed < o.seed;
+	    if (k != o.k) return k < o.k;
+	    return etype < o.etype;
+	  }
+	};
+
+	struct Entry {
+	  Neighborhood hood;
+	  int64_t epoch;
+	  int64_t bytes;
+	  std::list<Key>::iterator lru;
+	};
+
+	/* a vertex's hop distance within one cached neighborhood */
+	struct Membership {
+	  Key key;
+	  int64_t hops;
+	};
+
+	std::map<Key, Entry> entries;
+	std::list<Key> lru;
+	std::map<int64_t, std::vector<Membership> > members;
+	int64_t valid_epoch;  /* entries hold for epochs up to this one */
+	int64_t lock;
+	neighborhood_cache_stats_t stats;
+
+	void
+	erase(std::map<Key, Entry>::iterator it);
+
+	void
+	evict(int64_t max_bytes);
+
+	void
+	touch(int64_t src, int64_t dst, std::vector<Key> & stale);
+    };
+
+  }
+}
+
+#endif /* _NEIGHBORHOOD_CACHE_H */
@@ -0,0 +1,109 @@
+#ifndef _RPC_RESPONSE_H
+#define _RPC_RESPONSE_H
+
+#include <stdint.h>
+#include <cstddef>
+#include <string>
+
+#include "mongoose/mongoose.h"
+#include "rapidjson/document.h"
+
+#if defined(STINGER_RPC_USE_ZLIB)
+#include <zlib.h>
+#endif
+
+namespace gt {
+  namespace stinger {
+
+    typedef enum {
+      ENCODING_IDENTITY,
+      ENCODING_GZIP,
+      ENCODING_DEFLATE
+    } content_encoding_t;
+
+    /* The body of an HTTP response, written to the connection as it is
+     * produced. A body that fits in one buffer goes out whole with a
+     * Content-Length; a larger one is sent with chunked transfer encoding,
+     * except to HTTP/1.0 clients, which get it whole at the end. Bodies are
+     * gzip or deflate compressed when the request's Accept-Encoding allows
+     * it and zlib was found at build time. Also a rapidjson output stream. */
+    class ResponseStream {
+      public:
+	typedef char Ch;
+
+	ResponseStream(struct mg_connection * conn, const char * content_type, const char * extra_headers = "");
+	~ResponseStream();
+
+	void Put(char c) {
+	  buf[len++] = c;
+	  if (len == sizeof(buf))
+	    flush_buffer(false);
+	}
+
+	void Write(const void * data, size_t n);
+
+	/* sends what is buffered now, for bodies written over time */
+	void flush();
+
+	/* sends what is left and ends the response; returns -1 on a write
+	 * error and the body bytes put on the wire otherwise */
+	int64_t finish();
+
+	bool ok() const { return !failed; }
+
+      private:
+	struct mg_connection * conn;
+	const char * content_type;
+	const char * extra_headers;
+	content_encoding_t encoding;
+	bool chunkable;
+	bool chunked;
+	bool started;
+	bool failed;
+	int64_t sent;
+
+	char buf[1 << 16];
+	size_t len;
+	std::string held;
+
+#if defined(STINGER_RPC_USE_ZLIB)
+	z_stream zs;
+	bool zs_init;
+	char zbuf[1 << 16];
+#endif
+
+	void start(int64_t content_length);
+	void flush_buffer(bool last);
+	void emit(const char * data, size_t n, bool last, bool sync = false);
+	void send(const char * data, size_t n);
+    };
+
+    /* Writes response as compact JSON */
+    int64_t
+    json_rpc_send_response(struct mg_connection * conn, rapidjson::Document & response);
+
+    /* True if the request asked for Accept: application/octet-stream */
+    bool
+    json_rpc_wants_binary(struct mg_connection * conn);
+
+    /* Answers get_data_array and get_data_array_range with the requested
+     * field packed little-endian instead of JSON. The X-Stinger-Type header
+     * gives the field's description character (f, d, i, l or b) and
+     * X-Stinger-Offset and X-Stinger-Count the vertices covered, followed by
+     * the batch and time the values were read at. Returns false without
+     * writing anything if the request cannot be answered this way. */
+    bool
+    json_rpc_send_binary(struct mg_connection * conn, rapidjson::Document & request);
+
+    /* Serves /events?session_id=N as text/event-stream: an "update" event
+     * carrying what a request for the session would return, pushed after
+     * each batch that gives it something to report, and a comment line to
+     * keep the connection open otherwise. Holds a server thread until the
+     * client disconnects. Returns false if there is no such session. */
+    bool
+    json_rpc_stream_events(struct mg_connection * conn);
+
+  }
+}
+
+#endif /* _RPC_RESPONSE_H */
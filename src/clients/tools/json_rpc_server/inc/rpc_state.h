@@ -3,16 +3,20 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <list>
 #include <map>
 #include <string>
+#include <vector>
 #include <stdint.h>
 #include <semaphore.h>
+#include <pthread.h>
 #include "stinger_net/stinger_alg_state.h"
 #include "stinger_net/stinger_local_state_c.h"
 #include "stinger_core/stinger.h"
 #include "rapidjson/document.h"
 #include "stinger_net/proto/stinger-monitor.pb.h"
 #include "stinger_net/stinger_mon.h"
+#include "neighborhood_cache.h"
 
 namespace gt {
   namespace stinger {
@@ -56,20 +60,40 @@ namespace gt {
 	LOG_W("This is a generic JSON_RPCFunction object and should not be called");
       }
 
+      /* called with every batch; functions that cache results drop what it changed */
+      virtual int64_t update(const StingerBatch & batch) {
+	return 0;
+      }
+
+      /* true if the result depends only on the params and the batch, so the
+       * server may answer repeated calls from its result cache */
+      virtual bool cacheable() {
+	return false;
+      }
+
       bool contains_params(rpc_params_t * p, rapidjson::Value * params);
 
     };
 
+    /* sessions time out after 30 seconds untouched, so waits stay shorter */
+#define SESSION_MAX_WAIT_MS 20000
+
     class JSON_RPCSession {
       private:
 	int64_t the_lock;
 	int64_t session_id;
 	int64_t last_touched;
+	/* references held, guarded by the server state's session lock; the
+	 * session is freed when the last goes and closed once destroyed */
+	int64_t refs;
+	bool closed;
+	friend class JSON_RPCServerState;
       protected:
 	JSON_RPCServerState * server_state;
 
       public:
-	JSON_RPCSession(int64_t sess_id, JSON_RPCServerState * state) : session_id(sess_id), the_lock(0), server_state(state) { }
+	JSON_RPCSession(int64_t sess_id, JSON_RPCServerState * state) : session_id(sess_id), the_lock(0), refs(1), closed(false), server_state(state) { }
+	virtual ~JSON_RPCSession() { }
 	void lock();
 	void unlock();
 	virtual rpc_params_t * get_params() {
@@ -78,6 +102,13 @@ namespace gt {
 	virtual int64_t update(const StingerBatch & batch) {
 	  LOG_W("This is a generic JSON_RPCSession object and should not be called");
 	}
+	/* Called instead of update() for sessions that subscribed vertices
+	 * with the server state, and only for batches that touched them; ins
+	 * and del index the batch's insertions and deletions that did. */
+	virtual int64_t update_subscribed(const StingerBatch & batch,
+				const std::vector<int64_t> & ins, const std::vector<int64_t> & del) {
+	  return update(batch);
+	}
 	virtual int64_t onRegister(
 				rapidjson::Value & result,
 				rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator) {
@@ -92,12 +123,26 @@ namespace gt {
 	  LOG_W("This is a generic JSON_RPCSession object and should not be called");
 	  return NULL;
 	}
+	/* True if onRequest() has something new to report. Called with the
+	 * session locked; sessions that cannot tell always do. */
+	virtual bool has_pending() {
+	  return true;
+	}
 	bool is_timed_out();
 	int64_t reset_timeout();
 	int64_t get_session_id();
 	int64_t get_time_since();
     };
 
+    typedef struct {
+      int64_t entries;
+      int64_t bytes;
+      int64_t max_bytes;
+      int64_t hits;
+      int64_t misses;
+      int64_t evictions;
+    } result_cache_stats_t;
+
     class JSON_RPCServerState : public StingerMon {
       private:
 	/* I'm a singleton */
@@ -112,8 +157,56 @@ namespace gt {
 	int64_t max_sessions;
 	int64_t next_session_id;
 
+	/* vertex to subscribed sessions and back, with a bit per vertex that
+	 * has any so that a batch is checked once for all sessions */
+	std::map<int64_t, std::vector<int64_t> > vertex_subscribers;
+	std::map<int64_t, std::vector<int64_t> > session_subscriptions;
+	std::vector<uint64_t> subscribed_bits;
+	int64_t subscription_lock;
+
+	struct SessionEvents {
+	  std::vector<int64_t> ins;
+	  std::vector<int64_t> del;
+	};
+
+	void
+	unsubscribe_all(int64_t session_id);
+
+	void
+	collect_events(int64_t src, int64_t dst, int64_t index, bool insertion,
+	  std::map<int64_t, SessionEvents> & events);
+
 	time_t start_time;
 
+	/* broadcast once sessions have seen a batch or one is destroyed */
+	pthread_mutex_t push_mutex;
+	pthread_cond_t push_cond;
+	int64_t push_seq;
+	int64_t push_waiters;
+	int64_t max_push_waiters;
+
+	void
+	close_session(std::map<int64_t, JSON_RPCSession *>::iterator it);
+
+	void
+	wake_waiters();
+
+	/* serialized results of cacheable functions, least recently used last */
+	struct CachedResult {
+	  std::string text;
+	  int64_t epoch;
+	  std::list<std::string>::iterator lru;
+	};
+	std::map<std::string, CachedResult> result_cache;
+	std::list<std::string> result_lru;
+	int64_t result_cache_lock;
+	result_cache_stats_t result_cache_stats;
+
+	void
+	evict_results(int64_t max_bytes);
+
+	NeighborhoodCache neighborhood_cache;
+
       public:
 	static JSON_RPCServerState & get_server_state();
 
@@ -144,6 +237,7 @@ namespace gt {
 	int64_t
 	get_next_session();
 
+	/* The map takes its own reference; the caller keeps the one it had */
 	int64_t
 	add_session(int64_t session_id, JSON_RPCSession * session);
 
@@ -155,14 +249,71 @@ namespace gt {
 	int64_t
 	destroy_session(int64_t session_id);
 
+	void
+	set_max_sessions(int64_t max);
+
+	/* Routes the batch's edges touching vertex to the session's
+	 * update_subscribed(); subscriptions end with the session. */
+	void
+	subscribe_vertex(int64_t session_id, int64_t vertex);
+
+	/* Blocks until the session has pending updates, is destroyed, or
+	 * timeout_ms passes, keeping the session alive meanwhile. Returns true
+	 * if it has updates. Callers must hold a reference and not the alg
+	 * read lock. */
+	bool
+	wait_for_session(JSON_RPCSession * session, int64_t timeout_ms);
+
+	/* Long polls and event streams each hold a request worker while
+	 * they wait, so at most max of them may at once. begin_push_wait()
+	 * returns false when that many already are. */
+	void
+	set_max_push_waiters(int64_t max);
+
+	bool
+	begin_push_wait();
+
+	void
+	end_push_wait();
+
+	int64_t
+	get_num_push_waiters();
+
 	int64_t
 	get_num_sessions();
 
+	/* Returns the session with a reference the caller must release, or
+	 * NULL if there is no such session */
 	JSON_RPCSession *
 	get_session(int64_t session_id);
 
+	void
+	release_session(JSON_RPCSession * session);
+
+	/* True once destroy_session or a timeout has removed the session */
+	bool
+	session_closed(JSON_RPCSession * session);
+
 	time_t
 	get_time_since_start();
+
+	/* The result cache maps a canonical method and params key to the
+	 * serialized result computed in a given epoch; update_algs empties it. */
+	bool
+	get_cached_result(const std::string & key, int64_t epoch, std::string & text);
+
+	void
+	put_cached_result(const std::string & key, int64_t epoch, const std::string & text);
+
+	void
+	set_result_cache_size(int64_t max_bytes);
+
+	result_cache_stats_t
+	get_result_cache_stats();
+
+	/* k-hop neighborhoods, kept until a batch changes them */
+	NeighborhoodCache &
+	get_neighborhood_cache();
     };
 
   }
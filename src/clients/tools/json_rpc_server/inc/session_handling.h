@@ -13,6 +13,10 @@ using namespace gt::stinger;
 namespace gt {
   namespace stinger {
 
+    /* edge events a session holds for its client; past this many the rest
+     * are dropped and the client is told to reload */
+#define SESSION_MAX_PENDING_EDGES (1 << 16)
+
     class JSON_RPC_community_subgraph: public JSON_RPCSession {
       private:
 	rpc_params_t p[5];
@@ -25,6 +29,7 @@ namespace gt {
 
 	std::set<std::pair<int64_t, int64_t> > _insertions;
 	std::set<std::pair<int64_t, int64_t> > _deletions;
+	bool _overflow;
 
       public:
 	JSON_RPC_community_subgraph(int64_t sess_id, JSON_RPCServerState * session) : JSON_RPCSession(sess_id, session) {
@@ -33,6 +38,7 @@ namespace gt {
 	  p[2] = ((rpc_params_t) {"source", TYPE_VERTEX, &_source, false, 0});
 	  p[3] = ((rpc_params_t) {"strings", TYPE_BOOL, &_strings, true, 0});
 	  p[4] = ((rpc_params_t) {NULL, TYPE_NONE, NULL, false, 0});
+	  _overflow = false;
 	}
 	virtual rpc_params_t * get_params();
 	virtual int64_t update(const StingerBatch & batch);
@@ -42,6 +48,9 @@ namespace gt {
 	virtual int64_t onRequest(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+	virtual bool has_pending() {
+	  return _overflow || !_insertions.empty() || !_deletions.empty();
+	}
 	virtual JSON_RPCSession * gimme(int64_t sess_id, JSON_RPCServerState * session) {
 	  return new JSON_RPC_community_subgraph(sess_id, session);
 	}
@@ -56,21 +65,28 @@ namespace gt {
 
 	std::set<std::pair<int64_t, int64_t> > _insertions;
 	std::set<std::pair<int64_t, int64_t> > _deletions;
+	bool _overflow;
 
       public:
 	JSON_RPC_vertex_event_notifier(int64_t sess_id, JSON_RPCServerState * session) : JSON_RPCSession(sess_id, session) {
 	  p[0] = ((rpc_params_t) {"set", TYPE_ARRAY, &set_array, false, 0});
 	  p[1] = ((rpc_params_t) {"strings", TYPE_BOOL, &_strings, true, 0});
 	  p[2] = ((rpc_params_t) {NULL, TYPE_NONE, NULL, false, 0});
+	  _overflow = false;
 	}
 	virtual rpc_params_t * get_params();
 	virtual int64_t update(const StingerBatch & batch);
+	virtual int64_t update_subscribed(const StingerBatch & batch,
+		      const std::vector<int64_t> & ins, const std::vector<int64_t> & del);
 	virtual int64_t onRegister(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
 	virtual int64_t onRequest(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+	virtual bool has_pending() {
+	  return _overflow || !_insertions.empty() || !_deletions.empty();
+	}
 	virtual JSON_RPCSession * gimme(int64_t sess_id, JSON_RPCServerState * session) {
 	  return new JSON_RPC_vertex_event_notifier(sess_id, session);
 	}
@@ -97,6 +113,9 @@ namespace gt {
 	virtual int64_t onRequest(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+	virtual bool has_pending() {
+	  return !_coordinates.empty();
+	}
 	virtual JSON_RPCSession * gimme(int64_t sess_id, JSON_RPCServerState * session) {
 	  return new JSON_RPC_get_latlon(sess_id, session);
 	}
@@ -146,6 +165,9 @@ namespace gt {
 	virtual int64_t onRequest(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+	virtual bool has_pending() {
+	  return !_coordinates.empty();
+	}
 	virtual JSON_RPCSession * gimme(int64_t sess_id, JSON_RPCServerState * session) {
 	  return new JSON_RPC_get_latlon_gnip(sess_id, session);
 	}
@@ -199,6 +221,9 @@ namespace gt {
 	virtual int64_t onRequest(
 		      rapidjson::Value & result,
 		      rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator);
+	virtual bool has_pending() {
+	  return !_coordinates.empty();
+	}
 	virtual JSON_RPCSession * gimme(int64_t sess_id, JSON_RPCServerState * session) {
 	  return new JSON_RPC_get_latlon_twitter(sess_id, session);
 	}
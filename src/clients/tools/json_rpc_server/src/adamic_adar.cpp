@@ -18,11 +18,13 @@ JSON_RPC_adamic_adar::operator()(rapidjson::Value * params, rapidjson::Value & r
   int64_t source;
   bool strings;
   int64_t etype;
+  int64_t k;
 
   rpc_params_t p[] = {
     {"source", TYPE_VERTEX, &source, false, 0},
     {"strings", TYPE_BOOL, &strings, true, 0},
     {"etype", TYPE_EDGE_TYPE , &etype, true, -1},
+    {"k", TYPE_INT64, &k, true, 0},
     {NULL, TYPE_NONE, NULL, false, 0}
   };
 
@@ -59,7 +61,29 @@ JSON_RPC_adamic_adar::operator()(rapidjson::Value * params, rapidjson::Value & r
   int64_t * candidates = NULL;
   double * scores = NULL;
 
-  int64_t num_candidates = adamic_adar(S, source, etype, &candidates, &scores);
+  /* look up the cache for this edge type, creating it on first use */
+  pthread_rwlock_rdlock(&cache_lock);
+  std::map<int64_t, stinger_adamic_adar_t *>::iterator it = cache.find(etype);
+  if (it == cache.end() || it->second->nv != S->max_nv) {
+    pthread_rwlock_unlock(&cache_lock);
+    pthread_rwlock_wrlock(&cache_lock);
+    it = cache.find(etype);
+    if (it != cache.end() && it->second->nv != S->max_nv) {
+      adamic_adar_release(it->second);
+      delete it->second;
+      cache.erase(it);
+      it = cache.end();
+    }
+    if (it == cache.end()) {
+      stinger_adamic_adar_t * aa = new stinger_adamic_adar_t;
+      adamic_adar_initialize(S, S->max_nv, etype, aa);
+      it = cache.insert(std::make_pair(etype, aa)).first;
+    }
+  }
+
+  /* holding either lock keeps update() out while we read the cache */
+  int64_t num_candidates = adamic_adar_top_k(S, it->second, source, k, &candidates, &scores);
+  pthread_rwlock_unlock(&cache_lock);
 
   for (int64_t i = 0; i < num_candidates; i++) {
     name.SetInt64(candidates[i]);
@@ -93,3 +117,35 @@ JSON_RPC_adamic_adar::operator()(rapidjson::Value * params, rapidjson::Value & r
 
   return 0;
 }
+
+int64_t
+JSON_RPC_adamic_adar::update(const StingerBatch & batch)
+{
+  if (0 == batch.insertions_size () && 0 == batch.deletions_size ()) {
+    return 0;
+  }
+
+  stinger_t * S = server_state->get_stinger();
+  if (!S) {
+    LOG_E ("STINGER pointer is invalid");
+    return -1;
+  }
+
+  pthread_rwlock_wrlock(&cache_lock);
+  for (std::map<int64_t, stinger_adamic_adar_t *>::iterator it = cache.begin(); it != cache.end(); it++) {
+    stinger_adamic_adar_t * aa = it->second;
+    for (size_t i = 0; i < batch.insertions_size(); i++) {
+      const EdgeInsertion & in = batch.insertions(i);
+      adamic_adar_invalidate(S, aa, in.source());
+      adamic_adar_invalidate(S, aa, in.destination());
+    }
+    for (size_t d = 0; d < batch.deletions_size(); d++) {
+      const EdgeDeletion & del = batch.deletions(d);
+      adamic_adar_invalidate(S, aa, del.source());
+      adamic_adar_invalidate(S, aa, del.destination());
+    }
+  }
+  pthread_rwlock_unlock(&cache_lock);
+
+  return 0;
+}
@@ -10,47 +10,6 @@
 
 using namespace gt::stinger;
 
-template <typename T>
-inline int64_t* new_sorted_data_idx(T* data, int64_t nv, bool asc) {
-  int64_t * idx = (int64_t *) xmalloc (nv * sizeof(int64_t));
-  for (int64_t i = 0; i < nv; i++) {
-    idx[i] = i;
-  }
-
-  if (asc) {
-    compare_pair_asc<T> comparator(data);
-    std::sort(idx, idx + nv, comparator);
-  } else {
-    compare_pair_desc<T> comparator(data);
-    std::sort(idx, idx + nv, comparator);
-  }
-
-  return idx;
-}
-
-template <typename T>
-inline int64_t* new_sorted_data_idx(T* data_start, int64_t nv, bool asc, int64_t data_byte_offset) {
-  int64_t * idx = (int64_t *) xmalloc (nv * sizeof(int64_t));
-  for (int64_t i = 0; i < nv; i++) {
-    idx[i] = i;
-  }
-
-  if (asc) {
-    compare_pair_off_asc<T> comparator(data_start, data_byte_offset);
-    std::sort(idx, idx + nv, comparator);
-  } else {
-    compare_pair_off_desc<T> comparator(data_start, data_byte_offset);
-    std::sort(idx, idx + nv, comparator);
-  }
-
-  return idx;
-}
-
-inline void free_sorted_data_idx(int64_t* idx) {
-  free(idx);
-}
-
-
 /*! \brief Converts a STINGER algorithm data array into JSON
  *
  * Takes the data contained in a STINGER algorithm and adds any data
@@ -184,37 +143,33 @@ array_to_json_monolithic   (json_rpc_array_meth_t method, stinger_t * S,
     LOG_D_A ("%s: begin while :: %s", search_string, pch);
     if (strcmp(pch, search_string) == 0) {
       LOG_D_A ("%s: matches", search_string);
-      int64_t * idx;
+      const int64_t * idx;
       if (method == SORTED) {
+        /* sorted indices are kept per batch by the server state */
+        const uint8_t * sort_data = data;
+        int64_t sort_stride;
         switch (description_string[off]) {
-          case 'f':
-            LOG_D_A ("%s: case f", search_string);
-            idx = new_sorted_data_idx((float*)data, nv, asc);
-            break;
-          case 'd':
-            LOG_D_A ("%s: case d", search_string);
-            idx = new_sorted_data_idx((double*)data, nv, asc);
-            break;
-          case 'i':
-            LOG_D_A ("%s: case i", search_string);
-            idx = new_sorted_data_idx((int32_t*)data, nv, asc);
-            break;
-          case 'l':
-            LOG_D_A ("%s: case l", search_string);
-            idx = new_sorted_data_idx((int64_t*)data, nv, asc);
-            break;
-          case 'b':
-            LOG_D_A ("%s: case b", search_string);
-            idx = new_sorted_data_idx((uint8_t*)data, nv, asc);
-            break;
+          case 'f': sort_stride = sizeof(float); break;
+          case 'd': sort_stride = sizeof(double); break;
+          case 'i': sort_stride = sizeof(int32_t); break;
+          case 'l': sort_stride = sizeof(int64_t); break;
+          case 'b': sort_stride = sizeof(uint8_t); break;
           case 's':
-            LOG_D_A ("%s: case s", search_string);
-            idx = new_sorted_data_idx((int64_t*)stinger_local_state_get_data_ptr(S, search_string), nv, asc, sizeof(vertices->vertices[0]));
+            sort_data = (const uint8_t *)stinger_local_state_get_data_ptr(S, search_string);
+            sort_stride = sizeof(vertices->vertices[0]);
             break;
           default:
             LOG_W_A("Umm...what letter was that?\ndescription_string: %s", description_string);
+            free(tmp);
             return json_rpc_error(-32603, rtn, allocator);
         }
+        int64_t idx_len;
+        idx = JSON_RPCServerState::get_server_state().get_sorted_index(sort_data,
+          description_string[off], sort_stride, nv, asc, end, &idx_len);
+        if (!idx || idx_len < end) {
+          free(tmp);
+          return json_rpc_error(-32603, rtn, allocator);
+        }
       }
 
       rapidjson::Value value, name, vtx_phys;
@@ -282,6 +237,7 @@ array_to_json_monolithic   (json_rpc_array_meth_t method, stinger_t * S,
             break;
           default:
             LOG_W_A("Umm...what letter was that?\ndescription_string: %s", description_string);
+            free(tmp);
             return json_rpc_error(-32603, rtn, allocator);
         }
         
@@ -302,8 +258,6 @@ array_to_json_monolithic   (json_rpc_array_meth_t method, stinger_t * S,
         }
       }
 
-      if (method == SORTED)
-        free_sorted_data_idx(idx);
       done = 1;
     } else {
       LOG_D_A ("%s: does not match %d", search_string, nv);
@@ -332,6 +286,7 @@ array_to_json_monolithic   (json_rpc_array_meth_t method, stinger_t * S,
 
         default:
           LOG_W_A("Umm...what letter was that?\ndescription_string: %s", description_string);
+          free(tmp);
           return json_rpc_error(-32603, rtn, allocator);
       }
       off++;
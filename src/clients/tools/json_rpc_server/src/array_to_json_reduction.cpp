@@ -1,3 +1,5 @@
+#include <cmath>
+
 #include "json_rpc_server.h"
 #include "json_rpc.h"
 #include "stinger_core/xmalloc.h"
@@ -8,180 +10,209 @@
 
 using namespace gt::stinger;
 
-int
-array_to_json_reduction    (stinger_t * S,
-												    rapidjson::Value& rtn,
-												    rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator,
-												    const char * description_string, uint8_t * data,
-												    const char * algorithm_name
-												    )
+static void
+add_double(rapidjson::Value & obj, const char * name, double x,
+	   rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator)
 {
-  size_t off = 0;
-  size_t len = strlen(description_string);
-  char * tmp = (char *) xmalloc ((len+1) * sizeof(char));
-  strcpy(tmp, description_string);
+  rapidjson::Value val;
+  val.SetDouble(x);
+  obj.AddMember(name, val, allocator);
+}
 
-  rapidjson::Value fields (rapidjson::kArrayType);
+static void
+add_int64(rapidjson::Value & obj, const char * name, int64_t x,
+	  rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator)
+{
+  rapidjson::Value val;
+  val.SetInt64(x);
+  obj.AddMember(name, val, allocator);
+}
 
-  /* the description string is space-delimited */
-  char * placeholder;
-  char * ptr = strtok_r (tmp, " ", &placeholder);
+static bool
+integer_type(char type)
+{
+  return type == 'i' || type == 'l' || type == 'b';
+}
 
-  /* skip the formatting */
-  char * pch = strtok_r (NULL, " ", &placeholder);
+/* count, sum, mean, min and max; the last three are null without values.
+ * Integer fields report their exact sum. */
+static void
+add_values(rapidjson::Value & obj, const StingerValueSummary & s, char type,
+	   rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator)
+{
+  add_int64(obj, "count", s.count, allocator);
+  if (integer_type(type))
+    add_int64(obj, "sum", s.isum, allocator);
+  else
+    add_double(obj, "sum", s.sum, allocator);
+  if (s.count) {
+    add_double(obj, "mean", (integer_type(type) ? (double) s.isum : s.sum) / s.count, allocator);
+    add_double(obj, "min", s.min, allocator);
+    add_double(obj, "max", s.max, allocator);
+  } else {
+    rapidjson::Value null_val;
+    obj.AddMember("mean", null_val, allocator);
+    obj.AddMember("min", null_val, allocator);
+    obj.AddMember("max", null_val, allocator);
+  }
+}
 
-  if (pch == NULL) {
-    LOG_W_A ("pch is null :: %s :: %s", description_string, algorithm_name);
+/* Counts the values above threshold, which no pre-aggregate can answer */
+static int64_t
+count_above(char type, const uint8_t * field, int64_t nv, double threshold)
+{
+  int64_t count = 0;
+  switch (type) {
+    case 'f': {
+      const float * x = (const float *) field;
+      OMP("omp parallel for reduction(+:count)")
+      for (int64_t i = 0; i < nv; i++)
+	count += (x[i] > threshold);
+    } break;
+    case 'd': {
+      const double * x = (const double *) field;
+      OMP("omp parallel for reduction(+:count)")
+      for (int64_t i = 0; i < nv; i++)
+	count += (x[i] > threshold);
+    } break;
+    case 'i': {
+      const int32_t * x = (const int32_t *) field;
+      OMP("omp parallel for reduction(+:count)")
+      for (int64_t i = 0; i < nv; i++)
+	count += (x[i] > threshold);
+    } break;
+    case 'l': {
+      const int64_t * x = (const int64_t *) field;
+      OMP("omp parallel for reduction(+:count)")
+      for (int64_t i = 0; i < nv; i++)
+	count += ((double) x[i] > threshold);
+    } break;
+    case 'b': {
+      OMP("omp parallel for reduction(+:count)")
+      for (int64_t i = 0; i < nv; i++)
+	count += (field[i] > threshold);
+    } break;
   }
+  return count;
+}
 
-  int64_t start = 0;
-  int64_t end = S->max_nv;
-
-  while (pch != NULL)
-  {
-      size_t pch_len = strlen(pch);
-      switch (description_string[off]) {
-				case 'f':
-				  {
-				    rapidjson::Value reduction (rapidjson::kObjectType);
-				    rapidjson::Value reduction_name, reduction_value;
-				    double sum = 0.0;
-				    for (int64_t i = start; i < end; i++) {
-				      double val = (double)((float *) data)[i];
-				      if (val > 0.0)
-					sum += val;
-				    }
-				    reduction_value.SetDouble(sum);
-				    reduction_name.SetString(pch, pch_len, allocator);
-				    
-				    reduction.AddMember("field", reduction_name, allocator);
-				    reduction.AddMember("value", reduction_value, allocator);
-
-				    fields.PushBack(reduction, allocator);
-				    break;
-				  }
-
-				case 'd':
-				  {
-				    rapidjson::Value reduction (rapidjson::kObjectType);
-				    rapidjson::Value reduction_name, reduction_value;
-				    double sum = 0.0;
-				    for (int64_t i = start; i < end; i++) {
-				      double val = (double)((double *) data)[i];
-				      if (val > 0.0)
-					sum += val;
-				    }
-				    reduction_value.SetDouble(sum);
-				    reduction_name.SetString(pch, pch_len, allocator);
-				    
-				    reduction.AddMember("field", reduction_name, allocator);
-				    reduction.AddMember("value", reduction_value, allocator);
-
-				    fields.PushBack(reduction, allocator);
-				    break;
-				  }
-
-				case 'i':
-				  {
-				    rapidjson::Value reduction (rapidjson::kObjectType);
-				    rapidjson::Value reduction_name, reduction_value;
-				    int64_t sum = 0;
-				    for (int64_t i = start; i < end; i++) {
-				      int64_t val = (int64_t)((int32_t *) data)[i];
-				      if (val > 0)
-					sum += val;
-				    }
-				    reduction_value.SetInt64(sum);
-				    reduction_name.SetString(pch, pch_len, allocator);
-				    
-				    reduction.AddMember("field", reduction_name, allocator);
-				    reduction.AddMember("value", reduction_value, allocator);
-
-				    fields.PushBack(reduction, allocator);
-				    break;
-				  }
-
-				case 'l':
-				  {
-				    rapidjson::Value reduction (rapidjson::kObjectType);
-				    rapidjson::Value reduction_name, reduction_value;
-				    int64_t sum = 0;
-				    for (int64_t i = start; i < end; i++) {
-				      int64_t val = (int64_t)((int64_t *) data)[i];
-				      if (val > 0)
-					sum += val;
-				    }
-				    
-				    reduction_value.SetInt64(sum);
-				    reduction_name.SetString(pch, pch_len, allocator);
-				    
-				    reduction.AddMember("field", reduction_name, allocator);
-				    reduction.AddMember("value", reduction_value, allocator);
-
-				    fields.PushBack(reduction, allocator);
-				    break;
-				  }
-
-				case 'b':
-				  {
-				    rapidjson::Value reduction (rapidjson::kObjectType);
-				    rapidjson::Value reduction_name, reduction_value;
-				    int64_t sum = 0;
-				    for (int64_t i = start; i < end; i++) {
-				      int64_t val = (int64_t)((uint8_t *) data)[i];
-				      if (val > 0)
-					sum += val;
-				    }
-
-				    reduction_value.SetInt64(sum);
-				    reduction_name.SetString(pch, pch_len, allocator);
-				    
-				    reduction.AddMember("field", reduction_name, allocator);
-				    reduction.AddMember("value", reduction_value, allocator);
-				    
-				    fields.PushBack(reduction, allocator);
-				    break;
-				  }
-
-				default:
-				  LOG_W_A("Umm...what letter was that?\ndescription_string: %s", description_string);
-				  return json_rpc_error(-32603, rtn, allocator);
-
-				    }
-
-				    switch (description_string[off]) {
-				case 'f':
-				  data += (S->max_nv * sizeof(float));
-				  break;
-
-				case 'd':
-				  data += (S->max_nv * sizeof(double));
-				  break;
-
-				case 'i':
-				  data += (S->max_nv * sizeof(int32_t));
-				  break;
-
-				case 'l':
-				  data += (S->max_nv * sizeof(int64_t));
-				  break;
-
-				case 'b':
-				  data += (S->max_nv * sizeof(uint8_t));
-				  break;
-
-				default:
-				  LOG_W_A("Umm...what letter was that?\ndescription_string: %s", description_string);
-				  return json_rpc_error(-32603, rtn, allocator);
+static const char * reduction_ops[] = {
+  "sum", "count", "mean", "min", "max", "count_above", "summary", "histogram", "by_vtype", NULL
+};
 
+/* Answers op for each field in summary (or only the one named by field)
+ * from the aggregates StingerMon keeps per batch. "sum" is the sum of the
+ * positive values, as it always has been. */
+int
+array_to_json_reduction    (stinger_t * S,
+                rapidjson::Value& rtn,
+                rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>& allocator,
+                const std::vector<StingerFieldSummary> & summary,
+                uint8_t * data,
+                const char * algorithm_name,
+                const char * field,
+                const char * op,
+                double threshold
+                )
+{
+  bool known = false;
+  for (const char ** o = reduction_ops; *o && !known; o++)
+    known = (0 == strcmp(op, *o));
+  if (!known) {
+    LOG_W_A("Unknown reduction %s", op);
+    return json_rpc_error(-32602, rtn, allocator);
+  }
+
+  rapidjson::Value fields (rapidjson::kArrayType);
+  int64_t nv = S->max_nv;
+
+  for (size_t f = 0; f < summary.size(); f++) {
+    const StingerFieldSummary & s = summary[f];
+    uint8_t * field_data = data;
+    switch (s.type) {
+      case 'f': data += S->max_nv * sizeof(float); break;
+      case 'd': data += S->max_nv * sizeof(double); break;
+      case 'i': data += S->max_nv * sizeof(int32_t); break;
+      case 'l': data += S->max_nv * sizeof(int64_t); break;
+      case 'b': data += S->max_nv * sizeof(uint8_t); break;
+    }
+    if (field && s.name != field)
+      continue;
+
+    rapidjson::Value reduction (rapidjson::kObjectType);
+    rapidjson::Value reduction_name;
+    reduction_name.SetString(s.name.c_str(), s.name.size(), allocator);
+    reduction.AddMember("field", reduction_name, allocator);
+
+    if (0 == strcmp(op, "sum")) {
+      if (integer_type(s.type))
+	add_int64(reduction, "value", s.positive_isum, allocator);
+      else
+	add_double(reduction, "value", s.positive_sum, allocator);
+    } else if (0 == strcmp(op, "count")) {
+      add_int64(reduction, "value", s.all.count, allocator);
+    } else if (0 == strcmp(op, "mean")) {
+      double sum = integer_type(s.type) ? (double) s.all.isum : s.all.sum;
+      add_double(reduction, "value", s.all.count ? sum / s.all.count : 0.0, allocator);
+    } else if (0 == strcmp(op, "min") || 0 == strcmp(op, "max")) {
+      if (s.all.count) {
+	add_double(reduction, "value", op[1] == 'i' ? s.all.min : s.all.max, allocator);
+      } else {
+	rapidjson::Value null_val;
+	reduction.AddMember("value", null_val, allocator);
       }
-      off++;
-    
-    pch = strtok_r (NULL, " ", &placeholder);
+    } else if (0 == strcmp(op, "count_above")) {
+      add_int64(reduction, "value", count_above(s.type, field_data, nv, threshold), allocator);
+    } else if (0 == strcmp(op, "summary")) {
+      add_values(reduction, s.all, s.type, allocator);
+      add_int64(reduction, "positive", s.positive, allocator);
+      add_int64(reduction, "negative", s.negative, allocator);
+    } else if (0 == strcmp(op, "histogram")) {
+      /* non-empty bins of |value| by power of two */
+      rapidjson::Value bins (rapidjson::kArrayType);
+      for (int64_t b = 0; b < STINGER_SUMMARY_HIST_BINS; b++) {
+	if (!s.hist[b])
+	  continue;
+	rapidjson::Value bin (rapidjson::kObjectType);
+	if (b == 0) {
+	  add_double(bin, "min", 0.0, allocator);
+	  add_double(bin, "max", 0.0, allocator);
+	} else {
+	  int64_t e = b - 1 - STINGER_SUMMARY_HIST_BIAS;
+	  add_double(bin, "min", ldexp(1.0, e), allocator);
+	  add_double(bin, "max", ldexp(1.0, e + 1), allocator);
+	}
+	add_int64(bin, "count", s.hist[b], allocator);
+	bins.PushBack(bin, allocator);
+      }
+      reduction.AddMember("histogram", bins, allocator);
+      add_int64(reduction, "negative", s.negative, allocator);
+    } else if (0 == strcmp(op, "by_vtype")) {
+      rapidjson::Value groups (rapidjson::kArrayType);
+      for (size_t t = 0; t < s.by_vtype.size(); t++) {
+	if (!s.by_vtype[t].count)
+	  continue;
+	rapidjson::Value group (rapidjson::kObjectType), vtype_str;
+	add_int64(group, "vtype", t, allocator);
+	char * vtype_name = stinger_vtype_names_lookup_name(S, t);
+	if (vtype_name) {
+	  vtype_str.SetString(vtype_name, strlen(vtype_name), allocator);
+	  group.AddMember("vtype_str", vtype_str, allocator);
+	}
+	add_values(group, s.by_vtype[t], s.type, allocator);
+	groups.PushBack(group, allocator);
+      }
+      reduction.AddMember("groups", groups, allocator);
+    }
+
+    fields.PushBack(reduction, allocator);
   }
 
-  free(tmp);
-  rtn.AddMember(algorithm_name, fields, allocator);
+  if (field && fields.Size() == 0) {
+    LOG_W_A("No field %s in %s", field, algorithm_name);
+    return json_rpc_error(-32602, rtn, allocator);
+  }
 
+  rtn.AddMember(algorithm_name, fields, allocator);
   return 0;
 }
@@ -8,6 +8,7 @@
 #include "stinger_core/stinger_error.h"
 extern "C" {
   #include "stinger_alg/community_on_demand.h"
+  #include "stinger_alg/louvain.h"
 }
 
 using namespace gt::stinger;
@@ -16,9 +17,13 @@ int64_t
 JSON_RPC_community_on_demand::operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator)
 {
   bool strings;
+  int64_t levels;
+  int64_t iterations;
 
   rpc_params_t p[] = {
     {"strings", TYPE_BOOL, &strings, true, 0},
+    {"levels", TYPE_INT64, &levels, true, LOUVAIN_DEFAULT_LEVELS},
+    {"iterations", TYPE_INT64, &iterations, true, LOUVAIN_DEFAULT_ITERATIONS},
     {NULL, TYPE_NONE, NULL, false, 0}
   };
 
@@ -41,7 +46,7 @@ JSON_RPC_community_on_demand::operator()(rapidjson::Value * params, rapidjson::V
   int64_t * vertices = NULL;
   int64_t * partitions = NULL;
 
-  int64_t num_vertices = community_on_demand(S, &vertices, &partitions);
+  int64_t num_vertices = community_on_demand_louvain(S, &vertices, &partitions, levels, iterations);
 
   for (int64_t i = 0; i < num_vertices; i++) {
     name.SetInt64(vertices[i]);
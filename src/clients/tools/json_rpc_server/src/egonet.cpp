@@ -18,6 +18,8 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
   bool get_etypes;
   bool get_vtypes;
   bool incident_edges;
+  int64_t k;
+  int64_t etype_filter;
 
   rpc_params_t p[] = {
     {"source", TYPE_VERTEX, &source, false, 0},
@@ -26,10 +28,12 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
     {"get_etypes", TYPE_BOOL, &get_etypes, true, 0},
     {"get_vtypes", TYPE_BOOL, &get_vtypes, true, 0},
     {"incident_edges", TYPE_BOOL, &incident_edges, true, 0},
+    {"k", TYPE_INT64, &k, true, 1},
+    {"etype", TYPE_EDGE_TYPE, &etype_filter, true, -1},
     {NULL, TYPE_NONE, NULL, false, 0}
   };
 
-  if (!contains_params(p, params)) {
+  if (!contains_params(p, params) || k < 1) {
     return json_rpc_error(-32602, result, allocator);
   }
 
@@ -61,7 +65,6 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
 
   /* values to hold vertex information */
   rapidjson::Value vtype, vtype_str;
-  rapidjson::Value center, center_str;
   rapidjson::Value src, dst;
   rapidjson::Value src_str, dst_str;
   rapidjson::Value etype, etype_str;
@@ -78,39 +81,35 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
     result.AddMember("egonet", edges, allocator);
     return 0;
   }
- 
-  /* this array will hold the neighbor set */
-  int64_t nv = S->max_nv;
-  int64_t * marks = (int64_t *) xmalloc (nv * sizeof(int64_t));
-  for (int64_t i = 0; i < nv; i++) {
-    marks[i] = 0;
-  }
 
-  /* mark and insert source if we are returning incident edges */
-  if (incident_edges) {
-    marks[source] = 1;
-    center.SetInt64(source);
-    vtx.PushBack(center, allocator);
-    
+  /* the neighborhood is shared by every call for this source until a
+     batch changes it */
+  Neighborhood hood;
+  server_state->get_neighborhood_cache().get(S, server_state->get_epoch(), source, k, etype_filter, hood);
+
+  /* the source comes first, and only with its incident edges */
+  for (size_t i = incident_edges ? 0 : 1; i < hood.vertices.size(); i++) {
+    int64_t u = hood.vertices[i];
+    src.SetInt64(u);
+    vtx.PushBack(src, allocator);
+
     if (strings) {
       char * physID;
       uint64_t len;
-      if (-1 == stinger_mapping_physid_direct(S, source, &physID, &len)) {
+      if (-1 == stinger_mapping_physid_direct(S, u, &physID, &len)) {
         physID = (char *) "";
         len = 0;
       }
-      center_str.SetString(physID, len, allocator);
-      vtx_str.PushBack(center_str, allocator);
+      src_str.SetString(physID, len, allocator);
+      vtx_str.PushBack(src_str, allocator);
     }
 
     if (get_vtypes) {
-      int64_t source_type = stinger_vtype_get(S, source);
+      int64_t source_type = stinger_vtype_get(S, u);
       vtype.SetInt64(source_type);
       vtypes.PushBack(vtype, allocator);
 
       if (strings) {
-        char * name = NULL;
-        uint64_t len = 0;
         char * vtype_name = stinger_vtype_names_lookup_name(S, source_type);
         vtype_str.SetString(vtype_name, strlen(vtype_name), allocator);
         vtypes_str.PushBack(vtype_str, allocator);
@@ -118,12 +117,23 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
     }
   }
 
-  /* mark all neighbors of the source vertex */
-  STINGER_FORALL_EDGES_OF_VTX_BEGIN (S, source) {
-    int64_t u = STINGER_EDGE_DEST;
-    marks[u] = 1;
+  for (size_t i = 0; i < hood.edges.size(); i += 3) {
+    int64_t u = hood.edges[i];
+    int64_t v = hood.edges[i+1];
+    int64_t t = hood.edges[i+2];
+    if (!incident_edges && (u == source || v == source))
+      continue;
+
     src.SetInt64(u);
-    vtx.PushBack(src, allocator);
+    dst.SetInt64(v);
+    val.SetArray();
+    val.PushBack(src, allocator);
+    val.PushBack(dst, allocator);
+    if (get_etypes) {
+      etype.SetInt64(t);
+      val.PushBack(etype, allocator);
+    }
+    edges.PushBack(val, allocator);
 
     if (strings) {
       char * physID;
@@ -133,112 +143,23 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
         len = 0;
       }
       src_str.SetString(physID, len, allocator);
-      vtx_str.PushBack(src_str, allocator);
-    }
 
-    if (incident_edges && STINGER_IS_OUT_EDGE) {
-      src.SetInt64(source);
-      dst.SetInt64(u);
+      if (-1 == stinger_mapping_physid_direct(S, v, &physID, &len)) {
+        physID = (char *) "";
+        len = 0;
+      }
+      dst_str.SetString(physID, len, allocator);
       val.SetArray();
-      val.PushBack(src, allocator);
-      val.PushBack(dst, allocator);
+      val.PushBack(src_str, allocator);
+      val.PushBack(dst_str, allocator);
       if (get_etypes) {
-        etype.SetInt64(STINGER_EDGE_TYPE);
-        val.PushBack(etype, allocator);
-      }
-      edges.PushBack(val, allocator);
-
-      if (strings) {
-        char * physID;
-        uint64_t len;
-        if (-1 == stinger_mapping_physid_direct(S, source, &physID, &len)) {
-          physID = (char *) "";
-          len = 0;
-        }
-        src_str.SetString(physID, len, allocator);
-
-        if (-1 == stinger_mapping_physid_direct(S, u, &physID, &len)) {
-          physID = (char *) "";
-          len = 0;
-        }
-        dst_str.SetString(physID, len, allocator);
-
-        val.SetArray();
-        val.PushBack(src_str, allocator);
-        val.PushBack(dst_str, allocator);
-        if (get_etypes) {
-          char * etype_str_ptr = stinger_etype_names_lookup_name(S, STINGER_EDGE_TYPE);
-          etype_str.SetString(etype_str_ptr, strlen(etype_str_ptr), allocator);
-          val.PushBack(etype_str, allocator);
-        }
-        edges_str.PushBack(val, allocator);
+        char * etype_str_ptr = stinger_etype_names_lookup_name(S, t);
+        etype_str.SetString(etype_str_ptr, strlen(etype_str_ptr), allocator);
+        val.PushBack(etype_str, allocator);
       }
+      edges_str.PushBack(val, allocator);
     }
-    
-    if (get_vtypes) {
-      int64_t source_type = stinger_vtype_get(S, u);
-      vtype.SetInt64(source_type);
-      vtypes.PushBack(vtype, allocator);
-
-      if (strings) {
-        char * name = NULL;
-        uint64_t len = 0;
-        char * vtype_name = stinger_vtype_names_lookup_name(S, source_type);
-        vtype_str.SetString(vtype_name, strlen(vtype_name), allocator);
-        vtypes_str.PushBack(vtype_str, allocator);
-      }
-    }
-
-  } STINGER_FORALL_EDGES_OF_VTX_END();
-
-  /* now we will find all of the edges in common between the neighbors */
-  STINGER_FORALL_EDGES_OF_VTX_BEGIN (S, source) {
-    int64_t u = STINGER_EDGE_DEST;
-
-    STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN (S, u) {
-      int64_t v = STINGER_EDGE_DEST;
-
-      if (marks[v]) {
-        src.SetInt64(u);
-        dst.SetInt64(v);
-        val.SetArray();
-        val.PushBack(src, allocator);
-        val.PushBack(dst, allocator);
-        if (get_etypes) {
-          etype.SetInt64(STINGER_EDGE_TYPE);
-          val.PushBack(etype, allocator);
-        }
-        edges.PushBack(val, allocator);
-
-        if (strings) {
-          char * physID;
-          uint64_t len;
-          if (-1 == stinger_mapping_physid_direct(S, u, &physID, &len)) {
-            physID = (char *) "";
-            len = 0;
-          }
-          src_str.SetString(physID, len, allocator);
-
-          if (-1 == stinger_mapping_physid_direct(S, v, &physID, &len)) {
-            physID = (char *) "";
-            len = 0;
-          }
-          dst_str.SetString(physID, len, allocator);
-          val.SetArray();
-          val.PushBack(src_str, allocator);
-          val.PushBack(dst_str, allocator);
-          if (get_etypes) {
-            char * etype_str_ptr = stinger_etype_names_lookup_name(S, STINGER_EDGE_TYPE);
-            etype_str.SetString(etype_str_ptr, strlen(etype_str_ptr), allocator);
-            val.PushBack(etype_str, allocator);
-          }
-          edges_str.PushBack(val, allocator);
-        }
-      }
-
-    } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
-  } STINGER_FORALL_EDGES_OF_VTX_END();
-
+  }
 
   result.AddMember("vertices", vtx, allocator);
   if (strings) {
@@ -257,9 +178,6 @@ JSON_RPC_egonet::operator()(rapidjson::Value * params, rapidjson::Value & result
     result.AddMember("egonet_str", edges_str, allocator);
   }
 
-
-  free(marks);
-
   return 0;
 }
 
@@ -9,6 +9,7 @@
 #include "stinger_core/stinger_error.h"
 
 #include "stinger_core/xmalloc.h"
+#include "stinger_utils/timer.h"
 #include "rapidjson/document.h"
 #include "json_rpc_server.h"
 #include "json_rpc.h"
@@ -16,15 +17,28 @@
 
 using namespace gt::stinger;
 
+/* longest a request may search; clients can only ask for less */
+#define DIAMETER_MAX_TIMEOUT_MS 10000
+
+/* stops the search once the request has used up its time */
+static bool
+diameter_deadline(void * arg, int64_t lower, int64_t upper, int64_t searches)
+{
+    double deadline = *(double *)arg;
+    return timer() < deadline;
+}
 
 int64_t
 JSON_RPC_exact_diameter::operator()(rapidjson::Value * params, rapidjson::Value & result, rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator> & allocator)
 {
-    params_array_t vertices;
-    bool strings;
+    bool weighted;
+    int64_t timeout;
+    int64_t samples;
 
     rpc_params_t p[] = {
-            {"strings", TYPE_BOOL, &strings, true, 0},
+            {"weighted", TYPE_BOOL, &weighted, true, 0},
+            {"timeout", TYPE_INT64, &timeout, true, 0},
+            {"samples", TYPE_INT64, &samples, true, 0},
             {NULL, TYPE_NONE, NULL, false, 0}
     };
 
@@ -38,65 +52,47 @@ JSON_RPC_exact_diameter::operator()(rapidjson::Value * params, rapidjson::Value
         return json_rpc_error(-32603, result, allocator);
     }
 
-    //uint8_t * vtx_subset = (uint8_t *)xcalloc(S->max_nv,sizeof(uint8_t));
+    if (timeout <= 0 || timeout > DIAMETER_MAX_TIMEOUT_MS)
+        timeout = DIAMETER_MAX_TIMEOUT_MS;
 
-    //for (int64_t i = 0; i < vertices.len; i++) {
-        //vtx_subset[vertices.arr[i]] = 1;
-    //}
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    double deadline = timer() + (double)timeout / 1000.0;
+    diameter_progress_fn progress = diameter_deadline;
 
-    double * pr = (double *)xcalloc(S->max_nv,sizeof(double));
-    OMP("omp parallel for")
-    for(uint64_t i = 0; i < vertices.len; i++) {
-        pr[vertices.arr[i]] = 1 / ((double)vertices.len);
+    diameter_bounds_t bounds;
+    if (weighted) {
+        exact_diameter(S, nv, &bounds, progress, &deadline);
+    } else {
+        ifub_diameter(S, nv, &bounds, progress, &deadline);
     }
 
-    //double * tmp_pr = (double *)xcalloc(S->max_nv, sizeof(double));
-
-    //double epsilon = EPSILON_DEFAULT;
-    //double dampingfactor = DAMPINGFACTOR_DEFAULT;
-    //int64_t maxiter = MAXITER_DEFAULT;
-    int64_t diam;
-    diam = exact_diameter((stinger_t *)S, (int64_t)S->max_nv);
-
-    //page_rank_subset((stinger_t *)S, (int64_t)S->max_nv, (uint8_t *)vtx_subset, (int64_t)vertices.len,
-                     //(double *)pr, (double *)tmp_pr,
-                     //(double)epsilon, (double)dampingfactor, (int64_t)maxiter);
-
-    //xfree(tmp_pr);
-    //xfree(vtx_subset);
-
     // CREATE the JSON
-    rapidjson::Value vertex_id_json(rapidjson::kArrayType);
-    rapidjson::Value value_json(rapidjson::kArrayType);
-    //rapidjson::Value pagerank_json (rapidjson::kObjectType);
     rapidjson::Value diameter (rapidjson::kNumberType);
-    rapidjson::Value vtx_str (rapidjson::kArrayType);
-    rapidjson::Value vtx_phys;
-
-    for (uint64_t i = 0; i < vertices.len; i++) {
-        uint64_t vtx = vertices.arr[i];
-        vertex_id_json.PushBack(vtx,allocator);
-        value_json.PushBack(pr[vtx],allocator);
-        if (strings) {
-            char * physID;
-            uint64_t len;
-            if(-1 == stinger_mapping_physid_direct(S, vtx, &physID, &len)) {
-                physID = (char *) "";
-                len = 0;
-            }
-            vtx_phys.SetString(physID, len, allocator);
-            vtx_str.PushBack(vtx_phys, allocator);
-        }
-    }
-    diameter = diam;
+    rapidjson::Value lower (rapidjson::kNumberType);
+    rapidjson::Value upper (rapidjson::kNumberType);
+    rapidjson::Value searches (rapidjson::kNumberType);
+    rapidjson::Value complete (rapidjson::kTrueType);
+
+    diameter = bounds.lower;
+    lower = bounds.lower;
+    upper = bounds.upper;
+    searches = bounds.searches;
+    complete.SetBool(bounds.complete);
     result.AddMember("exact diameter", diameter, allocator);
-    //pagerank_json.AddMember("vertex_id", vertex_id_json, allocator);
-    //pagerank_json.AddMember("value", value_json, allocator);
-    //if (strings)
-        //pagerank_json.AddMember("vertex_str", vtx_str, allocator);
-
-    //result.AddMember("pagerank",pagerank_json,allocator);
+    result.AddMember("lower", lower, allocator);
+    result.AddMember("upper", upper, allocator);
+    result.AddMember("searches", searches, allocator);
+    result.AddMember("complete", complete, allocator);
+
+    if (samples > 0) {
+        double half_width;
+        rapidjson::Value mean (rapidjson::kNumberType);
+        rapidjson::Value error (rapidjson::kNumberType);
+        mean.SetDouble(mean_shortest_path_sampled(S, nv, samples, (uint64_t)samples, !weighted, &half_width));
+        error.SetDouble(half_width);
+        result.AddMember("mean shortest path", mean, allocator);
+        result.AddMember("mean shortest path error", error, allocator);
+    }
 
-    xfree(pr);
     return 0;
-}
\ No newline at end of file
+}
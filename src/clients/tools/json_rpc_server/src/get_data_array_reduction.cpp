@@ -13,9 +13,13 @@ JSON_RPC_get_data_array_reduction::operator()(rapidjson::Value * params, rapidjs
 {
   char * algorithm_name;
   char * reduce_op;
+  char * data_array_name;
+  double threshold;
   rpc_params_t p[] = {
     {"name", TYPE_STRING, &algorithm_name, false, 0},
     {"op", TYPE_STRING, &reduce_op, false, 0},
+    {"data", TYPE_STRING, &data_array_name, true, 0},
+    {"threshold", TYPE_DOUBLE, &threshold, true, 0},
     {NULL, TYPE_NONE, NULL, false, 0}
   };
 
@@ -28,15 +32,26 @@ JSON_RPC_get_data_array_reduction::operator()(rapidjson::Value * params, rapidjs
       LOG_E ("Algorithm is not running");
       return json_rpc_error(-32003, result, allocator);
     }
-    result.AddMember("time", max_time_seen, allocator);
-    return array_to_json_reduction (
+    /* aggregated once per batch by StingerMon */
+    const std::vector<StingerFieldSummary> * summary = server_state->get_alg_summary(algorithm_name);
+    if (!summary) {
+      LOG_E ("Algorithm has no data");
+      return json_rpc_error(-32003, result, allocator);
+    }
+    int64_t rtn = array_to_json_reduction (
 	server_state->get_stinger(),
 	result,
 	allocator,
-	alg_state->data_description.c_str(),
+	*summary,
 	(uint8_t *) alg_state->data,
-	algorithm_name
+	algorithm_name,
+	data_array_name,
+	reduce_op,
+	threshold
     );
+    if (!rtn)
+      result.AddMember("time", max_time_seen, allocator);
+    return rtn;
   } else {
     return json_rpc_error(-32602, result, allocator);
   }
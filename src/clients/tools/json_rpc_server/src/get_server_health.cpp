@@ -66,6 +66,77 @@ JSON_RPC_get_server_health::operator()(rapidjson::Value * params, rapidjson::Val
   max_time_seen.SetInt64(server_state->get_max_time());
   result.AddMember("time", max_time_seen, allocator);
 
+  /* Batch being read, and batches still mapped for running queries */
+  rapidjson::Value epoch;
+  epoch.SetInt64(server_state->get_epoch());
+  result.AddMember("batch", epoch, allocator);
+
+  rapidjson::Value live_epochs;
+  live_epochs.SetInt64(server_state->get_live_epochs());
+  result.AddMember("live_batches", live_epochs, allocator);
+
+  /* Result cache */
+  result_cache_stats_t cache_stats = server_state->get_result_cache_stats();
+  rapidjson::Value result_cache(rapidjson::kObjectType), cache_val;
+  cache_val.SetInt64(cache_stats.entries);
+  result_cache.AddMember("entries", cache_val, allocator);
+  cache_val.SetInt64(cache_stats.bytes);
+  result_cache.AddMember("bytes", cache_val, allocator);
+  cache_val.SetInt64(cache_stats.max_bytes);
+  result_cache.AddMember("max_bytes", cache_val, allocator);
+  cache_val.SetInt64(cache_stats.hits);
+  result_cache.AddMember("hits", cache_val, allocator);
+  cache_val.SetInt64(cache_stats.misses);
+  result_cache.AddMember("misses", cache_val, allocator);
+  cache_val.SetDouble(cache_stats.hits + cache_stats.misses > 0 ?
+    (double) cache_stats.hits / (double) (cache_stats.hits + cache_stats.misses) : 0.0);
+  result_cache.AddMember("hit_rate", cache_val, allocator);
+  cache_val.SetInt64(cache_stats.evictions);
+  result_cache.AddMember("evictions", cache_val, allocator);
+  result.AddMember("result_cache", result_cache, allocator);
+
+  /* Neighborhood cache */
+  neighborhood_cache_stats_t hood_stats = server_state->get_neighborhood_cache().get_stats();
+  rapidjson::Value hood_cache(rapidjson::kObjectType), hood_val;
+  hood_val.SetInt64(hood_stats.entries);
+  hood_cache.AddMember("entries", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.bytes);
+  hood_cache.AddMember("bytes", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.max_bytes);
+  hood_cache.AddMember("max_bytes", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.hits);
+  hood_cache.AddMember("hits", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.misses);
+  hood_cache.AddMember("misses", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.invalidations);
+  hood_cache.AddMember("invalidations", hood_val, allocator);
+  hood_val.SetInt64(hood_stats.evictions);
+  hood_cache.AddMember("evictions", hood_val, allocator);
+  result.AddMember("neighborhood_cache", hood_cache, allocator);
+
+  /* Shared memory mappings of STINGER and algorithm data */
+  snapshot_stats_t map_stats = server_state->get_snapshots().get_stats();
+  rapidjson::Value snapshots(rapidjson::kObjectType), map_val;
+  map_val.SetInt64(map_stats.mappings);
+  snapshots.AddMember("mappings", map_val, allocator);
+  map_val.SetInt64(map_stats.mapped_bytes);
+  snapshots.AddMember("mapped_bytes", map_val, allocator);
+  map_val.SetInt64(map_stats.maps);
+  snapshots.AddMember("maps", map_val, allocator);
+  map_val.SetInt64(map_stats.reuses);
+  snapshots.AddMember("reuses", map_val, allocator);
+  map_val.SetInt64(map_stats.unmaps);
+  snapshots.AddMember("unmaps", map_val, allocator);
+  map_val.SetDouble(map_stats.map_seconds * 1.0e3);
+  snapshots.AddMember("map_millis", map_val, allocator);
+  map_val.SetDouble(map_stats.last_map_seconds * 1.0e3);
+  snapshots.AddMember("last_map_millis", map_val, allocator);
+  map_val.SetInt64(map_stats.populated_bytes);
+  snapshots.AddMember("populated_bytes", map_val, allocator);
+  map_val.SetDouble(map_stats.populate_seconds * 1.0e3);
+  snapshots.AddMember("populate_millis", map_val, allocator);
+  result.AddMember("snapshots", snapshots, allocator);
+
   /* Number of vertices */
   rapidjson::Value nv;
   nv.SetInt64(stinger_num_active_vertices(S));
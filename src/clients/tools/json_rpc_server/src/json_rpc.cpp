@@ -3,6 +3,8 @@
 #include <cstring>
 #include <algorithm>
 #include <functional>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include "stinger_core/xmalloc.h"
@@ -22,6 +24,64 @@ extern "C" {
 
 using namespace gt::stinger;
 
+static bool
+compare_member_names(const rapidjson::Value::Member * a, const rapidjson::Value::Member * b)
+{
+  return strcmp(a->name.GetString(), b->name.GetString()) < 0;
+}
+
+/* Appends v to key with object members in name order, so that requests
+ * differing only in member order share a cache entry. Strings are length
+ * prefixed; the key is not JSON. */
+static void
+json_rpc_canonical_key(const rapidjson::Value & v, std::string & key)
+{
+  char buf[64];
+  switch (v.GetType()) {
+    case rapidjson::kNullType:
+      key += 'n';
+      break;
+    case rapidjson::kFalseType:
+      key += 'f';
+      break;
+    case rapidjson::kTrueType:
+      key += 't';
+      break;
+    case rapidjson::kStringType:
+      snprintf(buf, sizeof(buf), "s%lu:", (unsigned long) v.GetStringLength());
+      key += buf;
+      key.append(v.GetString(), v.GetStringLength());
+      break;
+    case rapidjson::kNumberType:
+      if (v.IsInt64())
+        snprintf(buf, sizeof(buf), "i%ld;", (long) v.GetInt64());
+      else if (v.IsUint64())
+        snprintf(buf, sizeof(buf), "u%lu;", (unsigned long) v.GetUint64());
+      else
+        snprintf(buf, sizeof(buf), "d%.17g;", v.GetDouble());
+      key += buf;
+      break;
+    case rapidjson::kArrayType:
+      key += '[';
+      for (rapidjson::SizeType i = 0; i < v.Size(); i++)
+        json_rpc_canonical_key(v[i], key);
+      key += ']';
+      break;
+    case rapidjson::kObjectType: {
+      std::vector<const rapidjson::Value::Member *> members;
+      for (rapidjson::Value::ConstMemberIterator it = v.MemberBegin(); it != v.MemberEnd(); it++)
+        members.push_back(&(*it));
+      std::sort(members.begin(), members.end(), compare_member_names);
+      key += '{';
+      for (size_t i = 0; i < members.size(); i++) {
+        json_rpc_canonical_key(members[i]->name, key);
+        json_rpc_canonical_key(members[i]->value, key);
+      }
+      key += '}';
+    } break;
+  }
+}
+
 
 void
 json_rpc_process_request (rapidjson::Document& document, rapidjson::Document& response)
@@ -165,16 +225,62 @@ json_rpc_process_request (rapidjson::Document& document, rapidjson::Document& re
     server_state.wait_for_sync();
   }
 
+  /* the whole call keeps the mappings and caches of the epoch pinned here,
+     though the data under them may change as batches arrive */
   server_state.get_alg_read_lock();
+  JSON_RPCFunction * function = server_state.get_rpc_function(method_str);
+  int64_t epoch = server_state.get_epoch();
+  int64_t max_time = server_state.get_max_time();
+
+  /* repeated calls within a batch are answered from the result cache */
+  std::string cache_key, cached;
+  bool hit = false;
+  if (function->cacheable()) {
+    cache_key = method_str;
+    cache_key += '\0';
+    if (params)
+      json_rpc_canonical_key(*params, cache_key);
+    if (server_state.get_cached_result(cache_key, epoch, cached)) {
+      /* parse into the response's allocator so the values outlive cached_doc */
+      rapidjson::Document cached_doc(&allocator);
+      cached_doc.Parse<0>(cached.c_str());
+      if (!cached_doc.HasParseError()) {
+        result = static_cast<rapidjson::Value &>(cached_doc);
+        hit = true;
+      }
+    }
+  }
+
   /* call the function */
   response.AddMember("jsonrpc", "2.0", allocator);
-  if ((*server_state.get_rpc_function(method_str))(params, result, allocator)) {
+  if (hit) {
+    response.AddMember("result", result, allocator);
+  }
+  else if ((*function)(params, result, allocator)) {
     response.AddMember("error", result, allocator);
   }
   else {
+    if (function->cacheable()) {
+      rapidjson::StringBuffer out_buf;
+      rapidjson::Writer<rapidjson::StringBuffer> writer(out_buf);
+      result.Accept(writer);
+      server_state.put_cached_result(cache_key, epoch, std::string(out_buf.GetString(), out_buf.Size()));
+    }
     response.AddMember("result", result, allocator);
   }
   response.AddMember("id", id, allocator);
+
+  /* a long poll pins a newer epoch while it waits; report that one */
+  epoch = server_state.get_epoch();
+  max_time = server_state.get_max_time();
+
+  rapidjson::Value snapshot(rapidjson::kObjectType), batch, time;
+  /* the batch pinned when the function returned, not a consistent version */
+  batch.SetInt64(epoch);
+  snapshot.AddMember("batch", batch, allocator);
+  time.SetInt64(max_time);
+  snapshot.AddMember("time", time, allocator);
+  response.AddMember("snapshot", snapshot, allocator);
   server_state.release_alg_read_lock();
 
 }
@@ -232,9 +338,14 @@ json_rpc_error (int32_t error_code, rapidjson::Value& err_obj, rapidjson::Memory
       {
 	message.SetString("Unknown algorithm");
       } break;
+
+    case (-32004):
+      {
+	message.SetString("Too many waiting requests");
+      } break;
   }
 
-  if ( (error_code <= -32004) && (error_code >= -32099)) {
+  if ( (error_code <= -32005) && (error_code >= -32099)) {
     message.SetString("Server error");
   }
 
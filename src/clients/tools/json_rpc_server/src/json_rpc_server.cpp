@@ -11,10 +11,9 @@
 #include "stinger_core/xmalloc.h"
 #include "rapidjson/document.h"
 #include "rapidjson/rapidjson.h"
-#include "rapidjson/stringbuffer.h"
-#include "rapidjson/prettywriter.h"
 #include "json_rpc_server.h"
 #include "json_rpc.h"
+#include "rpc_response.h"
 #include "rpc_state.h"
 #include "mon_handling.h"
 #include "session_handling.h"
@@ -25,28 +24,6 @@
 using namespace gt::stinger;
 
 
-static int
-send_response(struct mg_connection *conn, rapidjson::Document& response)
-{
-  /* format the response */
-  rapidjson::StringBuffer out_buf;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(out_buf);
-  response.Accept(writer);
-
-  const char * out_ch = out_buf.GetString();
-  int out_len = out_buf.Size();
-
-  /* send the response */
-  return  mg_printf(conn,
-	    "HTTP/1.1 200 OK\r\n"
-	    "Content-Type: text/plain\r\n"
-	    "Content-Length: %d\r\n"        // Always set Content-Length
-	    "Access-Control-Allow-Origin: *\r\n"
-	    "\r\n"
-	    "%s",
-	    out_len, out_ch);
-}
-
 static int
 create_error(rapidjson::Document& response)
 {
@@ -93,7 +70,7 @@ begin_request_handler(struct mg_connection *conn)
       
       /* send an error back */
       create_error(output);
-      send_response(conn, output);
+      json_rpc_send_response(conn, output);
 
       free(storage);
       return -1;
@@ -105,6 +82,11 @@ begin_request_handler(struct mg_connection *conn)
     input.Parse<0>((char *)storage);
     free(storage);
 
+    /* numeric arrays can skip JSON altogether */
+    if (json_rpc_wants_binary(conn) && json_rpc_send_binary(conn, input)) {
+      return 1;
+    }
+
     /* process the request */
     json_rpc_process_request(input, output);
     
@@ -116,7 +98,13 @@ begin_request_handler(struct mg_connection *conn)
     rapidjson::Document::AllocatorType& allocator = output.GetAllocator();
     output.AddMember("millis", exec_time, allocator);
 
-    return send_response(conn, output);
+    json_rpc_send_response(conn, output);
+    return 1;
+  }
+
+  /* pushes session updates as server-sent events */
+  if (strncmp(request_info->uri, "/events", 7)==0) {
+    return json_rpc_stream_events(conn) ? 1 : 0;
   }
 
   return 0;
@@ -127,27 +115,72 @@ int
 main (int argc, char ** argv)
 {
   int unleash_daemon = 0;
+  const char * num_threads = "50";
+  int64_t cache_mb = 64;
+  int64_t hood_mb = 64;
+  int64_t max_sessions = 1024;
 
   int opt = 0;
-  while(-1 != (opt = getopt(argc, argv, "h?d"))) {
+  while(-1 != (opt = getopt(argc, argv, "h?dt:c:k:s:"))) {
     switch(opt) {
       default: {
 	LOG_E_A("Unknown option %c", opt);
       } /* no break */
       case '?':
       case 'h': {
-	printf("Usage: %s [-d]\n", argv[0]);
+	printf("Usage: %s [-d] [-t threads] [-c cache_mb] [-k neighborhood_mb] [-s sessions]\n", argv[0]);
 	printf("-d\tdaemon mode\n");
+	printf("-t\tworker threads executing requests, at most half holding long polls and event streams (default: %s)\n", num_threads);
+	printf("-c\tMiB of results cached per batch, 0 to disable (default: %ld)\n", (long) cache_mb);
+	printf("-k\tMiB of egonet neighborhoods cached across batches, 0 to disable (default: %ld)\n", (long) hood_mb);
+	printf("-s\tmaximum number of open sessions (default: %ld)\n", (long) max_sessions);
 	exit(-1);
       } break;
 	
       case 'd': {
 	unleash_daemon = 1;
       } break;
+
+      case 't': {
+	if (atoi(optarg) < 1) {
+	  LOG_E_A("Invalid number of threads %s", optarg);
+	  exit(-1);
+	}
+	num_threads = optarg;
+      } break;
+
+      case 's': {
+	max_sessions = atol(optarg);
+	if (max_sessions < 1) {
+	  LOG_E_A("Invalid number of sessions %s", optarg);
+	  exit(-1);
+	}
+      } break;
+
+      case 'c': {
+	cache_mb = atol(optarg);
+	if (cache_mb < 0) {
+	  LOG_E_A("Invalid cache size %s", optarg);
+	  exit(-1);
+	}
+      } break;
+
+      case 'k': {
+	hood_mb = atol(optarg);
+	if (hood_mb < 0) {
+	  LOG_E_A("Invalid cache size %s", optarg);
+	  exit(-1);
+	}
+      } break;
     }
   }
 
   JSON_RPCServerState & server_state = JSON_RPCServerState::get_server_state();
+  server_state.set_result_cache_size(cache_mb << 20);
+  server_state.get_neighborhood_cache().set_size(hood_mb << 20);
+  server_state.set_max_sessions(max_sessions);
+  /* long polls and event streams may take half the workers */
+  server_state.set_max_push_waiters(atoi(num_threads) / 2);
   server_state.add_rpc_function("get_algorithms", new JSON_RPC_get_algorithms(&server_state));
   server_state.add_rpc_function("get_data_description", new JSON_RPC_get_data_description(&server_state));
   server_state.add_rpc_function("get_data_array_range", new JSON_RPC_get_data_array_range(&server_state));
@@ -184,8 +217,10 @@ main (int argc, char ** argv)
   struct mg_context *ctx;
   struct mg_callbacks callbacks;
 
-  // List of options. Last element must be NULL.
-  const char *opts[] = {"listening_ports", "8088", "document_root", "data", NULL};
+  // List of options. Last element must be NULL. Each worker thread runs one
+  // request at a time, pinning the epoch that was current when it began.
+  const char *opts[] = {"listening_ports", "8088", "document_root", "data",
+    "num_threads", num_threads, NULL};
 
   // Prepare callbacks structure. We have only one callback, the rest are NULL.
   memset(&callbacks, 0, sizeof(callbacks));
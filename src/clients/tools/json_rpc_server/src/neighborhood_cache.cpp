@@ -0,0 +1,251 @@
+#include <cstring>
+
+#include "stinger_core/x86_full_empty.h"
+#include "neighborhood_cache.h"
+
+#define LOG_AT_W  /* warning only */
+#include "stinger_core/stinger_error.h"
+
+using namespace gt::stinger;
+
+/* rough cost of indexing one member vertex */
+#define MEMBER_OVERHEAD 64
+
+static void
+visit(int64_t v, int64_t hops, std::map<int64_t, int64_t> & dist, std::vector<int64_t> & next,
+  Neighborhood & out)
+{
+  if (dist.find(v) == dist.end()) {
+    dist[v] = hops;
+    next.push_back(v);
+    out.vertices.push_back(v);
+  }
+}
+
+/* Breadth-first out to k hops in both directions, then the out-edges among
+ * what was reached. hops receives each vertex's distance. */
+static void
+build(stinger_t * S, int64_t seed, int64_t k, int64_t etype, Neighborhood & out, std::vector<int64_t> & hops)
+{
+  std::map<int64_t, int64_t> dist;
+  std::vector<int64_t> frontier, next;
+
+  out.vertices.clear();
+  out.edges.clear();
+  dist[seed] = 0;
+  out.vertices.push_back(seed);
+  frontier.push_back(seed);
+
+  for (int64_t h = 1; h <= k && !frontier.empty(); h++) {
+    next.clear();
+    for (size_t f = 0; f < frontier.size(); f++) {
+      int64_t u = frontier[f];
+      if (etype < 0) {
+	STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, u) {
+	  visit(STINGER_EDGE_DEST, h, dist, next, out);
+	} STINGER_FORALL_EDGES_OF_VTX_END();
+      } else {
+	STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_BEGIN(S, etype, u) {
+	  visit(STINGER_EDGE_DEST, h, dist, next, out);
+	} STINGER_FORALL_EDGES_OF_TYPE_OF_VTX_END();
+      }
+    }
+    frontier.swap(next);
+  }
+
+  hops.resize(out.vertices.size());
+  for (size_t i = 0; i < out.vertices.size(); i++) {
+    int64_t u = out.vertices[i];
+    hops[i] = dist[u];
+    if (etype < 0) {
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+	if (dist.find(STINGER_EDGE_DEST) != dist.end()) {
+	  out.edges.push_back(u);
+	  out.edges.push_back(STINGER_EDGE_DEST);
+	  out.edges.push_back(STINGER_EDGE_TYPE);
+	}
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    } else {
+      STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_BEGIN(S, etype, u) {
+	if (dist.find(STINGER_EDGE_DEST) != dist.end()) {
+	  out.edges.push_back(u);
+	  out.edges.push_back(STINGER_EDGE_DEST);
+	  out.edges.push_back(STINGER_EDGE_TYPE);
+	}
+      } STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_END();
+    }
+  }
+}
+
+NeighborhoodCache::NeighborhoodCache() : valid_epoch(-1), lock(0)
+{
+  memset(&stats, 0, sizeof(stats));
+  stats.max_bytes = 64 << 20;
+}
+
+void
+NeighborhoodCache::get(stinger_t * S, int64_t epoch, int64_t seed, int64_t k, int64_t etype, Neighborhood & out)
+{
+  Key key;
+  key.seed = seed;
+  key.k = k;
+  key.etype = etype;
+
+  /* an entry holds from the epoch it was built in through valid_epoch */
+  readfe((uint64_t *)&lock);
+  if (epoch <= valid_epoch) {
+    std::map<Key, Entry>::iterator it = entries.find(key);
+    if (it != entries.end() && it->second.epoch <= epoch) {
+      out = it->second.hood;
+      lru.splice(lru.begin(), lru, it->second.lru);
+      stats.hits++;
+      writeef((uint64_t *)&lock, 0);
+      return;
+    }
+  }
+  stats.misses++;
+  bool keep = (epoch == valid_epoch && stats.max_bytes > 0);
+  writeef((uint64_t *)&lock, 0);
+
+  std::vector<int64_t> hops;
+  build(S, seed, k, etype, out, hops);
+  if (!keep)
+    return;
+
+  int64_t bytes = sizeof(int64_t) * (out.vertices.size() + out.edges.size()) +
+		  MEMBER_OVERHEAD * out.vertices.size();
+
+  readfe((uint64_t *)&lock);
+  /* a batch may have been applied while building */
+  if (epoch == valid_epoch && bytes <= stats.max_bytes && entries.find(key) == entries.end()) {
+    Entry & e = entries[key];
+    e.hood = out;
+    e.epoch = epoch;
+    e.bytes = bytes;
+    lru.push_front(key);
+    e.lru = lru.begin();
+    stats.bytes += bytes;
+
+    Membership m;
+    m.key = key;
+    for (size_t i = 0; i < out.vertices.size(); i++) {
+      m.hops = hops[i];
+      members[out.vertices[i]].push_back(m);
+    }
+    evict(stats.max_bytes);
+  }
+  writeef((uint64_t *)&lock, 0);
+}
+
+void
+NeighborhoodCache::erase(std::map<Key, Entry>::iterator it)
+{
+  const Key & key = it->first;
+  const std::vector<int64_t> & vertices = it->second.hood.vertices;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    std::map<int64_t, std::vector<Membership> >::iterator m = members.find(vertices[i]);
+    if (m == members.end())
+      continue;
+    std::vector<Membership> & list = m->second;
+    for (size_t j = 0; j < list.size(); j++) {
+      if (!(list[j].key < key) && !(key < list[j].key)) {
+	list[j] = list.back();
+	list.pop_back();
+	break;
+      }
+    }
+    if (list.empty())
+      members.erase(m);
+  }
+
+  stats.bytes -= it->second.bytes;
+  lru.erase(it->second.lru);
+  entries.erase(it);
+}
+
+void
+NeighborhoodCache::evict(int64_t max_bytes)
+{
+  while (stats.bytes > max_bytes && !lru.empty()) {
+    erase(entries.find(lru.back()));
+    stats.evictions++;
+  }
+}
+
+/* An edge changes a neighborhood if it joins two members, or if it leaves
+ * a member short of the boundary and so may reach new vertices. Edge types
+ * are not checked. */
+void
+NeighborhoodCache::touch(int64_t src, int64_t dst, std::vector<Key> & stale)
+{
+  std::map<int64_t, std::vector<Membership> >::iterator ms = members.find(src);
+  std::map<int64_t, std::vector<Membership> >::iterator md = members.find(dst);
+  if (ms == members.end() && md == members.end())
+    return;
+
+  for (int side = 0; side < 2; side++) {
+    std::map<int64_t, std::vector<Membership> >::iterator a = side ? md : ms;
+    std::map<int64_t, std::vector<Membership> >::iterator b = side ? ms : md;
+    if (a == members.end())
+      continue;
+    for (size_t i = 0; i < a->second.size(); i++) {
+      const Membership & m = a->second[i];
+      if (m.hops < m.key.k) {
+	stale.push_back(m.key);
+      } else if (!side && b != members.end()) {
+	for (size_t j = 0; j < b->second.size(); j++) {
+	  if (!(b->second[j].key < m.key) && !(m.key < b->second[j].key)) {
+	    stale.push_back(m.key);
+	    break;
+	  }
+	}
+      }
+    }
+  }
+}
+
+void
+NeighborhoodCache::invalidate(const StingerBatch & batch, int64_t epoch)
+{
+  readfe((uint64_t *)&lock);
+  if (!entries.empty()) {
+    std::vector<Key> stale;
+    for (size_t i = 0; i < batch.insertions_size(); i++) {
+      const EdgeInsertion & in = batch.insertions(i);
+      touch(in.source(), in.destination(), stale);
+    }
+    for (size_t d = 0; d < batch.deletions_size(); d++) {
+      const EdgeDeletion & del = batch.deletions(d);
+      touch(del.source(), del.destination(), stale);
+    }
+
+    for (size_t i = 0; i < stale.size(); i++) {
+      std::map<Key, Entry>::iterator it = entries.find(stale[i]);
+      if (it != entries.end()) {
+	erase(it);
+	stats.invalidations++;
+      }
+    }
+  }
+  valid_epoch = epoch;
+  writeef((uint64_t *)&lock, 0);
+}
+
+void
+NeighborhoodCache::set_size(int64_t max_bytes)
+{
+  readfe((uint64_t *)&lock);
+  stats.max_bytes = max_bytes;
+  evict(max_bytes);
+  writeef((uint64_t *)&lock, 0);
+}
+
+neighborhood_cache_stats_t
+NeighborhoodCache::get_stats()
+{
+  readfe((uint64_t *)&lock);
+  neighborhood_cache_stats_t rtn = stats;
+  rtn.entries = entries.size();
+  writeef((uint64_t *)&lock, 0);
+  return rtn;
+}
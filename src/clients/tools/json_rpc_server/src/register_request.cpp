@@ -61,6 +61,7 @@ JSON_RPC_register::operator()(rapidjson::Value * params, rapidjson::Value & resu
   //session->lock();
   session->onRegister(result, allocator);
   session->unlock();
+  server_state->release_session(session);
 
   LOG_D ("Return");
 
@@ -73,9 +74,11 @@ JSON_RPC_request::operator()(rapidjson::Value * params, rapidjson::Value & resul
 {
   int64_t session_id;
   bool strings;
+  int64_t wait;
   rpc_params_t p[] = {
     {"session_id", TYPE_INT64, &session_id, false, 0},
     {"strings", TYPE_BOOL, &strings, true, 0},
+    {"wait", TYPE_INT64, &wait, true, 0},
     {NULL, TYPE_NONE, NULL, false, 0}
   };
 
@@ -96,6 +99,23 @@ JSON_RPC_request::operator()(rapidjson::Value * params, rapidjson::Value & resul
   json_session_id.SetInt64(session_id);
   result.AddMember("session_id", json_session_id, allocator);
 
+  /* long poll: hold the request up to wait milliseconds for something to
+     report, without keeping the old batch pinned meanwhile */
+  if (wait > 0) {
+    if (!server_state->begin_push_wait()) {
+      server_state->release_session(session);
+      return json_rpc_error(-32004, result, allocator);
+    }
+    server_state->release_alg_read_lock();
+    server_state->wait_for_session(session, wait);
+    server_state->get_alg_read_lock();
+    server_state->end_push_wait();
+    if (server_state->session_closed(session)) {
+      server_state->release_session(session);
+      return json_rpc_error(-32001, result, allocator);
+    }
+  }
+
   LOG_D ("Call the onRequest method for the session");
 
   /* this will send back the edge list to the client */
@@ -107,6 +127,7 @@ JSON_RPC_request::operator()(rapidjson::Value * params, rapidjson::Value & resul
   rapidjson::Value time_since;
   time_since.SetInt64(session->get_time_since());
   result.AddMember("time_since", time_since, allocator);
+  server_state->release_session(session);
 
   LOG_D ("Return");
 
@@ -0,0 +1,483 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
+#include "rpc_response.h"
+#include "rpc_state.h"
+
+#define LOG_AT_W  /* warning only */
+#include "stinger_core/stinger_error.h"
+
+using namespace gt::stinger;
+
+/* bodies shorter than this are not worth compressing */
+#define MIN_COMPRESS_BYTES 1024
+
+/* Does the comma-separated Accept-Encoding header allow coding? Entries with
+ * q=0 refuse it. */
+static bool
+accepts_encoding(const char * header, const char * coding)
+{
+  if (!header)
+    return false;
+
+  size_t coding_len = strlen(coding);
+  const char * p = header;
+  while (*p) {
+    while (*p == ' ' || *p == ',')
+      p++;
+    const char * token = p;
+    while (*p && *p != ',' && *p != ';' && *p != ' ')
+      p++;
+    bool match = ((size_t)(p - token) == coding_len && 0 == strncasecmp(token, coding, coding_len));
+
+    /* parameters up to the next entry */
+    const char * params = p;
+    while (*p && *p != ',')
+      p++;
+    if (match) {
+      const char * q = strstr(params, "q=");
+      if (q && q < p && strtod(q + 2, NULL) == 0.0)
+	return false;
+      return true;
+    }
+  }
+  return false;
+}
+
+ResponseStream::ResponseStream(struct mg_connection * conn, const char * content_type, const char * extra_headers) :
+  conn(conn), content_type(content_type), extra_headers(extra_headers), encoding(ENCODING_IDENTITY),
+  chunked(false), started(false), failed(false), sent(0), len(0)
+{
+  const char * http_version = mg_get_request_info(conn)->http_version;
+  chunkable = (http_version && 0 == strcmp(http_version, "1.1"));
+
+#if defined(STINGER_RPC_USE_ZLIB)
+  zs_init = false;
+  const char * accept = mg_get_header(conn, "Accept-Encoding");
+  if (accepts_encoding(accept, "gzip"))
+    encoding = ENCODING_GZIP;
+  else if (accepts_encoding(accept, "deflate"))
+    encoding = ENCODING_DEFLATE;
+#endif
+}
+
+ResponseStream::~ResponseStream()
+{
+#if defined(STINGER_RPC_USE_ZLIB)
+  if (zs_init)
+    deflateEnd(&zs);
+#endif
+}
+
+void
+ResponseStream::Write(const void * data, size_t n)
+{
+  const char * src = (const char *) data;
+  while (n > 0) {
+    size_t take = sizeof(buf) - len;
+    if (take > n)
+      take = n;
+    memcpy(buf + len, src, take);
+    len += take;
+    src += take;
+    n -= take;
+    if (len == sizeof(buf))
+      flush_buffer(false);
+  }
+}
+
+void
+ResponseStream::send(const char * data, size_t n)
+{
+  if (failed || n == 0)
+    return;
+
+  if (chunked && mg_printf(conn, "%lx\r\n", (unsigned long) n) <= 0)
+    failed = true;
+  if (!failed && mg_write(conn, data, n) != (int) n)
+    failed = true;
+  if (!failed && chunked && mg_write(conn, "\r\n", 2) != 2)
+    failed = true;
+  if (!failed)
+    sent += n;
+}
+
+/* Sends the status line and headers. A negative content_length means the
+ * length is not known yet. */
+void
+ResponseStream::start(int64_t content_length)
+{
+  const char * coding = "";
+  if (encoding == ENCODING_GZIP)
+    coding = "Content-Encoding: gzip\r\n";
+  else if (encoding == ENCODING_DEFLATE)
+    coding = "Content-Encoding: deflate\r\n";
+
+  char length_header[64];
+  if (content_length >= 0) {
+    snprintf(length_header, sizeof(length_header), "Content-Length: %ld\r\n", (long) content_length);
+  } else if (!chunkable) {
+    /* HTTP/1.0 streams end with the connection */
+    snprintf(length_header, sizeof(length_header), "Connection: close\r\n");
+  } else {
+    chunked = true;
+    snprintf(length_header, sizeof(length_header), "Transfer-Encoding: chunked\r\n");
+  }
+
+  if (mg_printf(conn,
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: %s\r\n"
+	"%s"
+	"%s"
+	"%s"
+	"Vary: Accept-Encoding\r\n"
+	"Access-Control-Allow-Origin: *\r\n"
+	"\r\n",
+	content_type, coding, length_header, extra_headers) <= 0) {
+    failed = true;
+  }
+  started = true;
+}
+
+/* Passes data on to the connection, through the compressor if there is one */
+void
+ResponseStream::emit(const char * data, size_t n, bool last, bool sync)
+{
+#if defined(STINGER_RPC_USE_ZLIB)
+  if (encoding != ENCODING_IDENTITY) {
+    if (!zs_init) {
+      memset(&zs, 0, sizeof(zs));
+      /* 15 window bits, plus 16 for a gzip header and trailer */
+      if (Z_OK != deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+	    encoding == ENCODING_GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY)) {
+	LOG_E("Failed to initialize zlib");
+	failed = true;
+	return;
+      }
+      zs_init = true;
+    }
+
+    zs.next_in = (Bytef *) data;
+    zs.avail_in = n;
+    int rc;
+    do {
+      zs.next_out = (Bytef *) zbuf;
+      zs.avail_out = sizeof(zbuf);
+      rc = deflate(&zs, last ? Z_FINISH : (sync ? Z_SYNC_FLUSH : Z_NO_FLUSH));
+      send(zbuf, sizeof(zbuf) - zs.avail_out);
+    } while (zs.avail_out == 0 || (last && rc != Z_STREAM_END && rc != Z_STREAM_ERROR));
+    return;
+  }
+#endif
+  send(data, n);
+}
+
+void
+ResponseStream::flush_buffer(bool last)
+{
+  /* HTTP/1.0 has no chunked encoding, so hold the body until its length is known */
+  if (!started && !chunkable) {
+    held.append(buf, len);
+    len = 0;
+    return;
+  }
+  if (!started)
+    start(-1);
+  emit(buf, len, last);
+  len = 0;
+}
+
+void
+ResponseStream::flush()
+{
+  if (!started)
+    start(-1);
+  emit(buf, len, false, true);
+  len = 0;
+}
+
+int64_t
+ResponseStream::finish()
+{
+  if (!started) {
+    /* everything is still buffered, so the length is known */
+    const char * body = buf;
+    if (!held.empty()) {
+      held.append(buf, len);
+      body = held.data();
+      len = held.size();
+    }
+    if (encoding != ENCODING_IDENTITY && len < MIN_COMPRESS_BYTES)
+      encoding = ENCODING_IDENTITY;
+
+#if defined(STINGER_RPC_USE_ZLIB)
+    if (encoding != ENCODING_IDENTITY) {
+      /* compress into memory first to know the compressed length */
+      z_stream one;
+      memset(&one, 0, sizeof(one));
+      uLong bound = compressBound(len) + 32;
+      Bytef * out = (Bytef *) malloc(bound);
+      bool ok = out && Z_OK == deflateInit2(&one, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+	  encoding == ENCODING_GZIP ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY);
+      if (ok) {
+	one.next_in = (Bytef *) body;
+	one.avail_in = len;
+	one.next_out = out;
+	one.avail_out = bound;
+	ok = (Z_STREAM_END == deflate(&one, Z_FINISH));
+	deflateEnd(&one);
+      }
+      if (ok) {
+	start(one.total_out);
+	send((const char *) out, one.total_out);
+	free(out);
+	len = 0;
+	return failed ? -1 : sent;
+      }
+      free(out);
+      encoding = ENCODING_IDENTITY;
+    }
+#endif
+
+    start(len);
+    send(body, len);
+    len = 0;
+  } else {
+    flush_buffer(true);
+    if (chunked && !failed && mg_write(conn, "0\r\n\r\n", 5) != 5)
+      failed = true;
+  }
+
+  return failed ? -1 : sent;
+}
+
+int64_t
+gt::stinger::json_rpc_send_response(struct mg_connection * conn, rapidjson::Document & response)
+{
+  ResponseStream out(conn, "application/json");
+  rapidjson::Writer<ResponseStream> writer(out);
+  response.Accept(writer);
+  return out.finish();
+}
+
+bool
+gt::stinger::json_rpc_wants_binary(struct mg_connection * conn)
+{
+  const char * accept = mg_get_header(conn, "Accept");
+  return accept && strstr(accept, "application/octet-stream");
+}
+
+/* Finds field in an algorithm's data, laid out as in its description string */
+static bool
+find_alg_field(const std::string & description, const char * field, int64_t max_nv, uint8_t * data,
+  char * type, uint8_t ** field_data)
+{
+  size_t space = description.find(' ');
+  if (space == std::string::npos)
+    return false;
+
+  std::string types = description.substr(0, space);
+  size_t pos = space + 1;
+  for (size_t i = 0; i < types.size(); i++) {
+    size_t end = description.find(' ', pos);
+    std::string name = description.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+
+    int64_t width;
+    switch (types[i]) {
+      case 'f': width = sizeof(float); break;
+      case 'd': width = sizeof(double); break;
+      case 'i': width = sizeof(int32_t); break;
+      case 'l': width = sizeof(int64_t); break;
+      case 'b': width = sizeof(uint8_t); break;
+      default: return false;
+    }
+
+    if (name == field) {
+      *type = types[i];
+      *field_data = data;
+      return true;
+    }
+    if (end == std::string::npos)
+      return false;
+
+    data += width * max_nv;
+    pos = end + 1;
+  }
+  return false;
+}
+
+bool
+gt::stinger::json_rpc_send_binary(struct mg_connection * conn, rapidjson::Document & request)
+{
+  if (!request.IsObject() || !request.HasMember("method") || !request["method"].IsString() ||
+      !request.HasMember("params") || !request["params"].IsObject())
+    return false;
+
+  const char * method = request["method"].GetString();
+  bool range = (0 == strcmp(method, "get_data_array_range"));
+  if (!range && 0 != strcmp(method, "get_data_array"))
+    return false;
+
+  rapidjson::Value & params = request["params"];
+  if (!params.HasMember("name") || !params["name"].IsString() ||
+      !params.HasMember("data") || !params["data"].IsString())
+    return false;
+
+  /* other options only make sense for JSON */
+  static const char * plain_params[] = { "strings", "stride", "samples", "log", "vtypes", NULL };
+  for (const char ** p = plain_params; *p; p++) {
+    if (params.HasMember(*p))
+      return false;
+  }
+
+  JSON_RPCServerState & server_state = JSON_RPCServerState::get_server_state();
+  if (params.HasMember("wait_for_update") && params["wait_for_update"].IsBool() &&
+      params["wait_for_update"].GetBool()) {
+    server_state.wait_for_sync();
+  }
+
+  server_state.get_alg_read_lock();
+  stinger_t * S = server_state.get_stinger();
+  StingerAlgState * alg_state = server_state.get_alg(params["name"].GetString());
+  char type;
+  uint8_t * data;
+  if (!S || !alg_state ||
+      !find_alg_field(alg_state->data_description, params["data"].GetString(), S->max_nv,
+	(uint8_t *) alg_state->data, &type, &data)) {
+    server_state.release_alg_read_lock();
+    return false;
+  }
+
+  int64_t nv = stinger_mapping_nv(S);
+  int64_t offset = 0, count = nv;
+  if (range) {
+    if (!params.HasMember("offset") || !params["offset"].IsInt64() ||
+	!params.HasMember("count") || !params["count"].IsInt64()) {
+      server_state.release_alg_read_lock();
+      return false;
+    }
+    offset = params["offset"].GetInt64();
+    count = params["count"].GetInt64();
+  }
+  if (offset < 0 || offset >= nv || count < 0) {
+    server_state.release_alg_read_lock();
+    return false;
+  }
+  if (offset + count > nv)
+    count = nv - offset;
+
+  int64_t width = (type == 'f' || type == 'i') ? 4 : (type == 'b' ? 1 : 8);
+
+  /* browsers hide custom headers from cross-origin scripts unless listed */
+  char headers[512];
+  snprintf(headers, sizeof(headers),
+      "Access-Control-Expose-Headers: X-Stinger-Type, X-Stinger-Offset, X-Stinger-Count, "
+	"X-Stinger-Batch, X-Stinger-Time\r\n"
+      "X-Stinger-Type: %c\r\n"
+      "X-Stinger-Offset: %ld\r\n"
+      "X-Stinger-Count: %ld\r\n"
+      "X-Stinger-Batch: %ld\r\n"
+      "X-Stinger-Time: %ld\r\n",
+      type, (long) offset, (long) count, (long) server_state.get_epoch(), (long) server_state.get_max_time());
+
+  ResponseStream out(conn, "application/octet-stream", headers);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  for (int64_t i = 0; i < count; i++) {
+    const uint8_t * v = data + (offset + i) * width;
+    for (int64_t b = width - 1; b >= 0; b--)
+      out.Put((char) v[b]);
+  }
+#else
+  out.Write(data + offset * width, count * width);
+#endif
+  out.finish();
+
+  server_state.release_alg_read_lock();
+  return true;
+}
+
+/* idle streams get a comment this often */
+#define EVENT_KEEPALIVE_MS 15000
+
+bool
+gt::stinger::json_rpc_stream_events(struct mg_connection * conn)
+{
+  const char * query = mg_get_request_info(conn)->query_string;
+  char id_str[32];
+  if (!query || mg_get_var(query, strlen(query), "session_id", id_str, sizeof(id_str)) <= 0)
+    return false;
+  int64_t session_id = strtol(id_str, NULL, 10);
+
+  JSON_RPCServerState & server_state = JSON_RPCServerState::get_server_state();
+  JSON_RPCSession * session = server_state.get_session(session_id);
+  if (!session)
+    return false;
+
+  /* leave workers for other requests */
+  if (!server_state.begin_push_wait()) {
+    server_state.release_session(session);
+    mg_printf(conn,
+	"HTTP/1.1 503 Service Unavailable\r\n"
+	"Content-Length: 0\r\n"
+	"Retry-After: 5\r\n"
+	"Access-Control-Allow-Origin: *\r\n"
+	"\r\n");
+    return true;
+  }
+
+  ResponseStream out(conn, "text/event-stream", "Cache-Control: no-cache\r\n");
+  const char * hello = "retry: 1000\n\n";
+  out.Write(hello, strlen(hello));
+  out.flush();
+
+  while (out.ok()) {
+    if (!server_state.wait_for_session(session, EVENT_KEEPALIVE_MS)) {
+      /* the stream ends with its session */
+      if (server_state.session_closed(session))
+	break;
+      const char * keepalive = ": keepalive\n\n";
+      out.Write(keepalive, strlen(keepalive));
+      out.flush();
+      continue;
+    }
+
+    rapidjson::Document event;
+    rapidjson::Document::AllocatorType & allocator = event.GetAllocator();
+    rapidjson::Value result(rapidjson::kObjectType), id, batch, time;
+    event.SetObject();
+
+    server_state.get_alg_read_lock();
+    session->lock();
+    session->onRequest(result, allocator);
+    session->reset_timeout();
+    session->unlock();
+
+    id.SetInt64(session_id);
+    event.AddMember("session_id", id, allocator);
+    event.AddMember("result", result, allocator);
+    rapidjson::Value snapshot(rapidjson::kObjectType);
+    batch.SetInt64(server_state.get_epoch());
+    snapshot.AddMember("batch", batch, allocator);
+    time.SetInt64(server_state.get_max_time());
+    snapshot.AddMember("time", time, allocator);
+    event.AddMember("snapshot", snapshot, allocator);
+    server_state.release_alg_read_lock();
+
+    /* compact JSON has no newlines, so the event is one data line */
+    const char * head = "event: update\ndata: ";
+    out.Write(head, strlen(head));
+    rapidjson::Writer<ResponseStream> writer(out);
+    event.Accept(writer);
+    out.Write("\n\n", 2);
+    out.flush();
+  }
+
+  out.finish();
+  server_state.end_push_wait();
+  server_state.release_session(session);
+  return true;
+}
@@ -1,5 +1,9 @@
 #include <pthread.h>
 #include <sys/time.h>
+#include <time.h>
+#include <errno.h>
+#include <cstring>
+#include <algorithm>
 
 #include "stinger_core/xmalloc.h"
 #include "stinger_core/x86_full_empty.h"
@@ -12,6 +16,14 @@
 
 using namespace gt::stinger;
 
+namespace {
+  inline bool
+  test_bit(const std::vector<uint64_t> & bits, int64_t v)
+  {
+    return v >= 0 && (v >> 6) < (int64_t) bits.size() && ((bits[v >> 6] >> (v & 63)) & 1);
+  }
+}
+
 JSON_RPCServerState &
 JSON_RPCServerState::get_server_state() {
   static JSON_RPCServerState state;
@@ -20,11 +32,17 @@ JSON_RPCServerState::get_server_state() {
 
 JSON_RPCServerState::JSON_RPCServerState() :
   next_session_id(1), session_lock(0),
-  max_sessions(20), StingerMon() {
+  max_sessions(1024), subscription_lock(0), result_cache_lock(0), push_seq(0), push_waiters(0), max_push_waiters(25), StingerMon() {
     time(&start_time);
+    pthread_mutex_init(&push_mutex, NULL);
+    pthread_cond_init(&push_cond, NULL);
+    memset(&result_cache_stats, 0, sizeof(result_cache_stats));
+    result_cache_stats.max_bytes = 64 << 20;
 }
 
 JSON_RPCServerState::~JSON_RPCServerState() {
+  pthread_cond_destroy(&push_cond);
+  pthread_mutex_destroy(&push_mutex);
 }
 
 void
@@ -77,23 +95,78 @@ JSON_RPCServerState::update_algs(stinger_t * stinger_copy, std::string new_loc,
                                  const StingerBatch & batch) {
   StingerMon::update_algs(stinger_copy, new_loc, new_sz, new_algs, new_alg_map, batch);
 
+  /* every cached result was computed on an older epoch */
+  readfe((uint64_t *)&result_cache_lock);
+  evict_results(0);
+  writeef((uint64_t *)&result_cache_lock, 0);
+
+  neighborhood_cache.invalidate(batch, get_epoch());
+
+  for(std::map<std::string, JSON_RPCFunction *>::iterator tmp = function_map.begin(); tmp != function_map.end(); tmp++) {
+    tmp->second->update(batch);
+  }
+
+  /* scan the batch once for edges touching subscribed vertices */
+  std::map<int64_t, SessionEvents> events;
+  SessionEvents no_events;  /* stands in for subscribers the batch missed */
   readfe((uint64_t *)&session_lock);
+  readfe((uint64_t *)&subscription_lock);
+  if (!vertex_subscribers.empty()) {
+    for(size_t d = 0; d < batch.deletions_size(); d++) {
+      const EdgeDeletion & del = batch.deletions(d);
+      collect_events(del.source(), del.destination(), d, false, events);
+    }
+    for(size_t i = 0; i < batch.insertions_size(); i++) {
+      const EdgeInsertion & in = batch.insertions(i);
+      collect_events(in.source(), in.destination(), i, true, events);
+    }
+  }
+
+  std::vector<JSON_RPCSession *> sessions;
+  std::vector<SessionEvents *> session_events;
   for(std::map<int64_t, JSON_RPCSession *>::iterator tmp = active_session_map.begin(); tmp != active_session_map.end(); tmp++) {
-    JSON_RPCSession * session = tmp->second;
+    int64_t session_id = tmp->first;
+    std::map<int64_t, SessionEvents>::iterator ev = events.find(session_id);
+    sessions.push_back(tmp->second);
+    if (ev != events.end())
+      session_events.push_back(&ev->second);
+    else if (session_subscriptions.count(session_id))
+      session_events.push_back(&no_events);
+    else
+      session_events.push_back(NULL);
+  }
+  writeef((uint64_t *)&subscription_lock, 0);
+
+  /* sessions update independently */
+  std::vector<uint8_t> timed_out(sessions.size(), 0);
+  OMP("omp parallel for schedule(dynamic)")
+  for(int64_t i = 0; i < sessions.size(); i++) {
+    JSON_RPCSession * session = sessions[i];
+    SessionEvents * ev = session_events[i];
     session->lock();
     if (session->is_timed_out()) {
-      int64_t session_id = session->get_session_id();
-      LOG_D_A ("Session %ld timed out. Destroying...", (long) session_id);
-      delete active_session_map[session_id];
-      active_session_map.erase (session_id);
+      timed_out[i] = 1;
     } else {
-      //int64_t session_id = session->get_session_id();
-      //LOG_D_A ("Session %ld updating...", (long) session_id);
-      session->update(batch);
+      if (!ev)
+	session->update(batch);
+      else if (ev != &no_events)
+	session->update_subscribed(batch, ev->ins, ev->del);
       session->unlock();
     }
   }
+
+  for(int64_t i = 0; i < sessions.size(); i++) {
+    if (timed_out[i]) {
+      int64_t session_id = sessions[i]->get_session_id();
+      LOG_D_A ("Session %ld timed out. Destroying...", (long) session_id);
+      sessions[i]->unlock();
+      close_session(active_session_map.find(session_id));
+    }
+  }
   writeef((uint64_t *)&session_lock, 0);
+
+  /* wake long polls and event streams */
+  wake_waiters();
 }
 
 bool
@@ -214,7 +287,8 @@ JSON_RPCFunction::contains_params(rpc_params_t * p, rapidjson::Value * params) {
         }
         break;
         case TYPE_DOUBLE: {
-          if(!(*params)[p->name].IsDouble()) {
+          /* integers such as 5 are doubles too */
+          if(!(*params)[p->name].IsNumber()) {
             return false;
           }
           *((double *)p->output) = (*params)[p->name].GetDouble();
@@ -314,6 +388,7 @@ JSON_RPCServerState::add_session(int64_t session_id, JSON_RPCSession * session)
   readfe((uint64_t *)&session_lock);
   if (active_session_map.size() < max_sessions) {
     active_session_map.insert( std::pair<int64_t, JSON_RPCSession *>(session_id, session) );
+    session->refs++;
   } else {
     session_id = -1;
   }
@@ -321,12 +396,32 @@ JSON_RPCServerState::add_session(int64_t session_id, JSON_RPCSession * session)
   return session_id;
 }
 
+/* Removes the session from the map and drops the map's reference; holders
+ * of others see it closed. Called with session_lock held. */
+void
+JSON_RPCServerState::close_session(std::map<int64_t, JSON_RPCSession *>::iterator it) {
+  JSON_RPCSession * session = it->second;
+  unsubscribe_all(it->first);
+  active_session_map.erase(it);
+  session->closed = true;
+  if (--session->refs == 0)
+    delete session;
+}
+
 int64_t
 JSON_RPCServerState::destroy_session(int64_t session_id) {
   readfe((uint64_t *)&session_lock);
-  delete active_session_map[session_id];
-  int64_t rtn = active_session_map.erase (session_id);
+  std::map<int64_t, JSON_RPCSession *>::iterator tmp = active_session_map.find(session_id);
+  int64_t rtn = 0;
+  if (tmp != active_session_map.end()) {
+    close_session(tmp);
+    rtn = 1;
+  }
   writeef((uint64_t *)&session_lock, 0);
+
+  /* end long polls and event streams on it */
+  if (rtn)
+    wake_waiters();
   return rtn;
 }
 
@@ -340,14 +435,127 @@ JSON_RPCServerState::get_num_sessions() {
 
 JSON_RPCSession *
 JSON_RPCServerState::get_session(int64_t session_id) {
+  JSON_RPCSession * rtn = NULL;
   readfe((uint64_t *)&session_lock);
   std::map<int64_t, JSON_RPCSession *>::iterator tmp = active_session_map.find(session_id);
+  if (tmp != active_session_map.end()) {
+    rtn = tmp->second;
+    rtn->refs++;
+  }
   writeef((uint64_t *)&session_lock, 0);
+  return rtn;
+}
 
-  if (tmp == active_session_map.end())
-    return NULL;
-  else
-    return tmp->second;
+void
+JSON_RPCServerState::release_session(JSON_RPCSession * session) {
+  readfe((uint64_t *)&session_lock);
+  bool last = (--session->refs == 0);
+  writeef((uint64_t *)&session_lock, 0);
+  if (last)
+    delete session;
+}
+
+bool
+JSON_RPCServerState::session_closed(JSON_RPCSession * session) {
+  readfe((uint64_t *)&session_lock);
+  bool rtn = session->closed;
+  writeef((uint64_t *)&session_lock, 0);
+  return rtn;
+}
+
+void
+JSON_RPCServerState::wake_waiters() {
+  pthread_mutex_lock(&push_mutex);
+  push_seq++;
+  pthread_cond_broadcast(&push_cond);
+  pthread_mutex_unlock(&push_mutex);
+}
+
+void
+JSON_RPCServerState::set_max_push_waiters(int64_t max) {
+  pthread_mutex_lock(&push_mutex);
+  max_push_waiters = max;
+  pthread_mutex_unlock(&push_mutex);
+}
+
+bool
+JSON_RPCServerState::begin_push_wait() {
+  pthread_mutex_lock(&push_mutex);
+  bool rtn = push_waiters < max_push_waiters;
+  if (rtn)
+    push_waiters++;
+  pthread_mutex_unlock(&push_mutex);
+  return rtn;
+}
+
+void
+JSON_RPCServerState::end_push_wait() {
+  pthread_mutex_lock(&push_mutex);
+  push_waiters--;
+  pthread_mutex_unlock(&push_mutex);
+}
+
+int64_t
+JSON_RPCServerState::get_num_push_waiters() {
+  pthread_mutex_lock(&push_mutex);
+  int64_t rtn = push_waiters;
+  pthread_mutex_unlock(&push_mutex);
+  return rtn;
+}
+
+bool
+JSON_RPCServerState::wait_for_session(JSON_RPCSession * session, int64_t timeout_ms)
+{
+  if (timeout_ms > SESSION_MAX_WAIT_MS)
+    timeout_ms = SESSION_MAX_WAIT_MS;
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+
+  while (1) {
+    /* read the count first so a batch landing after the check wakes us */
+    pthread_mutex_lock(&push_mutex);
+    int64_t seen = push_seq;
+    pthread_mutex_unlock(&push_mutex);
+
+    if (session_closed(session))
+      return false;
+
+    session->lock();
+    session->reset_timeout();
+    bool pending = session->has_pending();
+    session->unlock();
+    if (pending)
+      return true;
+
+    int rc = 0;
+    pthread_mutex_lock(&push_mutex);
+    while (push_seq == seen && rc != ETIMEDOUT)
+      rc = pthread_cond_timedwait(&push_cond, &push_mutex, &deadline);
+    pthread_mutex_unlock(&push_mutex);
+
+    if (rc == ETIMEDOUT) {
+      if (session_closed(session))
+	return false;
+      session->lock();
+      session->reset_timeout();
+      pending = session->has_pending();
+      session->unlock();
+      return pending;
+    }
+  }
+}
+
+NeighborhoodCache &
+JSON_RPCServerState::get_neighborhood_cache()
+{
+  return neighborhood_cache;
 }
 
 time_t
@@ -358,3 +566,151 @@ JSON_RPCServerState::get_time_since_start()
 
   return (cur_time - start_time);
 }
+
+/* caller holds result_cache_lock */
+void
+JSON_RPCServerState::evict_results(int64_t max_bytes)
+{
+  while (result_cache_stats.bytes > max_bytes && !result_lru.empty()) {
+    std::map<std::string, CachedResult>::iterator it = result_cache.find(result_lru.back());
+    result_cache_stats.bytes -= it->first.size() + it->second.text.size();
+    result_cache_stats.evictions++;
+    result_cache.erase(it);
+    result_lru.pop_back();
+  }
+  result_cache_stats.entries = result_cache.size();
+}
+
+bool
+JSON_RPCServerState::get_cached_result(const std::string & key, int64_t epoch, std::string & text)
+{
+  bool found = false;
+  readfe((uint64_t *)&result_cache_lock);
+  std::map<std::string, CachedResult>::iterator it = result_cache.find(key);
+  if (it != result_cache.end() && it->second.epoch == epoch) {
+    result_lru.splice(result_lru.begin(), result_lru, it->second.lru);
+    text = it->second.text;
+    result_cache_stats.hits++;
+    found = true;
+  } else {
+    result_cache_stats.misses++;
+  }
+  writeef((uint64_t *)&result_cache_lock, 0);
+  return found;
+}
+
+void
+JSON_RPCServerState::put_cached_result(const std::string & key, int64_t epoch, const std::string & text)
+{
+  int64_t bytes = key.size() + text.size();
+
+  readfe((uint64_t *)&result_cache_lock);
+  std::map<std::string, CachedResult>::iterator it = result_cache.find(key);
+  /* readers still on an older epoch must not replace newer results */
+  if (bytes <= result_cache_stats.max_bytes &&
+      (it == result_cache.end() || it->second.epoch < epoch)) {
+    if (it != result_cache.end()) {
+      result_cache_stats.bytes -= it->first.size() + it->second.text.size();
+      result_lru.erase(it->second.lru);
+      result_cache.erase(it);
+    }
+    result_lru.push_front(key);
+    CachedResult & entry = result_cache[key];
+    entry.text = text;
+    entry.epoch = epoch;
+    entry.lru = result_lru.begin();
+    result_cache_stats.bytes += bytes;
+    evict_results(result_cache_stats.max_bytes);
+  }
+  writeef((uint64_t *)&result_cache_lock, 0);
+}
+
+void
+JSON_RPCServerState::set_result_cache_size(int64_t max_bytes)
+{
+  readfe((uint64_t *)&result_cache_lock);
+  result_cache_stats.max_bytes = max_bytes;
+  evict_results(max_bytes);
+  writeef((uint64_t *)&result_cache_lock, 0);
+}
+
+result_cache_stats_t
+JSON_RPCServerState::get_result_cache_stats()
+{
+  readfe((uint64_t *)&result_cache_lock);
+  result_cache_stats_t rtn = result_cache_stats;
+  writeef((uint64_t *)&result_cache_lock, 0);
+  return rtn;
+}
+
+void
+JSON_RPCServerState::set_max_sessions(int64_t max) {
+  readfe((uint64_t *)&session_lock);
+  max_sessions = max;
+  writeef((uint64_t *)&session_lock, 0);
+}
+
+void
+JSON_RPCServerState::subscribe_vertex(int64_t session_id, int64_t vertex) {
+  if (vertex < 0)
+    return;
+
+  readfe((uint64_t *)&subscription_lock);
+  std::vector<int64_t> & subscribers = vertex_subscribers[vertex];
+  if (std::find(subscribers.begin(), subscribers.end(), session_id) == subscribers.end()) {
+    subscribers.push_back(session_id);
+    session_subscriptions[session_id].push_back(vertex);
+  }
+  if ((vertex >> 6) >= (int64_t) subscribed_bits.size())
+    subscribed_bits.resize((vertex >> 6) + 1, 0);
+  subscribed_bits[vertex >> 6] |= (1ULL << (vertex & 63));
+  writeef((uint64_t *)&subscription_lock, 0);
+}
+
+void
+JSON_RPCServerState::unsubscribe_all(int64_t session_id) {
+  readfe((uint64_t *)&subscription_lock);
+  std::map<int64_t, std::vector<int64_t> >::iterator subs = session_subscriptions.find(session_id);
+  if (subs != session_subscriptions.end()) {
+    for (size_t i = 0; i < subs->second.size(); i++) {
+      int64_t vertex = subs->second[i];
+      std::vector<int64_t> & subscribers = vertex_subscribers[vertex];
+      subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), session_id), subscribers.end());
+      if (subscribers.empty()) {
+	vertex_subscribers.erase(vertex);
+	subscribed_bits[vertex >> 6] &= ~(1ULL << (vertex & 63));
+      }
+    }
+    session_subscriptions.erase(subs);
+  }
+  writeef((uint64_t *)&subscription_lock, 0);
+}
+
+/* caller holds subscription_lock */
+void
+JSON_RPCServerState::collect_events(int64_t src, int64_t dst, int64_t index, bool insertion,
+                                    std::map<int64_t, SessionEvents> & events) {
+  bool src_sub = test_bit(subscribed_bits, src);
+  bool dst_sub = test_bit(subscribed_bits, dst) && dst != src;
+  if (!src_sub && !dst_sub)
+    return;
+
+  const std::vector<int64_t> * lists[2] = { NULL, NULL };
+  if (src_sub)
+    lists[0] = &vertex_subscribers[src];
+  if (dst_sub)
+    lists[1] = &vertex_subscribers[dst];
+
+  for (int l = 0; l < 2; l++) {
+    if (!lists[l])
+      continue;
+    for (size_t s = 0; s < lists[l]->size(); s++) {
+      int64_t session_id = (*lists[l])[s];
+      /* an edge between two of a session's vertices is reported once */
+      if (l == 1 && lists[0] && std::find(lists[0]->begin(), lists[0]->end(), session_id) != lists[0]->end())
+	continue;
+      SessionEvents & ev = events[session_id];
+      (insertion ? ev.ins : ev.del).push_back(index);
+    }
+  }
+}
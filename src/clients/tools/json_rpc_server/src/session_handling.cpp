@@ -16,6 +16,26 @@
 
 using namespace gt::stinger;
 
+typedef std::set<std::pair<int64_t, int64_t> > edge_set_t;
+
+/* Records an edge event for the next request. A pending event of the other
+ * kind for the same edge is superseded, since the client only needs the
+ * last; once too many are pending, overflow is set instead. */
+static void
+record_edge(edge_set_t & events, edge_set_t & opposite, int64_t src, int64_t dst, bool & overflow)
+{
+  std::pair<int64_t, int64_t> e(src, dst);
+  if (opposite.erase(e) || events.count(e)) {
+    events.insert(e);
+    return;
+  }
+  if (events.size() + opposite.size() >= SESSION_MAX_PENDING_EDGES) {
+    overflow = true;
+    return;
+  }
+  events.insert(e);
+}
+
 
 /* stateful subgraph extraction */
 
@@ -55,7 +75,7 @@ JSON_RPC_community_subgraph::update(const StingerBatch & batch)
        i.e. the edge that was deleted was previously on the screen */
     if ( _vertices.find(src) != _vertices.end() && _vertices.find(dst) != _vertices.end() ) {
       LOG_D_A("Adding <%ld, %ld> to deletions", (long) src, (long) dst);
-      _deletions.insert(std::make_pair(src, dst));
+      record_edge(_deletions, _insertions, src, dst, _overflow);
     }
   }
 
@@ -69,7 +89,7 @@ JSON_RPC_community_subgraph::update(const StingerBatch & batch)
 
     if (_data->equal(_source,src) && _data->equal(_source,dst)) {
       LOG_D_A("Adding <%ld, %ld> to insertions", (long) src, (long) dst);
-      _insertions.insert(std::make_pair(src, dst));
+      record_edge(_insertions, _deletions, src, dst, _overflow);
     }
   }
 
@@ -83,7 +103,7 @@ JSON_RPC_community_subgraph::update(const StingerBatch & batch)
       STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, *it) {
         /* edge used to be in the community */
         if ( _vertices.find(STINGER_EDGE_DEST) != _vertices.end() ) {
-          _deletions.insert(std::make_pair(*it, STINGER_EDGE_DEST));
+          record_edge(_deletions, _insertions, *it, STINGER_EDGE_DEST, _overflow);
         }
       } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
 
@@ -103,7 +123,7 @@ JSON_RPC_community_subgraph::update(const StingerBatch & batch)
         /* if the edge is in the community */
         if (_data->equal(i, STINGER_EDGE_DEST)) {
           LOG_D_A("and it has an edge inside the community to %ld", (long) STINGER_EDGE_DEST);
-          _insertions.insert(std::make_pair(i, STINGER_EDGE_DEST));
+          record_edge(_insertions, _deletions, i, STINGER_EDGE_DEST, _overflow);
         }
       } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
     }
@@ -198,9 +218,15 @@ JSON_RPC_community_subgraph::onRequest(
     result.AddMember("deletions_str", deletions_str, allocator);
   }
 
+  /* events were dropped, so the client should register again */
+  rapidjson::Value overflow;
+  overflow.SetBool(_overflow);
+  result.AddMember("overflow", overflow, allocator);
+
   /* clear both and reset the clock */
   _insertions.clear();
   _deletions.clear();
+  _overflow = false;
 
   return 0;
 }
@@ -390,7 +416,7 @@ JSON_RPC_vertex_event_notifier::update(const StingerBatch & batch)
        i.e. the edge that was deleted was previously on the screen */
     if ( _vertices.find(src) != _vertices.end() || _vertices.find(dst) != _vertices.end() ) {
       LOG_D_A("Adding <%ld, %ld> to deletions", (long) src, (long) dst);
-      _deletions.insert(std::make_pair(src, dst));
+      record_edge(_deletions, _insertions, src, dst, _overflow);
     }
   }
 
@@ -404,13 +430,31 @@ JSON_RPC_vertex_event_notifier::update(const StingerBatch & batch)
        i.e. the edge should be sent to the client */
     if ( _vertices.find(src) != _vertices.end() || _vertices.find(dst) != _vertices.end() ) {
       LOG_D_A("Adding <%ld, %ld> to insertions", (long) src, (long) dst);
-      _insertions.insert(std::make_pair(src, dst));
+      record_edge(_insertions, _deletions, src, dst, _overflow);
     }
   }
 
   return 0;
 }
 
+/* the server only passes on edges with an endpoint in _vertices */
+int64_t
+JSON_RPC_vertex_event_notifier::update_subscribed(const StingerBatch & batch,
+	      const std::vector<int64_t> & ins, const std::vector<int64_t> & del)
+{
+  for(size_t d = 0; d < del.size(); d++) {
+    const EdgeDeletion & e = batch.deletions(del[d]);
+    record_edge(_deletions, _insertions, e.source(), e.destination(), _overflow);
+  }
+
+  for(size_t i = 0; i < ins.size(); i++) {
+    const EdgeInsertion & e = batch.insertions(ins[i]);
+    record_edge(_insertions, _deletions, e.source(), e.destination(), _overflow);
+  }
+
+  return 0;
+}
+
 int64_t
 JSON_RPC_vertex_event_notifier::onRegister(
 	      rapidjson::Value & result,
@@ -429,6 +473,7 @@ JSON_RPC_vertex_event_notifier::onRegister(
   for (int64_t i = 0; i < set_len; i++) {
     int64_t vtx = set[i];
     _vertices.insert(vtx);
+    server_state->subscribe_vertex(get_session_id(), vtx);
   }
 
   /* Send back all edges incident on those vertices */
@@ -594,9 +639,15 @@ JSON_RPC_vertex_event_notifier::onRequest(
     result.AddMember("deletions_str", deletions_str, allocator);
   }
 
+  /* events were dropped, so the client should register again */
+  rapidjson::Value overflow;
+  overflow.SetBool(_overflow);
+  result.AddMember("overflow", overflow, allocator);
+
   /* clear both and reset the clock */
   _insertions.clear();
   _deletions.clear();
+  _overflow = false;
 
   return 0;
 }
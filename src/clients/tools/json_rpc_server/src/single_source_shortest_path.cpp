@@ -21,12 +21,14 @@ JSON_RPC_single_source_shortest_path::operator()(rapidjson::Value * params, rapi
     bool ignore_weights;
     bool strings;
     int64_t etype;
+    int64_t delta;
 
     rpc_params_t p[] = {
             {"source", TYPE_VERTEX, &source, false, 0},
             {"ignore_weights", TYPE_BOOL, &ignore_weights, false, 0},
             {"strings", TYPE_BOOL, &strings, true, 0},
             {"etype", TYPE_EDGE_TYPE , &etype, true, -1},
+            {"delta", TYPE_INT64, &delta, true, 0},
             {NULL, TYPE_NONE, NULL, false, 0}
     };
 
@@ -63,10 +65,16 @@ JSON_RPC_single_source_shortest_path::operator()(rapidjson::Value * params, rapi
     //int64_t * candidates = NULL;
     //double * scores = NULL;
 
-    std::vector<int64_t> paths = dijkstra(S, (int64_t)S->max_nv, source, ignore_weights);
+    /* only vertices up to the largest active one can be reached */
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    if (source >= nv)
+        nv = source + 1;
+
+    /* delta <= 0 lets delta_stepping pick the bucket width */
+    std::vector<int64_t> paths = delta_stepping(S, nv, source, ignore_weights, delta);
 
     //int64_t num_candidates = adamic_adar(S, source, etype, &candidates, &scores);
-    for (uint64_t i = 0; i < (uint64_t)S->max_nv; i++) {
+    for (uint64_t i = 0; i < (uint64_t)nv; i++) {
         uint64_t vtx =paths[i];
         vtx_id.PushBack(i,allocator);
         vtx_val.PushBack(vtx,allocator);
@@ -70,7 +70,7 @@ int main(int argc, char *argv[])
 
   /* parse command line configuration */
   int opt = 0;
-  while(-1 != (opt = getopt(argc, argv, "C:a:s:b:n:i:t:1h?dkvc:f:"))) {
+  while(-1 != (opt = getopt(argc, argv, "C:a:s:b:n:i:t:1h?dkvc:f:z:"))) {
     switch(opt) {
       case 'C': {
         strcpy(stinger_config_file,optarg);
@@ -103,6 +103,10 @@ int main(int argc, char *argv[])
 		  server_state.set_out_dir(optarg);
 		} break;
 
+      case 'z': {
+		  server_state.set_compress_data(atoi(optarg));
+		} break;
+
       case 'i': {
 		  strcpy (input_file, optarg);
 		} break;
@@ -129,9 +133,10 @@ int main(int argc, char *argv[])
 			 "   [-t file_type]\n"
 			 "   [-1 (for numeric IDs)]\n"
 			 "   [-d daemon mode]\n"
-			 "   [-k write algorithm states to disk]\n"
+			 "   [-k write algorithm states to disk, one file per field]\n"
 			 "   [-v write vertex name mapping to disk]\n"
 			 "   [-f output directory for vertex names, alg states]\n"
+			 "   [-z compress alg states with zlib at this level (1-9)]\n"
 			 "   [-c cap number of history files to keep per alg]  \n", argv[0]);
 		  printf("Defaults:\n\tport_algs: %d\n\tport_streams: %d\n\tgraph_name: %s\n", port_algs, port_streams, graph_name);
 		  exit(0);
@@ -425,6 +430,10 @@ cleanup (void)
     pthread_join(alg_server_tid, NULL);
     LOG_I("done."); fflush(stdout);
 
+    LOG_I("Writing pending results..."); fflush(stdout);
+    server_state.finish_writes();
+    LOG_I("done."); fflush(stdout);
+
     struct stinger * S = server_state.get_stinger();
     size_t graph_sz = S->length + sizeof(struct stinger);
     
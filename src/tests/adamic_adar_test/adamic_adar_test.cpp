@@ -194,6 +194,138 @@ TEST_F(AdamicAdarDirectedTest, AllEdgeTypes) {
   xfree(scores);
 }
 
+TEST_F(AdamicAdarTest, TopK) {
+  stinger_adamic_adar_t aa;
+  adamic_adar_initialize(S, S->max_nv, -1, &aa);
+
+  int64_t * candidates = NULL;
+  double * scores = NULL;
+  int64_t len = adamic_adar_top_k(S, &aa, 0, 2, &candidates, &scores);
+
+  ASSERT_EQ(2, len);
+  EXPECT_EQ(4, candidates[0]);
+  EXPECT_DOUBLE_EQ(1.0/log(2)+1/log(5), scores[0]);
+  EXPECT_EQ(8, candidates[1]);
+  EXPECT_DOUBLE_EQ(1.0/log(2), scores[1]);
+  xfree(candidates);
+  xfree(scores);
+
+  /* all of them, best first and ties by vertex id */
+  candidates = NULL;
+  scores = NULL;
+  len = adamic_adar_top_k(S, &aa, 0, 0, &candidates, &scores);
+  ASSERT_EQ(5, len);
+  int64_t expect[] = {4, 8, 5, 6, 7};
+  for (int64_t i = 0; i < len; i++) {
+    EXPECT_EQ(expect[i], candidates[i]);
+  }
+  xfree(candidates);
+  xfree(scores);
+
+  adamic_adar_release(&aa);
+}
+
+TEST_F(AdamicAdarTest, CacheInvalidation) {
+  stinger_adamic_adar_t aa;
+  adamic_adar_initialize(S, S->max_nv, -1, &aa);
+
+  int64_t * candidates = NULL;
+  double * scores = NULL;
+  adamic_adar_top_k(S, &aa, 0, 1, &candidates, &scores);
+  xfree(candidates);
+  xfree(scores);
+
+  /* 3 gains a second path to 5; 8 now scores through 3 with degree 3 */
+  stinger_insert_edge_pair(S, 0, 3, 5, 1, 1);
+  stinger_edge_update ins[1];
+  ins[0].source = 3;
+  ins[0].destination = 5;
+  adamic_adar_update(S, &aa, ins, 1, NULL, 0);
+
+  candidates = NULL;
+  scores = NULL;
+  int64_t len = adamic_adar_top_k(S, &aa, 0, 0, &candidates, &scores);
+
+  int64_t * fresh_candidates = NULL;
+  double * fresh_scores = NULL;
+  int64_t fresh_len = adamic_adar(S, 0, -1, &fresh_candidates, &fresh_scores);
+
+  ASSERT_EQ(fresh_len, len);
+  for (int64_t i = 0; i < len; i++) {
+    EXPECT_EQ(fresh_candidates[i], candidates[i]);
+    EXPECT_DOUBLE_EQ(fresh_scores[i], scores[i]);
+    if (candidates[i] == 5) {
+      EXPECT_DOUBLE_EQ(1.0/log(5)+1.0/log(3), scores[i]);
+    }
+  }
+
+  xfree(candidates);
+  xfree(scores);
+  xfree(fresh_candidates);
+  xfree(fresh_scores);
+  adamic_adar_release(&aa);
+}
+
+TEST_F(AdamicAdarTest, Batch) {
+  stinger_adamic_adar_t aa;
+  adamic_adar_initialize(S, S->max_nv, -1, &aa);
+
+  int64_t k = 3;
+  int64_t sources[] = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  int64_t n = 9;
+  int64_t * candidates = (int64_t *)xmalloc(n * k * sizeof(int64_t));
+  double * scores = (double *)xmalloc(n * k * sizeof(double));
+  int64_t counts[9];
+
+  adamic_adar_top_k_batch(S, &aa, sources, n, k, candidates, scores, counts);
+
+  for (int64_t i = 0; i < n; i++) {
+    int64_t * one_candidates = NULL;
+    double * one_scores = NULL;
+    int64_t len = adamic_adar_top_k(S, &aa, sources[i], k, &one_candidates, &one_scores);
+    ASSERT_EQ(len, counts[i]) << "source " << sources[i];
+    for (int64_t j = 0; j < len; j++) {
+      EXPECT_EQ(one_candidates[j], candidates[i * k + j]);
+      EXPECT_DOUBLE_EQ(one_scores[j], scores[i * k + j]);
+    }
+    xfree(one_candidates);
+    xfree(one_scores);
+  }
+
+  xfree(candidates);
+  xfree(scores);
+  adamic_adar_release(&aa);
+}
+
+TEST_F(AdamicAdarTest, WideTwoHop) {
+  /* 9 reaches 500 vertices through 10 alone; 1000 + v also through 11 */
+  stinger_insert_edge_pair(S,0,9,10,1,1);
+  stinger_insert_edge_pair(S,0,9,11,1,1);
+  for (int64_t v = 0; v < 500; v++) {
+    stinger_insert_edge_pair(S,0,10,1000 + v,1,1);
+    if (v % 50 == 0)
+      stinger_insert_edge_pair(S,0,11,1000 + v,1,1);
+  }
+
+  stinger_adamic_adar_t aa;
+  adamic_adar_initialize(S, S->max_nv, -1, &aa);
+
+  int64_t * candidates = NULL;
+  double * scores = NULL;
+  int64_t len = adamic_adar_top_k(S, &aa, 9, 0, &candidates, &scores);
+  ASSERT_EQ(500, len);
+  for (int64_t i = 0; i < 10; i++) {
+    EXPECT_EQ(1000 + 50 * i, candidates[i]);
+    EXPECT_DOUBLE_EQ(1.0/log(501)+1.0/log(11), scores[i]);
+  }
+  EXPECT_EQ(1001, candidates[10]);
+  EXPECT_DOUBLE_EQ(1.0/log(501), scores[499]);
+
+  xfree(candidates);
+  xfree(scores);
+  adamic_adar_release(&aa);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -135,6 +135,92 @@ TEST_F(BetweennessTest, UndirectedGraph) {
   }
 }
 
+TEST_F(BetweennessTest, IncrementalUndirectedGraph) {
+  stinger_insert_edge_pair(S, 0, 0, 1, 1, 1);
+  stinger_insert_edge_pair(S, 0, 1, 2, 1, 1);
+  stinger_insert_edge_pair(S, 0, 1, 3, 1, 1);
+  stinger_insert_edge_pair(S, 0, 1, 4, 1, 1);
+  stinger_insert_edge_pair(S, 0, 2, 8, 1, 1);
+  stinger_insert_edge_pair(S, 0, 3, 5, 1, 1);
+  stinger_insert_edge_pair(S, 0, 3, 6, 1, 1);
+  stinger_insert_edge_pair(S, 0, 4, 5, 1, 1);
+  stinger_insert_edge_pair(S, 0, 5, 6, 1, 1);
+  stinger_insert_edge_pair(S, 0, 5, 7, 1, 1);
+  stinger_insert_edge_pair(S, 0, 7, 8, 1, 1);
+
+  int64_t nv = stinger_max_active_vertex(S)+1;
+  int64_t max_nv = 16;
+
+  double * bc = (double *)xcalloc(max_nv, sizeof(double));
+  int64_t * times_found = (int64_t *)xcalloc(max_nv, sizeof(int64_t));
+  double * expected_bc = (double *)xcalloc(max_nv, sizeof(double));
+  int64_t * expected_found = (int64_t *)xcalloc(max_nv, sizeof(int64_t));
+
+  stinger_bc_internal bc_internal;
+  stinger_bc_stats stats;
+  stinger_bc_initialize_internals(S, nv, &bc_internal, 64, 1, bc, times_found);
+
+  sample_search(S, nv, 64, expected_bc, expected_found);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_NEAR(expected_bc[v],bc[v],0.00001) << "v = " << v;
+    EXPECT_EQ(expected_found[v],times_found[v]) << "v = " << v;
+  }
+
+  /* an edge between two vertices at the same distance from 0, 1 and 4 */
+  stinger_edge_update insertions[1];
+  memset(insertions, 0, sizeof(insertions));
+  insertions[0].source = 2; insertions[0].destination = 3;
+  stinger_insert_edge_pair(S, 0, 2, 3, 1, 2);
+
+  stinger_bc_reset_stats(&stats);
+  stinger_bc_update(S, nv, &bc_internal, &stats, insertions, 1, NULL, 0, bc, times_found);
+  EXPECT_EQ(0, stats.sources_added);
+  EXPECT_GE(stats.sources_skipped, 3);
+
+  sample_search(S, nv, 64, expected_bc, expected_found);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_NEAR(expected_bc[v],bc[v],0.00001) << "v = " << v;
+    EXPECT_EQ(expected_found[v],times_found[v]) << "v = " << v;
+  }
+
+  /* a new vertex becomes a source of its own */
+  insertions[0].source = 8; insertions[0].destination = 9;
+  stinger_insert_edge_pair(S, 0, 8, 9, 1, 2);
+  nv = stinger_max_active_vertex(S)+1;
+
+  stinger_bc_reset_stats(&stats);
+  stinger_bc_update(S, nv, &bc_internal, &stats, insertions, 1, NULL, 0, bc, times_found);
+  EXPECT_EQ(1, stats.sources_added);
+
+  sample_search(S, nv, 64, expected_bc, expected_found);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_NEAR(expected_bc[v],bc[v],0.00001) << "v = " << v;
+    EXPECT_EQ(expected_found[v],times_found[v]) << "v = " << v;
+  }
+
+  stinger_edge_update deletions[2];
+  memset(deletions, 0, sizeof(deletions));
+  deletions[0].source = 1; deletions[0].destination = 3;
+  deletions[1].source = 5; deletions[1].destination = 7;
+  stinger_remove_edge_pair(S, 0, 1, 3);
+  stinger_remove_edge_pair(S, 0, 5, 7);
+
+  stinger_bc_reset_stats(&stats);
+  stinger_bc_update(S, nv, &bc_internal, &stats, NULL, 0, deletions, 2, bc, times_found);
+
+  sample_search(S, nv, 64, expected_bc, expected_found);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_NEAR(expected_bc[v],bc[v],0.00001) << "v = " << v;
+    EXPECT_EQ(expected_found[v],times_found[v]) << "v = " << v;
+  }
+
+  stinger_bc_release_internals(&bc_internal);
+  xfree(expected_found);
+  xfree(expected_bc);
+  xfree(times_found);
+  xfree(bc);
+}
+
 int
 main (int argc, char *argv[])
 {
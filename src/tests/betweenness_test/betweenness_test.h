@@ -3,6 +3,7 @@
 
 extern "C" {
   #include "stinger_alg/betweenness.h"
+  #include "stinger_alg/streaming_betweenness.h"
   #include "stinger_core/stinger.h"
 }
 
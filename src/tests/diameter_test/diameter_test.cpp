@@ -56,6 +56,133 @@ TEST_F(DiameterTest, simple_directed) {
 }
 
 
+/* brute force: largest eccentricity of the undirected view */
+static int64_t
+undirected_diameter(stinger_t * S, int64_t nv) {
+    std::vector<int64_t> dist(nv, -1), queue(nv);
+    int64_t diam = 0;
+    for (int64_t v = 0; v < nv; v++) {
+        int64_t reached = hop_distances(S, nv, v, true, &dist[0], &queue[0]);
+        for (int64_t k = 0; k < reached; k++) {
+            diam = std::max(diam, dist[queue[k]]);
+            dist[queue[k]] = -1;
+        }
+    }
+    return diam;
+}
+
+TEST_F(DiameterTest, ifub_path_and_components) {
+    /* a path of 40 and a separate triangle */
+    for (int64_t v = 0; v < 39; v++) {
+        stinger_insert_edge(S, 0, v, v + 1, 1, 1);
+    }
+    stinger_insert_edge_pair(S, 0, 100, 101, 1, 1);
+    stinger_insert_edge_pair(S, 0, 101, 102, 1, 1);
+    stinger_insert_edge_pair(S, 0, 102, 100, 1, 1);
+
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    diameter_bounds_t bounds;
+    EXPECT_EQ(39, ifub_diameter(S, nv, &bounds));
+    EXPECT_TRUE(bounds.complete);
+    EXPECT_EQ(39, bounds.upper);
+    /* a path is settled by its double sweep and the root level */
+    EXPECT_GE(8, bounds.searches);
+}
+
+TEST_F(DiameterTest, ifub_matches_brute_force) {
+    /* sparse pseudo-random graph with a long tail */
+    int64_t n = 600;
+    uint64_t x = 12345;
+    for (int64_t k = 0; k < 900; k++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        int64_t u = (x >> 33) % n;
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+        int64_t v = (x >> 33) % n;
+        if (u != v)
+            stinger_insert_edge(S, 0, u, v, 1, 1);
+    }
+    for (int64_t v = n; v < n + 25; v++) {
+        stinger_insert_edge(S, 0, v - 1, v, 1, 1);
+    }
+
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    diameter_bounds_t bounds;
+    EXPECT_EQ(undirected_diameter(S, nv), ifub_diameter(S, nv, &bounds));
+    EXPECT_TRUE(bounds.complete);
+    EXPECT_GT(nv, bounds.searches);
+}
+
+static bool
+stop_after_three(void * arg, int64_t lower, int64_t upper, int64_t searches) {
+    int64_t * calls = (int64_t *)arg;
+    (*calls)++;
+    EXPECT_LE(lower, upper);
+    return searches < 3;
+}
+
+TEST_F(DiameterTest, ifub_cancel) {
+    /* a cycle keeps iFUB busy: every level is searched */
+    int64_t n = 200;
+    for (int64_t v = 0; v < n; v++) {
+        stinger_insert_edge_pair(S, 0, v, (v + 1) % n, 1, 1);
+    }
+
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    int64_t calls = 0;
+    diameter_bounds_t bounds;
+    ifub_diameter(S, nv, &bounds, stop_after_three, &calls);
+    EXPECT_FALSE(bounds.complete);
+    EXPECT_LE(bounds.lower, 100);
+    EXPECT_GE(bounds.upper, 100);
+    EXPECT_GE(3 + 1, calls);
+
+    EXPECT_EQ(100, ifub_diameter(S, nv, &bounds));
+    EXPECT_TRUE(bounds.complete);
+}
+
+TEST_F(DiameterTest, sampled_mean_shortest_path) {
+    /* complete digraph on 30 vertices: every path has length 1 */
+    for (int64_t u = 0; u < 30; u++) {
+        for (int64_t v = 0; v < 30; v++) {
+            if (u != v)
+                stinger_insert_edge(S, 0, u, v, 1, 1);
+        }
+    }
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    double half_width = -1;
+    EXPECT_DOUBLE_EQ(1.0, mean_shortest_path_sampled(S, nv, 10, 7, true, &half_width));
+    EXPECT_DOUBLE_EQ(0.0, half_width);
+    EXPECT_EQ(1, mean_shortest_path(S, nv));
+}
+
+TEST_F(DiameterTest, mean_shortest_path_over_pairs) {
+    /* source 0 reaches 3 vertices at 10, source 1 reaches one at 1:
+     * 31 over 4 pairs, where averaging the two sources would give 5 */
+    stinger_insert_edge(S, 0, 0, 1, 10, 1);
+    stinger_insert_edge(S, 0, 0, 2, 10, 1);
+    stinger_insert_edge(S, 0, 0, 3, 10, 1);
+    stinger_insert_edge(S, 0, 1, 2, 1, 1);
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    EXPECT_EQ(7, mean_shortest_path(S, nv));
+}
+
+TEST_F(DiameterTest, sampled_mean_shortest_path_interval) {
+    /* undirected path of 101 vertices: the exact mean is 34 */
+    int64_t n = 101;
+    for (int64_t v = 0; v + 1 < n; v++) {
+        stinger_insert_edge_pair(S, 0, v, v + 1, 1, 1);
+    }
+    int64_t nv = stinger_max_active_vertex(S) + 1;
+    double half_width;
+    EXPECT_NEAR(34.0, mean_shortest_path_sampled(S, nv, 0, 0, true, &half_width), 1e-9);
+    EXPECT_EQ(0.0, half_width);
+
+    double estimate = mean_shortest_path_sampled(S, nv, 40, 99, true, &half_width);
+    EXPECT_LT(0.0, half_width);
+    EXPECT_NEAR(34.0, estimate, 3 * half_width);
+}
+
+
 int
 main (int argc, char *argv[])
 {
@@ -0,0 +1,285 @@
+#include "edge_map_test.h"
+
+#include <math.h>
+#include <vector>
+
+#define restrict
+
+#define NV 2000
+
+class EdgeMapTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+    seed = 777;
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  int64_t next_random(int64_t n) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (int64_t)((seed >> 33) % n);
+  }
+
+  /* random edges inside [first, first + n), of alternating types */
+  void insert_random(int64_t first, int64_t n, int64_t ne, bool pairs) {
+    for (int64_t k = 0; k < ne; k++) {
+      int64_t u = first + next_random(n);
+      int64_t v = first + next_random(n);
+      if (u == v)
+        continue;
+      if (pairs)
+        stinger_insert_edge_pair(S, k & 1, u, v, 1, 1);
+      else
+        stinger_insert_edge(S, k & 1, u, v, 1, 1);
+    }
+  }
+
+  void reference_bfs(int64_t source, std::vector<int64_t> & level) {
+    std::vector<int64_t> queue;
+    level.assign(NV, -1);
+    level[source] = 0;
+    queue.push_back(source);
+    for (size_t q = 0; q < queue.size(); q++) {
+      int64_t u = queue[q];
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+        int64_t v = STINGER_EDGE_DEST;
+        if (v < NV && level[v] < 0) {
+          level[v] = level[u] + 1;
+          queue.push_back(v);
+        }
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+  uint64_t seed;
+};
+
+struct bfs_arg {
+  int64_t * level;
+  int64_t round;
+};
+
+static int
+bfs_cond(int64_t v, void * arg) {
+  return ((bfs_arg *)arg)->level[v] < 0;
+}
+
+static int
+bfs_update_atomic(int64_t src, int64_t dst, int64_t weight, void * arg) {
+  bfs_arg * a = (bfs_arg *)arg;
+  return stinger_int64_cas(&a->level[dst], -1, a->round) == -1;
+}
+
+/* a BFS written against the framework, with the traversal direction forced */
+static void
+flagged_bfs(stinger_t * S, int64_t source, int flags, std::vector<int64_t> & level) {
+  const edge_map_ops_t ops = { NULL, bfs_update_atomic, bfs_cond };
+  level.assign(NV, -1);
+  bfs_arg arg = { &level[0], 0 };
+  edge_map_graph_t G;
+  vertex_subset_t frontier, next;
+
+  edge_map_graph_init(&G, S, NV, -1);
+  vertex_subset_init(&frontier, NV);
+  vertex_subset_init(&next, NV);
+  level[source] = 0;
+  vertex_subset_from_vertex(&frontier, source);
+  while (frontier.size > 0) {
+    arg.round++;
+    edge_map(&G, &frontier, &ops, &arg, &next, flags);
+    std::swap(frontier, next);
+  }
+  vertex_subset_release(&frontier);
+  vertex_subset_release(&next);
+  edge_map_graph_release(&G);
+}
+
+TEST_F(EdgeMapTest, VertexSubset) {
+  vertex_subset_t vs, out;
+  vertex_subset_init(&vs, 10);
+  vertex_subset_init(&out, 10);
+
+  vertex_subset_from_vertex(&vs, 3);
+  EXPECT_EQ(1, vs.size);
+  EXPECT_TRUE(vertex_subset_contains(&vs, 3));
+  EXPECT_FALSE(vertex_subset_contains(&vs, 4));
+
+  vertex_subset_to_dense(&vs);
+  EXPECT_TRUE(vs.is_dense);
+  EXPECT_TRUE(vertex_subset_contains(&vs, 3));
+  EXPECT_FALSE(vertex_subset_contains(&vs, 4));
+
+  vertex_subset_all(&vs);
+  EXPECT_EQ(10, vs.size);
+  vertex_subset_to_sparse(&vs);
+  EXPECT_FALSE(vs.is_dense);
+  EXPECT_EQ(10, vs.size);
+  for (int64_t v = 0; v < 10; v++)
+    EXPECT_TRUE(vertex_subset_contains(&vs, v));
+
+  struct even { static int fn(int64_t v, void *) { return v % 2 == 0; } };
+  EXPECT_EQ(5, vertex_map(&vs, even::fn, NULL, &out));
+  vertex_subset_to_dense(&vs);
+  EXPECT_EQ(5, vertex_map(&vs, even::fn, NULL, &out));
+  for (int64_t v = 0; v < 10; v++)
+    EXPECT_EQ(v % 2 == 0, vertex_subset_contains(&out, v));
+
+  vertex_subset_release(&vs);
+  vertex_subset_release(&out);
+}
+
+TEST_F(EdgeMapTest, BFSAllDirections) {
+  insert_random(0, NV, 4 * NV, false);
+
+  std::vector<int64_t> expect, level(NV);
+  for (int64_t source = 0; source < 3; source++) {
+    reference_bfs(source, expect);
+
+    int64_t reached = bfs_edge_map(S, NV, source, &level[0]);
+    int64_t expect_reached = 0;
+    for (int64_t v = 0; v < NV; v++) {
+      EXPECT_EQ(expect[v], level[v]) << "vertex " << v;
+      expect_reached += expect[v] >= 0;
+    }
+    EXPECT_EQ(expect_reached, reached);
+
+    const int flags[] = { EDGE_MAP_SPARSE, EDGE_MAP_DENSE, EDGE_MAP_DENSE | EDGE_MAP_DENSE_FORWARD };
+    for (int f = 0; f < 3; f++) {
+      flagged_bfs(S, source, flags[f], level);
+      for (int64_t v = 0; v < NV; v++) {
+        EXPECT_EQ(expect[v], level[v]) << "flags " << flags[f] << " vertex " << v;
+      }
+    }
+  }
+}
+
+TEST_F(EdgeMapTest, ConnectedComponents) {
+  /* a few directed blobs of different sizes and a tail of isolated vertices */
+  insert_random(0, 500, 1500, false);
+  insert_random(500, 700, 2000, false);
+  insert_random(1200, 50, 200, false);
+  insert_random(1250, 10, 30, false);
+
+  std::vector<int64_t> expect(NV), labels(NV);
+  int64_t expect_count = afforest_components(S, NV, &expect[0], 2);
+  int64_t count = connected_components_edge_map(S, NV, &labels[0]);
+
+  EXPECT_EQ(expect_count, count);
+  for (int64_t v = 0; v < NV; v++) {
+    EXPECT_EQ(expect[v], labels[v]) << "vertex " << v;
+  }
+}
+
+TEST_F(EdgeMapTest, PageRank) {
+  insert_random(0, NV, 5 * NV, true);
+
+  std::vector<double> expect(NV, 1.0 / NV), pr(NV, 1.0 / NV);
+  page_rank(S, NV, &expect[0], NULL, EPSILON_DEFAULT, DAMPINGFACTOR_DEFAULT, 100);
+  int64_t iter = page_rank_edge_map(S, NV, &pr[0], EPSILON_DEFAULT, DAMPINGFACTOR_DEFAULT, 100);
+
+  EXPECT_GT(iter, 1);
+  double sum = 0;
+  for (int64_t v = 0; v < NV; v++) {
+    EXPECT_NEAR(expect[v], pr[v], 1e-9) << "vertex " << v;
+    sum += pr[v];
+  }
+  EXPECT_NEAR(1.0, sum, 1e-6);
+}
+
+/*
+ * Old edges at times 1..99 and new ones at 100..199, some of them old edges
+ * seen again. Over [100, 199] the kernels must match the same kernels run on a
+ * graph holding only the new edges.
+ */
+class EdgeMapWindowTest : public EdgeMapTest {
+protected:
+  virtual void SetUp() {
+    EdgeMapTest::SetUp();
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    recent = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+
+    std::vector<int64_t> old_u, old_v;
+    for (int64_t k = 0; k < 3 * NV; k++) {
+      int64_t u = next_random(NV), v = next_random(NV);
+      stinger_insert_edge_pair(S, k & 1, u, v, 1, 1 + k % 99);
+      old_u.push_back(u);
+      old_v.push_back(v);
+    }
+    for (int64_t k = 0; k < NV; k++) {
+      int64_t u, v, type;
+      if (k % 4 == 0) {
+        u = old_u[k]; v = old_v[k]; type = k & 1;
+      } else {
+        u = next_random(NV / 2); v = next_random(NV / 2); type = next_random(2);
+      }
+      int64_t t = 100 + k % 100;
+      stinger_insert_edge_pair(S, type, u, v, 1, t);
+      stinger_insert_edge_pair(recent, type, u, v, 1, t);
+    }
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(recent);
+    EdgeMapTest::TearDown();
+  }
+
+  struct stinger * recent;
+};
+
+TEST_F(EdgeMapWindowTest, BFS) {
+  std::vector<int64_t> expect(NV), level(NV);
+  for (int64_t source = 0; source < 5; source++) {
+    int64_t expect_reached = bfs_edge_map(recent, NV, source, &expect[0]);
+    EXPECT_EQ(expect_reached, bfs_edge_map_window(S, NV, source, 100, 199, &level[0]));
+    for (int64_t v = 0; v < NV; v++) {
+      EXPECT_EQ(expect[v], level[v]) << "vertex " << v;
+    }
+  }
+}
+
+TEST_F(EdgeMapWindowTest, ConnectedComponents) {
+  std::vector<int64_t> expect(NV), labels(NV);
+  int64_t expect_count = connected_components_edge_map(recent, NV, &expect[0]);
+  EXPECT_EQ(expect_count, connected_components_edge_map_window(S, NV, 100, 199, &labels[0]));
+  for (int64_t v = 0; v < NV; v++) {
+    EXPECT_EQ(expect[v], labels[v]) << "vertex " << v;
+  }
+
+  /* everything is connected over all time */
+  int64_t all = connected_components_edge_map_window(S, NV, 0, 1000, &labels[0]);
+  EXPECT_EQ(connected_components_edge_map(S, NV, &expect[0]), all);
+}
+
+TEST_F(EdgeMapWindowTest, PageRank) {
+  std::vector<double> expect(NV, 1.0 / NV), pr(NV, 1.0 / NV);
+  page_rank_edge_map(recent, NV, &expect[0], EPSILON_DEFAULT, DAMPINGFACTOR_DEFAULT, 100);
+  page_rank_edge_map_window(S, NV, 100, 199, &pr[0], EPSILON_DEFAULT, DAMPINGFACTOR_DEFAULT, 100);
+  for (int64_t v = 0; v < NV; v++) {
+    EXPECT_NEAR(expect[v], pr[v], 1e-9) << "vertex " << v;
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,15 @@
+#ifndef STINGER_EDGE_MAP_TEST_H_
+#define STINGER_EDGE_MAP_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_core/stinger_atomics.h"
+#include "stinger_alg/edge_map.h"
+#include "stinger_alg/pagerank.h"
+#include "stinger_alg/static_components.h"
+}
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_EDGE_MAP_TEST_H_ */
@@ -0,0 +1,179 @@
+#include "graph_partition_test.h"
+
+#define restrict
+
+class GraphPartitionTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+    memset(&part_internal, 0, sizeof(part_internal));
+    stinger_partition_reset_stats(&stats);
+  }
+
+  virtual void TearDown() {
+    stinger_partition_release_internals(&part_internal);
+    stinger_free_all(S);
+  }
+
+  void insert_clique(int64_t first, int64_t size, stinger_edge_update * batch = NULL, int64_t * n = NULL) {
+    for (int64_t u = first; u < first + size; u++) {
+      for (int64_t v = u + 1; v < first + size; v++) {
+        stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+        if (batch) {
+          batch[*n].source = u;
+          batch[*n].destination = v;
+          (*n)++;
+        }
+      }
+    }
+  }
+
+  /* cut and sizes recomputed from scratch */
+  void expect_consistent(int64_t nv, int64_t k, const int64_t * partitions, const int64_t * sizes, const int64_t * cut) {
+    int64_t * expect_sizes = (int64_t *)xcalloc(k + 1, sizeof(int64_t));
+    int64_t * expect_cut = (int64_t *)xcalloc(k + 1, sizeof(int64_t));
+    for (int64_t v = 0; v < nv; v++) {
+      int64_t p = partitions[v];
+      ASSERT_LE(0, p);
+      ASSERT_GE(k, p);
+      if (!p)
+        continue;
+      expect_sizes[p]++;
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        int64_t q = partitions[STINGER_EDGE_DEST];
+        if (q && q != p) {
+          expect_cut[p]++;
+          expect_cut[0]++;
+        }
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+    for (int64_t p = 1; p <= k; p++) {
+      EXPECT_EQ(expect_sizes[p], sizes[p]) << "partition " << p;
+    }
+    for (int64_t p = 0; p <= k; p++) {
+      EXPECT_EQ(expect_cut[p], cut[p]) << "partition " << p;
+    }
+    xfree(expect_sizes);
+    xfree(expect_cut);
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+  stinger_partition_internal part_internal;
+  stinger_partition_stats stats;
+};
+
+TEST_F(GraphPartitionTest, StaticLDGKeepsCliquesTogether) {
+  /* four cliques of 8 joined in a ring by single edges */
+  for (int64_t c = 0; c < 4; c++) {
+    insert_clique(c * 8, 8);
+    stinger_insert_edge_pair(S, 0, c * 8, ((c + 1) % 4) * 8 + 1, 1, 1);
+  }
+
+  int64_t nv = S->max_nv;
+  int64_t * partitions = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t sizes[5], cut[5];
+
+  stinger_partition_initialize_internals(S, nv, &part_internal, 4, GRAPH_PARTITION_LDG, 0,
+    partitions, sizes, cut, &stats);
+  stinger_partition_restream(S, &part_internal, &stats, 4, partitions, sizes, cut);
+
+  EXPECT_EQ(32, stats.vertices_assigned);
+  EXPECT_EQ(0, partitions[32]);
+  for (int64_t p = 1; p <= 4; p++) {
+    EXPECT_GE(10, sizes[p]) << "partition " << p;
+  }
+  expect_consistent(nv, 4, partitions, sizes, cut);
+
+  /* with 4 partitions at most the 4 ring edges (8 records) should be cut */
+  EXPECT_GE(8, cut[0]);
+
+  xfree(partitions);
+}
+
+TEST_F(GraphPartitionTest, FennelBalances) {
+  /* a random-ish graph: every vertex linked to a few others */
+  int64_t n = 400;
+  for (int64_t v = 0; v < n; v++) {
+    for (int64_t j = 1; j <= 3; j++) {
+      stinger_insert_edge_pair(S, 0, v, (v * 7 + j * 31) % n, 1, 1);
+    }
+  }
+
+  int64_t nv = S->max_nv;
+  int64_t * partitions = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t sizes[5], cut[5];
+
+  stinger_partition_initialize_internals(S, nv, &part_internal, 4, GRAPH_PARTITION_FENNEL, 0,
+    partitions, sizes, cut, &stats);
+  stinger_partition_restream(S, &part_internal, &stats, 3, partitions, sizes, cut);
+
+  int64_t total = 0;
+  for (int64_t p = 1; p <= 4; p++) {
+    EXPECT_LT(0, sizes[p]) << "partition " << p;
+    EXPECT_GE(n / 2, sizes[p]) << "partition " << p;
+    total += sizes[p];
+  }
+  EXPECT_EQ(n, total);
+  expect_consistent(nv, 4, partitions, sizes, cut);
+
+  xfree(partitions);
+}
+
+TEST_F(GraphPartitionTest, StreamingUpdate) {
+  insert_clique(0, 6);
+
+  int64_t nv = S->max_nv;
+  int64_t * partitions = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  int64_t sizes[3], cut[3];
+
+  stinger_partition_initialize_internals(S, nv, &part_internal, 2, GRAPH_PARTITION_LDG, 0,
+    partitions, sizes, cut, &stats);
+  expect_consistent(nv, 2, partitions, sizes, cut);
+
+  /* a second clique arrives in one batch and a bridge to the first */
+  stinger_edge_update ins[32];
+  int64_t nins = 0;
+  insert_clique(100, 6, ins, &nins);
+  stinger_insert_edge_pair(S, 0, 0, 100, 1, 1);
+  ins[nins].source = 0;
+  ins[nins].destination = 100;
+  nins++;
+
+  int64_t placed = stinger_partition_update(S, &part_internal, &stats, ins, nins, NULL, 0,
+    partitions, sizes, cut);
+
+  EXPECT_EQ(6, placed);
+  for (int64_t v = 100; v < 106; v++) {
+    EXPECT_LT(0, partitions[v]) << "vertex " << v;
+  }
+  expect_consistent(nv, 2, partitions, sizes, cut);
+
+  /* removing the bridge drops whatever it cut */
+  stinger_remove_edge_pair(S, 0, 0, 100);
+  stinger_edge_update del[1];
+  del[0].source = 0;
+  del[0].destination = 100;
+  EXPECT_EQ(0, stinger_partition_update(S, &part_internal, &stats, NULL, 0, del, 1,
+    partitions, sizes, cut));
+  expect_consistent(nv, 2, partitions, sizes, cut);
+
+  stinger_partition_restream(S, &part_internal, &stats, 2, partitions, sizes, cut);
+  expect_consistent(nv, 2, partitions, sizes, cut);
+
+  xfree(partitions);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,12 @@
+#ifndef STINGER_GRAPH_PARTITION_TEST_H_
+#define STINGER_GRAPH_PARTITION_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_alg/graph_partition.h"
+}
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_GRAPH_PARTITION_TEST_H_ */
@@ -121,6 +121,82 @@ TEST_F(HITSTest, DirectedBipartite) {
 }
 
 
+TEST_F(HITSTest, ConvergesToPrincipalVectors) {
+    /* 0 and 1 point at 2, 3 and 4; 5 points at 2 only */
+    for (int64_t u = 0; u < 2; u++) {
+        for (int64_t v = 2; v < 5; v++) {
+            stinger_insert_edge(S, 0, u, v, 1, 1);
+        }
+    }
+    stinger_insert_edge(S, 0, 5, 2, 1, 1);
+
+    int64_t nv = stinger_max_active_vertex(S)+1;
+
+    double_t * auth = (double_t *)xcalloc(nv, sizeof(double_t));
+    double_t * hubs = (double_t *)xcalloc(nv, sizeof(double_t));
+
+    int64_t iters = hits_centrality_epsilon(S, nv, hubs, auth, NULL, 1e-12, 1000, 0);
+    EXPECT_LT(iters, 1000);
+
+    double auth_norm = 0, hubs_norm = 0;
+    for (int64_t v = 0; v < nv; v++) {
+        auth_norm += auth[v] * auth[v];
+        hubs_norm += hubs[v] * hubs[v];
+    }
+    EXPECT_NEAR(1.0, auth_norm, 1e-12);
+    EXPECT_NEAR(1.0, hubs_norm, 1e-12);
+
+    EXPECT_GT(auth[2], auth[3]);
+    EXPECT_NEAR(auth[3], auth[4], 1e-12);
+    EXPECT_DOUBLE_EQ(0.0, auth[0]);
+    EXPECT_NEAR(hubs[0], hubs[1], 1e-12);
+    EXPECT_GT(hubs[0], hubs[5]);
+    EXPECT_DOUBLE_EQ(0.0, hubs[2]);
+
+    /* the fixed-iteration entry point lands on the same vectors */
+    double_t * auth_k = (double_t *)xcalloc(nv, sizeof(double_t));
+    double_t * hubs_k = (double_t *)xcalloc(nv, sizeof(double_t));
+    hits_centrality(S, nv, hubs_k, auth_k, 100);
+    for (int64_t v = 0; v < nv; v++) {
+        EXPECT_NEAR(auth[v], auth_k[v], 1e-9);
+        EXPECT_NEAR(hubs[v], hubs_k[v], 1e-9);
+    }
+
+    /* restarting from the answer converges almost at once */
+    EXPECT_LE(hits_centrality_epsilon(S, nv, hubs, auth, NULL, 1e-9, 1000, 1), 2);
+
+    xfree(hubs_k);
+    xfree(auth_k);
+    xfree(hubs);
+    xfree(auth);
+}
+
+TEST_F(HITSTest, TypedEdges) {
+    /* type 0 makes 0 the hub of 1 and 2, type 1 makes 3 the hub of 4 */
+    stinger_insert_edge(S, 0, 0, 1, 1, 1);
+    stinger_insert_edge(S, 0, 0, 2, 1, 1);
+    stinger_insert_edge(S, 1, 3, 4, 1, 1);
+
+    int64_t nv = stinger_max_active_vertex(S)+1;
+
+    double_t * auth = (double_t *)xcalloc(nv, sizeof(double_t));
+    double_t * hubs = (double_t *)xcalloc(nv, sizeof(double_t));
+
+    hits_centrality_type(S, nv, hubs, auth, NULL, 1e-12, 100, 0, 1);
+    EXPECT_NEAR(1.0, hubs[3], 1e-12);
+    EXPECT_NEAR(1.0, auth[4], 1e-12);
+    EXPECT_DOUBLE_EQ(0.0, hubs[0]);
+    EXPECT_DOUBLE_EQ(0.0, auth[1]);
+
+    hits_centrality_type(S, nv, hubs, auth, NULL, 1e-12, 100, 0, 0);
+    EXPECT_NEAR(1.0, hubs[0], 1e-12);
+    EXPECT_NEAR(auth[1], auth[2], 1e-12);
+    EXPECT_DOUBLE_EQ(0.0, auth[4]);
+
+    xfree(hubs);
+    xfree(auth);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -23,6 +23,38 @@ protected:
         stinger_free_all(S);
     }
 
+    /* no edge inside the set, and every vertex outside it has a neighbor in it */
+    void expect_maximal_independent(int64_t nv, const int64_t * iset) {
+        for (int64_t v = 0; v < nv; v++) {
+            ASSERT_TRUE(iset[v] == 0 || iset[v] == 1) << "vertex " << v;
+            int64_t members = 0;
+            STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, v) {
+                int64_t u = STINGER_EDGE_DEST;
+                if (u != v && u < nv)
+                    members += iset[u];
+            } STINGER_FORALL_EDGES_OF_VTX_END();
+            if (iset[v])
+                EXPECT_EQ(0, members) << "vertex " << v;
+            else
+                EXPECT_LT(0, members) << "vertex " << v;
+        }
+    }
+
+    /* random undirected graph on nv vertices */
+    void insert_random_edges(int64_t nv, int64_t ne, uint64_t * state) {
+        for (int64_t k = 0; k < ne; k++) {
+            int64_t u = next_random(state) % nv;
+            int64_t v = next_random(state) % nv;
+            if (u != v)
+                stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+        }
+    }
+
+    static uint64_t next_random(uint64_t * state) {
+        *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return *state >> 33;
+    }
+
     struct stinger_config_t * stinger_config;
     struct stinger * S;
 };
@@ -106,6 +138,110 @@ TEST_F(IndependentTest, medium_DAG) {
     }
 }
 
+TEST_F(IndependentTest, LubyIsMaximalAndDeterministic) {
+    uint64_t state = 7;
+    int64_t nv = 2000;
+    insert_random_edges(nv, 8000, &state);
+
+    int64_t * a = (int64_t *)xcalloc(nv, sizeof(int64_t));
+    int64_t * b = (int64_t *)xcalloc(nv, sizeof(int64_t));
+
+    int64_t size = independent_set_luby(S, nv, a, 42);
+    expect_maximal_independent(nv, a);
+
+    int64_t count = 0;
+    for (int64_t v = 0; v < nv; v++)
+        count += a[v];
+    EXPECT_EQ(count, size);
+
+    EXPECT_EQ(size, independent_set_luby(S, nv, b, 42));
+    for (int64_t v = 0; v < nv; v++)
+        EXPECT_EQ(a[v], b[v]) << "vertex " << v;
+
+    xfree(b);
+    xfree(a);
+}
+
+TEST_F(IndependentTest, RepairAfterBatches) {
+    uint64_t state = 11;
+    int64_t nv = 1000;
+    insert_random_edges(nv, 3000, &state);
+
+    int64_t * iset = (int64_t *)xcalloc(nv + 50, sizeof(int64_t));
+    int64_t * before = (int64_t *)xcalloc(nv + 50, sizeof(int64_t));
+    independent_set_luby(S, nv, iset, 3);
+
+    stinger_edge_update ins[64];
+    stinger_edge_update del[64];
+
+    for (int batch = 0; batch < 10; batch++) {
+        int64_t new_nv = nv + 5;
+        int64_t n_ins = 0, n_del = 0;
+
+        /* join members to each other so the repair has conflicts to resolve */
+        int64_t last = -1;
+        for (int64_t v = 0; v < nv && n_ins < 16; v++) {
+            if (iset[v]) {
+                if (last >= 0) {
+                    stinger_insert_edge_pair(S, 0, last, v, 1, 1);
+                    ins[n_ins].source = last;
+                    ins[n_ins].destination = v;
+                    n_ins++;
+                }
+                last = v;
+                v += next_random(&state) % 50;
+            }
+        }
+        for (int64_t k = 0; k < 16; k++) {
+            int64_t u = next_random(&state) % new_nv;
+            int64_t v = next_random(&state) % new_nv;
+            if (u == v)
+                continue;
+            stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+            ins[n_ins].source = u;
+            ins[n_ins].destination = v;
+            n_ins++;
+        }
+
+        /* remove every edge of a few members */
+        for (int64_t v = 0; v < nv && n_del < 48; v++) {
+            if (iset[v] && next_random(&state) % 20 == 0) {
+                int64_t nbr[64];
+                int64_t n = 0;
+                STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+                    if (n < 64)
+                        nbr[n++] = STINGER_EDGE_DEST;
+                } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+                for (int64_t k = 0; k < n && n_del < 64; k++) {
+                    stinger_remove_edge_pair(S, 0, v, nbr[k]);
+                    del[n_del].source = v;
+                    del[n_del].destination = nbr[k];
+                    del[n_del].result = 1;
+                    n_del++;
+                }
+            }
+        }
+
+        for (int64_t v = 0; v < nv; v++)
+            before[v] = iset[v];
+
+        int64_t repaired = independent_set_update(S, nv, new_nv, iset, 3, ins, n_ins, del, n_del);
+        nv = new_nv;
+
+        expect_maximal_independent(nv, iset);
+        EXPECT_LT(repaired, nv / 2);
+
+        /* vertices outside the repair keep their membership */
+        int64_t changed = 0;
+        for (int64_t v = 0; v < nv - 5; v++)
+            changed += (before[v] != iset[v]);
+        EXPECT_LE(changed, repaired);
+    }
+
+    xfree(before);
+    xfree(iset);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -0,0 +1,158 @@
+#include "kcore_test.h"
+
+#define restrict
+
+class KCoreTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  void expect_matches_static(int64_t nv, int64_t * core, int64_t * counts, int64_t k) {
+    int64_t * core_ref = (int64_t *)xcalloc(nv, sizeof(int64_t));
+    int64_t * counts_ref = (int64_t *)xcalloc(nv, sizeof(int64_t));
+    int64_t k_ref;
+
+    kcore_decomposition(S, nv, core_ref, &k_ref);
+    kcore_neighbor_counts(S, nv, core_ref, counts_ref);
+
+    EXPECT_EQ(k_ref, k);
+    for (int64_t v = 0; v < nv; v++) {
+      EXPECT_EQ(core_ref[v], core[v]) << "core of vertex " << v;
+      EXPECT_EQ(counts_ref[v], counts[v]) << "count of vertex " << v;
+    }
+
+    xfree(counts_ref);
+    xfree(core_ref);
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+};
+
+TEST_F(KCoreTest, StaticDecomposition) {
+  /* 4-clique 0..3 with a triangle 3,4,5 and a pendant 6 */
+  int64_t edges[][2] = {
+    {0,1}, {0,2}, {0,3}, {1,2}, {1,3}, {2,3},
+    {3,4}, {4,5}, {5,3},
+    {5,6}
+  };
+  for (int64_t i = 0; i < 10; i++) {
+    stinger_insert_edge_pair(S, 0, edges[i][0], edges[i][1], 1, 1);
+  }
+
+  int64_t nv = 8;
+  int64_t core[8];
+  int64_t counts[8];
+  int64_t k;
+
+  kcore_decomposition(S, nv, core, &k);
+  kcore_neighbor_counts(S, nv, core, counts);
+
+  int64_t expected[8] = {3, 3, 3, 3, 2, 2, 1, 0};
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_EQ(expected[v], core[v]);
+  }
+  EXPECT_EQ(3, k);
+  EXPECT_EQ(3, counts[0]);
+  EXPECT_EQ(3, counts[3]);
+  EXPECT_EQ(2, counts[4]);
+  EXPECT_EQ(1, counts[6]);
+  EXPECT_EQ(0, counts[7]);
+}
+
+TEST_F(KCoreTest, StreamingInsertAndDelete) {
+  int64_t nv = 64;
+  int64_t * core = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  int64_t * counts = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  int64_t k;
+
+  /* a ring with chords */
+  for (int64_t v = 0; v < 32; v++) {
+    stinger_insert_edge_pair(S, 0, v, (v + 1) % 32, 1, 1);
+    if (v % 4 == 0)
+      stinger_insert_edge_pair(S, 1, v, (v + 7) % 32, 1, 1);
+  }
+
+  stinger_kcore_internal kcore_internal;
+  stinger_kcore_stats stats;
+  stinger_kcore_reset_stats(&stats);
+  stinger_kcore_initialize_internals(S, nv, &kcore_internal, core, counts, &k);
+  expect_matches_static(nv, core, counts, k);
+
+  /* grow a 5-clique over 40..44 and attach it to the ring, one batch */
+  stinger_edge_update insertions[16];
+  int64_t num_insertions = 0;
+  for (int64_t u = 40; u < 45; u++) {
+    for (int64_t v = u + 1; v < 45; v++) {
+      insertions[num_insertions].type = 0;
+      insertions[num_insertions].source = u;
+      insertions[num_insertions].destination = v;
+      num_insertions++;
+    }
+  }
+  insertions[num_insertions].type = 0;
+  insertions[num_insertions].source = 44;
+  insertions[num_insertions].destination = 3;
+  num_insertions++;
+
+  for (int64_t i = 0; i < num_insertions; i++) {
+    insertions[i].result = stinger_insert_edge_pair(S, insertions[i].type,
+      insertions[i].source, insertions[i].destination, 1, 2);
+  }
+
+  stinger_kcore_update(S, &kcore_internal, &stats, insertions, num_insertions, NULL, 0, core, counts, &k);
+  expect_matches_static(nv, core, counts, k);
+  EXPECT_EQ(4, k);
+  EXPECT_EQ(num_insertions, stats.insertions_processed);
+
+  /* cut the ring in two places and remove a clique edge in the same batch as
+   * closing the ring again with a new chord */
+  stinger_edge_update deletions[3];
+  int64_t del[3][2] = { {10, 11}, {20, 21}, {40, 41} };
+  for (int64_t i = 0; i < 3; i++) {
+    deletions[i].type = 0;
+    deletions[i].source = del[i][0];
+    deletions[i].destination = del[i][1];
+    deletions[i].result = stinger_remove_edge_pair(S, 0, del[i][0], del[i][1]);
+  }
+  insertions[0].type = 1;
+  insertions[0].source = 11;
+  insertions[0].destination = 20;
+  insertions[0].result = stinger_insert_edge_pair(S, 1, 11, 20, 1, 3);
+
+  stinger_kcore_update(S, &kcore_internal, &stats, insertions, 1, deletions, 3, core, counts, &k);
+  expect_matches_static(nv, core, counts, k);
+  EXPECT_EQ(3, k);
+
+  /* re-inserting an edge that already exists changes nothing */
+  insertions[0].type = 0;
+  insertions[0].source = 0;
+  insertions[0].destination = 1;
+  insertions[0].result = stinger_insert_edge_pair(S, 0, 0, 1, 1, 4);
+
+  stinger_kcore_update(S, &kcore_internal, &stats, insertions, 1, NULL, 0, core, counts, &k);
+  expect_matches_static(nv, core, counts, k);
+
+  stinger_kcore_release_internals(&kcore_internal);
+  xfree(counts);
+  xfree(core);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
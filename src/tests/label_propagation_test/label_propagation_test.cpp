@@ -0,0 +1,152 @@
+#include "label_propagation_test.h"
+
+#define restrict
+
+class LabelPropagationTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+    memset(&lp_internal, 0, sizeof(lp_internal));
+    stinger_label_propagation_reset_stats(&stats);
+  }
+
+  virtual void TearDown() {
+    stinger_label_propagation_release_internals(&lp_internal);
+    stinger_free_all(S);
+  }
+
+  void insert_clique(int64_t first, int64_t size, stinger_edge_update * batch = NULL, int64_t * n = NULL) {
+    for (int64_t u = first; u < first + size; u++) {
+      for (int64_t v = u + 1; v < first + size; v++) {
+        stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+        if (batch) {
+          batch[*n].source = u;
+          batch[*n].destination = v;
+          (*n)++;
+        }
+      }
+    }
+  }
+
+  /* ring of cliques, each clique joined to the next by one edge */
+  void insert_ring_of_cliques(int64_t num_cliques, int64_t size) {
+    for (int64_t c = 0; c < num_cliques; c++) {
+      insert_clique(c * size, size);
+      stinger_insert_edge_pair(S, 0, c * size, ((c + 1) % num_cliques) * size + 1, 1, 1);
+    }
+  }
+
+  void expect_cliques(int64_t num_cliques, int64_t size, const int64_t * labels) {
+    for (int64_t v = 0; v < num_cliques * size; v++) {
+      EXPECT_EQ((v / size) * size, labels[v]) << "vertex " << v;
+    }
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+  stinger_label_propagation_internal lp_internal;
+  stinger_label_propagation_stats stats;
+};
+
+TEST_F(LabelPropagationTest, RingOfCliques) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t labels[32];
+  stinger_label_propagation_initialize_internals(S, 32, &lp_internal, 0, labels, &stats);
+
+  expect_cliques(6, 5, labels);
+  EXPECT_EQ(31, labels[31]);
+  EXPECT_EQ(8, label_propagation_count(32, labels));
+  EXPECT_GT(stats.rounds, 1);
+  EXPECT_LT(stats.rounds, LABEL_PROPAGATION_DEFAULT_ITERATIONS);
+}
+
+TEST_F(LabelPropagationTest, PairDoesNotOscillate) {
+  stinger_insert_edge_pair(S, 0, 3, 4, 1, 1);
+
+  int64_t labels[8];
+  stinger_label_propagation_initialize_internals(S, 8, &lp_internal, 0, labels, &stats);
+
+  EXPECT_EQ(3, labels[3]);
+  EXPECT_EQ(3, labels[4]);
+  EXPECT_EQ(2, stats.rounds);
+}
+
+TEST_F(LabelPropagationTest, HeavierEdgeWins) {
+  /* 2 is tied to 0 by weight 5 and to 1 by weight 1 */
+  stinger_insert_edge_pair(S, 0, 2, 0, 5, 1);
+  stinger_insert_edge_pair(S, 0, 2, 1, 1, 1);
+  insert_clique(1, 1);
+
+  int64_t labels[4];
+  stinger_label_propagation_initialize_internals(S, 4, &lp_internal, 0, labels, &stats);
+
+  EXPECT_EQ(0, labels[2]);
+  EXPECT_EQ(0, labels[0]);
+}
+
+TEST_F(LabelPropagationTest, StreamingInsertions) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t labels[40];
+  stinger_label_propagation_initialize_internals(S, 40, &lp_internal, 0, labels, &stats);
+
+  stinger_edge_update ins[16];
+  int64_t n = 0;
+  insert_clique(30, 5, ins, &n);
+  stinger_insert_edge_pair(S, 0, 2, 31, 1, 1);
+  ins[n].source = 2;
+  ins[n].destination = 31;
+  n++;
+
+  stinger_label_propagation_reset_stats(&stats);
+  stinger_label_propagation_update(S, &lp_internal, &stats, ins, n, NULL, 0, labels);
+
+  expect_cliques(7, 5, labels);
+  EXPECT_EQ(12, label_propagation_count(40, labels));
+
+  /* only the new clique and the vertices next to it were looked at */
+  EXPECT_LT(stats.vertices_evaluated, 4 * 12);
+}
+
+TEST_F(LabelPropagationTest, StreamingDeletions) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t labels[30];
+  stinger_label_propagation_initialize_internals(S, 30, &lp_internal, 0, labels, &stats);
+
+  /* cut vertex 17 loose from clique 3 */
+  stinger_edge_update del[4];
+  int64_t n = 0;
+  for (int64_t v = 15; v < 20; v++) {
+    if (v == 17)
+      continue;
+    stinger_remove_edge_pair(S, 0, 17, v);
+    del[n].source = 17;
+    del[n].destination = v;
+    del[n].result = 1;
+    n++;
+  }
+
+  stinger_label_propagation_update(S, &lp_internal, &stats, NULL, 0, del, n, labels);
+
+  EXPECT_EQ(17, labels[17]);
+  for (int64_t v = 0; v < 30; v++) {
+    if (v != 17)
+      EXPECT_EQ((v / 5) * 5, labels[v]) << "vertex " << v;
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,12 @@
+#ifndef STINGER_LABEL_PROPAGATION_TEST_H_
+#define STINGER_LABEL_PROPAGATION_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_alg/label_propagation.h"
+}
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_LABEL_PROPAGATION_TEST_H_ */
@@ -0,0 +1,167 @@
+#include "louvain_test.h"
+
+#define restrict
+
+class LouvainTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  void insert_clique(int64_t first, int64_t size) {
+    for (int64_t u = first; u < first + size; u++) {
+      for (int64_t v = u + 1; v < first + size; v++) {
+        stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+      }
+    }
+  }
+
+  /* ring of cliques, each clique joined to the next by one edge */
+  void insert_ring_of_cliques(int64_t num_cliques, int64_t size) {
+    for (int64_t c = 0; c < num_cliques; c++) {
+      insert_clique(c * size, size);
+      stinger_insert_edge_pair(S, 0, c * size, ((c + 1) % num_cliques) * size + 1, 1, 1);
+    }
+  }
+
+  void expect_cliques(int64_t num_cliques, int64_t size, const int64_t * partitions) {
+    for (int64_t v = 0; v < num_cliques * size; v++) {
+      EXPECT_EQ((v / size) * size, partitions[v]) << "vertex " << v;
+    }
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+};
+
+TEST_F(LouvainTest, RingOfCliques) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t nv = 30;
+  int64_t partitions[30];
+  stinger_louvain_stats stats;
+  stinger_louvain_reset_stats(&stats);
+
+  int64_t count = louvain_communities(S, nv, partitions, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, &stats);
+
+  EXPECT_EQ(6, count);
+  EXPECT_EQ(6, stats.communities);
+  expect_cliques(6, 5, partitions);
+
+  /* 6 * (10/66 - (22/132)^2) */
+  EXPECT_NEAR(6.0 * (10.0 / 66.0 - (22.0 / 132.0) * (22.0 / 132.0)), stats.modularity, 1e-9);
+}
+
+TEST_F(LouvainTest, IsolatedVerticesStayAlone) {
+  insert_clique(0, 4);
+
+  int64_t nv = 10;
+  int64_t partitions[10];
+  int64_t count = louvain_communities(S, nv, partitions, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, NULL);
+
+  EXPECT_EQ(7, count);
+  for (int64_t v = 0; v < 4; v++)
+    EXPECT_EQ(0, partitions[v]);
+  for (int64_t v = 4; v < nv; v++)
+    EXPECT_EQ(v, partitions[v]);
+}
+
+TEST_F(LouvainTest, CommunityDetectionWrapper) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t partitions[30];
+  community_detection(S, 30, partitions, 5);
+  expect_cliques(6, 5, partitions);
+}
+
+TEST_F(LouvainTest, WarmStartInsertions) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t partitions[40];
+  louvain_communities(S, 30, partitions, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, NULL);
+
+  /* a seventh clique on new vertices, hanging off clique 0 */
+  stinger_edge_update ins[11];
+  int64_t n = 0;
+  for (int64_t u = 30; u < 35; u++) {
+    for (int64_t v = u + 1; v < 35; v++) {
+      stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+      ins[n].source = u;
+      ins[n].destination = v;
+      n++;
+    }
+  }
+  stinger_insert_edge_pair(S, 0, 2, 31, 1, 1);
+  ins[n].source = 2;
+  ins[n].destination = 31;
+  n++;
+
+  stinger_louvain_stats stats;
+  stinger_louvain_reset_stats(&stats);
+  int64_t count = louvain_communities_update(S, 30, 40, partitions, ins, n, NULL, 0,
+    LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, &stats);
+
+  EXPECT_EQ(12, count);
+  expect_cliques(7, 5, partitions);
+  for (int64_t v = 35; v < 40; v++)
+    EXPECT_EQ(v, partitions[v]);
+
+  int64_t cold[40];
+  louvain_communities(S, 40, cold, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, NULL);
+  for (int64_t v = 0; v < 40; v++)
+    EXPECT_EQ(cold[v], partitions[v]) << "vertex " << v;
+}
+
+TEST_F(LouvainTest, WarmStartSplitsDisconnectedCommunity) {
+  insert_ring_of_cliques(6, 5);
+
+  int64_t partitions[30];
+  louvain_communities(S, 30, partitions, LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, NULL);
+  expect_cliques(6, 5, partitions);
+
+  /* empty out clique 1 (vertices 5..9) */
+  stinger_edge_update del[16];
+  int64_t n = 0;
+  for (int64_t u = 5; u < 10; u++) {
+    for (int64_t v = u + 1; v < 10; v++) {
+      stinger_remove_edge_pair(S, 0, u, v);
+      del[n].source = u;
+      del[n].destination = v;
+      del[n].result = 1;
+      n++;
+    }
+  }
+
+  int64_t count = louvain_communities_update(S, 30, 30, partitions, NULL, 0, del, n,
+    LOUVAIN_DEFAULT_LEVELS, LOUVAIN_DEFAULT_ITERATIONS, NULL);
+
+  /* 6 follows its bridge into clique 0 and 5 into clique 2, which is now
+   * labeled 5; the rest of the old clique is left alone */
+  EXPECT_EQ(8, count);
+  EXPECT_EQ(0, partitions[6]);
+  EXPECT_EQ(5, partitions[5]);
+  for (int64_t v = 7; v < 10; v++)
+    EXPECT_EQ(v, partitions[v]) << "vertex " << v;
+  for (int64_t v = 10; v < 15; v++)
+    EXPECT_EQ(5, partitions[v]) << "vertex " << v;
+  for (int64_t v = 15; v < 30; v++)
+    EXPECT_EQ((v / 5) * 5, partitions[v]) << "vertex " << v;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
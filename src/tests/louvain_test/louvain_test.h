@@ -0,0 +1,13 @@
+#ifndef STINGER_LOUVAIN_TEST_H_
+#define STINGER_LOUVAIN_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_alg/louvain.h"
+#include "stinger_alg/modularity.h"
+}
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_LOUVAIN_TEST_H_ */
@@ -0,0 +1,147 @@
+#include "neighborhood_cache_test.h"
+
+#define restrict
+
+using namespace gt::stinger;
+
+class NeighborhoodCacheTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+        stinger_config->nv = 1<<13;
+        stinger_config->nebs = 1<<16;
+        stinger_config->netypes = 2;
+        stinger_config->nvtypes = 2;
+        stinger_config->memory_size = 1<<30;
+        S = stinger_new_full(stinger_config);
+        xfree(stinger_config);
+
+        /* path 0 - 1 - 2 - 3, and 0 - 4 */
+        insert(0, 1);
+        insert(1, 2);
+        insert(2, 3);
+        insert(0, 4);
+        /* entries are only kept for the newest epoch applied */
+        StingerBatch empty;
+        cache.invalidate(empty, 0);
+    }
+
+    virtual void TearDown() {
+        stinger_free_all(S);
+    }
+
+    void insert(int64_t u, int64_t v) {
+        stinger_insert_edge_pair(S, 0, u, v, 1, 1);
+    }
+
+    /* inserts u - v into S and applies it to the cache as epoch */
+    void apply(int64_t u, int64_t v, int64_t epoch) {
+        insert(u, v);
+        StingerBatch batch;
+        EdgeInsertion * in = batch.add_insertions();
+        in->set_source(u);
+        in->set_destination(v);
+        cache.invalidate(batch, epoch);
+    }
+
+    struct stinger_config_t * stinger_config;
+    struct stinger * S;
+    NeighborhoodCache cache;
+};
+
+TEST_F(NeighborhoodCacheTest, HitWithinEpoch) {
+    Neighborhood a, b;
+    cache.get(S, 0, 0, 2, -1, a);
+    cache.get(S, 0, 0, 2, -1, b);
+
+    neighborhood_cache_stats_t stats = cache.get_stats();
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(1, stats.hits);
+    EXPECT_EQ(1, stats.entries);
+    EXPECT_EQ(4, a.vertices.size());   /* 0, 1, 4, 2 */
+    EXPECT_EQ(a.vertices, b.vertices);
+    EXPECT_EQ(a.edges, b.edges);
+}
+
+TEST_F(NeighborhoodCacheTest, DropsEdgeInsideNeighborhood) {
+    Neighborhood hood;
+    cache.get(S, 0, 0, 2, -1, hood);
+    EXPECT_EQ(4, hood.vertices.size());
+
+    /* 1 is one hop out, so a new neighbor of 1 joins at two */
+    apply(1, 7, 1);
+    neighborhood_cache_stats_t stats = cache.get_stats();
+    EXPECT_EQ(1, stats.invalidations);
+    EXPECT_EQ(0, stats.entries);
+
+    cache.get(S, 1, 0, 2, -1, hood);
+    EXPECT_EQ(5, hood.vertices.size());
+    EXPECT_EQ(0, cache.get_stats().hits);
+}
+
+TEST_F(NeighborhoodCacheTest, DropsEdgeJoiningMembers) {
+    Neighborhood hood;
+    cache.get(S, 0, 0, 2, -1, hood);
+    size_t edges = hood.edges.size();
+
+    /* 2 and 4 are both on the boundary, but the edge is among members */
+    apply(2, 4, 1);
+    EXPECT_EQ(1, cache.get_stats().invalidations);
+
+    cache.get(S, 1, 0, 2, -1, hood);
+    EXPECT_EQ(4, hood.vertices.size());
+    EXPECT_EQ(edges + 6, hood.edges.size());
+    EXPECT_EQ(0, cache.get_stats().hits);
+}
+
+TEST_F(NeighborhoodCacheTest, KeepsEdgeOnBoundary) {
+    Neighborhood before, after;
+    cache.get(S, 0, 0, 2, -1, before);
+
+    /* 2 is two hops out; its new neighbor stays outside */
+    apply(2, 7, 1);
+    neighborhood_cache_stats_t stats = cache.get_stats();
+    EXPECT_EQ(0, stats.invalidations);
+    EXPECT_EQ(1, stats.entries);
+
+    cache.get(S, 1, 0, 2, -1, after);
+    EXPECT_EQ(1, cache.get_stats().hits);
+    EXPECT_EQ(before.vertices, after.vertices);
+    EXPECT_EQ(before.edges, after.edges);
+}
+
+TEST_F(NeighborhoodCacheTest, NeverServesStaleEpoch) {
+    Neighborhood hood;
+    cache.get(S, 0, 0, 1, -1, hood);
+    EXPECT_EQ(3, hood.vertices.size());
+
+    /* a reader on an epoch whose batch the cache has not seen yet */
+    insert(0, 9);
+    cache.get(S, 1, 0, 1, -1, hood);
+    EXPECT_EQ(4, hood.vertices.size());
+    EXPECT_EQ(0, cache.get_stats().hits);
+
+    /* once applied, the entry is gone and one for epoch 1 replaces it */
+    StingerBatch batch;
+    EdgeInsertion * in = batch.add_insertions();
+    in->set_source(0);
+    in->set_destination(9);
+    cache.invalidate(batch, 1);
+    EXPECT_EQ(0, cache.get_stats().entries);
+    cache.get(S, 1, 0, 1, -1, hood);
+    EXPECT_EQ(1, cache.get_stats().entries);
+
+    /* a reader still pinned to epoch 0 must not see it */
+    cache.get(S, 0, 0, 1, -1, hood);
+    EXPECT_EQ(0, cache.get_stats().hits);
+    cache.get(S, 1, 0, 1, -1, hood);
+    EXPECT_EQ(1, cache.get_stats().hits);
+    EXPECT_EQ(4, hood.vertices.size());
+}
+
+int
+main (int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,13 @@
+#ifndef STINGER_NEIGHBORHOOD_CACHE_TEST_H
+#define STINGER_NEIGHBORHOOD_CACHE_TEST_H
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+}
+
+#include "neighborhood_cache.h"
+
+#include "gtest/gtest.h"
+
+#endif //STINGER_NEIGHBORHOOD_CACHE_TEST_H
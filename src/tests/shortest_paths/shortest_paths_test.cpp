@@ -81,6 +81,80 @@ TEST_F(ShortestPathsTest, medium_DAG){
     EXPECT_EQ(3, paths[18]);
 }
 
+TEST_F(ShortestPathsTest, settles_cheapest_first){
+    // the direct edge is found first but is more expensive than the detour
+    stinger_insert_edge(S, 0, 0, 1, 100, 1);
+    stinger_insert_edge(S, 0, 0, 2, 1, 1);
+    stinger_insert_edge(S, 0, 2, 3, 1, 1);
+    stinger_insert_edge(S, 0, 3, 1, 1, 1);
+    stinger_insert_edge(S, 0, 1, 4, 1, 1);
+
+    int64_t nv = stinger_max_active_vertex(S)+1;
+    std::vector<int64_t> paths = dijkstra(S, nv, 0, false);
+    EXPECT_EQ(3, paths[1]);
+    EXPECT_EQ(4, paths[4]);
+    EXPECT_EQ(4, a_star(S, nv, 0, 4, false));
+}
+
+TEST_F(ShortestPathsTest, delta_stepping_matches_dijkstra){
+    uint64_t state = 42;
+    int64_t nv = 500;
+    for (int64_t i = 0; i < 3000; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        int64_t u = (state >> 33) % nv;
+        int64_t v = (state >> 13) % nv;
+        int64_t w = 1 + ((state >> 5) % 20);
+        stinger_insert_edge(S, (state >> 3) & 1, u, v, w, 1);
+    }
+
+    for (int64_t source = 0; source < 5; source++) {
+        std::vector<int64_t> expected = dijkstra(S, nv, source, false);
+        for (int64_t delta = 0; delta <= 64; delta = delta ? delta * 4 : 1) {
+            std::vector<int64_t> paths = delta_stepping(S, nv, source, false, delta);
+            for (int64_t v = 0; v < nv; v++) {
+                ASSERT_EQ(expected[v], paths[v]) << "source " << source << " delta " << delta << " vertex " << v;
+            }
+        }
+
+        std::vector<int64_t> hops = dijkstra(S, nv, source, true);
+        std::vector<int64_t> paths = delta_stepping(S, nv, source, true, 0);
+        for (int64_t v = 0; v < nv; v++) {
+            ASSERT_EQ(hops[v], paths[v]);
+        }
+
+        for (int64_t dest = 0; dest < nv; dest += 37) {
+            EXPECT_EQ(expected[dest], bidirectional_shortest_path(S, nv, source, dest, false));
+            EXPECT_EQ(hops[dest], bidirectional_shortest_path(S, nv, source, dest, true));
+        }
+    }
+
+    std::vector<int64_t> sources;
+    for (int64_t v = 0; v < 40; v += 3) {
+        sources.push_back(v);
+    }
+    std::vector<std::vector<int64_t> > rows = multi_source_shortest_paths(S, nv, sources, false, 0);
+    ASSERT_EQ(sources.size(), rows.size());
+    for (size_t i = 0; i < sources.size(); i++) {
+        std::vector<int64_t> expected = dijkstra(S, nv, sources[i], false);
+        for (int64_t v = 0; v < nv; v++) {
+            ASSERT_EQ(expected[v], rows[i][v]);
+        }
+    }
+}
+
+TEST_F(ShortestPathsTest, bidirectional_asymmetric_weights){
+    // the two directions of each edge carry different weights
+    stinger_insert_edge(S, 0, 0, 1, 5, 1);
+    stinger_insert_edge(S, 0, 1, 0, 1, 1);
+    stinger_insert_edge(S, 0, 1, 2, 1, 1);
+    stinger_insert_edge(S, 0, 2, 1, 9, 1);
+
+    int64_t nv = stinger_max_active_vertex(S)+1;
+    EXPECT_EQ(6, bidirectional_shortest_path(S, nv, 0, 2, false));
+    EXPECT_EQ(10, bidirectional_shortest_path(S, nv, 2, 0, false));
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(), bidirectional_shortest_path(S, nv, 0, 3, false));
+}
+
 
 
 int
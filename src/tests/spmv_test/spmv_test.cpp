@@ -0,0 +1,241 @@
+#include "spmv_test.h"
+
+#include <math.h>
+#include <vector>
+
+#define restrict
+
+#define NV 500
+
+/* near enough, with equal infinities matching */
+static bool
+same(double a, double b) {
+  return a == b || fabs(a - b) < 1e-9;
+}
+
+class SpMVTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+
+    /* vertex degrees from 0 to 19 so rows hit both the vector loop and the tail */
+    uint64_t seed = 12345;
+    for (int64_t u = 0; u < NV; u++) {
+      int64_t deg = u % 20;
+      for (int64_t k = 0; k < deg; k++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int64_t v = (seed >> 33) % NV;
+        int64_t w = 1 + (seed >> 20) % 9;
+        int64_t type = (seed >> 40) & 1;
+        stinger_insert_edge(S, type, u, v, w, 1);
+      }
+    }
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  /* y = (+)_j A(i,j) (*) x[j], or its transpose, over every edge of type etype */
+  void reference(stinger_semiring_t sr, int transposed, int64_t etype, const double * x, double * y) {
+    double zero = stinger_semiring_zero(sr);
+    for (int64_t i = 0; i < NV; i++)
+      y[i] = zero;
+    for (int64_t u = 0; u < NV; u++) {
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+        if (etype >= 0 && STINGER_EDGE_TYPE != etype)
+          continue;
+        int64_t row = transposed ? STINGER_EDGE_DEST : u;
+        int64_t col = transposed ? u : STINGER_EDGE_DEST;
+        double a = (double)STINGER_EDGE_WEIGHT;
+        double b = x[col];
+        switch (sr) {
+          case STINGER_SEMIRING_PLUS_TIMES: y[row] += a * b; break;
+          case STINGER_SEMIRING_MIN_PLUS:   y[row] = fmin(y[row], a + b); break;
+          case STINGER_SEMIRING_OR_AND:     y[row] = (y[row] != 0 || (a != 0 && b != 0)) ? 1 : 0; break;
+          case STINGER_SEMIRING_MAX_TIMES:  y[row] = fmax(y[row], a * b); break;
+        }
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+  }
+
+  void fill_x(stinger_semiring_t sr, double * x) {
+    for (int64_t i = 0; i < NV; i++) {
+      if (sr == STINGER_SEMIRING_OR_AND)
+        x[i] = (i % 3 == 0) ? 1 : 0;
+      else if (sr == STINGER_SEMIRING_MIN_PLUS && i % 7 == 0)
+        x[i] = stinger_semiring_zero(sr);
+      else
+        x[i] = (double)(i % 11) * 0.5;
+    }
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+};
+
+static const stinger_semiring_t semirings[] = {
+  STINGER_SEMIRING_PLUS_TIMES, STINGER_SEMIRING_MIN_PLUS,
+  STINGER_SEMIRING_OR_AND, STINGER_SEMIRING_MAX_TIMES
+};
+
+TEST_F(SpMVTest, DenseAllSemirings) {
+  std::vector<double> x(NV), y(NV), expect(NV);
+
+  for (int transposed = 0; transposed < 2; transposed++) {
+    stinger_csr_t A;
+    stinger_csr_from_stinger(S, NV, -1, transposed, &A);
+    EXPECT_EQ(A.off[NV], A.ne);
+
+    for (int s = 0; s < 4; s++) {
+      fill_x(semirings[s], &x[0]);
+      reference(semirings[s], transposed, -1, &x[0], &expect[0]);
+      stinger_csr_spmv(&A, semirings[s], &x[0], &y[0], NULL, 0);
+      for (int64_t i = 0; i < NV; i++) {
+        EXPECT_TRUE(same(expect[i], y[i])) << expect[i] << " vs " << y[i] << ", semiring " << s << " transposed " << transposed << " row " << i;
+      }
+    }
+
+    stinger_csr_release(&A);
+  }
+}
+
+TEST_F(SpMVTest, EdgeTypeAndSortedRows) {
+  stinger_csr_t A;
+  stinger_csr_from_stinger(S, NV, 1, 0, &A);
+
+  int64_t ne = 0;
+  for (int64_t u = 0; u < NV; u++) {
+    ne += stinger_typed_outdegree(S, u, 1);
+    for (int64_t k = A.off[u] + 1; k < A.off[u+1]; k++) {
+      EXPECT_LT(A.ind[k-1], A.ind[k]);
+    }
+  }
+  EXPECT_EQ(ne, A.ne);
+
+  std::vector<double> x(NV), y(NV), expect(NV);
+  fill_x(STINGER_SEMIRING_PLUS_TIMES, &x[0]);
+  reference(STINGER_SEMIRING_PLUS_TIMES, 0, 1, &x[0], &expect[0]);
+  stinger_csr_spmv(&A, STINGER_SEMIRING_PLUS_TIMES, &x[0], &y[0], NULL, 0);
+  for (int64_t i = 0; i < NV; i++) {
+    EXPECT_NEAR(expect[i], y[i], 1e-9);
+  }
+
+  stinger_csr_release(&A);
+}
+
+TEST_F(SpMVTest, Mask) {
+  stinger_csr_t A;
+  stinger_csr_from_stinger(S, NV, -1, 0, &A);
+
+  std::vector<double> x(NV), expect(NV);
+  std::vector<uint8_t> mask(NV);
+  for (int64_t i = 0; i < NV; i++)
+    mask[i] = (i % 2 == 0);
+  fill_x(STINGER_SEMIRING_PLUS_TIMES, &x[0]);
+  reference(STINGER_SEMIRING_PLUS_TIMES, 0, -1, &x[0], &expect[0]);
+
+  for (int complement = 0; complement < 2; complement++) {
+    std::vector<double> y(NV, -1.0);
+    stinger_csr_spmv(&A, STINGER_SEMIRING_PLUS_TIMES, &x[0], &y[0], &mask[0], complement);
+    for (int64_t i = 0; i < NV; i++) {
+      if ((mask[i] != 0) != (complement != 0))
+        EXPECT_NEAR(expect[i], y[i], 1e-9);
+      else
+        EXPECT_EQ(-1.0, y[i]);
+    }
+  }
+
+  stinger_csr_release(&A);
+}
+
+TEST_F(SpMVTest, SparseMatchesDense) {
+  stinger_csr_t A, AT;
+  stinger_csr_from_stinger(S, NV, -1, 0, &A);
+  stinger_csr_from_stinger(S, NV, -1, 1, &AT);
+
+  stinger_spmspv_ws_t ws;
+  stinger_spmspv_ws_init(&ws, NV);
+
+  std::vector<uint8_t> mask(NV);
+  for (int64_t i = 0; i < NV; i++)
+    mask[i] = (i % 5 != 0);
+
+  /* run each semiring twice to check the workspace is left clean */
+  for (int rep = 0; rep < 2; rep++) {
+    for (int s = 0; s < 4; s++) {
+      stinger_semiring_t sr = semirings[s];
+      double zero = stinger_semiring_zero(sr);
+      std::vector<double> x(NV, zero), y(NV), dense(NV);
+      std::vector<int64_t> x_idx, y_idx(NV);
+      std::vector<double> x_val, y_val(NV);
+      for (int64_t i = 0; i < NV; i += 13) {
+        x[i] = (sr == STINGER_SEMIRING_OR_AND) ? 1 : 1 + (i % 4);
+        x_idx.push_back(i);
+        x_val.push_back(x[i]);
+      }
+
+      std::vector<double> before(NV, -7.0);
+      dense = before;
+      stinger_csr_spmv(&AT, sr, &x[0], &dense[0], &mask[0], 0);
+
+      int64_t n = stinger_csr_spmspv(&A, sr, x_idx.size(), &x_idx[0], &x_val[0],
+                                     &y_idx[0], &y_val[0], &mask[0], 0, &ws);
+      std::vector<double> got(NV, zero);
+      std::vector<int> seen(NV, 0);
+      for (int64_t k = 0; k < n; k++) {
+        ASSERT_TRUE(mask[y_idx[k]]);
+        EXPECT_EQ(0, seen[y_idx[k]]++);
+        got[y_idx[k]] = y_val[k];
+      }
+      for (int64_t i = 0; i < NV; i++) {
+        if (mask[i])
+          EXPECT_TRUE(same(dense[i], got[i])) << dense[i] << " vs " << got[i] << ", semiring " << s << " row " << i;
+        else
+          EXPECT_EQ(-7.0, dense[i]);
+      }
+    }
+  }
+
+  stinger_spmspv_ws_release(&ws);
+  stinger_csr_release(&A);
+  stinger_csr_release(&AT);
+}
+
+TEST_F(SpMVTest, MatvecSemirings) {
+  eweight_t (*mult[])(eweight_t, eweight_t) = { stinger_mult, stinger_add, stinger_and, stinger_mult, stinger_add };
+  eweight_t (*reduce[])(eweight_t, eweight_t) = { stinger_add, stinger_min, stinger_or, stinger_max, stinger_max };
+  eweight_t empty[] = { 0, INT64_MAX / 2, 0, 0, 0 };
+
+  std::vector<eweight_t> x(NV), y(NV), expect(NV);
+  for (int64_t i = 0; i < NV; i++)
+    x[i] = i % 4;
+
+  for (int s = 0; s < 5; s++) {
+    for (int64_t u = 0; u < NV; u++) {
+      eweight_t out = empty[s];
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, u) {
+        out = reduce[s](mult[s](STINGER_EDGE_WEIGHT, x[STINGER_EDGE_DEST]), out);
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+      expect[u] = out;
+    }
+    EXPECT_EQ(0, stinger_matvec(S, &x[0], NV, &y[0], mult[s], reduce[s], empty[s]));
+    for (int64_t i = 0; i < NV; i++) {
+      EXPECT_EQ(expect[i], y[i]) << "pair " << s << " row " << i;
+    }
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,13 @@
+#ifndef STINGER_SPMV_TEST_H_
+#define STINGER_SPMV_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_utils/stinger_la.h"
+}
+#include "stinger_utils/stinger_spmv.h"
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_SPMV_TEST_H_ */
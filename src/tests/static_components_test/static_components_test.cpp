@@ -0,0 +1,162 @@
+#include "static_components_test.h"
+
+#define restrict
+
+class StaticComponentsTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  /* serial flood fill from the smallest id, over in and out edges of all types */
+  void expect_min_labels(int64_t nv, const int64_t * components) {
+    int64_t * expected = (int64_t *)xmalloc(nv * sizeof(int64_t));
+    int64_t * queue = (int64_t *)xmalloc(nv * sizeof(int64_t));
+    for (int64_t v = 0; v < nv; v++)
+      expected[v] = -1;
+
+    for (int64_t s = 0; s < nv; s++) {
+      if (expected[s] >= 0)
+        continue;
+      int64_t head = 0, tail = 0;
+      expected[s] = s;
+      queue[tail++] = s;
+      while (head < tail) {
+        int64_t u = queue[head++];
+        STINGER_FORALL_EDGES_OF_VTX_BEGIN(S, u) {
+          int64_t w = STINGER_EDGE_DEST;
+          if (w < nv && expected[w] < 0) {
+            expected[w] = s;
+            queue[tail++] = w;
+          }
+        } STINGER_FORALL_EDGES_OF_VTX_END();
+      }
+    }
+
+    for (int64_t v = 0; v < nv; v++) {
+      EXPECT_EQ(expected[v], components[v]) << "vertex " << v;
+    }
+
+    xfree(queue);
+    xfree(expected);
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+};
+
+TEST_F(StaticComponentsTest, MixedTypesAndDirections) {
+  stinger_insert_edge_pair(S, 0, 0, 1, 1, 1);
+  stinger_insert_edge_pair(S, 1, 1, 2, 1, 1);
+  stinger_insert_edge(S, 0, 5, 3, 1, 1);      /* one direction only */
+  stinger_insert_edge_pair(S, 1, 3, 4, 1, 1);
+  stinger_insert_edge_pair(S, 0, 7, 6, 1, 1);
+
+  int64_t nv = 10;
+  int64_t components[10];
+  EXPECT_EQ(5, afforest_components(S, nv, components, 2));
+
+  int64_t expected[10] = {0, 0, 0, 3, 3, 3, 6, 6, 8, 9};
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_EQ(expected[v], components[v]);
+  }
+
+  parallel_shiloach_vishkin_components(S, nv, components);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_EQ(expected[v], components[v]);
+  }
+}
+
+TEST_F(StaticComponentsTest, RandomGraph) {
+  int64_t nv = 4000;
+  uint64_t state = 99;
+  for (int64_t i = 0; i < 3000; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    int64_t u = (state >> 33) % nv;
+    int64_t v = (state >> 13) % nv;
+    stinger_insert_edge_pair(S, (state >> 7) & 1, u, v, 1, 1);
+  }
+
+  int64_t * components = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  for (int64_t rounds = 0; rounds < 4; rounds++) {
+    afforest_components(S, nv, components, rounds);
+    expect_min_labels(nv, components);
+  }
+  xfree(components);
+}
+
+TEST_F(StaticComponentsTest, StreamingUpdates) {
+  int64_t nv = 1000;
+  uint64_t state = 7;
+  for (int64_t i = 0; i < 400; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    stinger_insert_edge_pair(S, 0, (state >> 33) % nv, (state >> 13) % nv, 1, 1);
+  }
+
+  int64_t * components = (int64_t *)xmalloc(1200 * sizeof(int64_t));
+  afforest_components(S, nv, components, 2);
+
+  stinger_edge_update insertions[100];
+  stinger_edge_update deletions[4];
+
+  for (int64_t round = 0; round < 6; round++) {
+    /* later rounds also touch vertices above the previous nv */
+    int64_t new_nv = nv + (round >= 3 ? 50 : 0);
+    for (int64_t i = 0; i < 100; i++) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      insertions[i].type = 1;
+      insertions[i].source = (state >> 33) % new_nv;
+      insertions[i].destination = (state >> 13) % new_nv;
+      insertions[i].result = stinger_insert_edge_pair(S, 1, insertions[i].source, insertions[i].destination, 1, 2);
+    }
+
+    EXPECT_EQ(1, afforest_components_update(S, nv, new_nv, components, insertions, 100, NULL, 0));
+    nv = new_nv;
+    expect_min_labels(nv, components);
+  }
+
+  /* deletions of missing edges (result -1) keep the fast path and the labels */
+  int64_t * before = (int64_t *)xmalloc(nv * sizeof(int64_t));
+  for (int64_t i = 0; i < nv; i++)
+    before[i] = components[i];
+  for (int64_t k = 0; k < 4; k++) {
+    deletions[k].type = 3;  /* no edges of this type exist */
+    deletions[k].source = k;
+    deletions[k].destination = nv - 1 - k;
+    deletions[k].result = stinger_remove_edge(S, 3, k, nv - 1 - k);
+    EXPECT_EQ(-1, deletions[k].result);
+  }
+  EXPECT_EQ(1, afforest_components_update(S, nv, nv, components, NULL, 0, deletions, 4));
+  for (int64_t i = 0; i < nv; i++)
+    EXPECT_EQ(before[i], components[i]);
+  xfree(before);
+
+  /* removing a real edge recomputes */
+  deletions[0].type = 1;
+  deletions[0].source = insertions[0].source;
+  deletions[0].destination = insertions[0].destination;
+  deletions[0].result = stinger_remove_edge_pair(S, 1, deletions[0].source, deletions[0].destination);
+  EXPECT_GT(deletions[0].result, 0);
+  EXPECT_EQ(0, afforest_components_update(S, nv, nv, components, NULL, 0, deletions, 1));
+  expect_min_labels(nv, components);
+
+  xfree(components);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+#include "stinger_mon_test.h"
+
+#define restrict
+
+using namespace gt::stinger;
+
+/* The monitor is a singleton, so each test publishes its own epoch and
+ * replaces it with an empty one when done. */
+class StingerMonTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+        stinger_config->nv = 1<<12;
+        stinger_config->nebs = 1<<12;
+        stinger_config->netypes = 2;
+        stinger_config->nvtypes = 2;
+        stinger_config->memory_size = 1<<28;
+        S = stinger_new_full(stinger_config);
+        xfree(stinger_config);
+        nv = S->max_nv;
+        data = NULL;
+    }
+
+    virtual void TearDown() {
+        StingerBatch empty;
+        StingerMon::get_mon().update_algs(NULL, "", 0, NULL, NULL, empty);
+        stinger_free_all(S);
+        free(data);
+    }
+
+    /* publishes one algorithm named alg over S as a new epoch, its data
+     * allocated and filled the first time */
+    void publish(const std::string & description, int64_t bytes) {
+        if (!data) {
+            data = (uint8_t *)xcalloc(1, bytes);
+            fill();
+        }
+        StingerAlgState * alg = new StingerAlgState();
+        alg->name = "alg";
+        alg->data_description = description;
+        alg->data = data;
+        alg->state = ALG_STATE_READY_POST;
+
+        std::vector<StingerAlgState *> * algs = new std::vector<StingerAlgState *>();
+        std::map<std::string, StingerAlgState *> * alg_map = new std::map<std::string, StingerAlgState *>();
+        algs->push_back(alg);
+        (*alg_map)[alg->name] = alg;
+
+        StingerBatch batch;
+        StingerMon::get_mon().update_algs(S, "", 0, algs, alg_map, batch);
+    }
+
+    virtual void fill() { }
+
+    struct stinger_config_t * stinger_config;
+    struct stinger * S;
+    int64_t nv;
+    uint8_t * data;
+};
+
+/* A double field with many ties: vertex v holds v % 100 */
+class StingerMonSortedTest : public StingerMonTest {
+protected:
+    virtual void fill() {
+        double * x = (double *)data;
+        for (int64_t v = 0; v < nv; v++)
+            x[v] = v % 100;
+    }
+
+    /* idx is ordered by value, then by vertex id */
+    void expect_sorted(const int64_t * idx, int64_t len, bool asc) {
+        const double * x = (const double *)data;
+        for (int64_t i = 1; i < len; i++) {
+            double a = x[idx[i-1]], b = x[idx[i]];
+            if (a == b)
+                EXPECT_LT(idx[i-1], idx[i]);
+            else
+                EXPECT_TRUE(asc ? a < b : a > b);
+        }
+    }
+};
+
+TEST_F(StingerMonSortedTest, GrowsPrefixGeometrically) {
+    publish("d x", nv * sizeof(double));
+    StingerMon & mon = StingerMon::get_mon();
+    mon.get_alg_read_lock();
+
+    int64_t len = 0;
+    const int64_t * idx = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 10, &len);
+    ASSERT_TRUE(idx != NULL);
+    EXPECT_EQ(1024, len);
+    expect_sorted(idx, len, false);
+    EXPECT_EQ(99, ((double *)data)[idx[0]]);
+    EXPECT_EQ(99, idx[0]);
+
+    /* a prefix long enough is handed back as is */
+    int64_t again_len = 0;
+    EXPECT_EQ(idx, mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 1000, &again_len));
+    EXPECT_EQ(len, again_len);
+
+    /* past it, the prefix at least doubles */
+    idx = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 1100, &len);
+    EXPECT_EQ(2048, len);
+    expect_sorted(idx, len, false);
+
+    /* close to nv the whole array is sorted */
+    idx = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 2100, &len);
+    EXPECT_EQ(nv, len);
+    expect_sorted(idx, len, false);
+
+    mon.release_alg_read_lock();
+}
+
+TEST_F(StingerMonSortedTest, DirectionsIndexedApart) {
+    publish("d x", nv * sizeof(double));
+    StingerMon & mon = StingerMon::get_mon();
+    mon.get_alg_read_lock();
+
+    int64_t len = 0;
+    const int64_t * desc = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 5, &len);
+    const int64_t * asc = mon.get_sorted_index(data, 'd', sizeof(double), nv, true, 5, &len);
+    EXPECT_NE(desc, asc);
+    expect_sorted(asc, len, true);
+    EXPECT_EQ(0, asc[0]);
+    EXPECT_EQ(100, asc[1]);
+    EXPECT_EQ(99, desc[0]);
+    EXPECT_EQ(199, desc[1]);
+
+    mon.release_alg_read_lock();
+}
+
+TEST_F(StingerMonSortedTest, NewEpochSortsAfresh) {
+    publish("d x", nv * sizeof(double));
+    StingerMon & mon = StingerMon::get_mon();
+
+    int64_t len = 0;
+    mon.get_alg_read_lock();
+    const int64_t * idx = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 5, &len);
+    EXPECT_EQ(99, idx[0]);
+    mon.release_alg_read_lock();
+
+    /* the data changes with the next batch */
+    ((double *)data)[7] = 1000;
+    publish("d x", nv * sizeof(double));
+
+    mon.get_alg_read_lock();
+    idx = mon.get_sorted_index(data, 'd', sizeof(double), nv, false, 5, &len);
+    EXPECT_EQ(7, idx[0]);
+    mon.release_alg_read_lock();
+}
+
+/* A double field of -1, 0, 1 repeating and an int64_t field whose sum
+ * a double cannot hold */
+class StingerMonSummaryTest : public StingerMonTest {
+protected:
+    virtual void fill() {
+        double * x = (double *)data;
+        int64_t * n = (int64_t *)(data + nv * sizeof(double));
+        for (int64_t v = 0; v < nv; v++)
+            x[v] = v % 3 - 1;
+        n[0] = 1LL << 53;
+        n[1] = 1;
+        n[2] = 1;
+        n[3] = -5;
+    }
+};
+
+TEST_F(StingerMonSummaryTest, SummarizesEveryField) {
+    for (int64_t v = 0; v < 10; v++)
+        stinger_vtype_set(S, v, 1);
+    publish("dl x n", nv * (sizeof(double) + sizeof(int64_t)));
+    StingerMon & mon = StingerMon::get_mon();
+    mon.get_alg_read_lock();
+
+    const std::vector<StingerFieldSummary> * summary = mon.get_alg_summary("alg");
+    ASSERT_TRUE(summary != NULL);
+    ASSERT_EQ(2, summary->size());
+    EXPECT_TRUE(mon.get_alg_summary("nope") == NULL);
+
+    /* every slot up to max_nv is counted */
+    const StingerFieldSummary & x = (*summary)[0];
+    EXPECT_EQ("x", x.name);
+    EXPECT_EQ('d', x.type);
+    EXPECT_EQ(nv, x.all.count);
+    EXPECT_EQ(-1, x.all.min);
+    EXPECT_EQ(1, x.all.max);
+    EXPECT_EQ(nv / 3, x.positive);
+    EXPECT_EQ(nv / 3, x.positive_sum);
+    EXPECT_EQ(nv - 2 * (nv / 3), x.negative);
+    EXPECT_EQ(x.positive - x.negative, x.all.sum);
+    EXPECT_EQ(nv / 3, x.hist[0]);                               /* zeros */
+    EXPECT_EQ(nv - nv / 3, x.hist[1 + STINGER_SUMMARY_HIST_BIAS]); /* |x| in [1, 2) */
+
+    /* vertices 0 to 9 are type 1: -1, 0, 1, -1, ... */
+    ASSERT_EQ(2, x.by_vtype.size());
+    EXPECT_EQ(10, x.by_vtype[1].count);
+    EXPECT_EQ(-1, x.by_vtype[1].sum);
+    EXPECT_EQ(nv - 10, x.by_vtype[0].count);
+
+    const StingerFieldSummary & n = (*summary)[1];
+    EXPECT_EQ("n", n.name);
+    EXPECT_EQ('l', n.type);
+    EXPECT_EQ(nv, n.all.count);
+    EXPECT_EQ((1LL << 53) - 3, n.all.isum);
+    EXPECT_EQ((1LL << 53) + 2, n.positive_isum);
+    EXPECT_EQ(3, n.positive);
+    EXPECT_EQ(1, n.negative);
+    EXPECT_EQ(-5, n.all.min);
+    EXPECT_EQ((double)(1LL << 53), n.all.max);
+
+    /* computed once per epoch */
+    EXPECT_EQ(summary, mon.get_alg_summary("alg"));
+    mon.release_alg_read_lock();
+}
+
+int
+main (int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,13 @@
+#ifndef STINGER_MON_TEST_H
+#define STINGER_MON_TEST_H
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+}
+
+#include "stinger_net/stinger_mon.h"
+
+#include "gtest/gtest.h"
+
+#endif //STINGER_MON_TEST_H
@@ -0,0 +1,237 @@
+#include "stinger_result_writer_test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+
+#define restrict
+
+using namespace gt::stinger;
+
+/* One column file read back */
+struct ColumnRead {
+  int64_t batch;
+  int64_t max_nv;
+  int64_t nv;
+  int64_t type;
+  std::string alg;
+  std::string field;
+  std::vector<uint8_t> data;
+};
+
+static bool
+read_string(FILE * fp, std::string & s)
+{
+  int64_t len;
+  if (fread(&len, sizeof(len), 1, fp) != 1 || len < 0 || len > 4096)
+    return false;
+  s.resize(len);
+  return len == 0 || fread(&s[0], 1, len, fp) == (size_t)len;
+}
+
+/* Parses the header and body described in stinger_result_writer.h */
+static bool
+read_column(const std::string & path, int64_t width, ColumnRead & col)
+{
+  FILE * fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return false;
+  char magic[8];
+  bool ok = fread(magic, 1, 8, fp) == 8 && 0 == memcmp(magic, "STGRCOL1", 8) &&
+            fread(&col.batch, sizeof(int64_t), 1, fp) == 1 &&
+            fread(&col.max_nv, sizeof(int64_t), 1, fp) == 1 &&
+            fread(&col.nv, sizeof(int64_t), 1, fp) == 1 &&
+            fread(&col.type, sizeof(int64_t), 1, fp) == 1 &&
+            read_string(fp, col.alg) && read_string(fp, col.field);
+  if (ok) {
+    col.data.resize(col.nv * width);
+    ok = fread(col.data.data(), 1, col.data.size(), fp) == col.data.size();
+    ok &= (fgetc(fp) == EOF);  /* nothing after the values */
+  }
+  fclose(fp);
+  return ok;
+}
+
+class StingerResultWriterTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+        stinger_config->nv = 1<<12;
+        stinger_config->nebs = 1<<12;
+        stinger_config->netypes = 2;
+        stinger_config->nvtypes = 2;
+        stinger_config->memory_size = 1<<28;
+        S = stinger_new_full(stinger_config);
+        xfree(stinger_config);
+        max_nv = S->max_nv;
+
+        /* mapped vertices bound what is written */
+        int64_t vtx;
+        stinger_mapping_create(S, "a", 1, &vtx);
+        stinger_mapping_create(S, "b", 1, &vtx);
+        stinger_mapping_create(S, "c", 1, &vtx);
+        nv = stinger_mapping_nv(S);
+
+        data = (uint8_t *)xcalloc(max_nv, sizeof(double) + sizeof(int32_t));
+        double * x = (double *)data;
+        int32_t * n = (int32_t *)(data + max_nv * sizeof(double));
+        for (int64_t v = 0; v < max_nv; v++) {
+            x[v] = v * 0.5;
+            n[v] = -v;
+        }
+
+        alg.name = "alg";
+        alg.data_description = "di x n";
+        alg.data = data;
+        alg.state = ALG_STATE_READY_POST;
+        algs.push_back(&alg);
+
+        char tmpl[] = "/tmp/stinger_result_writer_test.XXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+        dir = tmpl;
+    }
+
+    virtual void TearDown() {
+        DIR * d = opendir(dir.c_str());
+        if (d) {
+            struct dirent * e;
+            while ((e = readdir(d))) {
+                if (e->d_name[0] != '.')
+                    unlink((dir + "/" + e->d_name).c_str());
+            }
+            closedir(d);
+        }
+        rmdir(dir.c_str());
+        stinger_free_all(S);
+        free(data);
+    }
+
+    std::string path(const char * field, int64_t batch) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "/alg.%s.%ld.col", field, (long)batch);
+        return dir + buf;
+    }
+
+    std::string names_path(int64_t batch) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "/vertex_names.%ld.vtx", (long)batch);
+        return dir + buf;
+    }
+
+    bool exists(const std::string & p) {
+        return 0 == access(p.c_str(), F_OK);
+    }
+
+    struct stinger_config_t * stinger_config;
+    struct stinger * S;
+    int64_t max_nv;
+    int64_t nv;
+    uint8_t * data;
+    StingerAlgState alg;
+    std::vector<StingerAlgState *> algs;
+    std::string dir;
+    StingerResultWriter writer;
+};
+
+TEST_F(StingerResultWriterTest, ColumnRoundTrip) {
+    writer.submit(7, S, true, algs, dir, 0);
+    writer.finish();
+
+    ColumnRead x;
+    ASSERT_TRUE(read_column(path("x", 7), sizeof(double), x));
+    EXPECT_EQ(7, x.batch);
+    EXPECT_EQ(max_nv, x.max_nv);
+    EXPECT_EQ(nv, x.nv);
+    EXPECT_EQ('d', x.type);
+    EXPECT_EQ("alg", x.alg);
+    EXPECT_EQ("x", x.field);
+    EXPECT_EQ(0, memcmp(x.data.data(), data, nv * sizeof(double)));
+
+    /* the second field starts max_nv values into the data */
+    ColumnRead n;
+    ASSERT_TRUE(read_column(path("n", 7), sizeof(int32_t), n));
+    EXPECT_EQ('i', n.type);
+    EXPECT_EQ("n", n.field);
+    for (int64_t v = 0; v < nv; v++)
+        EXPECT_EQ(-v, ((int32_t *)n.data.data())[v]);
+
+    /* names are in stinger_names_save() form: max length, count, then
+     * each length and name */
+    FILE * fp = fopen(names_path(7).c_str(), "rb");
+    ASSERT_TRUE(fp != NULL);
+    int64_t max_len = 0, count = 0;
+    ASSERT_EQ(1, fread(&max_len, sizeof(int64_t), 1, fp));
+    ASSERT_EQ(1, fread(&count, sizeof(int64_t), 1, fp));
+    ASSERT_EQ(3, count);
+    const char * expected[] = { "a", "b", "c" };
+    for (int64_t i = 0; i < count; i++) {
+        std::string name;
+        ASSERT_TRUE(read_string(fp, name));
+        EXPECT_EQ(expected[i], name);
+    }
+    fclose(fp);
+
+    /* nothing is left under a temporary name */
+    EXPECT_FALSE(exists(path("x", 7) + ".tmp"));
+}
+
+TEST_F(StingerResultWriterTest, CopiesOnSubmit) {
+    writer.submit(1, S, false, algs, dir, 0);
+    /* the algorithm goes on with the next batch at once */
+    ((double *)data)[1] = 100;
+    writer.finish();
+
+    ColumnRead x;
+    ASSERT_TRUE(read_column(path("x", 1), sizeof(double), x));
+    EXPECT_EQ(0.5, ((double *)x.data.data())[1]);
+    EXPECT_FALSE(exists(names_path(1)));
+}
+
+TEST_F(StingerResultWriterTest, SkipsFinishedAlgorithms) {
+    alg.state = ALG_STATE_DONE;
+    writer.submit(1, S, false, algs, dir, 0);
+    writer.finish();
+    EXPECT_FALSE(exists(path("x", 1)));
+}
+
+TEST_F(StingerResultWriterTest, RotatesHistory) {
+    for (int64_t b = 1; b <= 4; b++) {
+        writer.submit(b, S, true, algs, dir, 2);
+        writer.finish();
+    }
+    for (int64_t b = 1; b <= 2; b++) {
+        EXPECT_FALSE(exists(path("x", b)));
+        EXPECT_FALSE(exists(path("n", b)));
+        EXPECT_FALSE(exists(names_path(b)));
+    }
+    EXPECT_TRUE(exists(path("x", 3)));
+    EXPECT_TRUE(exists(path("n", 3)));
+    EXPECT_FALSE(exists(names_path(3)));  /* only the latest names are kept */
+    EXPECT_TRUE(exists(path("x", 4)));
+    EXPECT_TRUE(exists(names_path(4)));
+}
+
+TEST_F(StingerResultWriterTest, SupersedesPending) {
+    for (int64_t b = 1; b <= 50; b++)
+        writer.submit(b, S, false, algs, dir, 0);
+    writer.finish();
+
+    /* the last always lands; an earlier one is written whole or not at all */
+    EXPECT_TRUE(exists(path("x", 50)));
+    EXPECT_TRUE(exists(path("n", 50)));
+    for (int64_t b = 1; b < 50; b++)
+        EXPECT_EQ(exists(path("x", b)), exists(path("n", b)));
+
+    ColumnRead x;
+    ASSERT_TRUE(read_column(path("x", 50), sizeof(double), x));
+    EXPECT_EQ(50, x.batch);
+}
+
+int
+main (int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
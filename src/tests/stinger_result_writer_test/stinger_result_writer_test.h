@@ -0,0 +1,13 @@
+#ifndef STINGER_RESULT_WRITER_TEST_H
+#define STINGER_RESULT_WRITER_TEST_H
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+}
+
+#include "stinger_net/stinger_result_writer.h"
+
+#include "gtest/gtest.h"
+
+#endif //STINGER_RESULT_WRITER_TEST_H
@@ -0,0 +1,123 @@
+#include "stinger_snapshot_test.h"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace gt::stinger;
+
+#define SEGMENTS 6
+#define SEGMENT_SIZE (1 << 16)
+
+class StingerSnapshotTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        for (int i = 0; i < SEGMENTS; i++) {
+            char name[64];
+            snprintf(name, sizeof(name), "/stinger_snapshot_test.%ld.%d", (long)getpid(), i);
+            names[i] = name;
+            int fd = shm_open(name, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+            ASSERT_GE(fd, 0);
+            ASSERT_EQ(0, ftruncate(fd, SEGMENT_SIZE));
+            close(fd);
+        }
+    }
+
+    virtual void TearDown() {
+        for (int i = 0; i < SEGMENTS; i++)
+            shm_unlink(names[i].c_str());
+    }
+
+    std::string names[SEGMENTS];
+    StingerSnapshotMaps maps;
+};
+
+TEST_F(StingerSnapshotTest, ReusesByNameAndSize) {
+    void * a = maps.map_data(names[0], SEGMENT_SIZE);
+    void * b = maps.map_stinger(names[0], SEGMENT_SIZE);
+    ASSERT_TRUE(a != NULL);
+    EXPECT_EQ(a, b);
+
+    /* the same name at another size is a mapping of its own */
+    void * c = maps.map_data(names[0], SEGMENT_SIZE / 2);
+    ASSERT_TRUE(c != NULL);
+    EXPECT_NE(a, c);
+
+    snapshot_stats_t stats = maps.get_stats();
+    EXPECT_EQ(2, stats.mappings);
+    EXPECT_EQ(2, stats.maps);
+    EXPECT_EQ(1, stats.reuses);
+    EXPECT_EQ(SEGMENT_SIZE + SEGMENT_SIZE / 2, stats.mapped_bytes);
+    EXPECT_EQ(SEGMENT_SIZE + SEGMENT_SIZE / 2, stats.populated_bytes);
+
+    maps.release(a);
+    maps.release(b);
+    maps.release(c);
+    EXPECT_EQ(0, maps.get_stats().unmaps);
+}
+
+TEST_F(StingerSnapshotTest, ShowsLaterWrites) {
+    const char * x = (const char *)maps.map_data(names[0], SEGMENT_SIZE);
+    ASSERT_TRUE(x != NULL);
+    maps.release((void *)x);
+
+    int fd = shm_open(names[0].c_str(), O_RDWR, S_IRUSR | S_IWUSR);
+    char * w = (char *)mmap(NULL, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, (void *)w);
+    w[100] = 42;
+    munmap(w, SEGMENT_SIZE);
+
+    /* the idle mapping is handed out again and sees the write */
+    EXPECT_EQ(x, maps.map_data(names[0], SEGMENT_SIZE));
+    EXPECT_EQ(42, x[100]);
+    maps.release((void *)x);
+}
+
+TEST_F(StingerSnapshotTest, TrimsIdleRing) {
+    void * addr[SEGMENTS];
+    for (int i = 0; i < SEGMENTS; i++) {
+        addr[i] = maps.map_data(names[i], SEGMENT_SIZE, false);
+        ASSERT_TRUE(addr[i] != NULL);
+    }
+    EXPECT_EQ(0, maps.get_stats().populated_bytes);
+
+    /* mappings in use are never trimmed */
+    EXPECT_EQ(SEGMENTS, maps.get_stats().mappings);
+
+    /* touch 0 so 1 and 2 become the least recently used */
+    EXPECT_EQ(addr[0], maps.map_data(names[0], SEGMENT_SIZE, false));
+    maps.release(addr[0]);
+    for (int i = 0; i < SEGMENTS; i++)
+        maps.release(addr[i]);
+
+    /* four idle mappings are kept */
+    snapshot_stats_t stats = maps.get_stats();
+    EXPECT_EQ(4, stats.mappings);
+    EXPECT_EQ(2, stats.unmaps);
+    EXPECT_EQ(4 * SEGMENT_SIZE, stats.mapped_bytes);
+
+    maps.map_data(names[0], SEGMENT_SIZE, false);
+    maps.map_data(names[1], SEGMENT_SIZE, false);
+    stats = maps.get_stats();
+    EXPECT_EQ(2, stats.reuses);
+    EXPECT_EQ(SEGMENTS + 1, stats.maps);
+
+    /* a smaller ring unmaps the idle, not the held */
+    maps.set_ring_size(0);
+    stats = maps.get_stats();
+    EXPECT_EQ(2, stats.mappings);
+    EXPECT_EQ(2 * SEGMENT_SIZE, stats.mapped_bytes);
+}
+
+TEST_F(StingerSnapshotTest, MissingSegment) {
+    EXPECT_TRUE(maps.map_data("/stinger_snapshot_test.missing", SEGMENT_SIZE) == NULL);
+    EXPECT_EQ(0, maps.get_stats().mappings);
+    maps.release(NULL);
+}
+
+int
+main (int argc, char *argv[])
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,13 @@
+#ifndef STINGER_SNAPSHOT_TEST_H
+#define STINGER_SNAPSHOT_TEST_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "stinger_net/stinger_snapshot.h"
+
+#include "gtest/gtest.h"
+
+#endif //STINGER_SNAPSHOT_TEST_H
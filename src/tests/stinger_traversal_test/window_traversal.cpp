@@ -0,0 +1,92 @@
+#include "stinger_traversal_test.h"
+
+/*
+ * Vertex 1000 gets an out-edge to 2000 + k at time 10 + k, so its edge blocks
+ * cover disjoint time ranges; the edge to 2000 is seen again at time 500.
+ */
+class StingerWindowTraversalTest : public StingerTraversalTest {
+protected:
+  virtual void SetUp() {
+    StingerTraversalTest::SetUp();
+    for (int64_t k = 0; k < 100; k++) {
+      stinger_insert_edge(S, 1, 1000, 2000 + k, 1, 10 + k);
+    }
+    stinger_insert_edge(S, 1, 1000, 2000, 1, 500);
+
+    for (int64_t k = 40; k <= 50; k++) {
+      expected.insert(2000 + k);
+    }
+    expected.insert(2000);
+  }
+
+  std::set<int64_t> expected;
+};
+
+TEST_F(StingerWindowTraversalTest, STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN) {
+  std::set<int64_t> seen;
+  STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S, 1000, 50, 60) {
+    EXPECT_TRUE(STINGER_IS_OUT_EDGE);
+    EXPECT_TRUE(seen.insert(STINGER_EDGE_DEST).second);
+  } STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END();
+  EXPECT_EQ(expected, seen);
+
+  /* the pairs inserted at time 1 are all outside */
+  for (int64_t v = 0; v < 200; v++) {
+    STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S, v, 2, 1000) {
+      ADD_FAILURE() << "Unexpected edge " << v << " " << STINGER_EDGE_DEST;
+    } STINGER_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END();
+  }
+}
+
+TEST_F(StingerWindowTraversalTest, STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_BEGIN) {
+  std::set<int64_t> seen;
+  STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_BEGIN(S, 1, 1000, 50, 60) {
+    EXPECT_EQ(1, STINGER_EDGE_TYPE);
+    EXPECT_TRUE(seen.insert(STINGER_EDGE_DEST).second);
+  } STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_END();
+  EXPECT_EQ(expected, seen);
+
+  STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_BEGIN(S, 0, 1000, 50, 60) {
+    ADD_FAILURE() << "Unexpected edge " << STINGER_EDGE_DEST;
+  } STINGER_FORALL_OUT_EDGES_OF_TYPE_OF_VTX_IN_WINDOW_END();
+}
+
+TEST_F(StingerWindowTraversalTest, STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN) {
+  std::set<int64_t> seen;
+  STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_BEGIN(S, 1000, 50, 60) {
+    OMP("omp critical")
+    seen.insert(STINGER_EDGE_DEST);
+  } STINGER_PARALLEL_FORALL_OUT_EDGES_OF_VTX_IN_WINDOW_END();
+  EXPECT_EQ(expected, seen);
+}
+
+TEST_F(StingerWindowTraversalTest, STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_BEGIN) {
+  std::set<int64_t> seen;
+  STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_BEGIN(S, 1, 50, 60) {
+    OMP("omp critical")
+    {
+      EXPECT_EQ(1000, STINGER_EDGE_SOURCE);
+      seen.insert(STINGER_EDGE_DEST);
+    }
+  } STINGER_PARALLEL_FORALL_EDGES_IN_WINDOW_END();
+  EXPECT_EQ(expected, seen);
+}
+
+TEST_F(StingerWindowTraversalTest, STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_BEGIN) {
+  int64_t count = 0;
+  STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_BEGIN(S, 0, 1) {
+    stinger_int64_fetch_add(&count, 1);
+  } STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_END();
+  EXPECT_EQ(stinger_total_edges(S) - 100, count);
+
+  std::set<int64_t> seen;
+  STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_BEGIN(S, 100, 1000) {
+    OMP("omp critical")
+    seen.insert(STINGER_EDGE_DEST);
+  } STINGER_PARALLEL_FORALL_EDGES_OF_ALL_TYPES_IN_WINDOW_END();
+  std::set<int64_t> late;
+  late.insert(2000);
+  for (int64_t k = 90; k < 100; k++)
+    late.insert(2000 + k);
+  EXPECT_EQ(late, seen);
+}
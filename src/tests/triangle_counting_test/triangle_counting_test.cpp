@@ -0,0 +1,175 @@
+#include "triangle_counting_test.h"
+
+#define restrict
+
+class TriangleCountingTest : public ::testing::Test {
+protected:
+  virtual void SetUp() {
+    stinger_config = (struct stinger_config_t *)xcalloc(1,sizeof(struct stinger_config_t));
+    stinger_config->nv = 1<<13;
+    stinger_config->nebs = 1<<16;
+    stinger_config->netypes = 2;
+    stinger_config->nvtypes = 2;
+    stinger_config->memory_size = 1<<30;
+    S = stinger_new_full(stinger_config);
+    xfree(stinger_config);
+  }
+
+  virtual void TearDown() {
+    stinger_free_all(S);
+  }
+
+  /* brute force over all vertex triples */
+  void expect_matches_brute_force(int64_t nv, const int64_t * ntri) {
+    uint8_t * adj = (uint8_t *)xcalloc(nv * nv, sizeof(uint8_t));
+    for (int64_t v = 0; v < nv; v++) {
+      STINGER_FORALL_OUT_EDGES_OF_VTX_BEGIN(S, v) {
+        if (STINGER_EDGE_DEST != v)
+          adj[v * nv + STINGER_EDGE_DEST] = 1;
+      } STINGER_FORALL_OUT_EDGES_OF_VTX_END();
+    }
+
+    for (int64_t v = 0; v < nv; v++) {
+      int64_t count = 0;
+      for (int64_t u = 0; u < nv; u++) {
+        if (!adj[v * nv + u])
+          continue;
+        for (int64_t w = u + 1; w < nv; w++) {
+          count += adj[v * nv + w] && adj[u * nv + w];
+        }
+      }
+      EXPECT_EQ(count, ntri[v]) << "triangles at vertex " << v;
+    }
+
+    xfree(adj);
+  }
+
+  struct stinger_config_t * stinger_config;
+  struct stinger * S;
+};
+
+TEST_F(TriangleCountingTest, Intersect) {
+  int64_t a[40], b[40], out[40];
+  for (int64_t i = 0; i < 40; i++) {
+    a[i] = 2 * i;
+    b[i] = 3 * i;
+  }
+  /* multiples of 6 below 80 */
+  EXPECT_EQ(14, triangle_intersect(a, 40, b, 40, out));
+  for (int64_t i = 0; i < 14; i++) {
+    EXPECT_EQ(6 * i, out[i]);
+  }
+  EXPECT_EQ(14, triangle_intersect(b, 40, a, 40, NULL));
+  EXPECT_EQ(3, triangle_intersect(a, 40, b, 5, NULL));
+  EXPECT_EQ(0, triangle_intersect(a, 0, b, 40, NULL));
+}
+
+TEST_F(TriangleCountingTest, StaticCounts) {
+  /* 4-clique 0..3 (4 triangles), a parallel edge of another type, a
+   * self-loop and a pendant path */
+  int64_t edges[][2] = { {0,1}, {0,2}, {0,3}, {1,2}, {1,3}, {2,3}, {3,4}, {4,5} };
+  for (int64_t i = 0; i < 8; i++) {
+    stinger_insert_edge_pair(S, 0, edges[i][0], edges[i][1], 1, 1);
+  }
+  stinger_insert_edge_pair(S, 1, 0, 1, 1, 1);
+  stinger_insert_edge(S, 0, 2, 2, 1, 1);
+
+  int64_t nv = 6;
+  int64_t ntri[6], deg[6];
+  double cc[6];
+  triangle_count_all(S, nv, ntri, deg);
+  triangle_clustering_coefficients(nv, ntri, deg, cc);
+
+  int64_t expected[6] = {3, 3, 3, 3, 0, 0};
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_EQ(expected[v], ntri[v]);
+  }
+  EXPECT_EQ(3, deg[0]);
+  EXPECT_EQ(4, deg[3]);
+  EXPECT_DOUBLE_EQ(1.0, cc[0]);
+  EXPECT_DOUBLE_EQ(0.5, cc[3]);
+  EXPECT_DOUBLE_EQ(0.0, cc[4]);
+}
+
+TEST_F(TriangleCountingTest, StreamingUpdates) {
+  int64_t nv = 96;
+  int64_t * ntri = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  double * cc = (double *)xcalloc(nv, sizeof(double));
+
+  uint64_t state = 12345;
+  for (int64_t i = 0; i < 600; i++) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    int64_t u = (state >> 33) % nv;
+    int64_t v = (state >> 13) % nv;
+    if (u != v)
+      stinger_insert_edge_pair(S, (state >> 7) & 1, u, v, 1, 1);
+  }
+
+  stinger_triangle_internal tri_internal;
+  stinger_triangle_stats stats;
+  stinger_triangle_reset_stats(&stats);
+  stinger_triangle_initialize_internals(S, nv, &tri_internal, ntri, cc);
+  expect_matches_brute_force(nv, ntri);
+
+  stinger_edge_update insertions[64];
+  stinger_edge_update deletions[64];
+
+  for (int64_t round = 0; round < 20; round++) {
+    int64_t num_insertions = 0, num_deletions = 0;
+    for (int64_t i = 0; i < 64; i++) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      int64_t u = (state >> 33) % nv;
+      int64_t v = (state >> 13) % nv;
+      int64_t t = (state >> 7) & 1;
+      if (u == v)
+        continue;
+      stinger_edge_update * e = (state >> 3) & 1 ? insertions + num_insertions++ : deletions + num_deletions++;
+      e->type = t;
+      e->source = u;
+      e->destination = v;
+    }
+
+    /* odd rounds skip the prepare step and take the fallback path */
+    if (!(round & 1))
+      stinger_triangle_prepare(S, &tri_internal, insertions, num_insertions, deletions, num_deletions);
+
+    for (int64_t i = 0; i < num_insertions; i++)
+      insertions[i].result = stinger_insert_edge_pair(S, insertions[i].type,
+        insertions[i].source, insertions[i].destination, 1, round + 2);
+    for (int64_t i = 0; i < num_deletions; i++)
+      deletions[i].result = stinger_remove_edge_pair(S, deletions[i].type,
+        deletions[i].source, deletions[i].destination);
+
+    stinger_triangle_update(S, &tri_internal, &stats, insertions, num_insertions,
+      deletions, num_deletions, ntri, cc);
+    expect_matches_brute_force(nv, ntri);
+    if (HasFailure())
+      break;
+  }
+
+  EXPECT_GT(stats.pairs_changed, 0);
+  EXPECT_GT(stats.neighbor_updates, 0);
+
+  int64_t * deg = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  int64_t * ntri_ref = (int64_t *)xcalloc(nv, sizeof(int64_t));
+  double * cc_ref = (double *)xcalloc(nv, sizeof(double));
+  triangle_count_all(S, nv, ntri_ref, deg);
+  triangle_clustering_coefficients(nv, ntri_ref, deg, cc_ref);
+  for (int64_t v = 0; v < nv; v++) {
+    EXPECT_DOUBLE_EQ(cc_ref[v], cc[v]);
+  }
+
+  xfree(cc_ref);
+  xfree(ntri_ref);
+  xfree(deg);
+  stinger_triangle_release_internals(&tri_internal);
+  xfree(cc);
+  xfree(ntri);
+}
+
+int
+main (int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
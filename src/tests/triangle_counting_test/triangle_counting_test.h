@@ -0,0 +1,12 @@
+#ifndef STINGER_TRIANGLE_COUNTING_TEST_H_
+#define STINGER_TRIANGLE_COUNTING_TEST_H_
+
+extern "C" {
+#include "stinger_core/stinger.h"
+#include "stinger_core/xmalloc.h"
+#include "stinger_alg/triangle_counting.h"
+}
+
+#include "gtest/gtest.h"
+
+#endif /* STINGER_TRIANGLE_COUNTING_TEST_H_ */